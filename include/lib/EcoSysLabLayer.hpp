@@ -37,6 +37,24 @@ namespace EcoSysLab {
 		IlluminationEstimationSettings m_shadowEstimationSettings;
 	};
 
+	/**
+	 * \brief The flow geometry of a tree in the local space of the tree, reused until the tree changes.
+	 */
+	struct TreeFlowGeometry
+	{
+		Entity m_entity;
+		int m_shootVersion = -1;
+		int m_changeVersion = -1;
+		int m_iteration = -1;
+		/**
+		 * The index of each flow in the sorted flow list, used to find the points of a flow when patching.
+		 */
+		std::vector<int> m_flowIndices;
+		std::vector<StrandPoint> m_stemPoints;
+		std::vector<ParticleInfo> m_foliage;
+		std::vector<ParticleInfo> m_fruits;
+	};
+
 	class EcoSysLabLayer : public ILayer {
 		unsigned m_operatorMode = static_cast<unsigned>(OperatorMode::Select);
 		float m_overrideGrowRate = 0.1f;
@@ -58,6 +76,7 @@ namespace EcoSysLab {
 
 		bool m_visualization = true;
 		std::vector<int> m_shootVersions;
+		std::vector<TreeFlowGeometry> m_treeFlowGeometries;
 		std::vector<glm::vec3> m_randomColors;
 
 		std::vector<glm::uint> m_shootStemSegments;
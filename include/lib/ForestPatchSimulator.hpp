@@ -0,0 +1,132 @@
+#pragma once
+#include "ForestPatch.hpp"
+using namespace EvoEngine;
+namespace EcoSysLab {
+	struct ForestPatchSimulationSettings
+	{
+		/**
+		 * The edge length of the square tiles (on the XZ plane) the patch is partitioned into.
+		 */
+		float m_tileSize = 20.0f;
+		/**
+		 * The width of the band around each tile whose shadow and occupancy are received from the neighbouring tiles.
+		 */
+		float m_haloSize = 3.0f;
+		float m_crownShynessDistance = 0.25f;
+		int m_maxNodeCount = 0;
+		IlluminationEstimationSettings m_shadowEstimationSettings;
+	};
+
+	struct ForestPatchSimulationTree
+	{
+		glm::mat4 m_globalTransform = glm::mat4(1.0f);
+		std::shared_ptr<TreeDescriptor> m_treeDescriptor;
+		TreeModel m_treeModel{};
+		ShootGrowthController m_shootGrowthController{};
+		unsigned m_tileIndex = 0;
+	};
+
+	/**
+	 * \brief How far the environment of the tiles is from a single grid over the whole patch, as the per-entity simulation builds it.
+	 */
+	struct ForestPatchSimulationComparison
+	{
+		size_t m_sampleCount = 0;
+		float m_maxLightIntensityError = 0.0f;
+		float m_meanLightIntensityError = 0.0f;
+		float m_maxSpaceOccupancyError = 0.0f;
+		/**
+		 * \brief The time to build the environment of all tiles, and of the single grid.
+		 */
+		float m_tiledTime = 0.0f;
+		float m_singleGridTime = 0.0f;
+	};
+
+	/**
+	 * \brief A contribution a tile hands over to one of its neighbours, with the voxel in lattice coordinates.
+	 */
+	struct ForestPatchBoundaryContribution
+	{
+		glm::ivec3 m_coordinate = glm::ivec3(0);
+		float m_shadowIntensity = 0.0f;
+		float m_biomass = 0.0f;
+		/**
+		 * \brief The index of the registration in the buffer of the sending tile, -1 if the internode is not registered.
+		 */
+		int m_registrationIndex = -1;
+	};
+
+	struct ForestPatchSimulationTile
+	{
+		glm::vec2 m_min = glm::vec2(0.0f);
+		glm::vec2 m_max = glm::vec2(0.0f);
+		/**
+		 * \brief The voxels covered by the environment grid of this tile, [min, max) in lattice coordinates.
+		 */
+		glm::ivec3 m_minCoordinate = glm::ivec3(0);
+		glm::ivec3 m_maxCoordinate = glm::ivec3(0);
+		ClimateModel m_climateModel{};
+		std::vector<unsigned> m_treeIndices;
+		/**
+		 * \brief The tiles whose environment grids overlap with the one of this tile.
+		 */
+		std::vector<unsigned> m_neighborTileIndices;
+		EnvironmentGridBuffer m_buffer;
+		/**
+		 * \brief The contributions for each of the neighbours, in the order of m_neighborTileIndices.
+		 */
+		std::vector<std::vector<ForestPatchBoundaryContribution>> m_exports;
+	};
+
+	/**
+	 * \brief Grows the trees of a forest patch without a scene, with the environment split into tiles.
+	 * Every tile keeps its own environment grid that covers the tile, its halo and the trees it owns, all grids share one voxel lattice.
+	 * During a step the tiles only exchange the contributions that fall into each other's grids, then propagate the shadow and grow
+	 * independently. Shadow deposits and node registrations inside a grid are the same as in a single grid (up to the order of the
+	 * floating point sums), so the light and space occupancy a tree samples only misses the shadow that is propagated into the grid
+	 * from outside of it. Propagation spreads a shadow at most 2 voxels sideways per layer with a spread of about 0.6 voxels per layer,
+	 * so the missed part is the tail beyond the halo of a walk with as many steps as there are layers above the sample.
+	 */
+	class ForestPatchSimulator {
+		std::vector<ForestPatchSimulationTree> m_trees;
+		std::vector<ForestPatchSimulationTile> m_tiles;
+		float m_time = 0.0f;
+
+		void UpdateTileGrids();
+		void DepositShadow(unsigned tileIndex);
+		void ReceiveBoundaries(unsigned tileIndex);
+		/**
+		 * Build the environment grids of all tiles from the current trees.
+		 */
+		void PrepareEnvironment();
+	public:
+		ForestPatchSimulationSettings m_settings{};
+		/**
+		 * Partition the trees of the patch into tiles, trees without a tree descriptor are skipped.
+		 * @param forestPatch The patch to simulate.
+		 */
+		void Initialize(const ForestPatch& forestPatch);
+		/**
+		 * Grow all trees for one iteration.
+		 * @param deltaTime The real world time for this iteration.
+		 * @return Whether any of the trees had a structural change.
+		 */
+		bool Step(float deltaTime);
+
+		/**
+		 * Sample the light and the space occupancy at every internode in the grid of its tile and in a single grid that covers
+		 * the whole patch, built the same way as Climate::PrepareForGrowth builds it for the trees of a scene.
+		 * The grids of the tiles are rebuilt from the current trees.
+		 */
+		[[nodiscard]] ForestPatchSimulationComparison CompareWithSingleGrid();
+		/**
+		 * Move the grown trees into the active scene as tree entities, the simulator is empty afterwards.
+		 * @param setParent Whether the trees are grouped under a parent entity.
+		 */
+		void InstantiateTrees(bool setParent);
+
+		[[nodiscard]] float GetTime() const;
+		[[nodiscard]] const std::vector<ForestPatchSimulationTree>& PeekTrees() const;
+		[[nodiscard]] const std::vector<ForestPatchSimulationTile>& PeekTiles() const;
+	};
+}
@@ -5,6 +5,7 @@
 #include "TreeModel.hpp"
 #include "Curve.hpp"
 #include "Octree.hpp"
+#include "BitVoxelGrid.hpp"
 using namespace EvoEngine;
 namespace EcoSysLab {
 	struct RingSegment {
@@ -68,6 +69,10 @@ namespace EcoSysLab {
 
 		bool m_presentationOverride = false;
 		bool m_foliageOverride = false;
+		/**
+		 * Render the foliage as instances of a single leaf instead of one baked mesh.
+		 */
+		bool m_foliageInstancing = false;
 		FoliageParameters m_foliageOverrideSettings = {};
 		PresentationOverrideSettings m_presentationOverrideSettings = {};
 		AssetRef m_foliageAlbedoTexture;
@@ -91,6 +96,10 @@ namespace EcoSysLab {
 		float m_baseControlPointRatio = 0.3f;
 		float m_branchControlPointRatio = 0.3f;
 		bool m_smoothness = true;
+		/**
+		 * Log the time the cylindrical mesh generator takes for each mesh.
+		 */
+		bool m_logCylindricalMeshTime = false;
 
 		bool m_autoLevel = true;
 		int m_voxelSubdivisionLevel = 10;
@@ -142,21 +151,29 @@ namespace EcoSysLab {
 		std::vector<unsigned int>& indices, const TreeMeshGeneratorSettings& settings,
 		const std::function<float(float xFactor, float distanceToRoot)>& func) const {
 		const auto& sortedInternodeList = treeSkeleton.RefSortedNodeList();
-		std::vector<std::vector<RingSegment>> ringsList;
-		std::map<NodeHandle, int> steps{};
-		ringsList.resize(sortedInternodeList.size());
-		std::vector<std::shared_future<void>> results;
-		std::vector<std::vector<std::pair<NodeHandle, int>>> tempSteps{};
-		tempSteps.resize(Jobs::Workers().Size());
-
-		Jobs::ParallelFor(sortedInternodeList.size(), [&](unsigned internodeIndex, unsigned threadIndex) {
+		const int internodeSize = sortedInternodeList.size();
+		const auto handleSize = treeSkeleton.RefRawNodes().size();
+		//Everything that is looked up through the parent is indexed by node handle, the rest by the position in the sorted list.
+		std::vector<int> steps(handleSize, 0);
+		std::vector<int> vertexLastRingStartVertexIndex(handleSize, 0);
+
+		struct InternodeSegment
+		{
+			glm::vec3 m_positionStart;
+			glm::vec3 m_positionEnd;
+			glm::vec3 m_directionStart;
+			glm::vec3 m_directionEnd;
+			float m_thicknessStart;
+			float m_thicknessEnd;
+			int m_amount;
+		};
+		std::vector<InternodeSegment> segments(internodeSize);
+		std::vector<int> ringOffsets(internodeSize + 1, 0);
+		Jobs::ParallelFor(internodeSize, [&](unsigned internodeIndex) {
 			auto internodeHandle = sortedInternodeList[internodeIndex];
 			const auto& internode = treeSkeleton.PeekNode(internodeHandle);
 			const auto& internodeInfo = internode.m_info;
-			
-
-			auto& rings = ringsList[internodeIndex];
-			rings.clear();
+			auto& segment = segments[internodeIndex];
 
 			glm::vec3 directionStart = internodeInfo.m_regulatedGlobalRotation * glm::vec3(0, 0, -1);
 			glm::vec3 directionEnd = directionStart;
@@ -196,10 +213,36 @@ namespace EcoSysLab {
 			if (step % 2 != 0)
 				++step;
 
-			tempSteps[threadIndex].emplace_back(internodeHandle, step);
+			steps[internodeHandle] = step;
 			int amount = glm::max(1, static_cast<int>(glm::distance(positionStart, positionEnd) / (internodeInfo.m_thickness >= settings.m_trunkThickness ? settings.m_trunkYSubdivision : settings.m_branchYSubdivision)));
 			if (amount % 2 != 0)
 				++amount;
+#pragma endregion
+			segment.m_positionStart = positionStart;
+			segment.m_positionEnd = positionEnd;
+			segment.m_directionStart = directionStart;
+			segment.m_directionEnd = directionEnd;
+			segment.m_thicknessStart = thicknessStart;
+			segment.m_thicknessEnd = thicknessEnd;
+			segment.m_amount = amount;
+			ringOffsets[internodeIndex + 1] = amount > 1 ? amount : 1;
+			}
+		);
+		for (int internodeIndex = 0; internodeIndex < internodeSize; internodeIndex++) ringOffsets[internodeIndex + 1] += ringOffsets[internodeIndex];
+
+		//The rings of all internodes live in one buffer, the rings of an internode start at its ring offset.
+		std::vector<RingSegment> rings(ringOffsets[internodeSize]);
+		Jobs::ParallelFor(internodeSize, [&](unsigned internodeIndex) {
+			const auto& internodeInfo = treeSkeleton.PeekNode(sortedInternodeList[internodeIndex]).m_info;
+			const auto& segment = segments[internodeIndex];
+			const auto& positionStart = segment.m_positionStart;
+			const auto& positionEnd = segment.m_positionEnd;
+			const auto& directionStart = segment.m_directionStart;
+			const auto& directionEnd = segment.m_directionEnd;
+			const auto thicknessStart = segment.m_thicknessStart;
+			const auto thicknessEnd = segment.m_thicknessEnd;
+			const auto amount = segment.m_amount;
+			int ringIndexInBuffer = ringOffsets[internodeIndex];
 			BezierCurve curve = BezierCurve(
 				positionStart,
 				positionStart +
@@ -216,14 +259,14 @@ namespace EcoSysLab {
 				float startThickness = static_cast<float>(ringIndex - 1) * radiusStep;
 				float endThickness = static_cast<float>(ringIndex) * radiusStep;
 				if (settings.m_smoothness) {
-					rings.emplace_back(
+					rings[ringIndexInBuffer++] = RingSegment(
 						curve.GetPoint(posStep * (ringIndex - 1)), curve.GetPoint(posStep * ringIndex),
 						directionStart + static_cast<float>(ringIndex - 1) * dirStep,
 						directionStart + static_cast<float>(ringIndex) * dirStep,
 						thicknessStart + startThickness, thicknessStart + endThickness);
 				}
 				else {
-					rings.emplace_back(
+					rings[ringIndexInBuffer++] = RingSegment(
 						curve.GetPoint(posStep * (ringIndex - 1)), curve.GetPoint(posStep * ringIndex),
 						directionEnd,
 						directionEnd,
@@ -231,64 +274,33 @@ namespace EcoSysLab {
 				}
 			}
 			if (amount > 1)
-				rings.emplace_back(
+				rings[ringIndexInBuffer] = RingSegment(
 					curve.GetPoint(1.0f - posStep), positionEnd, directionEnd - dirStep,
 					directionEnd,
 					thicknessEnd - radiusStep,
 					thicknessEnd);
 			else
-				rings.emplace_back(positionStart, positionEnd,
+				rings[ringIndexInBuffer] = RingSegment(positionStart, positionEnd,
 					directionStart, directionEnd, thicknessStart,
 					thicknessEnd);
-#pragma endregion
-			}, results);
-		for (auto& i : results) i.wait();
-
-		for (const auto& list : tempSteps)
-		{
-			for (const auto& element : list)
-			{
-				steps[element.first] = element.second;
-			}
-		}
-
-		std::map<NodeHandle, int> vertexLastRingStartVertexIndex{};
-
-		int nextTreePartIndex = 0;
-		int nextLineIndex = 0;
-		std::unordered_map<NodeHandle, TreePartInfo> treePartInfos{};
-
-		for (int internodeIndex = 0; internodeIndex < sortedInternodeList.size(); internodeIndex++) {
-			auto internodeHandle = sortedInternodeList[internodeIndex];
-			const auto& internode = treeSkeleton.PeekNode(internodeHandle);
-			const auto& internodeInfo = internode.m_info;
-			auto parentInternodeHandle = internode.GetParentHandle();
-			const glm::vec3 up = internodeInfo.m_regulatedGlobalRotation * glm::vec3(0, 1, 0);
-			glm::vec3 parentUp = up;
-			if (parentInternodeHandle != -1)
-			{
-				const auto& parentInternode = treeSkeleton.PeekNode(parentInternodeHandle);
-				parentUp = parentInternode.m_info.m_regulatedGlobalRotation * glm::vec3(0, 1, 0);
-			}
-			auto& rings = ringsList[internodeIndex];
-			if (rings.empty()) {
-				continue;
-			}
-			// For stitching
-			const int step = steps[internodeHandle];
-			int pStep = step;
-			if (parentInternodeHandle != -1)
-			{
-				pStep = steps[parentInternodeHandle];
 			}
-			float angleStep = 360.0f / static_cast<float>(step);
-			float pAngleStep = 360.0f / static_cast<float>(pStep);
-			int vertexIndex = vertices.size();
-			Vertex archetype;
-			const auto flowHandle = internode.GetFlowHandle();
-			archetype.m_vertexInfo1 = internodeHandle + 1;
-			archetype.m_vertexInfo2 = flowHandle + 1;
-			if (settings.m_junctionColor) {
+		);
+
+		//The tree parts are chained from parent to child, so they are assigned in order before the parallel emission.
+		std::vector<int> lineIndices;
+		std::vector<int> treePartIndices;
+		if (settings.m_junctionColor) {
+			lineIndices.resize(internodeSize);
+			treePartIndices.resize(internodeSize);
+			int nextTreePartIndex = 0;
+			int nextLineIndex = 0;
+			std::vector<TreePartInfo> treePartInfos(handleSize);
+			for (int internodeIndex = 0; internodeIndex < internodeSize; internodeIndex++) {
+				auto internodeHandle = sortedInternodeList[internodeIndex];
+				const auto& internode = treeSkeleton.PeekNode(internodeHandle);
+				const auto& internodeInfo = internode.m_info;
+				auto parentInternodeHandle = internode.GetParentHandle();
+				const auto flowHandle = internode.GetFlowHandle();
 #pragma region TreePart
 				const auto& flow = treeSkeleton.PeekFlow(internode.GetFlowHandle());
 				const auto& chainHandles = flow.RefNodeHandles();
@@ -411,16 +423,61 @@ namespace EcoSysLab {
 					}
 					//archetype.m_color = glm::vec4(1, 0, 0, 1);
 				}
-				archetype.m_vertexInfo3 = currentLineIndex + 1;
-				archetype.m_vertexInfo4.x = currentTreePartIndex + 1;
+				lineIndices[internodeIndex] = currentLineIndex;
+				treePartIndices[internodeIndex] = currentTreePartIndex;
 #pragma endregion
 			}
+		}
+
+		//Counting pass: the vertices of every internode are known up front, the root also has the ring at its base.
+		const int vertexStart = vertices.size();
+		std::vector<int> vertexOffsets(internodeSize + 1, vertexStart);
+		for (int internodeIndex = 0; internodeIndex < internodeSize; internodeIndex++) {
+			const auto internodeHandle = sortedInternodeList[internodeIndex];
+			const auto& internode = treeSkeleton.PeekNode(internodeHandle);
+			const int step = steps[internodeHandle];
+			const int pStep = internode.GetParentHandle() != -1 ? steps[internode.GetParentHandle()] : step;
+			const int ringSize = ringOffsets[internodeIndex + 1] - ringOffsets[internodeIndex];
+			vertexOffsets[internodeIndex + 1] = vertexOffsets[internodeIndex] + (internode.GetParentHandle() == -1 ? pStep : 0) + ringSize * step;
+			vertexLastRingStartVertexIndex[internodeHandle] = vertexOffsets[internodeIndex + 1] - step;
+		}
+		vertices.resize(vertexOffsets[internodeSize]);
+
+		Jobs::ParallelFor(internodeSize, [&](unsigned internodeIndex) {
+			auto internodeHandle = sortedInternodeList[internodeIndex];
+			const auto& internode = treeSkeleton.PeekNode(internodeHandle);
+			const auto& internodeInfo = internode.m_info;
+			auto parentInternodeHandle = internode.GetParentHandle();
+			const glm::vec3 up = internodeInfo.m_regulatedGlobalRotation * glm::vec3(0, 1, 0);
+			glm::vec3 parentUp = up;
+			if (parentInternodeHandle != -1)
+			{
+				const auto& parentInternode = treeSkeleton.PeekNode(parentInternodeHandle);
+				parentUp = parentInternode.m_info.m_regulatedGlobalRotation * glm::vec3(0, 1, 0);
+			}
+			const int step = steps[internodeHandle];
+			int pStep = step;
+			if (parentInternodeHandle != -1)
+			{
+				pStep = steps[parentInternodeHandle];
+			}
+			float angleStep = 360.0f / static_cast<float>(step);
+			float pAngleStep = 360.0f / static_cast<float>(pStep);
+			int vertexIndex = vertexOffsets[internodeIndex];
+			Vertex archetype;
+			archetype.m_vertexInfo1 = internodeHandle + 1;
+			archetype.m_vertexInfo2 = internode.GetFlowHandle() + 1;
+			if (settings.m_junctionColor) {
+				archetype.m_vertexInfo3 = lineIndices[internodeIndex] + 1;
+				archetype.m_vertexInfo4.x = treePartIndices[internodeIndex] + 1;
+			}
+			const auto ringStart = ringOffsets[internodeIndex];
 			float textureXStep = 1.0f / pStep * 4.0f;
 			if (parentInternodeHandle == -1) {
 				for (int p = 0; p < pStep; p++) {
 					float xFactor = static_cast<float>(p) / pStep;
 					float yFactor = internodeInfo.m_rootDistance - internodeInfo.m_length;
-					auto& ring = rings.at(0);
+					auto& ring = rings[ringStart];
 					auto direction = ring.GetDirection(
 						parentUp, pAngleStep * p, true);
 					archetype.m_position = ring.m_startPosition + direction * ring.m_startRadius * func(xFactor, yFactor);
@@ -428,55 +485,16 @@ namespace EcoSysLab {
 						p < pStep / 2 ? p * textureXStep : (pStep - p) * textureXStep;
 					archetype.m_texCoord = glm::vec2(x, 0.0f);
 					if (!settings.m_junctionColor) archetype.m_color = internodeInfo.m_color;
-					vertices.push_back(archetype);
-				}
-			}
-			std::vector<float> angles;
-			angles.resize(step);
-			std::vector<float> pAngles;
-			pAngles.resize(pStep);
-
-			for (auto p = 0; p < pStep; p++) {
-				pAngles[p] = pAngleStep * p;
-			}
-			for (auto s = 0; s < step; s++) {
-				angles[s] = angleStep * s;
-			}
-
-			std::vector<unsigned> pTarget;
-			std::vector<unsigned> target;
-			pTarget.resize(pStep);
-			target.resize(step);
-			for (int p = 0; p < pStep; p++) {
-				// First we allocate nearest vertices for parent.
-				auto minAngleDiff = 360.0f;
-				for (auto j = 0; j < step; j++) {
-					const float diff = glm::abs(pAngles[p] - angles[j]);
-					if (diff < minAngleDiff) {
-						minAngleDiff = diff;
-						pTarget[p] = j;
-					}
+					vertices[vertexIndex++] = archetype;
 				}
 			}
-			for (int s = 0; s < step; s++) {
-				// Second we allocate nearest vertices for child
-				float minAngleDiff = 360.0f;
-				for (int j = 0; j < pStep; j++) {
-					const float diff = glm::abs(angles[s] - pAngles[j]);
-					if (diff < minAngleDiff) {
-						minAngleDiff = diff;
-						target[s] = j;
-					}
-				}
-			}
-
 			textureXStep = 1.0f / step * 4.0f;
-			int ringSize = rings.size();
+			int ringSize = ringOffsets[internodeIndex + 1] - ringStart;
 			for (auto ringIndex = 0; ringIndex < ringSize; ringIndex++) {
 				for (auto s = 0; s < step; s++) {
 					float xFactor = static_cast<float>(s) / step;
 					float yFactor = internodeInfo.m_rootDistance - internodeInfo.m_length + (ringIndex + 1) * internodeInfo.m_length / ringSize;
-					auto& ring = rings.at(ringIndex);
+					auto& ring = rings[ringStart + ringIndex];
 					auto direction = ring.GetDirection(
 						up, angleStep * s, false);
 					archetype.m_position = ring.m_endPosition + direction * ring.m_endRadius * func(xFactor, yFactor);
@@ -485,144 +503,102 @@ namespace EcoSysLab {
 					const auto y = ringIndex % 2 == 0 ? 1.0f : 0.0f;
 					archetype.m_texCoord = glm::vec2(x, y);
 					if (!settings.m_junctionColor) archetype.m_color = internodeInfo.m_color;
-					vertices.push_back(archetype);
+					vertices[vertexIndex++] = archetype;
 				}
-				if (ringIndex == 0)
+			}
+			}
+		);
+
+		//The triangles of an internode only read vertices, so they are visited twice: once to count, once to write.
+		const auto forEachTriangle = [&](const int internodeIndex, auto&& emit)
+			{
+				const auto internodeHandle = sortedInternodeList[internodeIndex];
+				const auto parentInternodeHandle = treeSkeleton.PeekNode(internodeHandle).GetParentHandle();
+				const auto addTriangle = [&](const unsigned a, const unsigned b, const unsigned c)
+					{
+						if (vertices[a].m_position != vertices[b].m_position
+							&& vertices[b].m_position != vertices[c].m_position
+							&& vertices[a].m_position != vertices[c].m_position) {
+							emit(a, b, c);
+						}
+					};
+				// For stitching
+				const int step = steps[internodeHandle];
+				int pStep = step;
+				if (parentInternodeHandle != -1)
 				{
-					if (parentInternodeHandle != -1) {
-						int parentLastRingStartVertexIndex = vertexLastRingStartVertexIndex[parentInternodeHandle];
-						for (int p = 0; p < pStep; p++) {
-							if (pTarget[p] == pTarget[p == pStep - 1 ? 0 : p + 1]) {
-								auto a = parentLastRingStartVertexIndex + p;
-								auto b = parentLastRingStartVertexIndex + (p == pStep - 1 ? 0 : p + 1);
-								auto c = vertexIndex + pTarget[p];
-								if (vertices[a].m_position != vertices[b].m_position
-									&& vertices[b].m_position != vertices[c].m_position
-									&& vertices[a].m_position != vertices[c].m_position) {
-									indices.push_back(a);
-									indices.push_back(b);
-									indices.push_back(c);
-								}
-							}
-							else {
-								auto a = parentLastRingStartVertexIndex + p;
-								auto b = parentLastRingStartVertexIndex + (p == pStep - 1 ? 0 : p + 1);
-								auto c = vertexIndex + pTarget[p];
-								if (vertices[a].m_position != vertices[b].m_position
-									&& vertices[b].m_position != vertices[c].m_position
-									&& vertices[a].m_position != vertices[c].m_position) {
-									indices.push_back(a);
-									indices.push_back(b);
-									indices.push_back(c);
-								}
-								a = vertexIndex + pTarget[p == pStep - 1 ? 0 : p + 1];
-								b = vertexIndex + pTarget[p];
-								c = parentLastRingStartVertexIndex + (p == pStep - 1 ? 0 : p + 1);
-								if (vertices[a].m_position != vertices[b].m_position
-									&& vertices[b].m_position != vertices[c].m_position
-									&& vertices[a].m_position != vertices[c].m_position) {
-									indices.push_back(a);
-									indices.push_back(b);
-									indices.push_back(c);
-								}
+					pStep = steps[parentInternodeHandle];
+				}
+				const float angleStep = 360.0f / static_cast<float>(step);
+				const float pAngleStep = 360.0f / static_cast<float>(pStep);
+				const auto pTarget = [&](const int p)
+					{
+						// We allocate nearest vertices for parent.
+						unsigned target = 0;
+						auto minAngleDiff = 360.0f;
+						const float pAngle = pAngleStep * p;
+						for (auto j = 0; j < step; j++) {
+							const float diff = glm::abs(pAngle - angleStep * j);
+							if (diff < minAngleDiff) {
+								minAngleDiff = diff;
+								target = j;
 							}
 						}
-					}
-					else
+						return target;
+					};
+				int vertexIndex = vertexOffsets[internodeIndex];
+				const int ringSize = ringOffsets[internodeIndex + 1] - ringOffsets[internodeIndex];
+				for (auto ringIndex = 0; ringIndex < ringSize; ringIndex++) {
+					if (ringIndex == 0)
 					{
+						const int lastRingStart = parentInternodeHandle != -1 ? vertexLastRingStartVertexIndex[parentInternodeHandle] : vertexIndex;
+						const int ringStart = parentInternodeHandle != -1 ? vertexIndex : vertexIndex + pStep;
 						for (int p = 0; p < pStep; p++) {
-							if (pTarget[p] == pTarget[p == pStep - 1 ? 0 : p + 1]) {
-								auto a = vertexIndex + p;
-								auto b = vertexIndex + (p == pStep - 1 ? 0 : p + 1);
-								auto c = vertexIndex + pStep + pTarget[p];
-								if (vertices[a].m_position != vertices[b].m_position
-									&& vertices[b].m_position != vertices[c].m_position
-									&& vertices[a].m_position != vertices[c].m_position) {
-									indices.push_back(a);
-									indices.push_back(b);
-									indices.push_back(c);
-								}
-							}
-							else {
-								auto a = vertexIndex + p;
-								auto b = vertexIndex + (p == pStep - 1 ? 0 : p + 1);
-								auto c = vertexIndex + pStep + pTarget[p];
-								if (vertices[a].m_position != vertices[b].m_position
-									&& vertices[b].m_position != vertices[c].m_position
-									&& vertices[a].m_position != vertices[c].m_position) {
-									indices.push_back(a);
-									indices.push_back(b);
-									indices.push_back(c);
-								}
-								a = vertexIndex + pStep + pTarget[p == pStep - 1 ? 0 : p + 1];
-								b = vertexIndex + pStep + pTarget[p];
-								c = vertexIndex + (p == pStep - 1 ? 0 : p + 1);
-
-								if (vertices[a].m_position != vertices[b].m_position
-									&& vertices[b].m_position != vertices[c].m_position
-									&& vertices[a].m_position != vertices[c].m_position) {
-									indices.push_back(a);
-									indices.push_back(b);
-									indices.push_back(c);
-								}
+							const int nextP = p == pStep - 1 ? 0 : p + 1;
+							const auto target = pTarget(p);
+							const auto nextTarget = pTarget(nextP);
+							addTriangle(lastRingStart + p, lastRingStart + nextP, ringStart + target);
+							if (target != nextTarget) {
+								addTriangle(ringStart + nextTarget, ringStart + target, lastRingStart + nextP);
 							}
 						}
+						if (parentInternodeHandle == -1) vertexIndex += pStep;
 					}
-					if (parentInternodeHandle == -1) vertexIndex += pStep;
-				}
-				else {
-					for (int s = 0; s < step - 1; s++) {
-						// Down triangle
-						auto a = vertexIndex + (ringIndex - 1) * step + s;
-						auto b = vertexIndex + (ringIndex - 1) * step + s + 1;
-						auto c = vertexIndex + ringIndex * step + s;
-						if (vertices[a].m_position != vertices[b].m_position
-							&& vertices[b].m_position != vertices[c].m_position
-							&& vertices[a].m_position != vertices[c].m_position) {
-							indices.push_back(a);
-							indices.push_back(b);
-							indices.push_back(c);
+					else {
+						for (int s = 0; s < step - 1; s++) {
+							// Down triangle
+							addTriangle(vertexIndex + (ringIndex - 1) * step + s, vertexIndex + (ringIndex - 1) * step + s + 1, vertexIndex + ringIndex * step + s);
+							// Up triangle
+							addTriangle(vertexIndex + ringIndex * step + s + 1, vertexIndex + ringIndex * step + s, vertexIndex + (ringIndex - 1) * step + s + 1);
 						}
-
-
+						// Down triangle
+						addTriangle(vertexIndex + (ringIndex - 1) * step + step - 1, vertexIndex + (ringIndex - 1) * step, vertexIndex + ringIndex * step + step - 1);
 						// Up triangle
-						a = vertexIndex + ringIndex * step + s + 1;
-						b = vertexIndex + ringIndex * step + s;
-						c = vertexIndex + (ringIndex - 1) * step + s + 1;
-						if (vertices[a].m_position != vertices[b].m_position
-							&& vertices[b].m_position != vertices[c].m_position
-							&& vertices[a].m_position != vertices[c].m_position) {
-							indices.push_back(a);
-							indices.push_back(b);
-							indices.push_back(c);
-						}
-					}
-					// Down triangle
-					auto a = vertexIndex + (ringIndex - 1) * step + step - 1;
-					auto b = vertexIndex + (ringIndex - 1) * step;
-					auto c = vertexIndex + ringIndex * step + step - 1;
-					if (vertices[a].m_position != vertices[b].m_position
-						&& vertices[b].m_position != vertices[c].m_position
-						&& vertices[a].m_position != vertices[c].m_position) {
-						indices.push_back(a);
-						indices.push_back(b);
-						indices.push_back(c);
-					}
-					// Up triangle
-					a = vertexIndex + ringIndex * step;
-					b = vertexIndex + ringIndex * step + step - 1;
-					c = vertexIndex + (ringIndex - 1) * step;
-					if (vertices[a].m_position != vertices[b].m_position
-						&& vertices[b].m_position != vertices[c].m_position
-						&& vertices[a].m_position != vertices[c].m_position) {
-						indices.push_back(a);
-						indices.push_back(b);
-						indices.push_back(c);
+						addTriangle(vertexIndex + ringIndex * step, vertexIndex + ringIndex * step + step - 1, vertexIndex + (ringIndex - 1) * step);
 					}
 				}
+			};
+		std::vector<unsigned> indexOffsets(internodeSize + 1, 0);
+		Jobs::ParallelFor(internodeSize, [&](unsigned internodeIndex) {
+			unsigned triangleSize = 0;
+			forEachTriangle(internodeIndex, [&](unsigned, unsigned, unsigned) { triangleSize++; });
+			indexOffsets[internodeIndex + 1] = triangleSize * 3;
 			}
-			vertexLastRingStartVertexIndex[internodeHandle] = vertices.size() - step;
-		}
+		);
+		indexOffsets[0] = indices.size();
+		for (int internodeIndex = 0; internodeIndex < internodeSize; internodeIndex++) indexOffsets[internodeIndex + 1] += indexOffsets[internodeIndex];
+		indices.resize(indexOffsets[internodeSize]);
+		Jobs::ParallelFor(internodeSize, [&](unsigned internodeIndex) {
+			auto index = indexOffsets[internodeIndex];
+			forEachTriangle(internodeIndex, [&](const unsigned a, const unsigned b, const unsigned c)
+				{
+					indices[index] = a;
+					indices[index + 1] = b;
+					indices[index + 2] = c;
+					index += 3;
+				});
+			}
+		);
 	}
 
 	template <typename SkeletonData, typename FlowData, typename NodeData>
@@ -631,7 +607,8 @@ namespace EcoSysLab {
 		std::vector<unsigned>& indices, const TreeMeshGeneratorSettings& settings) const
 	{
 		const auto boxSize = treeSkeleton.m_max - treeSkeleton.m_min;
-		Octree<bool> octree;
+		//The voxels are as large as the smallest cells of an octree that covers the tree with the requested subdivision level.
+		float voxelSize;
 		if (settings.m_autoLevel)
 		{
 			const float maxRadius = glm::max(glm::max(boxSize.x, boxSize.y), boxSize.z) * 0.5f + 2.0f * settings.m_marchingCubeRadius;
@@ -643,25 +620,36 @@ namespace EcoSysLab {
 				testRadius *= 2.f;
 			}
 			EVOENGINE_LOG("Mesh formation: Auto set level to " + std::to_string(subdivisionLevel))
-
-				octree.Reset(maxRadius, subdivisionLevel, (treeSkeleton.m_min + treeSkeleton.m_max) * 0.5f);
+			voxelSize = maxRadius / glm::pow(2.0f, static_cast<float>(glm::max(subdivisionLevel, 0)));
 		}
 		else {
-			octree.Reset(glm::max((boxSize.x, boxSize.y), glm::max(boxSize.y, boxSize.z)) * 0.5f,
-				glm::clamp(settings.m_voxelSubdivisionLevel, 4, 16), (treeSkeleton.m_min + treeSkeleton.m_max) / 2.0f);
+			voxelSize = glm::max(glm::max(boxSize.x, boxSize.y), boxSize.z) * 0.5f
+				/ glm::pow(2.0f, static_cast<float>(glm::clamp(settings.m_voxelSubdivisionLevel, 4, 16)));
 		}
-		auto& nodeList = treeSkeleton.RefSortedNodeList();
-		for (const auto& nodeIndex : nodeList)
+		voxelSize = glm::max(voxelSize, 1e-5f);
+		const auto& nodeList = treeSkeleton.RefSortedNodeList();
+		std::vector<glm::vec3> starts(nodeList.size());
+		std::vector<glm::vec3> ends(nodeList.size());
+		std::vector<float> radii(nodeList.size());
+		float maxThickness = 0.0f;
+		for (int i = 0; i < nodeList.size(); i++)
 		{
-			const auto& node = treeSkeleton.PeekNode(nodeIndex);
+			const auto& node = treeSkeleton.PeekNode(nodeList[i]);
 			const auto& info = node.m_info;
 			auto thickness = info.m_thickness;
 			if (node.GetParentHandle() > 0)
 			{
 				thickness = (thickness + treeSkeleton.PeekNode(node.GetParentHandle()).m_info.m_thickness) / 2.0f;
 			}
-			octree.Occupy(info.m_globalPosition, info.m_globalRotation, info.m_length, thickness, [](OctreeNode&) {});
+			starts[i] = info.m_globalPosition;
+			ends[i] = info.GetGlobalEndPosition();
+			radii[i] = thickness;
+			maxThickness = glm::max(maxThickness, thickness);
 		}
-		octree.TriangulateField(vertices, indices, settings.m_removeDuplicate);
+		BitVoxelGrid voxelGrid;
+		const auto padding = glm::vec3(maxThickness + 2.0f * voxelSize);
+		voxelGrid.Initialize(voxelSize, treeSkeleton.m_min - padding, treeSkeleton.m_max + padding);
+		voxelGrid.RasterizeCapsules(starts, ends, radii);
+		voxelGrid.Triangulate(vertices, indices, settings.m_removeDuplicate);
 	}
 }
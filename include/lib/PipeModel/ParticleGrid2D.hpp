@@ -30,7 +30,7 @@ namespace EcoSysLab {
 		template<typename PD>
 		friend class PipeProfile;
 	public:
-		void ApplyBoundaries(const ProfileConstraints& profileBoundaries);
+		void ApplyBoundaries(const ProfileConstraints& profileBoundaries, bool parallel = false);
 		ParticleGrid2D() = default;
 		void Reset(float cellSize, const glm::vec2& minBound, const glm::ivec2& resolution);
 		void Reset(float cellSize, const glm::vec2& minBound, const glm::vec2& maxBound);
@@ -31,4 +31,48 @@ namespace EcoSysLab
 		[[nodiscard]] bool Valid(size_t boundaryIndex) const;
 		[[nodiscard]] glm::vec2 GetTarget(const glm::vec2& position) const;
 	};
+
+	/**
+	 * Profile constraints flattened for repeated queries over a grid. Boundaries become polygons with bounding boxes,
+	 * whose edges are binned into horizontal rows so the inside test only visits the edges crossing the query row.
+	 * For valid (non-self-intersecting) boundaries, GetTarget matches ProfileConstraints::GetTarget.
+	 */
+	class CompiledProfileConstraints
+	{
+		struct Edge
+		{
+			glm::vec2 m_p1;
+			glm::vec2 m_p2;
+			glm::vec2 m_min;
+			glm::vec2 m_max;
+		};
+		struct Polygon
+		{
+			glm::vec2 m_min = glm::vec2(FLT_MAX);
+			glm::vec2 m_max = glm::vec2(-FLT_MAX);
+			glm::vec2 m_center = glm::vec2(0.0f);
+			unsigned m_edgeOffset = 0;
+			unsigned m_edgeSize = 0;
+			unsigned m_binOffset = 0;
+			unsigned m_binSize = 0;
+			float m_binHeight = 1.0f;
+		};
+		struct AttractorSegment
+		{
+			glm::vec2 m_p1;
+			glm::vec2 m_p2;
+			//An empty attractor only offers the origin.
+			bool m_point = false;
+		};
+		std::vector<Edge> m_edges{};
+		std::vector<Polygon> m_polygons{};
+		//Edges of each row bin, stored as ranges of m_binEdges.
+		std::vector<unsigned> m_binOffsets{};
+		std::vector<unsigned> m_binEdges{};
+		std::vector<AttractorSegment> m_attractorSegments{};
+		[[nodiscard]] bool InPolygon(const Polygon& polygon, const glm::vec2& position) const;
+	public:
+		void Compile(const ProfileConstraints& profileConstraints);
+		[[nodiscard]] glm::vec2 GetTarget(const glm::vec2& position) const;
+	};
 }
\ No newline at end of file
@@ -96,12 +96,39 @@ namespace EcoSysLab
 		void SplitRootTestSetup();
 
 		void FixedUpdate() override;
-		Entity GenerateSurfaceQuadX(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor);
-		Entity GenerateSurfaceQuadZ(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor);
-
-		Entity GenerateCutOut(float xDepth, float zDepth, float waterFactor, float nutrientFactor, bool groundSurface);
-		Entity GenerateFullBox(float waterFactor, float nutrientFactor, bool groundSurface);
+		Entity GenerateSurfaceQuadX(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor, int textureLevel = 0);
+		Entity GenerateSurfaceQuadZ(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor, int textureLevel = 0);
+
+		Entity GenerateCutOut(float xDepth, float zDepth, float waterFactor, float nutrientFactor, bool groundSurface, int textureLevel = 0);
+		/**
+		 * Update the cut-out that is attached to this entity, or create it if there is none.
+		 * The slices whose cut position, range and texture settings did not change are kept, and the textures of the others
+		 * are cut from the layers the soil model has cached, so moving the cut only samples the newly exposed layer.
+		 */
+		Entity UpdateCutOut(float xDepth, float zDepth, float waterFactor, float nutrientFactor, bool groundSurface, int textureLevel = 0);
+		Entity GenerateFullBox(float waterFactor, float nutrientFactor, bool groundSurface, int textureLevel = 0);
 	private:
+		struct CutOutQuad
+		{
+			bool m_xAxis = false;
+			bool m_backFacing = false;
+			float m_depth = 0.0f;
+			glm::vec2 m_min = glm::vec2(0.0f);
+			glm::vec2 m_max = glm::vec2(1.0f);
+			Entity m_entity;
+		};
+		[[nodiscard]] static std::vector<CutOutQuad> GetCutOutQuads(float xDepth, float zDepth);
+		Entity GenerateSurfaceQuad(const CutOutQuad& quad, float waterFactor, float nutrientFactor, int textureLevel);
+		void GenerateGroundSurface(float xDepth, float zDepth);
+
+		Entity m_cutOutEntity;
+		std::vector<CutOutQuad> m_cutOutQuads;
+		float m_cutOutWaterFactor = 0.0f;
+		float m_cutOutNutrientFactor = 0.0f;
+		int m_cutOutTextureLevel = 0;
+		int m_cutOutSoilVersion = -1;
+		bool m_cutOutGroundSurface = false;
+		glm::vec2 m_cutOutGroundDepth = glm::vec2(-1.0f);
 		// member variables to avoid static variables (in case of multiple Soil instances?)
 		bool m_autoStep = false;
 		bool m_irrigation = true;
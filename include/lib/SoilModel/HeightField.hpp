@@ -9,12 +9,57 @@ using namespace EvoEngine;
 
 namespace EcoSysLab
 {
+	struct HeightFieldLevel
+	{
+		glm::vec2 m_origin = glm::vec2(0.0f);
+		float m_cellSize = 1.0f;
+		glm::ivec2 m_resolution = glm::ivec2(0);
+		std::vector<float> m_heights;
+		[[nodiscard]] float Fetch(int x, int y) const;
+	};
+
+	/**
+	 * The samples of one bake, a chain of levels with the finest first. The fingerprint of the noise it was baked from
+	 * tells whether it is still valid.
+	 */
+	struct HeightFieldBake
+	{
+		size_t m_fingerprint = 0;
+		std::vector<HeightFieldLevel> m_levels;
+	};
+
 	class HeightField : public IAsset
 	{
+		/**
+		 * One bake per cell size, so users baking at different resolutions do not overwrite each other.
+		 */
+		std::vector<HeightFieldBake> m_bakes;
+		[[nodiscard]] size_t GetNoiseFingerprint() const;
+		[[nodiscard]] const HeightFieldBake* FindBake(float cellSize) const;
 	public:
 		Noises2D m_noises2D;
 		int m_precisionLevel = 2;
-		[[nodiscard]] float GetValue(const glm::vec2& position);
+		[[nodiscard]] float GetValue(const glm::vec2& position) const;
+		/**
+		 * Bake the height over a rectangle into a grid of samples, with a chain of half resolution levels.
+		 * Each cell size has its own bake. Baking the same rectangle again is free unless the noise has changed since.
+		 * @param min The position of the first sample.
+		 * @param max The rectangle to cover.
+		 * @param cellSize The distance between samples on the finest level, the key of the bake.
+		 * @param levelCount The number of levels, including the finest.
+		 */
+		void Bake(const glm::vec2& min, const glm::vec2& max, float cellSize, int levelCount = 1);
+		void InvalidateCache();
+		/**
+		 * Interpolate the bake of the cell size. On a sample position of the finest level this is the exact height.
+		 * Falls back to GetValue outside the baked rectangle, without a bake of the cell size, or when the noise has changed
+		 * since the bake. Use GetValue where the exact height between samples matters, such as placing objects on the terrain.
+		 * @param position The position to sample.
+		 * @param cellSize The cell size the bake was made with.
+		 * @param level The level to sample from, 0 is the finest.
+		 * @param bicubic Use Catmull-Rom interpolation instead of bilinear.
+		 */
+		[[nodiscard]] float Sample(const glm::vec2& position, float cellSize, int level = 0, bool bicubic = false) const;
 
 		void OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) override;
 		void Serialize(YAML::Emitter& out) override;
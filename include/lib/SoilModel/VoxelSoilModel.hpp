@@ -30,6 +30,15 @@ namespace EcoSysLab {
 		std::vector<float> m_height_map;
 	};
 
+	struct SoilPhysicalProperties
+	{
+		std::vector<float> m_c;
+		std::vector<float> m_p;
+		std::vector<float> m_d;
+		std::vector<float> m_n;
+		std::vector<float> m_w;
+	};
+
 	struct SoilPhysicalMaterial
 	{
 		int m_id = -1;
@@ -39,6 +48,10 @@ namespace EcoSysLab {
 
 		std::function<float(const glm::vec3& position)> m_n; // initial amount of nutrients
 		std::function<float(const glm::vec3& position)> m_w; // initial amount of water
+		/**
+		 * Optional batched form of the functions above. When set, it fills all five properties for a slab of voxel positions at once.
+		 */
+		std::function<void(const std::vector<glm::vec3>& positions, SoilPhysicalProperties& properties)> m_batch;
 		std::shared_ptr<SoilMaterialTexture> m_soilMaterialTexture;
 	};
 
@@ -108,6 +121,8 @@ namespace EcoSysLab {
 		[[nodiscard]] bool CoordinateInsideVolume(const glm::ivec3& coordinate) const;
 		[[nodiscard]] bool Initialized() const;
 
+		// The slices are cut from whole layers of the volume that are cached per layer, see SoilTextureSlice.
+		// level n samples every 2^n-th texel of the material textures, which is used for quick previews.
 		void GetSoilTextureSlideZ(bool backFacing, float z, const glm::vec2 &xyMin, const glm::vec2 &xyMax,
 			std::vector<glm::vec4> &albedoData,
 			std::vector<glm::vec3> &normalData,
@@ -115,7 +130,7 @@ namespace EcoSysLab {
 			std::vector<float> &metallicData,
 			glm::ivec2& outputResolution
 			, float waterFactor, float nutrientFactor,
-			float blur_width=1); // the output as well as all input textures must have the same resolution!
+			float blur_width=1, int level=0); // the output as well as all input textures must have the same resolution!
 		void GetSoilTextureSlideX(bool backFacing, float x, const glm::vec2& yzMin, const glm::vec2& yzMax,
 			std::vector<glm::vec4> &albedoData,
 			std::vector<glm::vec3> &normalData,
@@ -123,13 +138,16 @@ namespace EcoSysLab {
 			std::vector<float> &metallicData,
 			glm::ivec2& outputResolution
 			, float waterFactor, float nutrientFactor,
-			float blur_width=1); // the output as well as all input textures must have the same resolution!
+			float blur_width=1, int level=0); // the output as well as all input textures must have the same resolution!
 		
 		void GetSoilTextureColorForPosition(const glm::vec3& position, int texture_idx, float blur_width,
 			glm::vec4& albedo,
 			glm::vec3& normal,
 			float &roughness,
-			float &metallic, float waterFactor, float nutrientFactor);
+			float &metallic, float waterFactor, float nutrientFactor) const;
+
+		int m_maxCachedTextureSlices = 8; // how many layers GetSoilTextureSlideX/Z keep around
+		void ClearTextureSlices();
 
 
 		int m_version = 0; // TODO: what does this do?
@@ -249,6 +267,33 @@ namespace EcoSysLab {
 		glm::ivec2 m_materialTextureResolution = { 128, 128 };
 		std::vector<SoilLayer> m_soilLayers;
 		SoilSurface m_soilSurface;
+
+		// The texture of one whole voxel layer, perpendicular to the x (m_axis = 0) or the z axis (m_axis = 2).
+		struct SoilTextureSlice
+		{
+			int m_axis = 0;
+			int m_layer = 0;
+			int m_level = 0;
+			float m_waterFactor = 0.f;
+			float m_nutrientFactor = 0.f;
+			float m_blurWidth = 1.f;
+			int m_version = -1; // m_version of the model when the slice was generated
+			glm::ivec2 m_resolution = glm::ivec2(0);
+			std::vector<glm::vec4> m_albedo;
+			std::vector<glm::vec3> m_normal;
+			std::vector<float> m_roughness;
+			std::vector<float> m_metallic;
+		};
+		std::vector<SoilTextureSlice> m_textureSlices; // least recently used first
+
+		const SoilTextureSlice& GetTextureSlice(int axis, int layer, int level, float waterFactor, float nutrientFactor, float blur_width);
+		void GenerateTextureSlice(SoilTextureSlice& slice) const;
+		void CopyTextureSlice(const SoilTextureSlice& slice, bool backFacing, const glm::vec2& rangeMin, const glm::vec2& rangeMax,
+			std::vector<glm::vec4>& albedoData,
+			std::vector<glm::vec3>& normalData,
+			std::vector<float>& roughnessData,
+			std::vector<float>& metallicData,
+			glm::ivec2& outputResolution) const;
 	};
 
 
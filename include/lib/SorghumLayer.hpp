@@ -5,6 +5,7 @@
 #include "ILayer.hpp"
 #include "PointCloud.hpp"
 #include "SorghumField.hpp"
+#include "CanopyIlluminationEstimator.hpp"
 #include <Curve.hpp>
 #include <LeafSegment.hpp>
 #include <Spline.hpp>
@@ -19,6 +20,20 @@ namespace EcoSysLab {
 	struct StemGeometryTag : IDataComponent {};
 	struct SorghumTag : IDataComponent {};
 	class SorghumStateGenerator;
+	class PARSensorGroup;
+
+	struct SorghumIlluminationResult {
+		Entity m_plant;
+		/**
+		 * The range of the triangles of the plant in the triangle irradiances.
+		 */
+		size_t m_triangleStart = 0;
+		size_t m_triangleSize = 0;
+		/**
+		 * The PAR absorbed by the whole plant, the irradiance of its triangles times their area.
+		 */
+		float m_absorbedPAR = 0.0f;
+	};
 
 
 
@@ -44,6 +59,22 @@ namespace EcoSysLab {
 
 #pragma endregion
 #endif
+#pragma region CPU Illumination
+		CanopyIlluminationSettings m_canopyIlluminationSettings{};
+		AssetRef m_skyIlluminance;
+		float m_skyIlluminanceTime = 0.0f;
+		std::vector<SorghumIlluminationResult> m_canopyIlluminationResults;
+		/**
+		 * The PAR of every triangle of the last CPU estimation, the plants index into it by their result.
+		 */
+		std::vector<float> m_canopyTriangleIrradiances;
+		float m_canopyIlluminationTime = 0.0f;
+		/**
+		 * Estimate the PAR of all sorghums in the scene at once on the CPU, using the sky illuminance at the set time.
+		 * @param sensorGroup Optional sensors that are estimated within the same canopy.
+		 */
+		void CalculateIlluminationCpu(const std::shared_ptr<PARSensorGroup>& sensorGroup = nullptr);
+#pragma endregion
 
 		bool m_bottomFace = true;
 		bool m_separated = false;
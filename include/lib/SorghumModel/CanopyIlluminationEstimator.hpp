@@ -0,0 +1,87 @@
+#pragma once
+#include "SkyIlluminance.hpp"
+
+using namespace EvoEngine;
+namespace EcoSysLab {
+struct CanopyIlluminationSettings {
+  /**
+   * The sky hemisphere of every receiver is split into this many strata along each axis, with one sample in each.
+   */
+  int m_skySampleResolution = 8;
+  /**
+   * The share of the global horizontal irradiance that arrives as diffuse light from a uniform sky, the rest comes from the sun.
+   */
+  float m_diffuseFraction = 0.3f;
+  /**
+   * The share of the irradiance that falls into the photosynthetically active band.
+   */
+  float m_parFraction = 0.45f;
+  float m_pushNormalDistance = 0.001f;
+  unsigned m_seed = 0;
+  bool OnInspect();
+};
+
+struct CanopyIrradiance {
+  float m_energy = 0.0f;
+  /**
+   * The irradiance weighted direction towards the light that reaches the receiver.
+   */
+  glm::vec3 m_direction = glm::vec3(0.0f);
+};
+
+/**
+ * \brief Estimates the PAR received by the triangles of a canopy and by free sensors on the CPU.
+ * The triangles are kept in a bounding volume hierarchy and every receiver traces shadow rays towards the sun and towards
+ * stratified, cosine weighted samples of the sky hemisphere around its normal. The ground blocks all light from below the horizon.
+ */
+class CanopyIlluminationEstimator {
+  struct BvhNode {
+    glm::vec3 m_min = glm::vec3(0.0f);
+    /**
+     * The first triangle of a leaf, the index of the second child of an inner node.
+     */
+    unsigned m_start = 0;
+    glm::vec3 m_max = glm::vec3(0.0f);
+    /**
+     * The amount of triangles of a leaf, 0 for inner nodes whose first child follows right after them.
+     */
+    unsigned m_count = 0;
+  };
+  std::vector<glm::vec3> m_positions;
+  std::vector<glm::uvec3> m_triangles;
+  std::vector<unsigned> m_triangleIndices;
+  std::vector<BvhNode> m_nodes;
+
+  unsigned BuildNode(unsigned start, unsigned count, const std::vector<glm::vec3> &centroids);
+  [[nodiscard]] bool IsOccluded(const glm::vec3 &origin, const glm::vec3 &direction, int ignoredTriangle) const;
+  [[nodiscard]] CanopyIrradiance EstimateHemisphere(const glm::vec3 &position, const glm::vec3 &normal, int ignoredTriangle,
+                                                    const CanopyIlluminationSettings &settings,
+                                                    const glm::vec3 &sunDirection, float ghi, unsigned sampleSeed) const;
+
+public:
+  /**
+   * Build the hierarchy over the triangles, the positions are in world space.
+   */
+  void Build(const std::vector<glm::vec3> &positions, const std::vector<glm::uvec3> &triangles);
+  /**
+   * Estimate the PAR of every triangle, as the sum of the irradiance received by its two faces.
+   * @param settings The sampling settings.
+   * @param snapshot The sky at the time of the estimation.
+   * @param irradiances The PAR of every triangle, in the order the triangles are given to Build.
+   */
+  void EstimateTriangles(const CanopyIlluminationSettings &settings, const SkyIlluminanceSnapshot &snapshot,
+                         std::vector<float> &irradiances) const;
+  /**
+   * Estimate the PAR received by sensors that are not part of the canopy.
+   * @param positions The positions of the sensors.
+   * @param normals The directions the sensors face.
+   * @param settings The sampling settings.
+   * @param snapshot The sky at the time of the estimation.
+   * @param irradiances The result for every sensor.
+   */
+  void EstimatePoints(const std::vector<glm::vec3> &positions, const std::vector<glm::vec3> &normals,
+                      const CanopyIlluminationSettings &settings, const SkyIlluminanceSnapshot &snapshot,
+                      std::vector<CanopyIrradiance> &irradiances) const;
+  [[nodiscard]] size_t GetTriangleSize() const;
+};
+} // namespace EcoSysLab
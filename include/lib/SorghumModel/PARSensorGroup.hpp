@@ -1,16 +1,32 @@
 #pragma once
 #ifdef BUILD_WITH_RAYTRACER
-
 #include <CUDAModule.hpp>
+#endif
+#include "CanopyIlluminationEstimator.hpp"
 using namespace EvoEngine;
 namespace EcoSysLab {
+struct PARSensor {
+  glm::vec3 m_position = glm::vec3(0.0f);
+  glm::vec3 m_normal = glm::vec3(0, 1, 0);
+  float m_energy = 0.0f;
+  glm::vec3 m_direction = glm::vec3(0.0f);
+};
 class PARSensorGroup : public IAsset {
 public:
-  std::vector<IlluminationSampler<glm::vec3>> m_samplers;
+  std::vector<PARSensor> m_sensors;
+#ifdef BUILD_WITH_RAYTRACER
   void CalculateIllumination(const RayProperties& rayProperties, int seed, float pushNormalDistance);
+#endif
+  /**
+   * Estimate the illumination of the sensors on the CPU.
+   * @param estimator The estimator that holds the canopy.
+   * @param settings The sampling settings.
+   * @param snapshot The sky at the time of the estimation.
+   */
+  void CalculateIllumination(const CanopyIlluminationEstimator &estimator, const CanopyIlluminationSettings &settings,
+                             const SkyIlluminanceSnapshot &snapshot);
   void OnInspect(const std::shared_ptr<EditorLayer>& editorLayer);
   void Serialize(YAML::Emitter &out) override;
   void Deserialize(const YAML::Node &in) override;
 };
 } // namespace EcoSysLab
-#endif
\ No newline at end of file
@@ -9,7 +9,10 @@ class PanicleData : public IPrivateComponent {
 public:
   std::vector<Vertex> m_vertices;
   std::vector<glm::uvec3> m_triangles;
-  void FormPanicle(const SorghumStatePair & sorghumStatePair);
+  /**
+   * Scatter the seeds of the panicle, the same state and seed always give the same panicle.
+   */
+  void FormPanicle(const SorghumStatePair & sorghumStatePair, unsigned seed);
   void OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) override;
   void OnDestroy() override;
   void Serialize(YAML::Emitter &out) override;
@@ -88,7 +88,17 @@ struct SorghumStatePair {
 class ProceduralSorghum : public IAsset {
   unsigned m_version = 0;
   friend class SorghumData;
+  /**
+   * The states sorted by their time.
+   */
   std::vector<std::pair<float, SorghumState>> m_sorghumStates;
+  void SortStates();
+  /**
+   * Find the index of the first state after the time.
+   * @param time The time to look up.
+   * @param cursor The result of the previous query, checked before searching and updated to the result.
+   */
+  [[nodiscard]] size_t UpperBound(float time, size_t &cursor) const;
 
 public:
   int m_mode = (int)StateMode::Default;
@@ -100,6 +110,18 @@ public:
   void ResetTime(float previousTime, float newTime);
   void Remove(float time);
   [[nodiscard]] SorghumStatePair Get(float time) const;
+  /**
+   * Interpolate the states at the time into existing storage, so the leaves of the pair are reused.
+   * @param time The time to look up.
+   * @param statePair The pair to write into.
+   * @param cursor The cursor of the caller, for time that moves monotonically the lookup takes constant time.
+   */
+  void Get(float time, SorghumStatePair &statePair, size_t &cursor) const;
+  /**
+   * Time the lookups across the animation against the linear scan they replaced, and check that both give the same states.
+   * @param queryCount The amount of evenly spaced queries, made from start to end.
+   */
+  void BenchmarkGet(int queryCount) const;
 
   void OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) override;
   void Serialize(YAML::Emitter &out) override;
@@ -10,11 +10,31 @@ struct SkyIlluminanceSnapshot {
   [[nodiscard]] float GetSunIntensity();
 };
 class SkyIlluminance : public IAsset {
+  void SetSnapshots(const std::map<float, SkyIlluminanceSnapshot> &snapshots);
 public:
-  std::map<float, SkyIlluminanceSnapshot> m_snapshots;
+  /**
+   * The times of the snapshots in ascending order.
+   */
+  std::vector<float> m_times;
+  /**
+   * The snapshots, in the order of m_times.
+   */
+  std::vector<SkyIlluminanceSnapshot> m_snapshots;
   float m_minTime;
   float m_maxTime;
-  [[nodiscard]] SkyIlluminanceSnapshot Get(float time);
+  [[nodiscard]] SkyIlluminanceSnapshot Get(float time) const;
+  /**
+   * Interpolate the snapshots at the time.
+   * @param time The time to look up.
+   * @param cursor The result of the previous query, for time that moves monotonically the lookup takes constant time.
+   * @return The interpolated snapshot.
+   */
+  [[nodiscard]] SkyIlluminanceSnapshot Get(float time, size_t &cursor) const;
+  /**
+   * Time the lookups across the series against the std::map scan they replaced, and check that both give the same snapshots.
+   * @param queryCount The amount of evenly spaced queries, made from the first to the last snapshot.
+   */
+  void BenchmarkGet(int queryCount) const;
   void ImportCSV(const std::filesystem::path &path);
   void OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) override;
   void Serialize(YAML::Emitter &out) override;
@@ -3,6 +3,9 @@
 #include <SorghumStateGenerator.hpp>
 using namespace EvoEngine;
 namespace EcoSysLab {
+class StemData;
+class LeafData;
+class PanicleData;
 enum class SorghumMode{
   ProceduralSorghum,
   SorghumStateGenerator
@@ -11,8 +14,15 @@ enum class SorghumMode{
 class SorghumData : public IPrivateComponent {
   float m_currentTime = 1.0f;
   unsigned m_recordedVersion = 0;
+  size_t m_stateCursor = 0;
   friend class SorghumLayer;
   bool m_segmentedMask = false;
+  [[nodiscard]] SorghumStatePair GetStatePair();
+  /**
+   * Replace the children of the owner with a new stem, leaves and panicle, the geometry of the organs is not formed yet.
+   */
+  void CreateOrgans(const SorghumStatePair &statePair, std::shared_ptr<StemData> &stemData,
+                    std::vector<std::shared_ptr<LeafData>> &leafData, std::shared_ptr<PanicleData> &panicleData);
 public:
   int m_mode = (int)SorghumMode::ProceduralSorghum;
   glm::vec3 m_gravityDirection = glm::vec3(0, -1, 0);
@@ -32,6 +42,12 @@ public:
   void Deserialize(const YAML::Node &in) override;
   void CollectAssetRef(std::vector<AssetRef> &list) override;
   void FormPlant();
+  /**
+   * Form multiple plants at once. The organ entities are created serially, the geometry of all the organs is then generated in parallel.
+   * @param scene The scene the plants belong to.
+   * @param plants The entities with SorghumData.
+   */
+  static void FormPlants(const std::shared_ptr<Scene> &scene, const std::vector<Entity> &plants);
   void ApplyGeometry();
 
   void SetEnableSegmentedMask(bool value);
@@ -18,6 +18,15 @@ public:
 
   int m_sizeLimit = 2000;
   float m_sorghumSize = 1.0f;
+  /**
+   * Plants whose generated states are the same share one geometry and are drawn as instances. Turned off, every plant gets its
+   * own entity hierarchy.
+   */
+  bool m_shareVariants = false;
+  /**
+   * The step the state parameters are rounded to before plants are compared, 0 only merges identical states.
+   */
+  float m_variantTolerance = 0.0f;
   std::vector<std::pair<AssetRef, glm::mat4>> m_newSorghums;
   virtual void GenerateMatrices(){};
   Entity InstantiateField();
@@ -0,0 +1,57 @@
+#pragma once
+#include "Vertex.hpp"
+#include "glm/gtx/hash.hpp"
+using namespace EvoEngine;
+namespace EcoSysLab {
+	/**
+	 * \brief A sparse occupancy grid with one bit per voxel, stored in bricks of 8x8x8 voxels.
+	 * The voxel centers follow the convention of VoxelGrid: the voxel at coordinate c has its center at m_minBound + (c + 0.5) * voxelSize.
+	 * Only the bricks that can be touched by the rasterized shapes are allocated, and they are found through a hash map keyed by
+	 * brick coordinate, so neither the memory nor the setup grows with the volume of the box and reading a voxel never walks
+	 * a hierarchy.
+	 */
+	class BitVoxelGrid
+	{
+		std::unordered_map<glm::ivec3, int> m_brickIndices;
+		std::vector<glm::ivec3> m_brickCoordinates;
+		/**
+		 * 8 words per brick, word z holds the bits of the 8x8 voxels of the layer, bit x + 8 * y.
+		 */
+		std::vector<std::atomic<uint64_t>> m_bits;
+		glm::vec3 m_minBound = glm::vec3(0.0f);
+		float m_voxelSize = 1.0f;
+		glm::ivec3 m_resolution = glm::ivec3(0);
+
+		/**
+		 * The index of the brick in m_brickCoordinates, -1 if the brick is not allocated.
+		 */
+		[[nodiscard]] int GetBrickIndex(const glm::ivec3& brickCoordinate) const;
+		[[nodiscard]] bool IsOccupied(int brickIndex, const glm::ivec3& localCoordinate) const;
+	public:
+		/**
+		 * Reset the grid to cover the box, with all voxels empty.
+		 * @param voxelSize The edge length of a voxel.
+		 * @param minBound The lower corner of the box.
+		 * @param maxBound The upper corner of the box.
+		 */
+		void Initialize(float voxelSize, const glm::vec3& minBound, const glm::vec3& maxBound);
+		/**
+		 * Occupy every voxel whose center lies within one of the capsules, the capsules are rasterized in parallel.
+		 * @param starts The start of the axis of every capsule.
+		 * @param ends The end of the axis of every capsule.
+		 * @param radii The radius of every capsule.
+		 */
+		void RasterizeCapsules(const std::vector<glm::vec3>& starts, const std::vector<glm::vec3>& ends, const std::vector<float>& radii);
+		[[nodiscard]] bool IsOccupied(const glm::ivec3& coordinate) const;
+		[[nodiscard]] glm::vec3 GetPosition(const glm::ivec3& coordinate) const;
+		[[nodiscard]] glm::ivec3 GetResolution() const;
+		[[nodiscard]] size_t GetBrickCount() const;
+		/**
+		 * Extract the boundary of the occupied voxels with marching cubes, with the voxel centers as the cell corners.
+		 * @param vertices The vertices are appended here.
+		 * @param indices The triangles are appended here.
+		 * @param removeDuplicate Whether the vertices on the same cell edge are shared between triangles.
+		 */
+		void Triangulate(std::vector<Vertex>& vertices, std::vector<unsigned>& indices, bool removeDuplicate) const;
+	};
+}
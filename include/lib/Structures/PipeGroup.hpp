@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Vertex.hpp"
+#include "Jobs.hpp"
 
 using namespace EvoEngine;
 namespace EcoSysLab
@@ -156,12 +157,20 @@ namespace EcoSysLab
 		std::queue<PipeSegmentHandle> m_pipeSegmentPool;
 
 		int m_version = -1;
-		void BuildStrand(float controlPointRatio, const Pipe<PipeData>& pipe, std::vector<glm::uint>& strands, std::vector<StrandPoint>& points, bool triplePoints, int nodeMaxCount) const;
+		/**
+		 * The amount of control points BuildStrand writes for the pipe, 0 if the pipe has no strand.
+		 */
+		[[nodiscard]] size_t GetStrandPointCount(const Pipe<PipeData>& pipe, bool triplePoints, int nodeMaxCount) const;
+		void BuildStrand(float controlPointRatio, const Pipe<PipeData>& pipe, StrandPoint* points, bool triplePoints, int nodeMaxCount) const;
 
 		[[nodiscard]] PipeSegmentHandle AllocatePipeSegment(PipeHandle pipeHandle, PipeSegmentHandle prevHandle, int index);
 	public:
 
-		void BuildStrands(float controlPointRatio, std::vector<glm::uint>& strands, std::vector<StrandPoint>& points, bool triplePoints, int nodeMaxCount) const;
+		/**
+		 * Append one strand of control points per pipe.
+		 * @param parallel Fill the strands with Jobs::ParallelFor, turn off when already running inside a job.
+		 */
+		void BuildStrands(float controlPointRatio, std::vector<glm::uint>& strands, std::vector<StrandPoint>& points, bool triplePoints, int nodeMaxCount, bool parallel = true) const;
 
 		PipeGroupData m_data;
 
@@ -246,17 +255,29 @@ namespace EcoSysLab
 		[[nodiscard]] int GetVersion() const;
 	};
 
+	template <typename PipeGroupData, typename PipeData, typename PipeSegmentData>
+	size_t PipeGroup<PipeGroupData, PipeData, PipeSegmentData>::GetStrandPointCount(const Pipe<PipeData>& pipe, const bool triplePoints,
+		const int nodeMaxCount) const
+	{
+		const auto& pipeSegmentHandles = pipe.PeekPipeSegmentHandles();
+		if (pipe.IsRecycled() || pipeSegmentHandles.empty()) return 0;
+		size_t segmentCount = pipeSegmentHandles.size();
+		if (nodeMaxCount != -1) segmentCount = glm::min(segmentCount, static_cast<size_t>(glm::max(nodeMaxCount, 0)));
+		if (triplePoints) return 3 + segmentCount * 3;
+		return segmentCount + 3;
+	}
+
 	template <typename PipeGroupData, typename PipeData, typename PipeSegmentData>
 	void PipeGroup<PipeGroupData, PipeData, PipeSegmentData>::BuildStrand(const float controlPointRatio, const Pipe<PipeData>& pipe,
-		std::vector<glm::uint>& strands, std::vector<StrandPoint>& points, bool triplePoints, int nodeMaxCount) const
+		StrandPoint* points, bool triplePoints, int nodeMaxCount) const
 	{
 		const auto& pipeSegmentHandles = pipe.PeekPipeSegmentHandles();
 		if (pipeSegmentHandles.empty())
 			return;
+		size_t pointIndex = 0;
 		if(triplePoints)
 		{
 			auto& baseInfo = pipe.m_info.m_baseInfo;
-			strands.emplace_back(points.size());
 			StrandPoint basePoint;
 			const auto& secondPipeSegment = PeekPipeSegment(pipeSegmentHandles[0]);
 			auto basePointDistance = glm::distance(baseInfo.m_globalPosition, secondPipeSegment.m_info.m_globalPosition);
@@ -264,11 +285,11 @@ namespace EcoSysLab
 			basePoint.m_color = baseInfo.m_color;
 			basePoint.m_position = baseInfo.m_globalPosition - baseTangent * basePointDistance * controlPointRatio;
 			basePoint.m_thickness = baseInfo.m_thickness;
-			points.emplace_back(basePoint);
+			points[pointIndex++] = basePoint;
 			basePoint.m_position = baseInfo.m_globalPosition;
-			points.emplace_back(basePoint);
+			points[pointIndex++] = basePoint;
 			basePoint.m_position = baseInfo.m_globalPosition + baseTangent * basePointDistance * controlPointRatio;
-			points.emplace_back(basePoint);
+			points[pointIndex++] = basePoint;
 
 			StrandPoint point;
 			for (int i = 0; i < pipeSegmentHandles.size() && (nodeMaxCount == -1 || i < nodeMaxCount); i++)
@@ -299,27 +320,25 @@ namespace EcoSysLab
 				point.m_color = pipeSegment.m_info.m_color;
 				point.m_position = pipeSegment.m_info.m_globalPosition - tangent * distance * controlPointRatio;
 				point.m_thickness = pipeSegment.m_info.m_thickness;
-				points.emplace_back(point);
+				points[pointIndex++] = point;
 
 				point.m_position = pipeSegment.m_info.m_globalPosition;
-				points.emplace_back(point);
+				points[pointIndex++] = point;
 
 				point.m_position = pipeSegment.m_info.m_globalPosition + tangent * distance * controlPointRatio;
-				points.emplace_back(point);
+				points[pointIndex++] = point;
 			}
 
 		}
 		else {
 			auto& baseInfo = pipe.m_info.m_baseInfo;
-			const auto startIndex = points.size();
-			strands.emplace_back(startIndex);
 			StrandPoint basePoint;
 			basePoint.m_color = baseInfo.m_color;
 			basePoint.m_thickness = baseInfo.m_thickness;
 			basePoint.m_position = baseInfo.m_globalPosition;
 
-			points.emplace_back(basePoint);
-			points.emplace_back(basePoint);
+			points[pointIndex++] = basePoint;
+			points[pointIndex++] = basePoint;
 
 			StrandPoint point;
 			for (int i = 0; i < pipeSegmentHandles.size() && (nodeMaxCount == -1 || i < nodeMaxCount); i++)
@@ -329,19 +348,19 @@ namespace EcoSysLab
 				point.m_color = pipeSegment.m_info.m_color;
 				point.m_thickness = pipeSegment.m_info.m_thickness;
 				point.m_position = pipeSegment.m_info.m_globalPosition;
-				points.emplace_back(point);
+				points[pointIndex++] = point;
 			}
-			auto& backPoint = points.at(points.size() - 2);
-			auto& lastPoint = points.at(points.size() - 1);
+			auto& backPoint = points[pointIndex - 2];
+			auto& lastPoint = points[pointIndex - 1];
 
 			point.m_color = 2.0f * lastPoint.m_color - backPoint.m_color;
 			point.m_thickness = 2.0f * lastPoint.m_thickness - backPoint.m_thickness;
 			point.m_position = 2.0f * lastPoint.m_position - backPoint.m_position;
-			points.emplace_back(point);
+			points[pointIndex++] = point;
 
-			auto& firstPoint = points.at(startIndex);
-			auto& secondPoint = points.at(startIndex + 1);
-			auto& thirdPoint = points.at(startIndex + 2);
+			auto& firstPoint = points[0];
+			auto& secondPoint = points[1];
+			auto& thirdPoint = points[2];
 			firstPoint.m_color = 2.0f * secondPoint.m_color - thirdPoint.m_color;
 			firstPoint.m_thickness = 2.0f * secondPoint.m_thickness - thirdPoint.m_thickness;
 			firstPoint.m_position = 2.0f * secondPoint.m_position - thirdPoint.m_position;
@@ -375,13 +394,39 @@ namespace EcoSysLab
 
 	template <typename PipeGroupData, typename PipeData, typename PipeSegmentData>
 	void PipeGroup<PipeGroupData, PipeData, PipeSegmentData>::BuildStrands(const float controlPointRatio, std::vector<glm::uint>& strands,
-		std::vector<StrandPoint>& points, bool triplePoints, int nodeMaxCount) const
+		std::vector<StrandPoint>& points, bool triplePoints, int nodeMaxCount, const bool parallel) const
 	{
-		for (const auto& pipe : m_pipes)
+		//The size of every strand is known up front, so the strands are laid out first and then filled in parallel,
+		//in the same order as the pipes.
+		const auto forEachPipe = [&](const std::function<void(unsigned)>& func)
+			{
+				if (parallel) Jobs::ParallelFor(m_pipes.size(), func);
+				else for (unsigned pipeIndex = 0; pipeIndex < m_pipes.size(); pipeIndex++) func(pipeIndex);
+			};
+		std::vector<size_t> pointStarts(m_pipes.size() + 1, 0);
+		forEachPipe([&](unsigned pipeIndex)
+			{
+				pointStarts[pipeIndex + 1] = GetStrandPointCount(m_pipes[pipeIndex], triplePoints, nodeMaxCount);
+			}
+		);
+		std::vector<size_t> strandIndices(m_pipes.size(), 0);
+		size_t strandCount = strands.size();
+		pointStarts[0] = points.size();
+		for (size_t pipeIndex = 0; pipeIndex < m_pipes.size(); pipeIndex++)
 		{
-			if (pipe.IsRecycled()) continue;
-			BuildStrand(controlPointRatio, pipe, strands, points, triplePoints, nodeMaxCount);
+			strandIndices[pipeIndex] = strandCount;
+			if (pointStarts[pipeIndex + 1] != 0) strandCount++;
+			pointStarts[pipeIndex + 1] += pointStarts[pipeIndex];
 		}
+		strands.resize(strandCount);
+		points.resize(pointStarts.back());
+		forEachPipe([&](unsigned pipeIndex)
+			{
+				if (pointStarts[pipeIndex + 1] == pointStarts[pipeIndex]) return;
+				strands[strandIndices[pipeIndex]] = static_cast<glm::uint>(pointStarts[pipeIndex]);
+				BuildStrand(controlPointRatio, m_pipes[pipeIndex], &points[pointStarts[pipeIndex]], triplePoints, nodeMaxCount);
+			}
+		);
 	}
 
 	template <typename PipeGroupData, typename PipeData, typename PipeSegmentData>
@@ -4,6 +4,7 @@
 namespace EcoSysLab {
 	typedef int NodeHandle;
 	typedef int FlowHandle;
+	class ShootSkeletonSnapshot;
 
 #pragma region Structural Info
 	struct NodeInfo {
@@ -58,6 +59,7 @@ namespace EcoSysLab {
 
 		template<typename SD, typename FD, typename ID>
 		friend class Skeleton;
+		friend class ShootSkeletonSnapshot;
 
 		bool m_endNode = true;
 		bool m_recycled = false;
@@ -67,6 +69,8 @@ namespace EcoSysLab {
 		std::vector<NodeHandle> m_childHandles;
 		bool m_apical = true;
 		int m_index = -1;
+		int m_changeVersion = 0;
+		int m_inputChangeVersion = 0;
 #pragma endregion
 	public:
 		NodeData m_data;
@@ -124,6 +128,11 @@ namespace EcoSysLab {
 		Node(NodeHandle handle);
 
 		[[nodiscard]] int GetIndex() const;
+		/**
+		 * Get the change version of the skeleton at the time this node was last created or marked as changed.
+		 * @return The change version.
+		 */
+		[[nodiscard]] int GetChangeVersion() const;
 	};
 
 	template<typename FlowData>
@@ -132,6 +141,7 @@ namespace EcoSysLab {
 
 		template<typename SD, typename FD, typename ID>
 		friend class Skeleton;
+		friend class ShootSkeletonSnapshot;
 
 		bool m_recycled = false;
 		FlowHandle m_handle = -1;
@@ -186,6 +196,7 @@ namespace EcoSysLab {
 	template<typename SkeletonData, typename FlowData, typename NodeData>
 	class Skeleton {
 #pragma region Private
+		friend class ShootSkeletonSnapshot;
 		std::vector<Flow<FlowData>> m_flows;
 		std::vector<Node<NodeData>> m_nodes;
 		std::queue<NodeHandle> m_nodePool;
@@ -193,6 +204,12 @@ namespace EcoSysLab {
 
 		int m_newVersion = 0;
 		int m_version = -1;
+
+		int m_changeVersion = 0;
+		/**
+		 * Everything is considered changed for consumers that synced before this change version.
+		 */
+		int m_fullChangeVersion = 0;
 		std::vector<NodeHandle> m_sortedNodeList;
 		std::vector<FlowHandle> m_sortedFlowList;
 
@@ -284,6 +301,52 @@ namespace EcoSysLab {
 		 */
 		[[nodiscard]] int GetVersion() const;
 
+		/**
+		 * Get the change version of the skeleton. It grows every time nodes are created, recycled or marked as changed,
+		 * so a consumer that keeps the change version it last synced at can query what happened since.
+		 * @return The change version.
+		 */
+		[[nodiscard]] int GetChangeVersion() const;
+
+		/**
+		 * Mark the node as changed, call this after you modify the info or data of individual nodes.
+		 * @param handle The handle of the changed node.
+		 */
+		void MarkChanged(NodeHandle handle);
+
+		/**
+		 * Mark a list of nodes as changed.
+		 * @param handles The handles of the changed nodes.
+		 */
+		void MarkChanged(const std::vector<NodeHandle>& handles);
+
+		/**
+		 * Mark the node as changed without making it an input change. Call this after a pass that rewrites values
+		 * derived from other nodes (distances, transforms) or state nothing else is computed from (light, growth rates, buds).
+		 * @param handle The handle of the changed node.
+		 */
+		void MarkStateChanged(NodeHandle handle);
+
+		/**
+		 * Mark a list of nodes as changed without making them input changes.
+		 * @param handles The handles of the changed nodes.
+		 */
+		void MarkStateChanged(const std::vector<NodeHandle>& handles);
+
+		/**
+		 * Mark all nodes as changed, call this after a pass that rewrites every node.
+		 */
+		void MarkAllChanged();
+
+		/**
+		 * Collect the nodes that are created or marked as changed after the given change version.
+		 * @param sinceChangeVersion The change version the consumer last synced at.
+		 * @param changedNodes The handles of the changed nodes, sorted from root to ends.
+		 * @param inputsOnly Leave out the nodes that were only marked with MarkStateChanged.
+		 * @return False if all nodes are changed since then, the consumer should sync everything.
+		 */
+		[[nodiscard]] bool CollectChangedNodes(int sinceChangeVersion, std::vector<NodeHandle>& changedNodes, bool inputsOnly = false) const;
+
 		/**
 		 * Calculate the structural information of the flows.
 		 */
@@ -447,6 +510,7 @@ namespace EcoSysLab {
 		auto &originalNode = m_nodes[targetHandle];
 		auto &newNode = m_nodes[newNodeHandle];
 		originalNode.m_endNode = false;
+		originalNode.m_changeVersion = m_changeVersion;
 		if (branching) {
 			auto newFlowHandle = AllocateFlow();
 			auto &newFlow = m_flows[newFlowHandle];
@@ -651,6 +715,12 @@ namespace EcoSysLab {
 		return m_index;
 	}
 
+	template <typename NodeData>
+	int Node<NodeData>::GetChangeVersion() const
+	{
+		return m_changeVersion;
+	}
+
 	template<typename FlowData>
 	Flow<FlowData>::Flow(const FlowHandle handle) {
 		m_handle = handle;
@@ -733,6 +803,7 @@ namespace EcoSysLab {
 		m_nodePool = {};
 		m_sortedNodeList.clear();
 		m_sortedFlowList.clear();
+		MarkAllChanged();
 
 		AllocateFlow();
 		auto firstNodeHandle = AllocateNode();
@@ -776,9 +847,11 @@ namespace EcoSysLab {
 	template <typename SkeletonData, typename FlowData, typename NodeData>
 	void Skeleton<SkeletonData, FlowData, NodeData>::CalculateDistance()
 	{
+		std::vector<NodeHandle> changedNodes;
 		for (const auto& nodeHandle : m_sortedNodeList) {
 			auto& node = m_nodes[nodeHandle];
 			auto& nodeInfo = node.m_info;
+			const auto previousRootDistance = nodeInfo.m_rootDistance;
 			if (node.GetParentHandle() == -1) {
 				nodeInfo.m_rootDistance = nodeInfo.m_length;
 			}
@@ -786,9 +859,11 @@ namespace EcoSysLab {
 				const auto& parentInternode = m_nodes[node.GetParentHandle()];
 				nodeInfo.m_rootDistance = parentInternode.m_info.m_rootDistance + nodeInfo.m_length;
 			}
+			if (nodeInfo.m_rootDistance != previousRootDistance) changedNodes.emplace_back(nodeHandle);
 		}
 		for (auto it = m_sortedNodeList.rbegin(); it != m_sortedNodeList.rend(); ++it) {
 			auto& node = m_nodes[*it];
+			const auto previousEndDistance = node.m_info.m_endDistance;
 			float maxDistanceToAnyBranchEnd = 0;
 			node.m_info.m_endDistance = 0;
 			for (const auto& i : node.RefChildHandles())
@@ -800,15 +875,19 @@ namespace EcoSysLab {
 				maxDistanceToAnyBranchEnd = glm::max(maxDistanceToAnyBranchEnd, childMaxDistanceToAnyBranchEnd);
 			}
 			node.m_info.m_endDistance = maxDistanceToAnyBranchEnd;
+			if (maxDistanceToAnyBranchEnd != previousEndDistance) changedNodes.emplace_back(*it);
 		}
+		MarkStateChanged(changedNodes);
 	}
 
 	template<typename SkeletonData, typename FlowData, typename NodeData>
 	void Skeleton<SkeletonData, FlowData, NodeData>::CalculateRegulatedGlobalRotation()
 	{
+		std::vector<NodeHandle> changedNodes;
 		for (const auto& nodeHandle : m_sortedNodeList) {
 			auto& node = m_nodes[nodeHandle];
 			auto& nodeInfo = node.m_info;
+			const auto previousRegulatedGlobalRotation = nodeInfo.m_regulatedGlobalRotation;
 			if (node.m_parentHandle != -1) {
 				auto& parentInfo = m_nodes[node.m_parentHandle].m_info;
 				auto front = nodeInfo.m_globalRotation * glm::vec3(0, 0, -1);
@@ -819,7 +898,9 @@ namespace EcoSysLab {
 			{
 				nodeInfo.m_regulatedGlobalRotation = nodeInfo.m_globalRotation;
 			}
+			if (nodeInfo.m_regulatedGlobalRotation != previousRegulatedGlobalRotation) changedNodes.emplace_back(nodeHandle);
 		}
+		MarkStateChanged(changedNodes);
 	}
 
 	template<typename SkeletonData, typename FlowData, typename NodeData>
@@ -913,6 +994,13 @@ namespace EcoSysLab {
 		assert(!m_nodes[handle].m_recycled);
 		auto &node = m_nodes[handle];
 		nodeHandler(handle);
+		//The parent loses a descendant, so whatever it derives from its subtree changes.
+		if (node.m_parentHandle != -1 && !m_nodes[node.m_parentHandle].m_recycled)
+		{
+			auto& parentNode = m_nodes[node.m_parentHandle];
+			parentNode.m_changeVersion = parentNode.m_inputChangeVersion = m_changeVersion + 1;
+		}
+		m_changeVersion++;
 		node.m_parentHandle = -1;
 		node.m_flowHandle = -1;
 		node.m_endNode = true;
@@ -928,9 +1016,11 @@ namespace EcoSysLab {
 	template<typename SkeletonData, typename FlowData, typename NodeData>
 	NodeHandle Skeleton<SkeletonData, FlowData, NodeData>::AllocateNode() {
 		m_maxIndex++;
+		m_changeVersion++;
 		if (m_nodePool.empty()) {
 			auto& newNode = m_nodes.emplace_back(m_nodes.size());
 			newNode.m_index = m_maxIndex;
+			newNode.m_changeVersion = newNode.m_inputChangeVersion = m_changeVersion;
 			return newNode.m_handle;
 		}
 		auto handle = m_nodePool.front();
@@ -938,6 +1028,7 @@ namespace EcoSysLab {
 		auto &node = m_nodes[handle];
 		node.m_recycled = false;
 		node.m_index = m_maxIndex;
+		node.m_changeVersion = node.m_inputChangeVersion = m_changeVersion;
 		return handle;
 	}
 
@@ -946,6 +1037,66 @@ namespace EcoSysLab {
 		return m_version;
 	}
 
+	template<typename SkeletonData, typename FlowData, typename NodeData>
+	int Skeleton<SkeletonData, FlowData, NodeData>::GetChangeVersion() const {
+		return m_changeVersion;
+	}
+
+	template<typename SkeletonData, typename FlowData, typename NodeData>
+	void Skeleton<SkeletonData, FlowData, NodeData>::MarkChanged(const NodeHandle handle) {
+		assert(handle >= 0 && handle < m_nodes.size());
+		assert(!m_nodes[handle].m_recycled);
+		m_changeVersion++;
+		m_nodes[handle].m_changeVersion = m_nodes[handle].m_inputChangeVersion = m_changeVersion;
+	}
+
+	template<typename SkeletonData, typename FlowData, typename NodeData>
+	void Skeleton<SkeletonData, FlowData, NodeData>::MarkChanged(const std::vector<NodeHandle>& handles) {
+		if (handles.empty()) return;
+		m_changeVersion++;
+		for (const auto& handle : handles) {
+			assert(handle >= 0 && handle < m_nodes.size());
+			assert(!m_nodes[handle].m_recycled);
+			m_nodes[handle].m_changeVersion = m_nodes[handle].m_inputChangeVersion = m_changeVersion;
+		}
+	}
+
+	template<typename SkeletonData, typename FlowData, typename NodeData>
+	void Skeleton<SkeletonData, FlowData, NodeData>::MarkStateChanged(const NodeHandle handle) {
+		assert(handle >= 0 && handle < m_nodes.size());
+		assert(!m_nodes[handle].m_recycled);
+		m_changeVersion++;
+		m_nodes[handle].m_changeVersion = m_changeVersion;
+	}
+
+	template<typename SkeletonData, typename FlowData, typename NodeData>
+	void Skeleton<SkeletonData, FlowData, NodeData>::MarkStateChanged(const std::vector<NodeHandle>& handles) {
+		if (handles.empty()) return;
+		m_changeVersion++;
+		for (const auto& handle : handles) {
+			assert(handle >= 0 && handle < m_nodes.size());
+			assert(!m_nodes[handle].m_recycled);
+			m_nodes[handle].m_changeVersion = m_changeVersion;
+		}
+	}
+
+	template<typename SkeletonData, typename FlowData, typename NodeData>
+	void Skeleton<SkeletonData, FlowData, NodeData>::MarkAllChanged() {
+		m_changeVersion++;
+		m_fullChangeVersion = m_changeVersion;
+	}
+
+	template<typename SkeletonData, typename FlowData, typename NodeData>
+	bool Skeleton<SkeletonData, FlowData, NodeData>::CollectChangedNodes(const int sinceChangeVersion, std::vector<NodeHandle>& changedNodes, const bool inputsOnly) const {
+		changedNodes.clear();
+		if (sinceChangeVersion < m_fullChangeVersion) return false;
+		for (const auto& nodeHandle : m_sortedNodeList) {
+			const auto& node = m_nodes[nodeHandle];
+			if ((inputsOnly ? node.m_inputChangeVersion : node.m_changeVersion) > sinceChangeVersion) changedNodes.emplace_back(nodeHandle);
+		}
+		return true;
+	}
+
 	template<typename SkeletonData, typename FlowData, typename NodeData>
 	void Skeleton<SkeletonData, FlowData, NodeData>::CalculateFlows() {
 		for (const auto &flowHandle: m_sortedFlowList) {
@@ -60,6 +60,10 @@ namespace EcoSysLab {
 
 		void ForEach(const glm::vec3& minBound, const glm::vec3& maxBound, const std::function<void(VoxelData& data)>& func);
 		void ForEach(const glm::vec3& center, float radius, const std::function<void(VoxelData& data)>& func);
+		/**
+		 * Get the (unclamped) range of coordinates visited by ForEach(center, radius, ...).
+		 */
+		void GetRange(const glm::vec3& center, float radius, glm::ivec3& start, glm::ivec3& end) const;
 		[[nodiscard]] bool IsValid(const glm::vec3& position) const;
 
 		[[nodiscard]] std::vector<VoxelData>& RefData();
@@ -254,11 +258,8 @@ namespace EcoSysLab {
 	void VoxelGrid<VoxelData>::ForEach(const glm::vec3& center, float radius,
 		const std::function<void(VoxelData& data)>& func)
 	{
-		const auto actualCenter = center - m_minBound;
-		const auto actualMinBound = actualCenter - glm::vec3(radius);
-		const auto actualMaxBound = actualCenter + glm::vec3(radius);
-		const auto start = glm::ivec3(glm::floor(actualMinBound / glm::vec3(m_voxelSize)));
-		const auto end = glm::ivec3(glm::ceil(actualMaxBound / glm::vec3(m_voxelSize)));
+		glm::ivec3 start, end;
+		GetRange(center, radius, start, end);
 		for (int i = start.x; i <= end.x; i++) {
 			for (int j = start.y; j <= end.y; j++) {
 				for (int k = start.z; k <= end.z; k++) {
@@ -270,6 +271,16 @@ namespace EcoSysLab {
 		}
 	}
 
+	template <typename VoxelData>
+	void VoxelGrid<VoxelData>::GetRange(const glm::vec3& center, const float radius, glm::ivec3& start, glm::ivec3& end) const
+	{
+		const auto actualCenter = center - m_minBound;
+		const auto actualMinBound = actualCenter - glm::vec3(radius);
+		const auto actualMaxBound = actualCenter + glm::vec3(radius);
+		start = glm::ivec3(glm::floor(actualMinBound / glm::vec3(m_voxelSize)));
+		end = glm::ivec3(glm::ceil(actualMaxBound / glm::vec3(m_voxelSize)));
+	}
+
 	template <typename VoxelData>
 	bool VoxelGrid<VoxelData>::IsValid(const glm::vec3& position) const
 	{
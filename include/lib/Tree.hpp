@@ -7,6 +7,7 @@
 #include "TreeGraph.hpp"
 #include "TreeGrowthParameters.hpp"
 #include "TreePipeMeshGenerator.hpp"
+#include "BinvoxVolume.hpp"
 using namespace EvoEngine;
 namespace EcoSysLab {
 
@@ -31,7 +32,50 @@ namespace EcoSysLab {
 		friend class EcoSysLabLayer;
 		void PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescriptor);
 		ShootGrowthController m_shootGrowthController{};
+		/**
+		 * The shoot the tree is deserialized with, it stays encoded until LoadShootSnapshot is called.
+		 */
+		ShootSkeletonSnapshot m_pendingShootSnapshot{};
+		/**
+		 * The time spent in growing the tree, saved with the tree to compare with the time to load it.
+		 */
+		float m_shootGrowthTime = 0.0f;
+		float m_shootSnapshotDecodeTime = 0.0f;
+		/**
+		 * The iteration and the change version of the shoot the meshes are generated from, -1 when there are no meshes.
+		 */
+		int m_meshIteration = -1;
+		int m_meshChangeVersion = -1;
 	public:
+		/**
+		 * Whether the shoot is saved with quantized transforms, which is smaller but not lossless.
+		 */
+		bool m_quantizeShootSnapshot = false;
+		/**
+		 * Decode the shoot the tree is deserialized with, nothing happens when there is none. Call it from the main thread, the
+		 * visualizer is reset and the load time is logged.
+		 * @return False if the snapshot is invalid, the tree is reset in that case.
+		 */
+		bool LoadShootSnapshot();
+		/**
+		 * Round trip the shoot through Serialize and Deserialize and through Step and Reverse of the history, and log the
+		 * internodes that differ. The tree itself is left untouched.
+		 * @return Whether every round trip reproduces the shoot.
+		 */
+		bool VerifyShootSnapshotRoundTrip();
+		/**
+		 * Time loading the shoot from a snapshot against regrowing it from the tree descriptor for the same number of
+		 * iterations, and log both.
+		 */
+		void CompareShootLoadWithRegrowth();
+		/**
+		 * Fill the growth controller with the procedures of the tree descriptor.
+		 * @param treeDescriptor The descriptor the controller reads its parameters from, kept alive by the procedures.
+		 * @param climateModel The climate model the tree grows in, it must outlive the controller.
+		 * @param shootGrowthController The controller to fill.
+		 */
+		static void PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescriptor, const ClimateModel& climateModel,
+			ShootGrowthController& shootGrowthController);
 		PipeModelParameters m_pipeModelParameters{};
 
 		static void SerializeTreeGrowthSettings(const TreeGrowthSettings& treeGrowthSettings, YAML::Emitter& out);
@@ -42,11 +86,34 @@ namespace EcoSysLab {
 		std::shared_ptr<Strands> GenerateStrands();
 
 		std::shared_ptr<Mesh> GenerateBranchMesh(const TreeMeshGeneratorSettings& meshGeneratorSettings);
+		/**
+		 * Compute the transforms that place the unit quad at each leaf of the foliage.
+		 * The leaves are generated in parallel, the variation of the leaves of a node is drawn from a generator seeded by the node.
+		 * @param foliageParameters The parameters of the foliage.
+		 * @param adjustedTransforms Whether the leaves follow the transforms adjusted by the pipe model instead of the ones of the skeleton.
+		 * @param leafTransforms The transforms of the leaves, in the order of the sorted nodes.
+		 */
+		void GenerateFoliageTransforms(const FoliageParameters& foliageParameters, bool adjustedTransforms, std::vector<glm::mat4>& leafTransforms) const;
+		/**
+		 * Bake the leaves into one mesh, each leaf is the quad with a front and a back face.
+		 */
+		static std::shared_ptr<Mesh> GenerateFoliageMesh(const std::vector<glm::mat4>& leafTransforms);
 		std::shared_ptr<Mesh> GenerateFoliageMesh(const TreeMeshGeneratorSettings& meshGeneratorSettings);
 		std::shared_ptr<Mesh> GeneratePipeModelBranchMesh(const PipeModelMeshGeneratorSettings& treePipeMeshGeneratorSettings);
 		std::shared_ptr<Mesh> GeneratePipeModelFoliageMesh(const PipeModelMeshGeneratorSettings& pipeModelMeshGeneratorSettings);
 		void ExportOBJ(const std::filesystem::path& path, const TreeMeshGeneratorSettings& meshGeneratorSettings);
-		bool TryGrow(float deltaTime, NodeHandle baseInternodeHandle, bool pruning, float overrideGrowthRate);
+		/**
+		 * Grow the tree for one iteration.
+		 * @param parallel Whether the checkpoint of the history is encoded in parallel, turn off when already running inside a job.
+		 * The shoot snapshot of the tree has to be loaded on the main thread beforehand in that case.
+		 * @return Whether the tree is grown.
+		 */
+		bool TryGrow(float deltaTime, NodeHandle baseInternodeHandle, bool pruning, float overrideGrowthRate, bool parallel = true);
+		/**
+		 * Grow the tree into the occupied voxels of the volume, the volume is stretched to the box of the given radius around the root.
+		 * @return Whether the tree has a tree descriptor to read the internode length from.
+		 */
+		bool ApplyEnvelope(const BinvoxVolume& volume, float radius, int markersPerVoxel = 1);
 		[[nodiscard]] bool ParseBinvox(const std::filesystem::path& filePath, VoxelGrid<TreeOccupancyGridBasicData>& voxelGrid, float voxelSize = 1.0f);
 
 		void Reset();
@@ -87,7 +154,13 @@ namespace EcoSysLab {
 		void OnCreate() override;
 
 		void InitializeMeshRenderer(const TreeMeshGeneratorSettings& meshGeneratorSettings, int iteration = -1);
-		void ClearMeshRenderer() const;
+		/**
+		 * Whether the meshes are generated from the current shoot, nothing changed in the shoot since then.
+		 * The mesh generator settings are not tracked.
+		 * @return False if the meshes need to be generated again.
+		 */
+		[[nodiscard]] bool IsMeshUpToDate() const;
+		void ClearMeshRenderer();
 		void ClearTwigsStrandRenderer() const;
 
 
@@ -99,7 +172,7 @@ namespace EcoSysLab {
 
 		void ClearPipeModelMeshRenderer();
 
-		void RegisterVoxel();
+		void RegisterVoxel(EnvironmentGridBuffer& buffer, bool registerNodes);
 		void FromLSystemString(const std::shared_ptr<LSystemString>& lSystemString);
 		void FromTreeGraph(const std::shared_ptr<TreeGraph>& treeGraph);
 		void FromTreeGraphV2(const std::shared_ptr<TreeGraphV2>& treeGraphV2);
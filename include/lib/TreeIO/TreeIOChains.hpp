@@ -206,6 +206,18 @@ public:
     void cascadeUpwards(UpwardPropFunT fun);
     /// @brief Perform computation by downwards propagation - from leaves towards the root. Returned bool used for premature stopping.
     void cascadeDownwards(DownwardPropFunT fun);
+    /**
+     * @brief Perform computation by upwards propagation in parallel, one depth level at a time. Nodes of the same
+     * level may be processed concurrently, so fun must only modify the current node. Returned bool stops the
+     * propagation once the current level is finished.
+     */
+    void cascadeUpwardsParallel(UpwardPropFunT fun);
+    /**
+     * @brief Perform computation by downwards propagation in parallel, one height level at a time - all children
+     * are finished before their parent. Nodes of the same level may be processed concurrently, so fun must only
+     * modify the current node. Returned bool stops the propagation once the current level is finished.
+     */
+    void cascadeDownwardsParallel(DownwardPropFunT fun);
 
     // Accessors:
 
@@ -243,6 +255,8 @@ public:
 private:
     /// @brief Minimum distance of two nodes in order to compute the MRF.
     static constexpr auto MINIMUM_MRF_DISTANCE{ 0.01f };
+    /// @brief Number of nodes or chains handed to a thread at once by the parallel passes.
+    static constexpr std::size_t PARALLEL_GRAIN_SIZE{ 64u };
 
     /// @brief Frenet frame used for rotation frame minimization.
     struct FrenetFrame
@@ -259,8 +273,10 @@ private:
     bool generateUpwardPassInformation(InternalArrayTree &tree);
     /// @brief Generate information going from leaves to the root of the current tree.
     bool generateDownwardPassInformation(InternalArrayTree &tree);
-    /// @brief Generate orthonormal bases for the current tree.
+    /// @brief Generate orthonormal bases for the current tree. Requires the node chains.
     bool generateOrthoBases(InternalArrayTree &tree);
+    /// @brief Calculate basis of given non-root node, minimizing its rotation against the basis of its parent.
+    void calculateNodeBasis(InternalArrayTree &tree, const NodeIdT &nodeId) const;
     /// @brief Generate node chains for the current tree.
     bool generateNodeChains(const InternalArrayTree &tree, ChainStorage &chains,
         ChainIdxStorage &leafChains, std::size_t &maxChainDepth, std::size_t &maxGraveliusDepth);
@@ -290,6 +306,14 @@ private:
     InternalArrayTree mInternalTree{ };
     /// List leaf node ids from mInternalTree.
     NodeIdStorage mLeafNodes{ };
+    /// Node ids from mInternalTree sorted by depth, parents always come before their children.
+    NodeIdStorage mDepthOrder{ };
+    /// Offsets of the depth levels within mDepthOrder, with the total count at the end.
+    std::vector<std::size_t> mDepthLevels{ };
+    /// Node ids from mInternalTree sorted by height above their deepest leaf, children always come before their parent.
+    NodeIdStorage mHeightOrder{ };
+    /// Offsets of the height levels within mHeightOrder, with the total count at the end.
+    std::vector<std::size_t> mHeightLevels{ };
     /// List of chains making up the whole tree. First chain is the root one.
     ChainStorage mChains{ };
     /// List of indices of leaf chains from mChains.
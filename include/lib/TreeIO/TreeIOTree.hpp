@@ -370,6 +370,12 @@ public:
     /// @brief Parse ArrayTreeT from file path using .tree format. Does not provide runtime meta-data.
     inline static ArrayTreeT fromPathNoRuntime(const std::string &path);
 
+    /// @brief Load all .tree files within given directory in parallel, ordered by their path.
+    template <typename RuntimeMetaDataT>
+    static std::vector<ArrayTreeT> fromDirectory(const std::string &path);
+    /// @brief Load all .tree files within given directory in parallel, ordered by their path. Does not provide runtime meta-data.
+    inline static std::vector<ArrayTreeT> fromDirectoryNoRuntime(const std::string &path);
+
     /// @brief Is given node index a valid one?
     static constexpr bool isNodeIdValidValue(const NodeIdT &idx);
 
@@ -547,9 +553,12 @@ protected:
 
     // TODO - Rewrite all recursive algorithms to use stack?
 
-    /// @brief Procedure which serializes this tree to given stream using .tree format.
-    template <typename ST>
-    void saveTreeRecursion(ST &ss, const NodeIdT &currentId) const;
+    /// @brief Procedure which appends the sub-tree of given node to the buffer using .tree format.
+    void saveTreeIterative(std::string &buffer, const NodeIdT &rootId) const;
+
+    /// @brief Load given files on the job system. Resulting trees are in the same order as the paths.
+    template <typename LoaderT>
+    static std::vector<ArrayTreeT> loadTreesParallel(const std::vector<std::string> &paths, const LoaderT &loader);
 
     /// @brief Create empty tree with a single root node, using given runtime meta-data.
     static ArrayTreeT emptyTree(const TreeRuntimeMetaData::Ptr &runtime);
@@ -557,8 +566,8 @@ protected:
     /// @brief De-serialize ArrayTree from given string.
     static ArrayTreeT parseTreeFromString(const std::string &serialized, const TreeRuntimeMetaData::Ptr &runtime);
 
-    /// @brief De-serialize ArrayTree from .tree format.
-    static ArrayTreeT parseTreeFromTreeString(const std::string &serialized, const TreeRuntimeMetaData::Ptr &runtime);
+    /// @brief De-serialize ArrayTree from .tree format. Throws with the position of the first malformed value.
+    static ArrayTreeT parseTreeFromTreeString(std::string_view serialized, const TreeRuntimeMetaData::Ptr &runtime);
 
     /// @brief De-serialize ArrayTree from .json format.
     static ArrayTreeT parseTreeFromJSONString(const std::string &serialized, const TreeRuntimeMetaData::Ptr &runtime);
@@ -846,6 +855,55 @@ ArrayTreeT<OutDataT, MetaDataT> ArrayTreeT<DataT, MetaDataT>::copy() const
     return result;
 }
 
+namespace impl
+{
+
+/// @brief Parse a single value of a .tree node, accepting the same inputs as std::stof.
+inline float parseTreeValue(std::string_view text, std::size_t begin, std::size_t end)
+{
+    auto first{ text.data() + begin };
+    const auto last{ text.data() + end };
+    while (first != last && std::isspace(static_cast<unsigned char>(*first)))
+    { ++first; }
+    if (first != last && *first == '+')
+    { ++first; }
+
+    float value{ 0.0f };
+    const auto [ptr, ec]{ std::from_chars(first, last, value) };
+    if (ec != std::errc{ })
+    {
+        throw std::runtime_error("Invalid node value \"" + std::string{ text.substr(begin, end - begin) } +
+            "\" at position " + std::to_string(begin) + "!");
+    }
+
+    return value;
+}
+
+/// @brief Append a single value of a .tree node, formatted the same way as the default std::ostream.
+inline void appendTreeValue(std::string &buffer, float value)
+{
+    char characters[32];
+    const auto [ptr, ec]{ std::to_chars(characters, characters + sizeof(characters),
+        value, std::chars_format::general, 6) };
+    buffer.append(characters, ptr);
+}
+
+/// @brief List all .tree files within given directory, sorted by path.
+inline std::vector<std::string> listTreeFiles(const std::string &path)
+{
+    std::vector<std::string> result{ };
+    for (const auto &entry : std::filesystem::directory_iterator(path))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".tree")
+        { result.push_back(entry.path().string()); }
+    }
+    std::sort(result.begin(), result.end());
+
+    return result;
+}
+
+}
+
 template <typename DataT, typename MetaDataT>
 template <typename RuntimeMetaDataT>
 ArrayTreeT<DataT, MetaDataT> ArrayTreeT<DataT, MetaDataT>::fromPath(const std::string &path)
@@ -874,6 +932,42 @@ template <typename DataT, typename MetaDataT>
 inline ArrayTreeT<DataT, MetaDataT> ArrayTreeT<DataT, MetaDataT>::fromStringNoRuntime(const std::string &serialized)
 { return parseTreeFromString(serialized, nullptr); }
 
+template <typename DataT, typename MetaDataT>
+template <typename RuntimeMetaDataT>
+std::vector<ArrayTreeT<DataT, MetaDataT>> ArrayTreeT<DataT, MetaDataT>::fromDirectory(
+    const std::string &path)
+{
+    return loadTreesParallel(impl::listTreeFiles(path),
+        [](const std::string &treePath) { return fromPath<RuntimeMetaDataT>(treePath); });
+}
+
+template <typename DataT, typename MetaDataT>
+inline std::vector<ArrayTreeT<DataT, MetaDataT>> ArrayTreeT<DataT, MetaDataT>::fromDirectoryNoRuntime(
+    const std::string &path)
+{
+    return loadTreesParallel(impl::listTreeFiles(path),
+        [](const std::string &treePath) { return fromPathNoRuntime(treePath); });
+}
+
+template <typename DataT, typename MetaDataT>
+template <typename LoaderT>
+std::vector<ArrayTreeT<DataT, MetaDataT>> ArrayTreeT<DataT, MetaDataT>::loadTreesParallel(
+    const std::vector<std::string> &paths, const LoaderT &loader)
+{
+    std::vector<ArrayTreeT> trees(paths.size());
+
+    // Files differ wildly in size, so the paths are handed out one by one instead of in larger chunks.
+    treeutil::parallelFor(paths.size(), [&](std::size_t idx)
+    {
+        try
+        { trees[idx] = loader(paths[idx]); }
+        catch (std::exception &e)
+        { treeutil::Error << "Failed to load tree \"" << paths[idx] << "\" : \"" << e.what() << "\"" << std::endl; }
+    }, 1u);
+
+    return trees;
+}
+
 template <typename DataT, typename MetaDataT>
 constexpr bool ArrayTreeT<DataT, MetaDataT>::isNodeIdValidValue(const NodeIdT &idx)
 { return idx != INVALID_NODE_ID; }
@@ -1197,15 +1291,14 @@ std::string ArrayTreeT<DataT, MetaDataT>::serialize() const
     if (!isNodeIdValid(mRoot))
     { return ""; }
 
-    std::stringstream ss{ };
-
     // Output the metadata:
-    ss << mMetaData.serialize() << "\n#####\n";
+    std::string buffer{ mMetaData.serialize() };
+    buffer += "\n#####\n";
 
     // Traverse the tree and output it:
-    saveTreeRecursion(ss, mRoot);
+    saveTreeIterative(buffer, mRoot);
 
-    return ss.str();
+    return buffer;
 }
 
 template <typename DataT, typename MetaDataT>
@@ -1350,32 +1443,58 @@ typename ArrayTreeT<DataT, MetaDataT>::template IteratorT<true, UserDataT>
 { return IteratorT<true, UserDataT>(id, *this, style, indirectNodes, keepHistory); }
 
 template <typename DataT, typename MetaDataT>
-template <typename ST>
-void ArrayTreeT<DataT, MetaDataT>::saveTreeRecursion(ST &ss, const NodeIdT &currentId) const
+void ArrayTreeT<DataT, MetaDataT>::saveTreeIterative(std::string &buffer, const NodeIdT &rootId) const
 {
-    // Get data for current node.
-    auto &currentNode{ getNode(currentId) };
-    const auto &currentData{ currentNode.data() };
-
-    // Serialize the node.
-    ss << "(" << currentData.pos.x
-       << "," << currentData.pos.y
-       << "," << currentData.pos.z
-       << "," << currentData.thickness
-       << ")";
-
-    // Move to the children.
-    const auto &currentChildren{ currentNode.children() };
-    const auto multipleChildren{ currentChildren.size() > 1u };
-
-    // Serialize all children recursively.
-    for (std::size_t iii = 0u; iii < currentChildren.size(); ++iii)
+    // Roughly 4 values of up to 12 characters each, plus the separators.
+    buffer.reserve(buffer.size() + mNodes.size() * 56u);
+
+    const auto appendNode{ [&](const NodeIdT &id)
+    {
+        const auto &data{ getNode(id).data() };
+        buffer.push_back('(');
+        impl::appendTreeValue(buffer, data.pos.x);
+        buffer.push_back(',');
+        impl::appendTreeValue(buffer, data.pos.y);
+        buffer.push_back(',');
+        impl::appendTreeValue(buffer, data.pos.z);
+        buffer.push_back(',');
+        impl::appendTreeValue(buffer, data.thickness);
+        buffer.push_back(')');
+    } };
+
+    struct StackFrame
     {
-        if (multipleChildren && iii != currentChildren.size() - 1u)
-        { ss << "["; }
-        saveTreeRecursion(ss, currentChildren[iii]);
-        if (multipleChildren && iii != currentChildren.size() - 1u)
-        { ss << "]"; }
+        /// Node whose children are being serialized.
+        NodeIdT id;
+        /// Index of the next child to serialize.
+        std::size_t nextChild;
+        /// Was this node opened with a square bracket?
+        bool closeBracket;
+    }; // struct StackFrame
+
+    std::vector<StackFrame> stack{ };
+    appendNode(rootId);
+    stack.push_back({ rootId, 0u, false });
+    while (!stack.empty())
+    {
+        auto &frame{ stack.back() };
+        const auto &children{ getNode(frame.id).children() };
+        if (frame.nextChild == children.size())
+        {
+            if (frame.closeBracket)
+            { buffer.push_back(']'); }
+            stack.pop_back();
+            continue;
+        }
+
+        // All children but the last one are enclosed within square brackets.
+        const auto childIdx{ frame.nextChild++ };
+        const auto bracket{ children.size() > 1u && childIdx != children.size() - 1u };
+        const auto childId{ children[childIdx] };
+        if (bracket)
+        { buffer.push_back('['); }
+        appendNode(childId);
+        stack.push_back({ childId, 0u, bracket });
     }
 }
 
@@ -1432,44 +1551,42 @@ ArrayTreeT<DataT, MetaDataT> ArrayTreeT<DataT, MetaDataT>::parseTreeFromString(
 
 template <typename DataT, typename MetaDataT>
 ArrayTreeT<DataT, MetaDataT> ArrayTreeT<DataT, MetaDataT>::parseTreeFromTreeString(
-    const std::string &serialized, const TreeRuntimeMetaData::Ptr &runtime)
+    std::string_view serialized, const TreeRuntimeMetaData::Ptr &runtime)
 {
     // Split meta info and nodes
     auto divider{ serialized.find_first_of("#####") };
     auto dividernext{ divider + 5u };
-    if (divider == std::string::npos)
+    if (divider == std::string_view::npos)
     { // No divider found, assume there is no metadata and just read the branches:
         divider = 0u;
         dividernext = 0u;
     }
-    const auto metatext{ serialized.substr(0u, divider) };
-    const auto nodetext{ serialized.substr(dividernext) };
+    dividernext = std::min(dividernext, serialized.size());
 
     // Parse it.
     MetaDataT metaData{ };
-    metaData.deserialize(metatext, runtime);
-
-    // Parse the tree structure
-    std::size_t ptr{ 0u };
-    std::size_t depth{ 0u };
-    const char brackets[4] = { '(','[',']' };
-    const char closing[2] = { ',',')' };
+    metaData.deserialize(std::string{ serialized.substr(0u, divider) }, runtime);
 
     ArrayTree newTree;
     newTree.mLoaded = false;
+    newTree.mNodes.reserve(std::count(serialized.begin() + dividernext, serialized.end(), '(') + 1u);
 
+    // Parse the tree structure. All positions are kept relative to the whole string for error reporting.
+    std::size_t ptr{ dividernext };
+    std::size_t depth{ 0u };
     bool hasRoot = false;
     std::vector<NodeIdT> turtleDives{ }; // for storing parent to go back to on each dive.
     NodeIdT current{ INVALID_NODE_ID };
     // break skips to the end where the tree is assembled as if the reading went fine.
-    while (depth >= 0u && ptr < nodetext.size())
+    while (ptr < serialized.size())
     {
-        const auto nextb{ nodetext.find_first_of(brackets, ptr) };
-        if (nextb == std::string::npos)
+        const auto nextb{ serialized.find_first_of("([]", ptr) };
+        if (nextb == std::string_view::npos)
         { // No more brackets
-            std::cerr << "npos";
             if (depth > 0u)
             { // Mismatched parsing (some nodes were not closed)
+                treeutil::Error << "Unclosed branch at the end of tree string (position "
+                                << serialized.size() << ")!" << std::endl;
                 return newTree;
             }
             else
@@ -1477,17 +1594,15 @@ ArrayTreeT<DataT, MetaDataT> ArrayTreeT<DataT, MetaDataT>::parseTreeFromTreeStri
                 break;
             }
         }
-        ptr = nextb + 1; // move pointer
-        const auto nbracket{ nodetext[nextb] };
-        const auto b_dive{ nbracket == '[' };
-        const auto b_diveup{ nbracket == ']' };
-        const auto b_newnode{ nbracket == '(' };
-        if (b_dive)
+        ptr = nextb + 1u; // move pointer
+        const auto nbracket{ serialized[nextb] };
+        if (nbracket == '[')
         { depth++; turtleDives.push_back(current); }
-        else if (b_diveup)
+        else if (nbracket == ']')
         {
             if (depth == 0u)
             { // Mismatched parsing (atemped to close square bracket at depth 0)
+                treeutil::Error << "Unmatched closing bracket at position " << nextb << "!" << std::endl;
                 newTree.mLoaded = false;
                 return newTree;
             }
@@ -1496,70 +1611,44 @@ ArrayTreeT<DataT, MetaDataT> ArrayTreeT<DataT, MetaDataT>::parseTreeFromTreeStri
             current = turtleDives.back();
             turtleDives.pop_back();
         }
-        else if (b_newnode)
+        else
         {
-            NodeT myNode;
-            // Parse params
-            int nextsem;
-            bool finishedNode = false;
-            std::string subbie;
-            // x
-            nextsem = nodetext.find_first_of(closing, ptr);
-            if (!finishedNode)
+            NodeDataT myData{ };
+            // Parse params: x, y, z and thickness, stopping early at the closing bracket.
+            for (std::size_t field = 0u; field < 4u; ++field)
             {
-                finishedNode |= nodetext[nextsem] == ')';
-                subbie = nodetext.substr(ptr, nextsem - ptr);
-                //std::cout << subbie << "\n";
-                myNode.data().pos.x = std::stof(subbie);
-                ptr = nextsem + 1;
-            }
-            // y
-            nextsem = nodetext.find_first_of(closing, ptr);
-            if (!finishedNode)
-            {
-                finishedNode |= nodetext[nextsem] == ')';
-                subbie = nodetext.substr(ptr, nextsem - ptr);
-                //std::cout << subbie << "\n";
-                myNode.data().pos.y = std::stof(subbie);
-                ptr = nextsem + 1;
-            }
-            // z
-            nextsem = nodetext.find_first_of(closing, ptr);
-            if (!finishedNode)
-            {
-                finishedNode |= nodetext[nextsem] == ')';
-                subbie = nodetext.substr(ptr, nextsem - ptr);
-                //std::cout << subbie << "\n";
-                myNode.data().pos.z = std::stof(subbie);
-                ptr = nextsem + 1;
-            }
-            // w
-            nextsem = nodetext.find_first_of(closing, ptr);
-            if (!finishedNode)
-            {
-                finishedNode |= nodetext[nextsem] == ')';
-                subbie = nodetext.substr(ptr, nextsem - ptr);
-                //std::cout << subbie << "\n";
-                myNode.data().thickness = std::stof(subbie);
-                ptr = nextsem + 1;
+                const auto nextsem{ serialized.find_first_of(",)", ptr) };
+                if (nextsem == std::string_view::npos)
+                { throw std::runtime_error("Unclosed node at position " + std::to_string(nextb) + "!"); }
+                const auto value{ impl::parseTreeValue(serialized, ptr, nextsem) };
+                switch (field)
+                {
+                    case 0u: myData.pos.x = value; break;
+                    case 1u: myData.pos.y = value; break;
+                    case 2u: myData.pos.z = value; break;
+                    default: myData.thickness = value; break;
+                }
+                ptr = nextsem + 1u;
+                if (serialized[nextsem] == ')')
+                { break; }
             }
             //insert my node at the end (since it's a struct) and then make it 'current':
-            myNode.mArrayParent = current;
             NodeIdT myNodeId{ INVALID_NODE_ID };
             if (hasRoot)
-            { myNodeId = newTree.addNodeChild(current, myNode.data()); }
+            { myNodeId = newTree.addNodeChild(current, myData); }
             else
-            { hasRoot = true; myNodeId = newTree.addRoot(myNode.data()); }
+            { hasRoot = true; myNodeId = newTree.addRoot(myData); }
             current = myNodeId;
 
             //move to the next closing bracket
-            const auto nextb{ nodetext.find_first_of(')', ptr - 1) };
-            if (nextb == std::string::npos)
+            const auto nextc{ serialized.find(')', ptr - 1u) };
+            if (nextc == std::string_view::npos)
             { //mismatched parsing (the current node was not closed)
+                treeutil::Error << "Unclosed node at position " << nextb << "!" << std::endl;
                 newTree.mLoaded = false;
                 return newTree;
             }
-            ptr = nextb + 1;
+            ptr = nextc + 1u;
         }
     }
     // Assemble the final tree:
@@ -10,6 +10,8 @@
 
 #include <array>
 #include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
@@ -21,7 +23,9 @@
 #include <set>
 #include <stack>
 #include <string>
+#include <string_view>
 #include <sstream>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -221,6 +225,15 @@ auto argMax(const ArrT &arr);
 template <typename ArrT>
 auto argMinMax(const ArrT &arr);
 
+/**
+ * @brief Call fun(idx) for every idx in [0, count) on the job system of the engine.
+ * Indices are handed out in chunks of grainSize, everything runs on the calling
+ * thread when there is only a single chunk. The first exception thrown by fun
+ * is rethrown on the calling thread once all chunks have finished.
+ */
+void parallelFor(std::size_t count, const std::function<void(std::size_t)> &fun,
+    std::size_t grainSize = 1u);
+
 /// @brief Simple logging manager.
 class Logger
 {
@@ -0,0 +1,55 @@
+#pragma once
+#include "TreeOccupancyGrid.hpp"
+using namespace EvoEngine;
+namespace EcoSysLab
+{
+	/**
+	 * \brief An occupancy volume read from a binvox file, with one bit per voxel.
+	 * The bits are kept in the order of the runs in the file, binvox x maps to z and binvox z maps to x of the grid.
+	 * Like Tree::ParseBinvox, the volume starts at the origin and is shifted on the XZ plane so the occupied voxels in the
+	 * lowest fifth of the volume are centered around the origin.
+	 */
+	class BinvoxVolume
+	{
+		std::vector<uint64_t> m_bits{};
+		glm::ivec3 m_resolution = glm::ivec3(0);
+		glm::vec3 m_minBound = glm::vec3(0.0f);
+		float m_voxelSize = 1.0f;
+		size_t m_occupiedCount = 0;
+
+		[[nodiscard]] size_t GetBitIndex(const glm::ivec3& coordinate) const;
+		[[nodiscard]] size_t CountBits(size_t begin, size_t end) const;
+	public:
+		/**
+		 * Load the volume, the file is read into memory at once and the runs are written into the bitset word by word.
+		 * @param filePath The path of the binvox file.
+		 * @param voxelSize The edge length of a voxel.
+		 * @return Whether the file is a valid binvox file.
+		 */
+		bool Load(const std::filesystem::path& filePath, float voxelSize = 1.0f);
+		/**
+		 * Load all binvox files in the folder (not recursive) in parallel.
+		 * @param folderPath The folder to load.
+		 * @param volumes The volumes that loaded, in the order of their file names.
+		 * @param paths The path of each volume.
+		 * @param voxelSize The edge length of a voxel.
+		 */
+		static void LoadFolder(const std::filesystem::path& folderPath, std::vector<BinvoxVolume>& volumes,
+			std::vector<std::filesystem::path>& paths, float voxelSize = 1.0f);
+
+		[[nodiscard]] bool IsOccupied(const glm::ivec3& coordinate) const;
+		/**
+		 * Whether the voxel containing the position is occupied, positions outside of the volume are not.
+		 */
+		[[nodiscard]] bool IsOccupied(const glm::vec3& position) const;
+		[[nodiscard]] glm::ivec3 GetResolution() const;
+		[[nodiscard]] glm::vec3 GetMinBound() const;
+		[[nodiscard]] glm::vec3 GetMaxBound() const;
+		[[nodiscard]] float GetVoxelSize() const;
+		[[nodiscard]] size_t GetOccupiedCount() const;
+		/**
+		 * Copy the volume into a voxel grid.
+		 */
+		void ToVoxelGrid(VoxelGrid<TreeOccupancyGridBasicData>& voxelGrid) const;
+	};
+}
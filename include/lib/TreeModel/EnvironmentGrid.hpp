@@ -18,6 +18,36 @@ namespace EcoSysLab
 		float m_thickness = 0.0f;
 	};
 
+	struct InternodeVoxelContribution
+	{
+		int m_voxelIndex = -1;
+		float m_shadowIntensity = 0.0f;
+		float m_biomass = 0.0f;
+		/**
+		 * \brief The index of the registration in the same buffer, -1 if the internode is not registered.
+		 */
+		int m_registrationIndex = -1;
+	};
+
+	/**
+	 * \brief Contributions collected by one thread before they are merged into the grid.
+	 */
+	struct EnvironmentGridBuffer
+	{
+		std::vector<InternodeVoxelContribution> m_contributions;
+		std::vector<InternodeVoxelRegistration> m_registrations;
+	};
+
+	/**
+	 * \brief The range of contributions a single tree wrote into one of the buffers.
+	 */
+	struct EnvironmentGridBufferSegment
+	{
+		unsigned m_bufferIndex = 0;
+		size_t m_start = 0;
+		size_t m_end = 0;
+	};
+
 	struct EnvironmentVoxel
 	{
 		glm::vec3 m_shadowDirection = glm::vec3(0.0f);
@@ -33,10 +63,29 @@ namespace EcoSysLab
 		float m_voxelSize = 0.1f;
 		IlluminationEstimationSettings m_settings;
 		VoxelGrid<EnvironmentVoxel> m_voxel;
+		std::vector<EnvironmentGridBuffer> m_buffers;
 		[[nodiscard]] float IlluminationEstimation(const glm::vec3& position, glm::vec3& lightDirection) const;
 		void AddShadowValue(const glm::vec3& position, float value);
-		void ShadowPropagation();
+		/**
+		 * Propagate the shadow downwards, layer by layer.
+		 * @param parallel Whether the voxels of a layer are processed with the job system, turn off when already running inside a job.
+		 */
+		void ShadowPropagation(bool parallel = true);
 		void AddBiomass(const glm::vec3& position, float value);
 		void AddNode(const InternodeVoxelRegistration& registration);
+		/**
+		 * Clear the buffers (capacity is kept) and make sure there is one per thread.
+		 */
+		void PrepareBuffers(size_t bufferCount);
+		/**
+		 * Accumulate the contributions in the buffers into the voxels. Each voxel receives its contributions in the order of the segments,
+		 * so the result does not depend on how the segments were distributed among the buffers.
+		 * @param segments The ranges of contributions, in the order they should be applied.
+		 */
+		void MergeBuffers(const std::vector<EnvironmentGridBufferSegment>& segments);
+		/**
+		 * Accumulate all contributions of a single buffer into the voxels on the calling thread.
+		 */
+		void ApplyBuffer(const EnvironmentGridBuffer& buffer);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include "TreeGrowthData.hpp"
+using namespace EvoEngine;
+namespace EcoSysLab
+{
+	/**
+	 * \brief A compact binary copy of a shoot skeleton, used for the history of the tree model and for saving grown trees.
+	 * The snapshot starts with a versioned header and stores the skeleton as independent column blocks, one for each group of
+	 * fields, so a reader skips the columns it does not know and a newer schema can add columns without breaking older files.
+	 * Handles are written as variable length deltas to the handle of the node they belong to. Every column can be compressed
+	 * with a small LZ77 codec, which is only kept when it makes the column smaller.
+	 * In the quantized mode positions are stored relative to the parent on a fixed grid, rotations and directions as 16 bit
+	 * fixed point and colors as 8 bit. The position of a node is relative to the reconstructed position of its parent, so the
+	 * error does not accumulate along the branches.
+	 * The pipe model data of the internodes and the octree of the shoot are derived and not stored.
+	 */
+	class ShootSkeletonSnapshot
+	{
+		std::vector<uint8_t> m_bytes{};
+	public:
+		/**
+		 * The version of the layout the snapshots are written in, snapshots of a newer version are rejected.
+		 */
+		static constexpr int m_schemaVersion = 1;
+		/**
+		 * Encode the skeleton, the columns are built and compressed in parallel.
+		 * @param skeleton The skeleton to encode.
+		 * @param quantize Whether the transforms are quantized, otherwise the snapshot is lossless.
+		 * @param compress Whether the columns are compressed.
+		 * @param positionPrecision The grid size for the positions and lengths of the quantized mode.
+		 * @param parallel Whether the columns are built in parallel, turn off when already running inside a job.
+		 */
+		void Encode(const ShootSkeleton& skeleton, bool quantize = false, bool compress = true, float positionPrecision = 0.0001f, bool parallel = true);
+		/**
+		 * Decode the snapshot, the skeleton is left untouched if the snapshot is invalid. All nodes of the decoded skeleton are
+		 * marked as changed at the change version of the encoded skeleton and the sorted lists are rebuilt.
+		 * @param skeleton The skeleton to write to.
+		 * @param parallel Whether the columns are decoded in parallel, turn off when already running inside a job.
+		 * @return Whether the snapshot is valid.
+		 */
+		[[nodiscard]] bool Decode(ShootSkeleton& skeleton, bool parallel = true) const;
+
+		[[nodiscard]] const std::vector<uint8_t>& RefBytes() const;
+		void SetBytes(const uint8_t* data, size_t size);
+		[[nodiscard]] size_t GetSize() const;
+		[[nodiscard]] bool Empty() const;
+		void Clear();
+	};
+}
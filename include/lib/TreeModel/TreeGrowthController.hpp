@@ -35,6 +35,10 @@ namespace EcoSysLab
 		 * \brief The strength of gravity bending.
 		 */
 		std::function<float(const Node<InternodeGrowthData>& internode)> m_sagging;
+		/**
+		 * \brief The sagging factor, thickness reduction and max sagging that m_sagging reads.
+		 */
+		glm::vec3 m_saggingFactorThicknessReductionMax = glm::vec3(0.0f);
 
 		/**
 		 * \brief The internode length
@@ -4,6 +4,7 @@
 #include "Octree.hpp"
 #include "TreeGrowthController.hpp"
 #include "TreeIOTree.hpp"
+#include "ShootSkeletonSnapshot.hpp"
 using namespace EvoEngine;
 namespace EcoSysLab {
 	struct TreeGrowthSettings
@@ -14,6 +15,20 @@ namespace EcoSysLab {
 		float m_spaceColonizationRemovalDistanceFactor = 2;
 		float m_spaceColonizationDetectionDistanceFactor = 4;
 		float m_spaceColonizationTheta = 90.0f;
+		/**
+		 * Update thickness, biomass and transform only along the root paths of the nodes that changed since the last
+		 * iteration, instead of walking the entire tree.
+		 */
+		bool m_incrementalShootUpdate = true;
+		/**
+		 * Run the full passes on a copy after every incremental update and log where the results differ.
+		 */
+		bool m_verifyIncrementalShootUpdate = false;
+		/**
+		 * Sagging changes below this value are ignored, so the transforms of the subtree above stay untouched.
+		 * The full and the incremental passes apply the same tolerance.
+		 */
+		float m_saggingTolerance = 0.0f;
 	};
 
 	class TreeModel {
@@ -32,6 +47,65 @@ namespace EcoSysLab {
 
 		void CalculateLevel();
 
+		/**
+		 * Recalculate the thickness of the internode from its children.
+		 * @return Whether the thickness of the internode changed.
+		 */
+		bool UpdateInternodeThickness(NodeHandle internodeHandle, const ShootGrowthController& shootGrowthController);
+		/**
+		 * Recalculate the biomass of the internode and its descendants.
+		 * @return Whether the biomass of the internode changed.
+		 */
+		bool UpdateInternodeBiomass(NodeHandle internodeHandle, const ShootGrowthController& shootGrowthController);
+		/**
+		 * Recalculate the transform of the internode from the transform of its parent.
+		 * @return Whether the transform of the internode changed.
+		 */
+		bool UpdateInternodeTransform(NodeHandle internodeHandle, const ShootGrowthController& shootGrowthController, bool sagging);
+
+		void ExpandShootBounds(NodeHandle internodeHandle);
+		/**
+		 * The controller values the last post process used, the incremental update is only valid while they stay the same.
+		 */
+		struct ShootUpdateParameters
+		{
+			float m_endNodeThickness = 0.0f;
+			float m_thicknessAccumulationFactor = 0.0f;
+			float m_internodeLengthThicknessFactor = 0.0f;
+			float m_internodeLength = 0.0f;
+			bool m_branchPush = false;
+			glm::vec3 m_gravityDirection = glm::vec3(0.0f);
+			float m_saggingTolerance = 0.0f;
+			glm::vec3 m_saggingFactorThicknessReductionMax = glm::vec3(0.0f);
+			/**
+			 * The extra mass of all internodes, sagging reads it besides the biomass.
+			 */
+			float m_totalExtraMass = 0.0f;
+			[[nodiscard]] bool operator==(const ShootUpdateParameters& other) const;
+		};
+		ShootUpdateParameters m_postProcessedParameters{};
+		/**
+		 * The change version of the shoot skeleton right after the last post process.
+		 */
+		int m_postProcessedChangeVersion = -1;
+		std::vector<unsigned char> m_internodeUpdateFlags;
+		/**
+		 * Update thickness and biomass along the root paths of the changed internodes, and the transforms of the subtrees
+		 * whose parent changed.
+		 * @param changedInternodes The internodes that are created or changed since the last post process.
+		 */
+		void UpdateShootIncrementally(const std::vector<NodeHandle>& changedInternodes, const ShootGrowthController& shootGrowthController);
+		/**
+		 * Run the full thickness, biomass, level and transform passes on a copy of the incrementally updated skeleton and
+		 * log the internodes where they differ. The skeleton is left as the incremental update produced it.
+		 */
+		void VerifyIncrementalShootUpdate(const ShootGrowthController& shootGrowthController);
+
+		/**
+		 * The internodes whose buds changed during the growth pass, marked as changed at once after the pass.
+		 */
+		std::vector<NodeHandle> m_budChangedInternodes;
+
 		bool GrowInternode(ClimateModel& climateModel, NodeHandle internodeHandle, const ShootGrowthController& shootGrowthController);
 
 		bool ElongateInternode(float extendLength, NodeHandle internodeHandle,
@@ -48,11 +122,29 @@ namespace EcoSysLab {
 
 		ShootSkeleton m_shootSkeleton;
 
-		std::deque<ShootSkeleton> m_history;
+		/**
+		 * The history is kept as lossless compressed snapshots, the pipe model data of the past iterations is not kept.
+		 */
+		std::deque<ShootSkeletonSnapshot> m_history;
+		/**
+		 * The last history entry that is peeked, decoded.
+		 */
+		mutable ShootSkeleton m_historyCache;
+		mutable int m_historyCacheIteration = -1;
 
 		int m_leafCount = 0;
 		int m_fruitCount = 0;
 		int m_twigCount = 0;
+		/**
+		 * The number of live internodes and shoot stems, kept up to date as internodes are created and pruned.
+		 * A new skeleton starts with the root internode on its own stem.
+		 */
+		int m_internodeCount = 1;
+		int m_shootStemCount = 1;
+		/**
+		 * Count the internodes and stems again, after the skeleton is replaced as a whole.
+		 */
+		void RecountShoot();
 
 		float m_age = 0;
 		int m_ageInYear = 0;
@@ -74,7 +166,16 @@ namespace EcoSysLab {
 
 		float m_crownShynessDistance = 0.0f;
 		unsigned m_index = 0;
-		void RegisterVoxel(const glm::mat4& globalTransform, ClimateModel& climateModel, const ShootGrowthController& shootGrowthController);
+		/**
+		 * Collect the shadow and biomass contributions of all internodes into the buffer, to be merged into the environment grid later.
+		 * @param globalTransform The global transform of tree in world space.
+		 * @param climateModel The climate model.
+		 * @param shootGrowthController The procedural parameters that guides the growth of the branches.
+		 * @param buffer The buffer to append to.
+		 * @param registerNodes Whether end nodes should also be registered (required by crown shyness).
+		 */
+		void RegisterVoxel(const glm::mat4& globalTransform, const ClimateModel& climateModel, const ShootGrowthController& shootGrowthController,
+			EnvironmentGridBuffer& buffer, bool registerNodes) const;
 		TreeOccupancyGrid m_treeOccupancyGrid{};
 
 		void PruneInternode(NodeHandle internodeHandle);
@@ -94,6 +195,11 @@ namespace EcoSysLab {
 		std::vector<int> m_internodeOrderCounts;
 
 		TreeGrowthSettings m_treeGrowthSettings;
+		/**
+		 * The time the last shoot post process took in seconds, and whether it was incremental.
+		 */
+		double m_lastPostProcessTime = 0.0;
+		bool m_lastPostProcessIncremental = false;
 
 		glm::vec3 m_currentGravityDirection = glm::vec3(0, -1, 0);
 
@@ -104,6 +210,8 @@ namespace EcoSysLab {
 
 		[[nodiscard]] int GetLeafCount() const;
 		[[nodiscard]] int GetFruitCount() const;
+		[[nodiscard]] int GetInternodeCount() const;
+		[[nodiscard]] int GetShootStemCount() const;
 		/**
 		 * Grow one iteration of the tree, given the nutrients and the procedural parameters.
 		 * @param deltaTime The real world time for this iteration.
@@ -123,17 +231,36 @@ namespace EcoSysLab {
 		void SampleTemperature(const glm::mat4& globalTransform, ClimateModel& climateModel);
 		[[nodiscard]] ShootSkeleton& RefShootSkeleton();
 
+		/**
+		 * Access the skeleton of an iteration. A past iteration is decoded from the history, the reference stays valid until
+		 * another past iteration is peeked or the history changes.
+		 * @param iteration The iteration, -1 for the current skeleton.
+		 */
 		[[nodiscard]] const ShootSkeleton& PeekShootSkeleton(int iteration = -1) const;
+		/**
+		 * The memory taken by the snapshots of the history.
+		 */
+		[[nodiscard]] size_t GetHistoryMemoryUsage() const;
 
 		void ClearHistory();
 
-		void Step();
+		/**
+		 * Push the current skeleton to the history as a checkpoint.
+		 * @param parallel Whether the snapshot is encoded in parallel, turn off when already running inside a job.
+		 */
+		void Step(bool parallel = true);
 
 		void Pop();
 
 		[[nodiscard]] int CurrentIteration() const;
 
-		void Reverse(int iteration);
+		/**
+		 * Restore the skeleton of a checkpoint and drop the checkpoints after it. The checkpoints keep no pipe profiles, so the
+		 * profiles have to be prepared again after reversing.
+		 * @param iteration The checkpoint to restore.
+		 * @return False if the checkpoint can not be decoded, the tree and the history are left untouched in that case.
+		 */
+		bool Reverse(int iteration);
 
 		void ExportTreeIOSkeleton(treeio::ArrayTree& arrayTree) const;
 
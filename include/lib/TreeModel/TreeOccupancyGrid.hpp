@@ -6,6 +6,7 @@ using namespace EvoEngine;
 namespace EcoSysLab
 {
 	class RadialBoundingVolume;
+	class BinvoxVolume;
 
 	struct OccupancyGridSettings
 	{
@@ -19,7 +20,18 @@ namespace EcoSysLab
 	};
 
 	struct TreeOccupancyGridVoxelData {
-		std::vector<TreeOccupancyGridMarker> m_markers;
+		/**
+		 * \brief The start of the markers of this voxel in the marker list of the grid.
+		 */
+		unsigned m_markerOffset = 0;
+		/**
+		 * \brief The amount of markers (consumed or not) of this voxel.
+		 */
+		unsigned m_markerSize = 0;
+		/**
+		 * \brief The first m_liveMarkerSize markers of the voxel are not consumed yet.
+		 */
+		unsigned m_liveMarkerSize = 0;
 	};
 
 	struct TreeOccupancyGridBasicData
@@ -30,13 +42,31 @@ namespace EcoSysLab
 	class TreeOccupancyGrid
 	{
 		VoxelGrid<TreeOccupancyGridVoxelData> m_occupancyGrid {};
+		std::vector<TreeOccupancyGridMarker> m_markers{};
 		float m_removalDistanceFactor = 2;
 		float m_theta = 90.0f;
 		float m_detectionDistanceFactor = 4;
 		float m_internodeLength = 1.0f;
 		size_t m_markersPerVoxel = 5;
+
+		std::vector<std::vector<NodeHandle>> m_nodeBuckets{};
+		std::vector<int> m_nodeVoxelIndices{};
+
+		/**
+		 * Rebuild the marker list in voxel order. Markers of each voxel are kept (live first, then consumed),
+		 * voxels selected by the filter receive m_markersPerVoxel new live markers.
+		 */
+		void GenerateMarkers(const std::function<bool(unsigned voxelIndex)>& filter);
 	public:
 		void ResetMarkers();
+		/**
+		 * Move all markers that have been assigned to a node out of the live marker lists.
+		 */
+		void RemoveConsumedMarkers();
+		/**
+		 * Remove the gaps left in the marker list by cleared voxels.
+		 */
+		void Compact();
 		[[nodiscard]] float GetRemovalDistanceFactor() const;
 		[[nodiscard]] float GetTheta() const;
 		[[nodiscard]] float GetDetectionDistanceFactor() const;
@@ -48,12 +78,40 @@ namespace EcoSysLab
 		void Resize(const glm::vec3 &min, const glm::vec3& max);
 		void Initialize(const VoxelGrid<TreeOccupancyGridBasicData>& srcGrid, const glm::vec3& min, const glm::vec3& max, float internodeLength,
 			float removalDistanceFactor = 2.0f, float theta = 90.0f, float detectionDistanceFactor = 4.0f, size_t markersPerVoxel = 1);
+		/**
+		 * Fill the grid with markers where the volume is occupied, the volume is stretched to fill the box like a voxel grid source.
+		 */
+		void Initialize(const BinvoxVolume& srcVolume, const glm::vec3& min, const glm::vec3& max, float internodeLength,
+			float removalDistanceFactor = 2.0f, float theta = 90.0f, float detectionDistanceFactor = 4.0f, size_t markersPerVoxel = 1);
 		void Initialize(const std::shared_ptr<RadialBoundingVolume>& srcRadialBoundingVolume, const glm::vec3& min, const glm::vec3& max, float internodeLength,
 			float removalDistanceFactor = 2.0f, float theta = 90.0f, float detectionDistanceFactor = 4.0f, size_t markersPerVoxel = 1);
 		[[nodiscard]] VoxelGrid<TreeOccupancyGridVoxelData>& RefGrid();
+		[[nodiscard]] std::vector<TreeOccupancyGridMarker>& RefMarkers();
+		[[nodiscard]] const std::vector<TreeOccupancyGridMarker>& PeekMarkers() const;
+		/**
+		 * Get the memory held by the voxels and the markers, in bytes.
+		 */
+		[[nodiscard]] size_t GetMemoryUsage() const;
 		[[nodiscard]] glm::vec3 GetMin() const;
 		[[nodiscard]] glm::vec3 GetMax() const;
 
 		void InsertObstacle(const GlobalTransform& globalTransform, const std::shared_ptr<CubeVolume>& cubeVolume);
+
+#pragma region Node index
+		/**
+		 * Register the node in the voxel containing the position (clamped to the grid). Buckets are only touched when the voxel changes.
+		 * @param nodeHandle The handle of the node.
+		 * @param position The position of the node.
+		 */
+		void UpdateNode(NodeHandle nodeHandle, const glm::vec3& position);
+		void RemoveNode(NodeHandle nodeHandle);
+		void ClearNodes();
+		/**
+		 * Access the voxel index each node is registered at, -1 for nodes not registered.
+		 * @return The list of voxel indices, indexed by node handle.
+		 */
+		[[nodiscard]] const std::vector<int>& PeekNodeVoxelIndices() const;
+		[[nodiscard]] const std::vector<NodeHandle>& PeekNodes(const glm::ivec3& coordinate) const;
+#pragma endregion
 	};
 }
\ No newline at end of file
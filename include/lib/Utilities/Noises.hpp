@@ -40,6 +40,13 @@ namespace EcoSysLab
 		void Load(const std::string& name, const YAML::Node& in);
 
 		[[nodiscard]] float GetValue(const glm::vec2& position) const;
+		/**
+		 * Evaluate the noise for a batch of positions, with the same results as GetValue. The noise functions are evaluated one
+		 * position at a time as in GetValue, only the descriptor dispatch and the clamp and accumulate passes are batched.
+		 * @param positions The positions to evaluate.
+		 * @param values The output, resized to match the positions.
+		 */
+		void GetValues(const std::vector<glm::vec2>& positions, std::vector<float>& values) const;
 	};
 
 	class Noises3D {
@@ -52,5 +59,12 @@ namespace EcoSysLab
 		void Load(const std::string& name, const YAML::Node& in);
 
 		[[nodiscard]] float GetValue(const glm::vec3& position) const;
+		/**
+		 * Evaluate the noise for a batch of positions, with the same results as GetValue. The noise functions are evaluated one
+		 * position at a time as in GetValue, only the descriptor dispatch and the clamp and accumulate passes are batched.
+		 * @param positions The positions to evaluate.
+		 * @param values The output, resized to match the positions.
+		 */
+		void GetValues(const std::vector<glm::vec3>& positions, std::vector<float>& values) const;
 	};
 }
\ No newline at end of file
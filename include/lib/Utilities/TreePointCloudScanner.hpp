@@ -4,9 +4,27 @@
 
 using namespace EvoEngine;
 namespace EcoSysLab {
+	struct ScannedPointCloud
+	{
+		std::vector<glm::vec3> m_points;
+		std::vector<int> m_internodeIndex;
+		std::vector<int> m_branchIndex;
+		std::vector<int> m_treePartIndex;
+		std::vector<int> m_lineIndex;
+		std::vector<int> m_instanceIndex;
+		std::vector<int> m_typeIndex;
+	};
+
 	class TreePointCloudScanner : public IPrivateComponent{
 	public:
         PointCloudPointSettings m_pointSettings;
+        /**
+         * Scan the scene into memory. The label lists are only filled when enabled in the point settings.
+         * @param captureSettings The settings that generate the samples.
+         * @param pointCloud The output.
+         * @return False if scanning is unavailable (requires the ray tracer) or there is no soil or tree in the scene.
+         */
+        bool Scan(const std::shared_ptr<PointCloudCaptureSettings>& captureSettings, ScannedPointCloud& pointCloud) const;
         void Capture(const std::filesystem::path& savePath, const std::shared_ptr<PointCloudCaptureSettings>& captureSettings) const;
 		void OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) override;
 
@@ -41,6 +41,26 @@ namespace EcoSysLab {
 		std::vector<glm::vec4> m_randomColors;
 
 		std::shared_ptr<ParticleInfoList> m_internodeMatrices;
+		/**
+		 * The instance of every node in m_internodeMatrices, indexed by node handle.
+		 */
+		std::vector<int> m_internodeInstanceIndices;
+		std::vector<NodeHandle> m_changedInternodes;
+		int m_syncedIteration = -1;
+		int m_syncedVersion = -1;
+		int m_syncedChangeVersion = -1;
+
+		[[nodiscard]] static glm::mat4 GetInternodeMatrix(const NodeInfo& nodeInfo);
+		[[nodiscard]] glm::vec4 GetInternodeColor(const Node<InternodeGrowthData>& node) const;
+		/**
+		 * Update the instances of the nodes that changed since the last sync.
+		 * @return False if the structure changed or the skeleton is a different one, everything needs to be synced.
+		 */
+		bool SyncChangedInternodes(const ShootSkeleton& skeleton);
+		/**
+		 * Compare the patched instances with the ones a full sync produces and log the result.
+		 */
+		void VerifyInternodeInstances(const ShootSkeleton& skeleton) const;
 
 		
 		
@@ -69,6 +89,10 @@ namespace EcoSysLab {
 		int m_checkpointIteration = 0;
 		bool m_needUpdate = false;
 		bool m_needShootColorUpdate = false;
+		/**
+		 * Check every incremental sync against a full sync of the matrices and colors.
+		 */
+		bool m_verifyIncrementalSync = false;
 
 		[[nodiscard]] bool Initialized() const;
 		void ClearSelections();
@@ -0,0 +1,226 @@
+#include "BinvoxVolume.hpp"
+
+using namespace EcoSysLab;
+
+static unsigned PopCount(uint64_t word)
+{
+	word = word - ((word >> 1) & 0x5555555555555555ull);
+	word = (word & 0x3333333333333333ull) + ((word >> 2) & 0x3333333333333333ull);
+	word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return static_cast<unsigned>((word * 0x0101010101010101ull) >> 56);
+}
+
+size_t BinvoxVolume::GetBitIndex(const glm::ivec3& coordinate) const
+{
+	return (static_cast<size_t>(coordinate.z) * m_resolution.y + coordinate.x) * m_resolution.x + coordinate.y;
+}
+
+size_t BinvoxVolume::CountBits(const size_t begin, const size_t end) const
+{
+	if (begin >= end) return 0;
+	const size_t firstWord = begin >> 6;
+	const size_t lastWord = (end - 1) >> 6;
+	const uint64_t firstMask = ~0ull << (begin & 63);
+	const uint64_t lastMask = ~0ull >> (63 - ((end - 1) & 63));
+	if (firstWord == lastWord) return PopCount(m_bits[firstWord] & firstMask & lastMask);
+	size_t count = PopCount(m_bits[firstWord] & firstMask) + PopCount(m_bits[lastWord] & lastMask);
+	for (size_t word = firstWord + 1; word < lastWord; word++) count += PopCount(m_bits[word]);
+	return count;
+}
+
+bool BinvoxVolume::Load(const std::filesystem::path& filePath, const float voxelSize)
+{
+	m_bits.clear();
+	m_resolution = glm::ivec3(0);
+	m_minBound = glm::vec3(0.0f);
+	m_voxelSize = voxelSize;
+	m_occupiedCount = 0;
+
+	std::ifstream input(filePath, std::ios::in | std::ios::binary | std::ios::ate);
+	if (!input.is_open())
+	{
+		EVOENGINE_ERROR("Binvox: could not open file " + filePath.string());
+		return false;
+	}
+	std::vector<unsigned char> buffer(static_cast<size_t>(input.tellg()));
+	input.seekg(0);
+	input.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+	input.close();
+
+	size_t cursor = 0;
+	const auto nextToken = [&]()
+		{
+			while (cursor < buffer.size() && std::isspace(buffer[cursor])) cursor++;
+			const auto start = cursor;
+			while (cursor < buffer.size() && !std::isspace(buffer[cursor])) cursor++;
+			return std::string(buffer.begin() + start, buffer.begin() + cursor);
+		};
+	if (nextToken() != "#binvox")
+	{
+		EVOENGINE_ERROR("Binvox: " + filePath.string() + " is not a binvox file");
+		return false;
+	}
+	nextToken();
+	int depth = -1, height = -1, width = -1;
+	bool done = false;
+	while (cursor < buffer.size() && !done)
+	{
+		const auto token = nextToken();
+		if (token == "data") done = true;
+		else if (token == "dim")
+		{
+			depth = std::atoi(nextToken().c_str());
+			height = std::atoi(nextToken().c_str());
+			width = std::atoi(nextToken().c_str());
+		}
+		else {
+			while (cursor < buffer.size() && buffer[cursor] != '\n') cursor++;
+		}
+	}
+	if (!done || depth <= 0 || height <= 0 || width <= 0)
+	{
+		EVOENGINE_ERROR("Binvox: error reading the header of " + filePath.string());
+		return false;
+	}
+	//Skip the linefeed after "data".
+	cursor++;
+
+	m_resolution = glm::ivec3(width, height, depth);
+	const size_t voxelCount = static_cast<size_t>(width) * height * depth;
+	m_bits.resize((voxelCount + 63) / 64, 0);
+	size_t index = 0;
+	while (index < voxelCount && cursor + 1 < buffer.size())
+	{
+		const auto value = buffer[cursor];
+		const auto count = buffer[cursor + 1];
+		cursor += 2;
+		const size_t endIndex = index + count;
+		if (endIndex > voxelCount)
+		{
+			EVOENGINE_ERROR("Binvox: the runs of " + filePath.string() + " exceed the volume");
+			m_bits.clear();
+			return false;
+		}
+		if (value && endIndex > index)
+		{
+			const size_t firstWord = index >> 6;
+			const size_t lastWord = (endIndex - 1) >> 6;
+			const uint64_t firstMask = ~0ull << (index & 63);
+			const uint64_t lastMask = ~0ull >> (63 - ((endIndex - 1) & 63));
+			if (firstWord == lastWord) m_bits[firstWord] |= firstMask & lastMask;
+			else {
+				m_bits[firstWord] |= firstMask;
+				std::fill(m_bits.begin() + firstWord + 1, m_bits.begin() + lastWord, ~0ull);
+				m_bits[lastWord] |= lastMask;
+			}
+		}
+		index = endIndex;
+	}
+	m_occupiedCount = CountBits(0, voxelCount);
+
+	//Each row of the file runs along y, so the occupied voxels of the lowest fifth are counted row by row.
+	int lowLimit = 0;
+	while (lowLimit < width && lowLimit < height * 0.2f) lowLimit++;
+	std::vector<glm::dvec2> lowSums(depth, glm::dvec2(0.0));
+	std::vector<size_t> lowCounts(depth, 0);
+	Jobs::ParallelFor(depth, [&](unsigned z)
+		{
+			for (int x = 0; x < height; x++)
+			{
+				const auto rowStart = (static_cast<size_t>(z) * height + x) * width;
+				const auto count = CountBits(rowStart, rowStart + lowLimit);
+				lowSums[z] += glm::dvec2(x + 0.5, z + 0.5) * static_cast<double>(count);
+				lowCounts[z] += count;
+			}
+		}
+	);
+	glm::dvec2 lowSum = glm::dvec2(0.0);
+	size_t lowSumCount = 0;
+	for (int z = 0; z < depth; z++)
+	{
+		lowSum += lowSums[z];
+		lowSumCount += lowCounts[z];
+	}
+	if (lowSumCount != 0)
+	{
+		lowSum *= m_voxelSize / static_cast<double>(lowSumCount);
+		m_minBound = -glm::vec3(lowSum.x, 0.0f, lowSum.y);
+	}
+	return true;
+}
+
+void BinvoxVolume::LoadFolder(const std::filesystem::path& folderPath, std::vector<BinvoxVolume>& volumes,
+	std::vector<std::filesystem::path>& paths, const float voxelSize)
+{
+	volumes.clear();
+	paths.clear();
+	if (!std::filesystem::is_directory(folderPath)) return;
+	std::vector<std::filesystem::path> candidates;
+	for (const auto& entry : std::filesystem::directory_iterator(folderPath))
+	{
+		if (entry.is_regular_file() && entry.path().extension().string() == ".binvox") candidates.emplace_back(entry.path());
+	}
+	std::sort(candidates.begin(), candidates.end());
+	std::vector<BinvoxVolume> candidateVolumes(candidates.size());
+	std::vector<unsigned char> loaded(candidates.size(), 0);
+	Jobs::ParallelFor(candidates.size(), [&](unsigned i)
+		{
+			loaded[i] = candidateVolumes[i].Load(candidates[i], voxelSize) ? 1 : 0;
+		}
+	);
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		if (!loaded[i]) continue;
+		volumes.emplace_back(std::move(candidateVolumes[i]));
+		paths.emplace_back(candidates[i]);
+	}
+}
+
+bool BinvoxVolume::IsOccupied(const glm::ivec3& coordinate) const
+{
+	if (coordinate.x < 0 || coordinate.y < 0 || coordinate.z < 0
+		|| coordinate.x >= m_resolution.x || coordinate.y >= m_resolution.y || coordinate.z >= m_resolution.z) return false;
+	const auto bitIndex = GetBitIndex(coordinate);
+	if (bitIndex >= m_bits.size() * 64) return false;
+	return (m_bits[bitIndex >> 6] >> (bitIndex & 63)) & 1;
+}
+
+bool BinvoxVolume::IsOccupied(const glm::vec3& position) const
+{
+	return IsOccupied(glm::ivec3(glm::floor((position - m_minBound) / m_voxelSize)));
+}
+
+glm::ivec3 BinvoxVolume::GetResolution() const
+{
+	return m_resolution;
+}
+
+glm::vec3 BinvoxVolume::GetMinBound() const
+{
+	return m_minBound;
+}
+
+glm::vec3 BinvoxVolume::GetMaxBound() const
+{
+	return m_minBound + glm::vec3(m_resolution) * m_voxelSize;
+}
+
+float BinvoxVolume::GetVoxelSize() const
+{
+	return m_voxelSize;
+}
+
+size_t BinvoxVolume::GetOccupiedCount() const
+{
+	return m_occupiedCount;
+}
+
+void BinvoxVolume::ToVoxelGrid(VoxelGrid<TreeOccupancyGridBasicData>& voxelGrid) const
+{
+	voxelGrid.Initialize(m_voxelSize, m_resolution, m_minBound, {});
+	Jobs::ParallelFor(voxelGrid.GetVoxelCount(), [&](unsigned i)
+		{
+			voxelGrid.Ref(static_cast<int>(i)).m_occupied = IsOccupied(voxelGrid.GetCoordinate(static_cast<int>(i)));
+		}
+	);
+}
@@ -0,0 +1,258 @@
+#include "BitVoxelGrid.hpp"
+#include "Jobs.hpp"
+#include "MarchingCubes.hpp"
+using namespace EcoSysLab;
+
+static float DistanceToSegment(const glm::vec3& position, const glm::vec3& start, const glm::vec3& end)
+{
+	const auto axis = end - start;
+	const float lengthSquared = glm::dot(axis, axis);
+	if (lengthSquared <= 0.0f) return glm::distance(position, start);
+	const float t = glm::clamp(glm::dot(position - start, axis) / lengthSquared, 0.0f, 1.0f);
+	return glm::distance(position, start + axis * t);
+}
+
+int BitVoxelGrid::GetBrickIndex(const glm::ivec3& brickCoordinate) const
+{
+	const auto search = m_brickIndices.find(brickCoordinate);
+	if (search == m_brickIndices.end()) return -1;
+	return search->second;
+}
+
+bool BitVoxelGrid::IsOccupied(const int brickIndex, const glm::ivec3& localCoordinate) const
+{
+	return (m_bits[brickIndex * 8 + localCoordinate.z].load(std::memory_order_relaxed) >> (localCoordinate.x + 8 * localCoordinate.y)) & 1;
+}
+
+void BitVoxelGrid::Initialize(const float voxelSize, const glm::vec3& minBound, const glm::vec3& maxBound)
+{
+	m_voxelSize = voxelSize;
+	m_minBound = minBound;
+	m_resolution = glm::max(glm::ivec3(glm::ceil((maxBound - minBound) / voxelSize)), glm::ivec3(1));
+	m_brickIndices.clear();
+	m_brickCoordinates.clear();
+	std::vector<std::atomic<uint64_t>> bits{};
+	m_bits.swap(bits);
+}
+
+void BitVoxelGrid::RasterizeCapsules(const std::vector<glm::vec3>& starts, const std::vector<glm::vec3>& ends,
+	const std::vector<float>& radii)
+{
+	assert(starts.size() == ends.size() && starts.size() == radii.size());
+	std::vector<glm::ivec3> voxelMins(starts.size());
+	std::vector<glm::ivec3> voxelMaxs(starts.size());
+	//A marching cube cell is handled by the brick of its lower corner, so a brick is needed when one of its voxels or
+	//the next voxel along any axis is occupied. The bricks are tested as a whole against the capsules first.
+	std::vector<std::vector<glm::ivec3>> capsuleBricks(starts.size());
+	const float brickRadius = 4.0f * m_voxelSize * glm::sqrt(3.0f);
+	Jobs::ParallelFor(starts.size(), [&](unsigned capsuleIndex)
+		{
+			const auto& start = starts[capsuleIndex];
+			const auto& end = ends[capsuleIndex];
+			const float radius = radii[capsuleIndex];
+			const auto boxMin = glm::min(start, end) - radius;
+			const auto boxMax = glm::max(start, end) + radius;
+			const auto voxelMin = glm::max(glm::ivec3(glm::ceil((boxMin - m_minBound) / m_voxelSize - 0.5f)), glm::ivec3(0));
+			const auto voxelMax = glm::min(glm::ivec3(glm::floor((boxMax - m_minBound) / m_voxelSize - 0.5f)), m_resolution - 1);
+			voxelMins[capsuleIndex] = voxelMin;
+			voxelMaxs[capsuleIndex] = voxelMax;
+			if (voxelMin.x > voxelMax.x || voxelMin.y > voxelMax.y || voxelMin.z > voxelMax.z) return;
+			const auto brickMin = glm::max(voxelMin - 1, glm::ivec3(0)) / 8;
+			const auto brickMax = voxelMax / 8;
+			for (int x = brickMin.x; x <= brickMax.x; x++)
+			{
+				for (int y = brickMin.y; y <= brickMax.y; y++)
+				{
+					for (int z = brickMin.z; z <= brickMax.z; z++)
+					{
+						const auto brickCenter = m_minBound + (glm::vec3(x, y, z) * 8.0f + 4.5f) * m_voxelSize;
+						if (DistanceToSegment(brickCenter, start, end) > radius + brickRadius) continue;
+						capsuleBricks[capsuleIndex].emplace_back(x, y, z);
+					}
+				}
+			}
+		}
+	);
+	//The new bricks are numbered in x, y, z order, so the output does not depend on the order of the capsules.
+	std::vector<glm::ivec3> newBrickCoordinates{};
+	for (const auto& bricks : capsuleBricks)
+	{
+		for (const auto& brickCoordinate : bricks)
+		{
+			if (m_brickIndices.emplace(brickCoordinate, -1).second) newBrickCoordinates.emplace_back(brickCoordinate);
+		}
+	}
+	std::sort(newBrickCoordinates.begin(), newBrickCoordinates.end(), [](const glm::ivec3& a, const glm::ivec3& b)
+		{
+			if (a.z != b.z) return a.z < b.z;
+			if (a.y != b.y) return a.y < b.y;
+			return a.x < b.x;
+		});
+	for (const auto& brickCoordinate : newBrickCoordinates)
+	{
+		m_brickIndices[brickCoordinate] = static_cast<int>(m_brickCoordinates.size());
+		m_brickCoordinates.emplace_back(brickCoordinate);
+	}
+	if (m_bits.size() != m_brickCoordinates.size() * 8)
+	{
+		std::vector<std::atomic<uint64_t>> bits(m_brickCoordinates.size() * 8);
+		for (size_t i = 0; i < m_bits.size(); i++) bits[i].store(m_bits[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+		m_bits.swap(bits);
+	}
+
+	//The voxels are visited brick by brick, so the brick is looked up once and not for every voxel.
+	Jobs::ParallelFor(starts.size(), [&](unsigned capsuleIndex)
+		{
+			const auto& start = starts[capsuleIndex];
+			const auto& end = ends[capsuleIndex];
+			const float radius = radii[capsuleIndex];
+			const auto& voxelMin = voxelMins[capsuleIndex];
+			const auto& voxelMax = voxelMaxs[capsuleIndex];
+			if (voxelMin.x > voxelMax.x || voxelMin.y > voxelMax.y || voxelMin.z > voxelMax.z) return;
+			for (int brickZ = voxelMin.z / 8; brickZ <= voxelMax.z / 8; brickZ++)
+			{
+				for (int brickY = voxelMin.y / 8; brickY <= voxelMax.y / 8; brickY++)
+				{
+					for (int brickX = voxelMin.x / 8; brickX <= voxelMax.x / 8; brickX++)
+					{
+						const glm::ivec3 brickCoordinate = { brickX, brickY, brickZ };
+						const auto brickIndex = GetBrickIndex(brickCoordinate);
+						if (brickIndex == -1) continue;
+						const auto rangeMin = glm::max(voxelMin, brickCoordinate * 8);
+						const auto rangeMax = glm::min(voxelMax, brickCoordinate * 8 + 7);
+						for (int z = rangeMin.z; z <= rangeMax.z; z++)
+						{
+							for (int y = rangeMin.y; y <= rangeMax.y; y++)
+							{
+								for (int x = rangeMin.x; x <= rangeMax.x; x++)
+								{
+									const glm::ivec3 coordinate = { x, y, z };
+									if (DistanceToSegment(GetPosition(coordinate), start, end) > radius) continue;
+									const auto local = coordinate % 8;
+									m_bits[brickIndex * 8 + local.z].fetch_or(uint64_t(1) << (local.x + 8 * local.y), std::memory_order_relaxed);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	);
+}
+
+bool BitVoxelGrid::IsOccupied(const glm::ivec3& coordinate) const
+{
+	if (coordinate.x < 0 || coordinate.y < 0 || coordinate.z < 0
+		|| coordinate.x >= m_resolution.x || coordinate.y >= m_resolution.y || coordinate.z >= m_resolution.z) return false;
+	const auto brickIndex = GetBrickIndex(coordinate / 8);
+	if (brickIndex == -1) return false;
+	return IsOccupied(brickIndex, coordinate % 8);
+}
+
+glm::vec3 BitVoxelGrid::GetPosition(const glm::ivec3& coordinate) const
+{
+	return m_minBound + (glm::vec3(coordinate) + 0.5f) * m_voxelSize;
+}
+
+glm::ivec3 BitVoxelGrid::GetResolution() const
+{
+	return m_resolution;
+}
+
+size_t BitVoxelGrid::GetBrickCount() const
+{
+	return m_brickCoordinates.size();
+}
+
+void BitVoxelGrid::Triangulate(std::vector<Vertex>& vertices, std::vector<unsigned>& indices, const bool removeDuplicate) const
+{
+	//The corners in the order of the marching cubes tables.
+	static const glm::ivec3 cornerOffsets[8] = {
+		{0, 0, 0}, {1, 0, 0}, {1, 0, 1}, {0, 0, 1},
+		{0, 1, 0}, {1, 1, 0}, {1, 1, 1}, {0, 1, 1}
+	};
+	//The values are either 0 or 1, so every surface vertex sits in the middle of a cell edge and is identified by the
+	//sum of the coordinates of the two corners.
+	std::vector<std::vector<glm::ivec3>> brickEdgeKeys(m_brickCoordinates.size());
+	Jobs::ParallelFor(m_brickCoordinates.size(), [&](unsigned brickIndex)
+		{
+			auto& edgeKeys = brickEdgeKeys[brickIndex];
+			const auto& brickCoordinate = m_brickCoordinates[brickIndex];
+			const auto brickStart = brickCoordinate * 8;
+			//The cells of the brick reach one voxel into the next bricks along each axis, so those are looked up once here.
+			int neighborBrickIndices[8];
+			for (int i = 0; i < 8; i++)
+			{
+				neighborBrickIndices[i] = GetBrickIndex(brickCoordinate + glm::ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+			}
+			//Bricks are allocated by a conservative test, so many of them and their neighbors hold no voxel at all.
+			bool empty = true;
+			for (int i = 0; i < 8 && empty; i++)
+			{
+				if (neighborBrickIndices[i] == -1) continue;
+				for (int z = 0; z < 8 && empty; z++)
+				{
+					if (m_bits[neighborBrickIndices[i] * 8 + z].load(std::memory_order_relaxed) != 0) empty = false;
+				}
+			}
+			if (empty) return;
+			const auto isOccupied = [&](const glm::ivec3& relativeCoordinate)
+				{
+					const auto brickOffset = relativeCoordinate / 8;
+					const auto neighborBrickIndex = neighborBrickIndices[brickOffset.x + 2 * brickOffset.y + 4 * brickOffset.z];
+					if (neighborBrickIndex == -1) return false;
+					return IsOccupied(neighborBrickIndex, relativeCoordinate % 8);
+				};
+			for (int z = 0; z < 8; z++)
+			{
+				for (int y = 0; y < 8; y++)
+				{
+					for (int x = 0; x < 8; x++)
+					{
+						const glm::ivec3 relativeCoordinate = { x, y, z };
+						const auto coordinate = brickStart + relativeCoordinate;
+						int cubeIndex = 0;
+						for (int i = 0; i < 8; i++)
+						{
+							if (!isOccupied(relativeCoordinate + cornerOffsets[i])) cubeIndex |= 1 << i;
+						}
+						if (cubeIndex == 0 || cubeIndex == 255) continue;
+						for (int i = 0; MarchingCubes::m_triangleTable[cubeIndex][i] != -1; i += 3)
+						{
+							for (int j = 2; j >= 0; j--)
+							{
+								const auto& edge = MarchingCubes::m_edgeToVertices[MarchingCubes::m_triangleTable[cubeIndex][i + j]];
+								edgeKeys.emplace_back(2 * coordinate + cornerOffsets[edge.first] + cornerOffsets[edge.second]);
+							}
+						}
+					}
+				}
+			}
+		}
+	);
+	size_t vertexCount = 0;
+	for (const auto& edgeKeys : brickEdgeKeys) vertexCount += edgeKeys.size();
+	indices.reserve(indices.size() + vertexCount);
+	if (!removeDuplicate) vertices.reserve(vertices.size() + vertexCount);
+	std::unordered_map<glm::ivec3, unsigned> vertexIndices{};
+	Vertex archetype{};
+	for (const auto& edgeKeys : brickEdgeKeys)
+	{
+		for (const auto& edgeKey : edgeKeys)
+		{
+			if (removeDuplicate)
+			{
+				const auto search = vertexIndices.find(edgeKey);
+				if (search != vertexIndices.end())
+				{
+					indices.emplace_back(search->second);
+					continue;
+				}
+				vertexIndices[edgeKey] = vertices.size();
+			}
+			indices.emplace_back(vertices.size());
+			archetype.m_position = m_minBound + (glm::vec3(edgeKey) * 0.5f + 0.5f) * m_voxelSize;
+			vertices.emplace_back(archetype);
+		}
+	}
+}
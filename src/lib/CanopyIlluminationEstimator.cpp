@@ -0,0 +1,218 @@
+#include "CanopyIlluminationEstimator.hpp"
+#include "Jobs.hpp"
+
+using namespace EcoSysLab;
+
+bool CanopyIlluminationSettings::OnInspect() {
+  bool changed = false;
+  if (ImGui::DragInt("Sky sample resolution", &m_skySampleResolution, 1, 1, 64))
+    changed = true;
+  if (ImGui::DragFloat("Diffuse fraction", &m_diffuseFraction, 0.01f, 0.0f, 1.0f))
+    changed = true;
+  if (ImGui::DragFloat("PAR fraction", &m_parFraction, 0.01f, 0.0f, 1.0f))
+    changed = true;
+  if (ImGui::DragFloat("Push distance along normal", &m_pushNormalDistance, 0.0001f, 0.0f, 1.0f, "%.5f"))
+    changed = true;
+  if (ImGui::DragScalar("Seed", ImGuiDataType_U32, &m_seed))
+    changed = true;
+  return changed;
+}
+
+void CanopyIlluminationEstimator::Build(const std::vector<glm::vec3> &positions,
+                                        const std::vector<glm::uvec3> &triangles) {
+  m_positions = positions;
+  m_triangles = triangles;
+  m_nodes.clear();
+  m_triangleIndices.resize(m_triangles.size());
+  std::vector<glm::vec3> centroids(m_triangles.size());
+  for (unsigned i = 0; i < m_triangles.size(); i++) {
+    m_triangleIndices[i] = i;
+    const auto &triangle = m_triangles[i];
+    centroids[i] = (m_positions[triangle.x] + m_positions[triangle.y] + m_positions[triangle.z]) / 3.0f;
+  }
+  if (m_triangles.empty())
+    return;
+  m_nodes.reserve(2 * m_triangles.size() / 4 + 1);
+  BuildNode(0, m_triangles.size(), centroids);
+}
+
+unsigned CanopyIlluminationEstimator::BuildNode(const unsigned start, const unsigned count,
+                                                const std::vector<glm::vec3> &centroids) {
+  const auto nodeIndex = static_cast<unsigned>(m_nodes.size());
+  m_nodes.emplace_back();
+  glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+  glm::vec3 centroidMin = min;
+  glm::vec3 centroidMax = max;
+  for (unsigned i = start; i < start + count; i++) {
+    const auto &triangle = m_triangles[m_triangleIndices[i]];
+    for (int j = 0; j < 3; j++) {
+      min = glm::min(min, m_positions[triangle[j]]);
+      max = glm::max(max, m_positions[triangle[j]]);
+    }
+    centroidMin = glm::min(centroidMin, centroids[m_triangleIndices[i]]);
+    centroidMax = glm::max(centroidMax, centroids[m_triangleIndices[i]]);
+  }
+  m_nodes[nodeIndex].m_min = min;
+  m_nodes[nodeIndex].m_max = max;
+  const auto extent = centroidMax - centroidMin;
+  if (count <= 4 || glm::max(extent.x, glm::max(extent.y, extent.z)) <= 0.0f) {
+    m_nodes[nodeIndex].m_start = start;
+    m_nodes[nodeIndex].m_count = count;
+    return nodeIndex;
+  }
+  // Median split along the longest axis of the centroids.
+  const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+  const auto half = count / 2;
+  std::nth_element(m_triangleIndices.begin() + start, m_triangleIndices.begin() + start + half,
+                   m_triangleIndices.begin() + start + count,
+                   [&](const unsigned a, const unsigned b) { return centroids[a][axis] < centroids[b][axis]; });
+  BuildNode(start, half, centroids);
+  const auto secondChild = BuildNode(start + half, count - half, centroids);
+  m_nodes[nodeIndex].m_start = secondChild;
+  return nodeIndex;
+}
+
+bool CanopyIlluminationEstimator::IsOccluded(const glm::vec3 &origin, const glm::vec3 &direction,
+                                             const int ignoredTriangle) const {
+  if (m_nodes.empty())
+    return false;
+  const auto inverseDirection = 1.0f / direction;
+  unsigned stack[64];
+  int stackSize = 0;
+  stack[stackSize++] = 0;
+  while (stackSize > 0) {
+    const auto nodeIndex = stack[--stackSize];
+    const auto &node = m_nodes[nodeIndex];
+    // Slab test, the ray is unbounded.
+    const auto t0 = (node.m_min - origin) * inverseDirection;
+    const auto t1 = (node.m_max - origin) * inverseDirection;
+    const auto tMin = glm::min(t0, t1);
+    const auto tMax = glm::max(t0, t1);
+    const float enter = glm::max(tMin.x, glm::max(tMin.y, tMin.z));
+    const float exit = glm::min(tMax.x, glm::min(tMax.y, tMax.z));
+    if (exit < glm::max(enter, 0.0f))
+      continue;
+    if (node.m_count == 0) {
+      stack[stackSize++] = node.m_start;
+      stack[stackSize++] = nodeIndex + 1;
+      continue;
+    }
+    for (unsigned i = node.m_start; i < node.m_start + node.m_count; i++) {
+      const auto triangleIndex = m_triangleIndices[i];
+      if (static_cast<int>(triangleIndex) == ignoredTriangle)
+        continue;
+      const auto &triangle = m_triangles[triangleIndex];
+      const auto &p0 = m_positions[triangle.x];
+      const auto e1 = m_positions[triangle.y] - p0;
+      const auto e2 = m_positions[triangle.z] - p0;
+      const auto p = glm::cross(direction, e2);
+      const float determinant = glm::dot(e1, p);
+      if (glm::abs(determinant) < 1e-12f)
+        continue;
+      const float inverseDeterminant = 1.0f / determinant;
+      const auto s = origin - p0;
+      const float u = glm::dot(s, p) * inverseDeterminant;
+      if (u < 0.0f || u > 1.0f)
+        continue;
+      const auto q = glm::cross(s, e1);
+      const float v = glm::dot(direction, q) * inverseDeterminant;
+      if (v < 0.0f || u + v > 1.0f)
+        continue;
+      if (glm::dot(e2, q) * inverseDeterminant > 0.0f)
+        return true;
+    }
+  }
+  return false;
+}
+
+CanopyIrradiance CanopyIlluminationEstimator::EstimateHemisphere(const glm::vec3 &position, const glm::vec3 &normal,
+                                                                 const int ignoredTriangle,
+                                                                 const CanopyIlluminationSettings &settings,
+                                                                 const glm::vec3 &sunDirection, const float ghi,
+                                                                 const unsigned sampleSeed) const {
+  CanopyIrradiance irradiance{};
+  const auto origin = position + normal * settings.m_pushNormalDistance;
+  glm::vec3 directionSum = glm::vec3(0.0f);
+
+  // The sky radiance is uniform, so with cosine weighted samples the irradiance is the horizontal diffuse irradiance
+  // times the visible share of the samples.
+  const int resolution = glm::max(1, settings.m_skySampleResolution);
+  const float sampleEnergy = ghi * settings.m_diffuseFraction / static_cast<float>(resolution * resolution);
+  const auto tangent = glm::normalize(glm::abs(normal.y) < 0.99f ? glm::cross(normal, glm::vec3(0, 1, 0))
+                                                                  : glm::cross(normal, glm::vec3(1, 0, 0)));
+  const auto bitangent = glm::cross(normal, tangent);
+  std::mt19937 random(sampleSeed);
+  std::uniform_real_distribution<float> jitter(0.0f, 1.0f);
+  for (int i = 0; i < resolution; i++) {
+    for (int j = 0; j < resolution; j++) {
+      const float u = (static_cast<float>(i) + jitter(random)) / static_cast<float>(resolution);
+      const float v = (static_cast<float>(j) + jitter(random)) / static_cast<float>(resolution);
+      const float radius = glm::sqrt(u);
+      const float phi = 2.0f * glm::pi<float>() * v;
+      const auto direction = tangent * (radius * glm::cos(phi)) + bitangent * (radius * glm::sin(phi)) +
+                             normal * glm::sqrt(glm::max(0.0f, 1.0f - u));
+      if (direction.y <= 0.0f || IsOccluded(origin, direction, ignoredTriangle))
+        continue;
+      irradiance.m_energy += sampleEnergy;
+      directionSum += direction * sampleEnergy;
+    }
+  }
+
+  const float cosine = glm::dot(normal, sunDirection);
+  if (sunDirection.y > 0.0f && cosine > 0.0f && !IsOccluded(origin, sunDirection, ignoredTriangle)) {
+    // The direct normal irradiance follows from its horizontal share, low suns are clamped so it stays finite.
+    const float directNormal = ghi * (1.0f - settings.m_diffuseFraction) / glm::max(sunDirection.y, 0.05f);
+    irradiance.m_energy += directNormal * cosine;
+    directionSum += sunDirection * directNormal * cosine;
+  }
+  irradiance.m_energy *= settings.m_parFraction;
+  if (glm::length(directionSum) > 0.0f)
+    irradiance.m_direction = glm::normalize(directionSum);
+  return irradiance;
+}
+
+void CanopyIlluminationEstimator::EstimateTriangles(const CanopyIlluminationSettings &settings,
+                                                    const SkyIlluminanceSnapshot &snapshot,
+                                                    std::vector<float> &irradiances) const {
+  irradiances.resize(m_triangles.size());
+  auto sky = snapshot;
+  const auto sunDirection = glm::normalize(sky.GetSunDirection());
+  const float ghi = sky.GetSunIntensity();
+  Jobs::ParallelFor(m_triangles.size(), [&](unsigned triangleIndex) {
+    const auto &triangle = m_triangles[triangleIndex];
+    const auto &p0 = m_positions[triangle.x];
+    const auto &p1 = m_positions[triangle.y];
+    const auto &p2 = m_positions[triangle.z];
+    const auto cross = glm::cross(p1 - p0, p2 - p0);
+    irradiances[triangleIndex] = 0.0f;
+    if (glm::length(cross) <= 0.0f)
+      return;
+    const auto normal = glm::normalize(cross);
+    const auto centroid = (p0 + p1 + p2) / 3.0f;
+    // Seeds depend on the triangle only, so the result does not depend on the scheduling.
+    const auto seed = settings.m_seed * 2654435761u + triangleIndex * 2u;
+    irradiances[triangleIndex] =
+        EstimateHemisphere(centroid, normal, triangleIndex, settings, sunDirection, ghi, seed).m_energy +
+        EstimateHemisphere(centroid, -normal, triangleIndex, settings, sunDirection, ghi, seed + 1u).m_energy;
+  });
+}
+
+void CanopyIlluminationEstimator::EstimatePoints(const std::vector<glm::vec3> &positions,
+                                                 const std::vector<glm::vec3> &normals,
+                                                 const CanopyIlluminationSettings &settings,
+                                                 const SkyIlluminanceSnapshot &snapshot,
+                                                 std::vector<CanopyIrradiance> &irradiances) const {
+  assert(positions.size() == normals.size());
+  irradiances.resize(positions.size());
+  auto sky = snapshot;
+  const auto sunDirection = glm::normalize(sky.GetSunDirection());
+  const float ghi = sky.GetSunIntensity();
+  Jobs::ParallelFor(positions.size(), [&](unsigned pointIndex) {
+    const auto seed = settings.m_seed * 2654435761u + pointIndex * 2u;
+    irradiances[pointIndex] =
+        EstimateHemisphere(positions[pointIndex], glm::normalize(normals[pointIndex]), -1, settings, sunDirection, ghi, seed);
+  });
+}
+
+size_t CanopyIlluminationEstimator::GetTriangleSize() const { return m_triangles.size(); }
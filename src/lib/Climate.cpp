@@ -93,11 +93,22 @@ void Climate::PrepareForGrowth()
 	}
 	if (boundChanged) estimator.m_voxel.Initialize(estimator.m_voxelSize, minBound, maxBound);
 	estimator.m_voxel.Reset();
-	for (const auto& treeEntity : *treeEntities)
-	{
-		const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
-		tree->RegisterVoxel();
-	}
+	//Node registrations are only read by crown shyness.
+	const bool registerNodes = ecoSysLabLayer->m_simulationSettings.m_crownShynessDistance > 0.0f;
+	estimator.PrepareBuffers(Jobs::Workers().Size());
+	std::vector<EnvironmentGridBufferSegment> segments(treeEntities->size());
+	Jobs::ParallelFor(treeEntities->size(), [&](unsigned i, unsigned threadIndex)
+		{
+			const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntities->at(i)).lock();
+			auto& buffer = estimator.m_buffers[threadIndex];
+			auto& segment = segments[i];
+			segment.m_bufferIndex = threadIndex;
+			segment.m_start = buffer.m_contributions.size();
+			tree->RegisterVoxel(buffer, registerNodes);
+			segment.m_end = buffer.m_contributions.size();
+		}
+	);
+	estimator.MergeBuffers(segments);
 
 	estimator.ShadowPropagation();
 }
@@ -122,8 +122,8 @@ void EcoSysLabLayer::Visualization() {
 			auto treeEntity = treeEntities->at(i);
 			auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
 			auto& treeModel = tree->m_treeModel;
-			if (m_shootVersions[i] != treeModel.RefShootSkeleton().GetVersion()) {
-				m_shootVersions[i] = treeModel.RefShootSkeleton().GetVersion();
+			if (m_shootVersions[i] != treeModel.RefShootSkeleton().GetChangeVersion()) {
+				m_shootVersions[i] = treeModel.RefShootSkeleton().GetChangeVersion();
 				m_needFullFlowUpdate = true;
 			}
 		}
@@ -175,6 +175,8 @@ void EcoSysLabLayer::Visualization() {
 		if (editorLayer && scene->IsEntityValid(m_selectedTree))
 		{
 			const auto& tree = scene->GetOrSetPrivateComponent<Tree>(m_selectedTree).lock();
+			//Trees loaded from a scene keep their shoot encoded until they are grown, inspected or meshed.
+			tree->LoadShootSnapshot();
 			auto& treeModel = tree->m_treeModel;
 			auto& treeVisualizer = tree->m_treeVisualizer;
 			const auto globalTransform = scene->GetDataComponent<GlobalTransform>(m_selectedTree);
@@ -205,6 +207,7 @@ void EcoSysLabLayer::Visualization() {
 									treeModel.PruneInternode(childHandle);
 								}
 								pruningInternode.m_data.m_internodeLength *= treeVisualizer.m_selectedInternodeLengthFactor;
+								skeleton.MarkChanged(treeVisualizer.m_selectedInternodeHandle);
 								treeModel.CalculateTransform(tree->m_shootGrowthController, true);
 								treeVisualizer.m_selectedInternodeLengthFactor = 1.0f;
 								for (auto& bud : pruningInternode.m_data.m_buds) {
@@ -280,6 +283,7 @@ void EcoSysLabLayer::Visualization() {
 										if (parentHandle != -1) {
 											internode.m_data.m_desiredLocalRotation = glm::inverse(currentSkeleton.PeekNode(parentHandle).m_data.m_desiredGlobalRotation) * internode.m_data.m_desiredGlobalRotation;
 										}
+										currentSkeleton.MarkChanged(treeVisualizer.m_selectedInternodeHandle);
 										treeModel.CalculateTransform(tree->m_shootGrowthController, true);
 										lastGizmosUsed = true;
 									}
@@ -338,6 +342,7 @@ void EcoSysLabLayer::Visualization() {
 										if (parentHandle != -1) {
 											internode.m_data.m_desiredLocalRotation = glm::inverse(currentSkeleton.PeekNode(parentHandle).m_data.m_desiredGlobalRotation) * internode.m_data.m_desiredGlobalRotation;
 										}
+										currentSkeleton.MarkChanged(treeVisualizer.m_selectedInternodeHandle);
 										treeModel.CalculateTransform(tree->m_shootGrowthController, true);
 										lastGizmosUsed = true;
 									}
@@ -583,6 +588,7 @@ void EcoSysLabLayer::ResetAllTrees(const std::vector<Entity>* treeEntities) {
 		tree->Reset();
 	}
 	m_needFullFlowUpdate = true;
+	m_treeFlowGeometries.clear();
 	m_totalTime = 0;
 	m_internodeSize = 0;
 	m_leafSize = 0;
@@ -649,6 +655,24 @@ void EcoSysLabLayer::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 			FileUtils::SaveFile("Export all trees as OBJ", "OBJ", { ".obj" }, [&](const std::filesystem::path& path) {
 				ExportAllTrees(path);
 				}, false);
+			static float envelopeRadius = 1.5f;
+			static int envelopeMarkersPerVoxel = 5;
+			ImGui::DragFloat("Envelope radius", &envelopeRadius, 0.01f, 0.01f, 10.0f);
+			ImGui::DragInt("Envelope markers per voxel", &envelopeMarkersPerVoxel, 1, 1, 100);
+			FileUtils::OpenFolder("Load envelopes from folder", [&](const std::filesystem::path& path) {
+				std::vector<BinvoxVolume> volumes;
+				std::vector<std::filesystem::path> paths;
+				BinvoxVolume::LoadFolder(path, volumes, paths, 1.f);
+				if (volumes.empty()) return;
+				for (size_t i = 0; i < treeEntities->size(); i++)
+				{
+					const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntities->at(i)).lock();
+					auto& treeGrowthSettings = tree->m_treeModel.m_treeGrowthSettings;
+					treeGrowthSettings.m_useSpaceColonization = true;
+					treeGrowthSettings.m_spaceColonizationAutoResize = false;
+					tree->ApplyEnvelope(volumes[i % volumes.size()], envelopeRadius, envelopeMarkersPerVoxel);
+				}
+				}, false);
 
 			ImGui::Checkbox("Auto generate mesh", &m_autoGenerateMeshAfterEditing);
 			ImGui::Checkbox("Auto generate Skeletal Graph Per Frame", &m_autoGenerateSkeletalGraphEveryFrame);
@@ -806,6 +830,7 @@ void EcoSysLabLayer::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 		if (m_visualization && ImGui::TreeNodeEx("Visualization settings")) {
 			if (ImGui::Button("Update")) {
 				m_needFullFlowUpdate = true;
+				m_treeFlowGeometries.clear();
 			}
 
 			ImGui::Checkbox("Display shoot stem", &m_displayShootStem);
@@ -851,7 +876,8 @@ void EcoSysLabLayer::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 			autoTimeGrow = false;
 			for (const auto& treeEntity : *treeEntities) {
 				auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
-				if (m_autoGenerateMeshAfterEditing)
+				//The trees that did not change during the growth keep their meshes.
+				if (m_autoGenerateMeshAfterEditing && !tree->IsMeshUpToDate())
 				{
 					tree->InitializeMeshRenderer(m_meshGeneratorSettings, -1);
 				}
@@ -1075,190 +1101,195 @@ void EcoSysLabLayer::OnSoilVisualizationMenu() {
 }
 
 void EcoSysLabLayer::UpdateFlows(const std::vector<Entity>* treeEntities, const std::shared_ptr<Strands>& branchStrands) {
-	{
-		const auto scene = Application::GetActiveScene();
-
-		m_boundingBoxMatrices->m_particleInfos.clear();
-		m_boundingBoxMatrices->SetPendingUpdate();
-
-		std::vector<int> branchStartIndices;
-		int branchLastStartIndex = 0;
-		branchStartIndices.emplace_back(branchLastStartIndex);
-
-		std::vector<int> fruitStartIndices;
-		int fruitLastStartIndex = 0;
-		fruitStartIndices.emplace_back(fruitLastStartIndex);
-
-		std::vector<int> leafStartIndices;
-		int leafLastStartIndex = 0;
-		leafStartIndices.emplace_back(leafLastStartIndex);
-
-		if (treeEntities->empty()) {
-			m_shootStemSegments.clear();
-			m_shootStemPoints.clear();
-
-			m_foliageMatrices->m_particleInfos.clear();
-			m_foliageMatrices->SetPendingUpdate();
-			m_fruitMatrices->m_particleInfos.clear();
-			m_fruitMatrices->SetPendingUpdate();
-		}
-
-		for (int listIndex = 0; listIndex < treeEntities->size(); listIndex++) {
-			auto treeEntity = treeEntities->at(listIndex);
-			const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
-			auto& treeModel = tree->m_treeModel;
-			const auto& branchSkeleton = treeModel.RefShootSkeleton();
-			const auto& branchList = branchSkeleton.RefSortedFlowList();
-
-			auto entityGlobalTransform = scene->GetDataComponent<GlobalTransform>(treeEntity);
-			auto& [instanceMatrix, instanceColor] = m_boundingBoxMatrices->m_particleInfos.emplace_back();
-			instanceMatrix.m_value = entityGlobalTransform.m_value *
-				(glm::translate(
-					(branchSkeleton.m_max + branchSkeleton.m_min) / 2.0f) *
-					glm::scale(branchSkeleton.m_max - branchSkeleton.m_min));
-			instanceColor = glm::vec4(m_randomColors[listIndex], 0.05f);
-			if (treeEntity != m_selectedTree) {
-				branchLastStartIndex += branchList.size();
-				branchStartIndices.emplace_back(branchLastStartIndex);
-
-				fruitLastStartIndex += treeModel.GetFruitCount();
-				fruitStartIndices.emplace_back(fruitLastStartIndex);
-
-				leafLastStartIndex += treeModel.GetLeafCount();
-				leafStartIndices.emplace_back(leafLastStartIndex);
+	const auto scene = Application::GetActiveScene();
+	const auto treeSize = treeEntities->size();
+	m_treeFlowGeometries.resize(treeSize);
+	//Regenerate the local space geometry of the trees that changed since it was cached.
+	Jobs::ParallelFor(treeSize, [&](unsigned treeIndex) {
+		const auto treeEntity = treeEntities->at(treeIndex);
+		if (treeEntity == m_selectedTree) return;
+		const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
+		const auto& treeModel = tree->m_treeModel;
+		const auto& branchSkeleton = treeModel.PeekShootSkeleton();
+		auto& geometry = m_treeFlowGeometries[treeIndex];
+		const bool sameStructure = geometry.m_entity == treeEntity && geometry.m_shootVersion == branchSkeleton.GetVersion()
+			&& geometry.m_iteration == treeModel.m_iteration && geometry.m_changeVersion <= branchSkeleton.GetChangeVersion();
+		if (sameStructure && geometry.m_changeVersion == branchSkeleton.GetChangeVersion()) return;
+
+		const auto& branchFlowList = branchSkeleton.RefSortedFlowList();
+		//With the same structure only the flows holding a changed node and the flows attached to them move.
+		std::vector<int> updatedFlowIndices;
+		std::vector<NodeHandle> changedNodes;
+		if (sameStructure && branchSkeleton.CollectChangedNodes(geometry.m_changeVersion, changedNodes)) {
+			std::vector<bool> flowUpdated(branchFlowList.size(), false);
+			const auto addFlow = [&](const FlowHandle flowHandle) {
+				const auto flowIndex = geometry.m_flowIndices[flowHandle];
+				if (flowUpdated[flowIndex]) return;
+				flowUpdated[flowIndex] = true;
+				updatedFlowIndices.emplace_back(flowIndex);
+				};
+			for (const auto& nodeHandle : changedNodes) {
+				const auto flowHandle = branchSkeleton.PeekNode(nodeHandle).GetFlowHandle();
+				addFlow(flowHandle);
+				for (const auto& childFlowHandle : branchSkeleton.PeekFlow(flowHandle).RefChildHandles()) addFlow(childFlowHandle);
 			}
-			else
-			{
-				branchStartIndices.emplace_back(branchLastStartIndex);
-				fruitStartIndices.emplace_back(fruitLastStartIndex);
-				leafStartIndices.emplace_back(leafLastStartIndex);
+		}
+		else {
+			geometry.m_stemPoints.resize(branchFlowList.size() * 6);
+			geometry.m_flowIndices.resize(branchSkeleton.RefRawFlows().size());
+			updatedFlowIndices.resize(branchFlowList.size());
+			for (int i = 0; i < branchFlowList.size(); i++) {
+				geometry.m_flowIndices[branchFlowList[i]] = i;
+				updatedFlowIndices[i] = i;
 			}
 		}
-		m_shootStemSegments.resize(branchLastStartIndex * 3);
-		m_shootStemPoints.resize(branchLastStartIndex * 6);
-		m_foliageMatrices->m_particleInfos.resize(leafLastStartIndex);
-		m_fruitMatrices->m_particleInfos.resize(fruitLastStartIndex);
-		{
-			auto& foliageMatrices = m_foliageMatrices->m_particleInfos;
-			auto& fruitMatrices = m_fruitMatrices->m_particleInfos;
-			Jobs::ParallelFor(treeEntities->size(), [&](unsigned treeIndex) {
-				auto treeEntity = treeEntities->at(treeIndex);
-				if (treeEntity == m_selectedTree) return;
-				auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
-				auto& treeModel = tree->m_treeModel;
-				const auto& branchSkeleton = treeModel.RefShootSkeleton();
-				const auto& branchFlowList = branchSkeleton.RefSortedFlowList();
-				const auto& internodeList = branchSkeleton.RefSortedNodeList();
-				auto entityGlobalTransform = scene->GetDataComponent<GlobalTransform>(treeEntity);
-				auto branchStartIndex = branchStartIndices[treeIndex];
-				for (int i = 0; i < branchFlowList.size(); i++) {
-					auto& flow = branchSkeleton.PeekFlow(branchFlowList[i]);
-					auto cp1 = flow.m_info.m_globalStartPosition;
-					auto cp4 = flow.m_info.m_globalEndPosition;
-					float distance = glm::distance(cp1, cp4);
-					glm::vec3 cp0, cp2;
-					if (flow.GetParentHandle() > 0) {
-						cp0 = cp1 + branchSkeleton.PeekFlow(flow.GetParentHandle()).m_info.m_globalEndRotation *
-							glm::vec3(0, 0, 1) * distance / 3.0f;
-						cp2 = cp1 + branchSkeleton.PeekFlow(flow.GetParentHandle()).m_info.m_globalEndRotation *
-							glm::vec3(0, 0, -1) * distance / 3.0f;
-					}
-					else {
-						cp0 = cp1 + flow.m_info.m_globalStartRotation * glm::vec3(0, 0, 1) * distance / 3.0f;
-						cp2 = cp1 + flow.m_info.m_globalStartRotation * glm::vec3(0, 0, -1) * distance / 3.0f;
-					}
-					auto cp3 = cp4 + flow.m_info.m_globalEndRotation * glm::vec3(0, 0, 1) * distance / 3.0f;
-					auto cp5 = cp4 + flow.m_info.m_globalEndRotation * glm::vec3(0, 0, -1) * distance / 3.0f;
-
-					auto& p0 = m_shootStemPoints[branchStartIndex * 6 + i * 6];
-					auto& p1 = m_shootStemPoints[branchStartIndex * 6 + i * 6 + 1];
-					auto& p2 = m_shootStemPoints[branchStartIndex * 6 + i * 6 + 2];
-					auto& p3 = m_shootStemPoints[branchStartIndex * 6 + i * 6 + 3];
-					auto& p4 = m_shootStemPoints[branchStartIndex * 6 + i * 6 + 4];
-					auto& p5 = m_shootStemPoints[branchStartIndex * 6 + i * 6 + 5];
-					p0.m_position = (entityGlobalTransform.m_value *
-						glm::translate(cp0))[3];
-					p1.m_position = (entityGlobalTransform.m_value *
-						glm::translate(cp1))[3];
-					p2.m_position = (entityGlobalTransform.m_value *
-						glm::translate(cp2))[3];
-					p3.m_position = (entityGlobalTransform.m_value *
-						glm::translate(cp3))[3];
-					p4.m_position = (entityGlobalTransform.m_value *
-						glm::translate(cp4))[3];
-					p5.m_position = (entityGlobalTransform.m_value *
-						glm::translate(cp5))[3];
-					if (flow.GetParentHandle() > 0) {
-						p1.m_thickness = branchSkeleton.PeekFlow(flow.GetParentHandle()).m_info.m_endThickness;
-					}
-					else {
-						p1.m_thickness = flow.m_info.m_startThickness;
-					}
-					p4.m_thickness = flow.m_info.m_endThickness;
-
+		geometry.m_entity = treeEntity;
+		geometry.m_shootVersion = branchSkeleton.GetVersion();
+		geometry.m_changeVersion = branchSkeleton.GetChangeVersion();
+		geometry.m_iteration = treeModel.m_iteration;
+
+		for (const auto& i : updatedFlowIndices) {
+			auto& flow = branchSkeleton.PeekFlow(branchFlowList[i]);
+			auto cp1 = flow.m_info.m_globalStartPosition;
+			auto cp4 = flow.m_info.m_globalEndPosition;
+			float distance = glm::distance(cp1, cp4);
+			glm::vec3 cp0, cp2;
+			if (flow.GetParentHandle() > 0) {
+				cp0 = cp1 + branchSkeleton.PeekFlow(flow.GetParentHandle()).m_info.m_globalEndRotation *
+					glm::vec3(0, 0, 1) * distance / 3.0f;
+				cp2 = cp1 + branchSkeleton.PeekFlow(flow.GetParentHandle()).m_info.m_globalEndRotation *
+					glm::vec3(0, 0, -1) * distance / 3.0f;
+			}
+			else {
+				cp0 = cp1 + flow.m_info.m_globalStartRotation * glm::vec3(0, 0, 1) * distance / 3.0f;
+				cp2 = cp1 + flow.m_info.m_globalStartRotation * glm::vec3(0, 0, -1) * distance / 3.0f;
+			}
+			auto cp3 = cp4 + flow.m_info.m_globalEndRotation * glm::vec3(0, 0, 1) * distance / 3.0f;
+			auto cp5 = cp4 + flow.m_info.m_globalEndRotation * glm::vec3(0, 0, -1) * distance / 3.0f;
+
+			auto& p0 = geometry.m_stemPoints[i * 6];
+			auto& p1 = geometry.m_stemPoints[i * 6 + 1];
+			auto& p2 = geometry.m_stemPoints[i * 6 + 2];
+			auto& p3 = geometry.m_stemPoints[i * 6 + 3];
+			auto& p4 = geometry.m_stemPoints[i * 6 + 4];
+			auto& p5 = geometry.m_stemPoints[i * 6 + 5];
+			p0.m_position = cp0;
+			p1.m_position = cp1;
+			p2.m_position = cp2;
+			p3.m_position = cp3;
+			p4.m_position = cp4;
+			p5.m_position = cp5;
+			if (flow.GetParentHandle() > 0) {
+				p1.m_thickness = branchSkeleton.PeekFlow(flow.GetParentHandle()).m_info.m_endThickness;
+			}
+			else {
+				p1.m_thickness = flow.m_info.m_startThickness;
+			}
+			p4.m_thickness = flow.m_info.m_endThickness;
 
-					p2.m_thickness = p3.m_thickness = (p1.m_thickness + p4.m_thickness) / 2.0f;
-					p0.m_thickness = 2.0f * p1.m_thickness - p2.m_thickness;
-					p5.m_thickness = 2.0f * p4.m_thickness - p3.m_thickness;
 
+			p2.m_thickness = p3.m_thickness = (p1.m_thickness + p4.m_thickness) / 2.0f;
+			p0.m_thickness = 2.0f * p1.m_thickness - p2.m_thickness;
+			p5.m_thickness = 2.0f * p4.m_thickness - p3.m_thickness;
 
-					p0.m_color = glm::vec4(m_randomColors[flow.m_data.m_order], 1.0f);
-					p1.m_color = glm::vec4(m_randomColors[flow.m_data.m_order], 1.0f);
-					p2.m_color = glm::vec4(m_randomColors[flow.m_data.m_order], 1.0f);
-					p3.m_color = glm::vec4(m_randomColors[flow.m_data.m_order], 1.0f);
-					p4.m_color = glm::vec4(m_randomColors[flow.m_data.m_order], 1.0f);
-					p5.m_color = glm::vec4(m_randomColors[flow.m_data.m_order], 1.0f);
+			const auto color = glm::vec4(m_randomColors[flow.m_data.m_order], 1.0f);
+			p0.m_color = p1.m_color = p2.m_color = p3.m_color = p4.m_color = p5.m_color = color;
+		}
 
-					m_shootStemSegments[branchStartIndex * 3 + i * 3] = branchStartIndex * 6 + i * 6;
-					m_shootStemSegments[branchStartIndex * 3 + i * 3 + 1] = branchStartIndex * 6 + i * 6 + 1;
-					m_shootStemSegments[branchStartIndex * 3 + i * 3 + 2] = branchStartIndex * 6 + i * 6 + 2;
+		geometry.m_foliage.clear();
+		geometry.m_fruits.clear();
+		for (const auto& internodeHandle : branchSkeleton.RefSortedNodeList()) {
+			const auto& internodeData = branchSkeleton.PeekNode(internodeHandle).m_data;
+			for (const auto& bud : internodeData.m_buds) {
+				if (bud.m_status != BudStatus::Died) continue;
+				if (bud.m_reproductiveModule.m_maturity <= 0.0f) continue;
+				if (bud.m_type == BudType::Leaf) {
+					auto& [instanceMatrix, instanceColor] = geometry.m_foliage.emplace_back();
+					instanceMatrix.m_value = bud.m_reproductiveModule.m_transform;
+					instanceColor = glm::vec4(
+						glm::mix(glm::vec3(152 / 255.0f, 203 / 255.0f, 0 / 255.0f),
+							glm::vec3(159 / 255.0f, 100 / 255.0f, 66 / 255.0f),
+							1.0f - bud.m_reproductiveModule.m_health), 1.0f);
 				}
-				auto leafStartIndex = leafStartIndices[treeIndex];
-				auto fruitStartIndex = fruitStartIndices[treeIndex];
-
-				int leafIndex = 0;
-				int fruitIndex = 0;
-
-				for (const auto& internodeHandle : internodeList) {
-					const auto& internode = branchSkeleton.PeekNode(internodeHandle);
-					const auto& internodeData = internode.m_data;
-
-					for (const auto& bud : internodeData.m_buds) {
-
-						if (bud.m_status != BudStatus::Died) continue;
-						if (bud.m_reproductiveModule.m_maturity <= 0.0f) continue;
-
-
-						if (bud.m_type == BudType::Leaf) {
-
-							foliageMatrices[leafStartIndex + leafIndex].m_instanceMatrix.m_value =
-								entityGlobalTransform.m_value * bud.m_reproductiveModule.m_transform;
-							foliageMatrices[leafStartIndex + leafIndex].m_instanceColor = glm::vec4(
-								glm::mix(glm::vec3(152 / 255.0f, 203 / 255.0f, 0 / 255.0f),
-									glm::vec3(159 / 255.0f, 100 / 255.0f, 66 / 255.0f),
-									1.0f - bud.m_reproductiveModule.m_health), 1.0f);
-
-							leafIndex++;
-						}
-						else if (bud.m_type == BudType::Fruit) {
-
-							fruitMatrices[fruitStartIndex + fruitIndex].m_instanceMatrix.m_value =
-								entityGlobalTransform.m_value * bud.m_reproductiveModule.m_transform;
-							fruitMatrices[fruitStartIndex + fruitIndex].m_instanceColor = glm::vec4(255 / 255.0f, 165 / 255.0f,
-								0 / 255.0f, 1.0f);
-
-							fruitIndex++;
-						}
-					}
+				else if (bud.m_type == BudType::Fruit) {
+					auto& [instanceMatrix, instanceColor] = geometry.m_fruits.emplace_back();
+					instanceMatrix.m_value = bud.m_reproductiveModule.m_transform;
+					instanceColor = glm::vec4(255 / 255.0f, 165 / 255.0f, 0 / 255.0f, 1.0f);
 				}
-				});
-			StrandPointAttributes strandPointAttributes{};
-			strandPointAttributes.m_normal = false;
-			branchStrands->SetSegments(strandPointAttributes, m_shootStemSegments, m_shootStemPoints);
-			m_foliageMatrices->SetPendingUpdate();
-			m_fruitMatrices->SetPendingUpdate();
+			}
 		}
+		});
+
+	auto& boundingBoxMatrices = m_boundingBoxMatrices->m_particleInfos;
+	boundingBoxMatrices.resize(treeSize);
+	std::vector<glm::mat4> globalTransforms(treeSize);
+	std::vector<size_t> pointStartIndices(treeSize + 1, 0);
+	std::vector<size_t> leafStartIndices(treeSize + 1, 0);
+	std::vector<size_t> fruitStartIndices(treeSize + 1, 0);
+	for (int treeIndex = 0; treeIndex < treeSize; treeIndex++) {
+		const auto treeEntity = treeEntities->at(treeIndex);
+		const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
+		const auto& branchSkeleton = tree->m_treeModel.PeekShootSkeleton();
+		globalTransforms[treeIndex] = scene->GetDataComponent<GlobalTransform>(treeEntity).m_value;
+		auto& [instanceMatrix, instanceColor] = boundingBoxMatrices[treeIndex];
+		instanceMatrix.m_value = globalTransforms[treeIndex] *
+			(glm::translate(
+				(branchSkeleton.m_max + branchSkeleton.m_min) / 2.0f) *
+				glm::scale(branchSkeleton.m_max - branchSkeleton.m_min));
+		instanceColor = glm::vec4(m_randomColors[treeIndex], 0.05f);
+
+		pointStartIndices[treeIndex + 1] = pointStartIndices[treeIndex];
+		leafStartIndices[treeIndex + 1] = leafStartIndices[treeIndex];
+		fruitStartIndices[treeIndex + 1] = fruitStartIndices[treeIndex];
+		if (treeEntity == m_selectedTree) continue;
+		const auto& geometry = m_treeFlowGeometries[treeIndex];
+		pointStartIndices[treeIndex + 1] += geometry.m_stemPoints.size();
+		leafStartIndices[treeIndex + 1] += geometry.m_foliage.size();
+		fruitStartIndices[treeIndex + 1] += geometry.m_fruits.size();
 	}
+	m_boundingBoxMatrices->SetPendingUpdate();
+
+	m_shootStemPoints.resize(pointStartIndices[treeSize]);
+	m_shootStemSegments.resize(pointStartIndices[treeSize] / 2);
+	auto& foliageMatrices = m_foliageMatrices->m_particleInfos;
+	auto& fruitMatrices = m_fruitMatrices->m_particleInfos;
+	foliageMatrices.resize(leafStartIndices[treeSize]);
+	fruitMatrices.resize(fruitStartIndices[treeSize]);
+	//Move the cached geometry into the world space of each tree.
+	Jobs::ParallelFor(treeSize, [&](unsigned treeIndex) {
+		if (treeEntities->at(treeIndex) == m_selectedTree) return;
+		const auto& geometry = m_treeFlowGeometries[treeIndex];
+		const auto& globalTransform = globalTransforms[treeIndex];
+		const auto pointStartIndex = pointStartIndices[treeIndex];
+		for (size_t i = 0; i < geometry.m_stemPoints.size(); i++) {
+			auto& point = m_shootStemPoints[pointStartIndex + i];
+			point = geometry.m_stemPoints[i];
+			point.m_position = globalTransform * glm::vec4(point.m_position, 1.0f);
+		}
+		//Each flow is drawn by one curve that starts at its first point, using the 3 points after it as well.
+		for (size_t i = 0; i < geometry.m_stemPoints.size() / 6; i++) {
+			const auto segmentStart = pointStartIndex / 2 + i * 3;
+			const auto pointIndex = static_cast<glm::uint>(pointStartIndex + i * 6);
+			m_shootStemSegments[segmentStart] = pointIndex;
+			m_shootStemSegments[segmentStart + 1] = pointIndex + 1;
+			m_shootStemSegments[segmentStart + 2] = pointIndex + 2;
+		}
+		for (size_t i = 0; i < geometry.m_foliage.size(); i++) {
+			auto& particleInfo = foliageMatrices[leafStartIndices[treeIndex] + i];
+			particleInfo.m_instanceMatrix.m_value = globalTransform * geometry.m_foliage[i].m_instanceMatrix.m_value;
+			particleInfo.m_instanceColor = geometry.m_foliage[i].m_instanceColor;
+		}
+		for (size_t i = 0; i < geometry.m_fruits.size(); i++) {
+			auto& particleInfo = fruitMatrices[fruitStartIndices[treeIndex] + i];
+			particleInfo.m_instanceMatrix.m_value = globalTransform * geometry.m_fruits[i].m_instanceMatrix.m_value;
+			particleInfo.m_instanceColor = geometry.m_fruits[i].m_instanceColor;
+		}
+		});
+	StrandPointAttributes strandPointAttributes{};
+	strandPointAttributes.m_normal = false;
+	branchStrands->SetSegments(strandPointAttributes, m_shootStemSegments, m_shootStemPoints);
+	m_foliageMatrices->SetPendingUpdate();
+	m_fruitMatrices->SetPendingUpdate();
 }
 
 void EcoSysLabLayer::ClearGroundFruitAndLeaf() {
@@ -1653,98 +1684,140 @@ void EcoSysLabLayer::Simulate(float deltaTime) {
 		}
 
 		climate->PrepareForGrowth();
-		std::vector<bool> grownStat{};
-		grownStat.resize(Jobs::Workers().Size());
-		std::vector<std::shared_future<void>> results;
-		Jobs::ParallelFor(treeEntities->size(), [&](unsigned i, unsigned threadIndex) {
-			const auto treeEntity = treeEntities->at(i);
-			if (!scene->IsEntityEnabled(treeEntity)) return;
+		std::vector<char> grownStat{};
+		grownStat.resize(Jobs::Workers().Size(), 0);
+		//The trees grow inside jobs, so the ones still encoded are loaded on the main thread first and the checkpoints are
+		//encoded serially by the jobs.
+		std::vector<std::shared_ptr<Tree>> growingTrees;
+		for (const auto& treeEntity : *treeEntities) {
+			if (!scene->IsEntityEnabled(treeEntity)) continue;
 			const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
-			if (!tree->IsEnabled()) return;
-			if (m_simulationSettings.m_maxNodeCount > 0 && tree->m_treeModel.RefShootSkeleton().RefSortedNodeList().size() >= m_simulationSettings.m_maxNodeCount) return;
-			grownStat[threadIndex] = tree->TryGrow(deltaTime, 0, true, -1);
+			if (!tree->IsEnabled() || !tree->LoadShootSnapshot()) continue;
+			growingTrees.emplace_back(tree);
+		}
+		std::vector<std::shared_future<void>> results;
+		Jobs::ParallelFor(growingTrees.size(), [&](unsigned i, unsigned threadIndex) {
+			const auto& tree = growingTrees[i];
+			if (m_simulationSettings.m_maxNodeCount > 0 && tree->m_treeModel.GetInternodeCount() >= m_simulationSettings.m_maxNodeCount) return;
+			if (tree->TryGrow(deltaTime, 0, true, -1, false)) grownStat[threadIndex] = 1;
 			}, results);
 		for (auto& i : results) i.wait();
 
-		auto heightField = soil->m_soilDescriptor.Get<SoilDescriptor>()->m_heightField.Get<HeightField>();
-		for (const auto& treeEntity : *treeEntities) {
-			if (!scene->IsEntityEnabled(treeEntity)) return;
-			auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
-			auto treeGlobalTransform = scene->GetDataComponent<GlobalTransform>(treeEntity);
-			if (!tree->IsEnabled()) return;
-			//Collect fruit and leaves here.
-			if (!m_simulationSettings.m_autoClearFruitAndLeaves) {
-				for (const auto& fruit : tree->m_treeModel.RefShootSkeleton().m_data.m_droppedFruits) {
-					Fruit newFruit;
-					newFruit.m_globalTransform.m_value = treeGlobalTransform.m_value * fruit.m_transform;
-
-					auto position = newFruit.m_globalTransform.GetPosition();
-					const auto groundHeight = heightField->GetValue({ position.x, position.z });
-					const auto height = position.y - groundHeight;
-					position.x += glm::gaussRand(0.0f, height * 0.1f);
-					position.z += glm::gaussRand(0.0f, height * 0.1f);
-					position.y = groundHeight + 0.1f;
-					newFruit.m_globalTransform.SetPosition(position);
-
-					newFruit.m_maturity = fruit.m_maturity;
-					newFruit.m_health = fruit.m_health;
-					m_fruits.emplace_back(newFruit);
-				}
-
-
-				for (const auto& leaf : tree->m_treeModel.RefShootSkeleton().m_data.m_droppedLeaves) {
-					Leaf newLeaf;
-					newLeaf.m_globalTransform.m_value = treeGlobalTransform.m_value * leaf.m_transform;
-
-					auto position = newLeaf.m_globalTransform.GetPosition();
-					const auto groundHeight = heightField ? heightField->GetValue({ position.x, position.z }) : 0.0f;
-					const auto height = position.y - groundHeight;
-					position.x += glm::gaussRand(0.0f, height * 0.1f);
-					position.z += glm::gaussRand(0.0f, height * 0.1f);
-					position.y = groundHeight + 0.1f;
-					newLeaf.m_globalTransform.SetPosition(position);
-
-					newLeaf.m_maturity = leaf.m_maturity;
-					newLeaf.m_health = leaf.m_health;
-					m_leaves.emplace_back(newLeaf);
-				}
-				tree->m_treeVisualizer.m_needUpdate = true;
+		//Collect fruit and leaves here. Every tree writes into its own range of the pre-sized lists.
+		const auto heightField = soil->m_soilDescriptor.Get<SoilDescriptor>()->m_heightField.Get<HeightField>();
+		const auto treeSize = treeEntities->size();
+		std::vector<std::shared_ptr<Tree>> trees(treeSize);
+		Jobs::ParallelFor(treeSize, [&](unsigned i)
+			{
+				const auto treeEntity = treeEntities->at(i);
+				if (!scene->IsEntityEnabled(treeEntity)) return;
+				const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
+				if (!tree->IsEnabled()) return;
+				trees[i] = tree;
 			}
+		);
+		if (!m_simulationSettings.m_autoClearFruitAndLeaves) {
+			std::vector<size_t> fruitOffsets(treeSize + 1, 0);
+			std::vector<size_t> leafOffsets(treeSize + 1, 0);
+			fruitOffsets[0] = m_fruits.size();
+			leafOffsets[0] = m_leaves.size();
+			for (size_t i = 0; i < treeSize; i++)
+			{
+				fruitOffsets[i + 1] = fruitOffsets[i];
+				leafOffsets[i + 1] = leafOffsets[i];
+				if (!trees[i]) continue;
+				const auto& shootData = trees[i]->m_treeModel.RefShootSkeleton().m_data;
+				fruitOffsets[i + 1] += shootData.m_droppedFruits.size();
+				leafOffsets[i + 1] += shootData.m_droppedLeaves.size();
+			}
+			m_fruits.resize(fruitOffsets[treeSize]);
+			m_leaves.resize(leafOffsets[treeSize]);
+			Jobs::ParallelFor(treeSize, [&](unsigned i)
+				{
+					const auto& tree = trees[i];
+					if (!tree) return;
+					const auto treeGlobalTransform = scene->GetDataComponent<GlobalTransform>(treeEntities->at(i));
+					const auto& shootData = tree->m_treeModel.RefShootSkeleton().m_data;
+					//The scatter is drawn from an engine of the tree instead of the shared std::rand, so it does not depend on the scheduling.
+					std::mt19937 random(static_cast<unsigned>(tree->m_treeModel.m_seed) * 2654435761u
+						+ static_cast<unsigned>(tree->m_treeModel.m_iteration) * 40503u + i);
+					std::normal_distribution<float> scatter(0.0f, 1.0f);
+					auto fruitIndex = fruitOffsets[i];
+					for (const auto& fruit : shootData.m_droppedFruits) {
+						auto& newFruit = m_fruits[fruitIndex];
+						newFruit.m_globalTransform.m_value = treeGlobalTransform.m_value * fruit.m_transform;
+
+						auto position = newFruit.m_globalTransform.GetPosition();
+						const auto groundHeight = heightField ? heightField->GetValue({ position.x, position.z }) : 0.0f;
+						const auto height = position.y - groundHeight;
+						position.x += scatter(random) * height * 0.1f;
+						position.z += scatter(random) * height * 0.1f;
+						position.y = groundHeight + 0.1f;
+						newFruit.m_globalTransform.SetPosition(position);
+
+						newFruit.m_maturity = fruit.m_maturity;
+						newFruit.m_health = fruit.m_health;
+						fruitIndex++;
+					}
+					auto leafIndex = leafOffsets[i];
+					for (const auto& leaf : shootData.m_droppedLeaves) {
+						auto& newLeaf = m_leaves[leafIndex];
+						newLeaf.m_globalTransform.m_value = treeGlobalTransform.m_value * leaf.m_transform;
+
+						auto position = newLeaf.m_globalTransform.GetPosition();
+						const auto groundHeight = heightField ? heightField->GetValue({ position.x, position.z }) : 0.0f;
+						const auto height = position.y - groundHeight;
+						position.x += scatter(random) * height * 0.1f;
+						position.z += scatter(random) * height * 0.1f;
+						position.y = groundHeight + 0.1f;
+						newLeaf.m_globalTransform.SetPosition(position);
+
+						newLeaf.m_maturity = leaf.m_maturity;
+						newLeaf.m_health = leaf.m_health;
+						leafIndex++;
+					}
+					tree->m_treeVisualizer.m_needUpdate = true;
+				}
+			);
+		}
+		for (const auto& tree : trees)
+		{
+			if (!tree) continue;
 			tree->m_treeModel.RefShootSkeleton().m_data.m_droppedFruits.clear();
 			tree->m_treeModel.RefShootSkeleton().m_data.m_droppedLeaves.clear();
-
 		}
 		m_lastUsedTime = Times::Now() - time;
 		m_totalTime += m_lastUsedTime;
 
-		for (int i = 0; i < grownStat.size(); i++)
+		if (std::find(grownStat.begin(), grownStat.end(), 1) != grownStat.end())
 		{
-			if (grownStat[i])
-			{
-				m_needFullFlowUpdate = true;
-
-				int totalInternodeSize = 0;
-				int totalFlowSize = 0;
-				int totalRootNodeSize = 0;
-				int totalRootFlowSize = 0;
-				int totalLeafSize = 0;
-				int totalFruitSize = 0;
-				for (int i = 0; i < treeEntities->size(); i++) {
-					auto treeEntity = treeEntities->at(i);
-					auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
-					auto& treeModel = tree->m_treeModel;
-					totalInternodeSize += treeModel.RefShootSkeleton().RefSortedNodeList().size();
-					totalFlowSize += treeModel.RefShootSkeleton().RefSortedFlowList().size();
-					totalLeafSize += treeModel.GetLeafCount();
-					totalFruitSize += treeModel.GetFruitCount();
+			m_needFullFlowUpdate = true;
+			//The counters are kept by each tree model, we only need to sum them up.
+			const auto threadCount = Jobs::Workers().Size();
+			std::vector<int> internodeSizes(threadCount, 0);
+			std::vector<int> flowSizes(threadCount, 0);
+			std::vector<int> leafSizes(threadCount, 0);
+			std::vector<int> fruitSizes(threadCount, 0);
+			Jobs::ParallelFor(treeSize, [&](unsigned i, unsigned threadIndex)
+				{
+					const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntities->at(i)).lock();
+					const auto& treeModel = tree->m_treeModel;
+					internodeSizes[threadIndex] += treeModel.GetInternodeCount();
+					flowSizes[threadIndex] += treeModel.GetShootStemCount();
+					leafSizes[threadIndex] += treeModel.GetLeafCount();
+					fruitSizes[threadIndex] += treeModel.GetFruitCount();
 				}
-				m_internodeSize = totalInternodeSize;
-				m_shootStemSize = totalFlowSize;
-				m_rootNodeSize = totalRootNodeSize;
-				m_rootStemSize = totalRootFlowSize;
-				m_leafSize = totalLeafSize;
-				m_fruitSize = totalFruitSize;
+			);
+			m_internodeSize = m_shootStemSize = m_leafSize = m_fruitSize = 0;
+			for (int i = 0; i < threadCount; i++)
+			{
+				m_internodeSize += internodeSizes[i];
+				m_shootStemSize += flowSizes[i];
+				m_leafSize += leafSizes[i];
+				m_fruitSize += fruitSizes[i];
 			}
+			m_rootNodeSize = 0;
+			m_rootStemSize = 0;
 		}
 	}
 }
@@ -26,11 +26,11 @@ void EnvironmentGrid::AddShadowValue(const glm::vec3& position, float value)
 	data.m_shadowIntensity += value;
 }
 
-void EnvironmentGrid::ShadowPropagation()
+void EnvironmentGrid::ShadowPropagation(const bool parallel)
 {
 	const auto resolution = m_voxel.GetResolution();
 	for (int y = resolution.y - 2; y >= 0; y--) {
-		Jobs::ParallelFor(resolution.x * resolution.z, [&](unsigned i)
+		const auto propagate = [&](unsigned i)
 			{
 				const int x = i / resolution.z;
 				const int z = i % resolution.z;
@@ -62,8 +62,9 @@ void EnvironmentGrid::ShadowPropagation()
 				{
 					voxel.m_shadowDirection = glm::vec3(0.0f);
 				}
-			}
-		);
+			};
+		if (parallel) Jobs::ParallelFor(resolution.x * resolution.z, propagate);
+		else for (unsigned i = 0; i < static_cast<unsigned>(resolution.x * resolution.z); i++) propagate(i);
 	}
 }
 
@@ -79,3 +80,88 @@ void EnvironmentGrid::AddNode(const InternodeVoxelRegistration& registration)
 	data.m_internodeVoxelRegistrations.emplace_back(registration);
 }
 
+void EnvironmentGrid::PrepareBuffers(const size_t bufferCount)
+{
+	m_buffers.resize(bufferCount);
+	for (auto& buffer : m_buffers)
+	{
+		buffer.m_contributions.clear();
+		buffer.m_registrations.clear();
+	}
+}
+
+void EnvironmentGrid::ApplyBuffer(const EnvironmentGridBuffer& buffer)
+{
+	for (const auto& contribution : buffer.m_contributions)
+	{
+		auto& data = m_voxel.Ref(contribution.m_voxelIndex);
+		data.m_shadowIntensity += contribution.m_shadowIntensity;
+		data.m_totalBiomass += contribution.m_biomass;
+		if (contribution.m_registrationIndex != -1)
+		{
+			data.m_internodeVoxelRegistrations.emplace_back(buffer.m_registrations[contribution.m_registrationIndex]);
+		}
+	}
+}
+
+void EnvironmentGrid::MergeBuffers(const std::vector<EnvironmentGridBufferSegment>& segments)
+{
+	const auto voxelCount = m_voxel.GetVoxelCount();
+	if (voxelCount == 0 || segments.empty()) return;
+	//Counting sort of the contributions into chunks of voxels, one chunk is then accumulated by a single task.
+	const size_t chunkCount = glm::min(voxelCount, static_cast<size_t>(Jobs::Workers().Size()) * 4);
+	const size_t chunkSize = (voxelCount + chunkCount - 1) / chunkCount;
+	std::vector<size_t> counts(segments.size() * chunkCount, 0);
+	Jobs::ParallelFor(segments.size(), [&](unsigned i)
+		{
+			const auto& segment = segments[i];
+			const auto& contributions = m_buffers[segment.m_bufferIndex].m_contributions;
+			for (size_t c = segment.m_start; c < segment.m_end; c++)
+			{
+				counts[i * chunkCount + contributions[c].m_voxelIndex / chunkSize]++;
+			}
+		}
+	);
+	std::vector<size_t> chunkStarts(chunkCount + 1);
+	size_t sum = 0;
+	for (size_t chunk = 0; chunk < chunkCount; chunk++)
+	{
+		chunkStarts[chunk] = sum;
+		for (size_t i = 0; i < segments.size(); i++)
+		{
+			const auto count = counts[i * chunkCount + chunk];
+			counts[i * chunkCount + chunk] = sum;
+			sum += count;
+		}
+	}
+	chunkStarts[chunkCount] = sum;
+	std::vector<std::pair<unsigned, unsigned>> sortedContributions(sum);
+	Jobs::ParallelFor(segments.size(), [&](unsigned i)
+		{
+			const auto& segment = segments[i];
+			const auto& contributions = m_buffers[segment.m_bufferIndex].m_contributions;
+			for (size_t c = segment.m_start; c < segment.m_end; c++)
+			{
+				auto& offset = counts[i * chunkCount + contributions[c].m_voxelIndex / chunkSize];
+				sortedContributions[offset] = { segment.m_bufferIndex, static_cast<unsigned>(c) };
+				offset++;
+			}
+		}
+	);
+	Jobs::ParallelFor(chunkCount, [&](unsigned chunk)
+		{
+			for (size_t i = chunkStarts[chunk]; i < chunkStarts[chunk + 1]; i++)
+			{
+				const auto& buffer = m_buffers[sortedContributions[i].first];
+				const auto& contribution = buffer.m_contributions[sortedContributions[i].second];
+				auto& data = m_voxel.Ref(contribution.m_voxelIndex);
+				data.m_shadowIntensity += contribution.m_shadowIntensity;
+				data.m_totalBiomass += contribution.m_biomass;
+				if (contribution.m_registrationIndex != -1)
+				{
+					data.m_internodeVoxelRegistrations.emplace_back(buffer.m_registrations[contribution.m_registrationIndex]);
+				}
+			}
+		}
+	);
+}
@@ -9,6 +9,8 @@
 #include "Climate.hpp"
 #include "Tree.hpp"
 #include "EcoSysLabLayer.hpp"
+#include "ForestPatchSimulator.hpp"
+#include "Times.hpp"
 using namespace EcoSysLab;
 
 void TreeInfo::Serialize(YAML::Emitter& out) const
@@ -141,6 +143,44 @@ void ForestPatch::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 		InstantiatePatch(setParent);
 	}
 
+	static ForestPatchSimulator simulator{};
+	static int headlessIterations = 100;
+	static float headlessDeltaTime = 0.0822f;
+	if (ImGui::TreeNode("Headless simulation"))
+	{
+		ImGui::DragFloat("Tile size", &simulator.m_settings.m_tileSize, 1.0f, 1.0f, 1000.0f);
+		ImGui::DragFloat("Halo size", &simulator.m_settings.m_haloSize, 0.1f, 0.0f, 100.0f);
+		ImGui::DragFloat("Crown shyness distance", &simulator.m_settings.m_crownShynessDistance, 0.01f, 0.0f, 1.0f);
+		ImGui::DragInt("Max node count", &simulator.m_settings.m_maxNodeCount, 100, 0, 10000000);
+		ImGui::DragInt("Iterations", &headlessIterations, 1, 1, 10000);
+		ImGui::DragFloat("Delta time", &headlessDeltaTime, 0.001f, 0.001f, 1.0f);
+		if (ImGui::Button("Simulate headless"))
+		{
+			const auto ecoSysLabLayer = Application::GetLayer<EcoSysLabLayer>();
+			if (ecoSysLabLayer) simulator.m_settings.m_shadowEstimationSettings = ecoSysLabLayer->m_simulationSettings.m_shadowEstimationSettings;
+			simulator.Initialize(*this);
+			const float startTime = Times::Now();
+			for (int i = 0; i < headlessIterations; i++) simulator.Step(headlessDeltaTime);
+			const float usedTime = Times::Now() - startTime;
+			EVOENGINE_LOG("Forest patch: " + std::to_string(simulator.PeekTrees().size()) + " trees in " + std::to_string(simulator.PeekTiles().size())
+				+ " tiles, " + std::to_string(usedTime / headlessIterations) + "s per iteration");
+		}
+		if (!simulator.PeekTrees().empty())
+		{
+			ImGui::Text(("Simulated " + std::to_string(simulator.PeekTrees().size()) + " trees for " + std::to_string(simulator.GetTime()) + " years").c_str());
+			if (ImGui::Button("Compare with single grid"))
+			{
+				const auto comparison = simulator.CompareWithSingleGrid();
+				EVOENGINE_LOG("Forest patch: " + std::to_string(comparison.m_sampleCount) + " internodes, light error max "
+					+ std::to_string(comparison.m_maxLightIntensityError) + " mean " + std::to_string(comparison.m_meanLightIntensityError)
+					+ ", space occupancy error max " + std::to_string(comparison.m_maxSpaceOccupancyError)
+					+ ", environment built in " + std::to_string(comparison.m_tiledTime) + "s tiled vs " + std::to_string(comparison.m_singleGridTime) + "s single grid");
+			}
+			if (ImGui::Button("Instantiate simulated trees")) simulator.InstantiateTrees(setParent);
+		}
+		ImGui::TreePop();
+	}
+
 
 	if (!m_treeInfos.empty() && ImGui::Button("Clear")) {
 		m_treeInfos.clear();
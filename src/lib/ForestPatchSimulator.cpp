@@ -0,0 +1,321 @@
+#include "ForestPatchSimulator.hpp"
+#include "Times.hpp"
+
+using namespace EcoSysLab;
+
+void ForestPatchSimulator::Initialize(const ForestPatch& forestPatch)
+{
+	m_trees.clear();
+	m_tiles.clear();
+	m_time = 0.0f;
+	glm::vec2 patchMin = glm::vec2(std::numeric_limits<float>::max());
+	glm::vec2 patchMax = glm::vec2(-std::numeric_limits<float>::max());
+	for (const auto& treeInfo : forestPatch.m_treeInfos)
+	{
+		const auto treeDescriptor = treeInfo.m_treeDescriptor.Get<TreeDescriptor>();
+		if (!treeDescriptor) continue;
+		auto& tree = m_trees.emplace_back();
+		tree.m_globalTransform = treeInfo.m_globalTransform.m_value;
+		tree.m_treeDescriptor = treeDescriptor;
+		tree.m_treeModel.m_treeGrowthSettings = forestPatch.m_treeGrowthSettings;
+		tree.m_treeModel.m_index = static_cast<unsigned>(m_trees.size() - 1);
+		const glm::vec2 position = { tree.m_globalTransform[3].x, tree.m_globalTransform[3].z };
+		patchMin = glm::min(patchMin, position);
+		patchMax = glm::max(patchMax, position);
+	}
+	if (m_trees.size() != forestPatch.m_treeInfos.size())
+	{
+		EVOENGINE_ERROR("Trees without tree descriptor are skipped!");
+	}
+	if (m_trees.empty()) return;
+
+	const float tileSize = glm::max(m_settings.m_tileSize, 1.0f);
+	const auto tileCount = glm::ivec2(glm::floor((patchMax - patchMin) / tileSize)) + 1;
+	std::vector<int> tileIndices(tileCount.x * tileCount.y, -1);
+	for (unsigned treeIndex = 0; treeIndex < m_trees.size(); treeIndex++)
+	{
+		auto& tree = m_trees[treeIndex];
+		const glm::vec2 position = { tree.m_globalTransform[3].x, tree.m_globalTransform[3].z };
+		const auto tileCoordinate = glm::clamp(glm::ivec2(glm::floor((position - patchMin) / tileSize)), glm::ivec2(0), tileCount - 1);
+		auto& tileIndex = tileIndices[tileCoordinate.x * tileCount.y + tileCoordinate.y];
+		if (tileIndex == -1)
+		{
+			tileIndex = static_cast<int>(m_tiles.size());
+			auto& tile = m_tiles.emplace_back();
+			tile.m_min = patchMin + glm::vec2(tileCoordinate) * tileSize;
+			tile.m_max = tile.m_min + tileSize;
+		}
+		m_tiles[tileIndex].m_treeIndices.emplace_back(treeIndex);
+		tree.m_tileIndex = tileIndex;
+	}
+	//The controllers point to the climate model of the tile, so the tiles must not move anymore from here.
+	for (auto& tree : m_trees)
+	{
+		Tree::PrepareControllers(tree.m_treeDescriptor, m_tiles[tree.m_tileIndex].m_climateModel, tree.m_shootGrowthController);
+	}
+}
+
+bool ForestPatchSimulator::Step(const float deltaTime)
+{
+	if (m_tiles.empty()) return false;
+	m_time += deltaTime;
+	PrepareEnvironment();
+	std::vector<char> grownStat(m_trees.size(), 0);
+	Jobs::ParallelFor(m_trees.size(), [&](unsigned treeIndex)
+		{
+			auto& tree = m_trees[treeIndex];
+			if (m_settings.m_maxNodeCount > 0 && tree.m_treeModel.GetInternodeCount() >= m_settings.m_maxNodeCount) return;
+			auto& climateModel = m_tiles[tree.m_tileIndex].m_climateModel;
+			if (tree.m_treeModel.Grow(deltaTime, 0, tree.m_globalTransform, climateModel, tree.m_shootGrowthController, true, -1)) grownStat[treeIndex] = 1;
+		}
+	);
+	for (const auto& i : grownStat)
+	{
+		if (i != 0) return true;
+	}
+	return false;
+}
+
+void ForestPatchSimulator::PrepareEnvironment()
+{
+	UpdateTileGrids();
+	Jobs::ParallelFor(m_tiles.size(), [&](unsigned tileIndex)
+		{
+			DepositShadow(tileIndex);
+		}
+	);
+	Jobs::ParallelFor(m_tiles.size(), [&](unsigned tileIndex)
+		{
+			ReceiveBoundaries(tileIndex);
+			m_tiles[tileIndex].m_climateModel.m_environmentGrid.ShadowPropagation(false);
+		}
+	);
+}
+
+ForestPatchSimulationComparison ForestPatchSimulator::CompareWithSingleGrid()
+{
+	ForestPatchSimulationComparison comparison{};
+	if (m_tiles.empty()) return comparison;
+	float startTime = Times::Now();
+	PrepareEnvironment();
+	comparison.m_tiledTime = Times::Now() - startTime;
+
+	//The single grid spans all tiles on the same lattice, so every voxel of a tile has a counterpart.
+	startTime = Times::Now();
+	ClimateModel singleGridClimate{};
+	auto& singleGrid = singleGridClimate.m_environmentGrid;
+	const float voxelSize = m_tiles.front().m_climateModel.m_environmentGrid.m_voxelSize;
+	singleGrid.m_voxelSize = voxelSize;
+	singleGrid.m_settings = m_settings.m_shadowEstimationSettings;
+	auto minCoordinate = m_tiles.front().m_minCoordinate;
+	auto maxCoordinate = m_tiles.front().m_maxCoordinate;
+	for (const auto& tile : m_tiles)
+	{
+		minCoordinate = glm::min(minCoordinate, tile.m_minCoordinate);
+		maxCoordinate = glm::max(maxCoordinate, tile.m_maxCoordinate);
+	}
+	singleGrid.m_voxel.Initialize(voxelSize, maxCoordinate - minCoordinate, glm::vec3(minCoordinate) * voxelSize);
+	singleGrid.m_voxel.Reset();
+	EnvironmentGridBuffer buffer{};
+	const bool registerNodes = m_settings.m_crownShynessDistance > 0.0f;
+	for (const auto& tree : m_trees)
+	{
+		tree.m_treeModel.RegisterVoxel(tree.m_globalTransform, singleGridClimate, tree.m_shootGrowthController, buffer, registerNodes);
+	}
+	singleGrid.ApplyBuffer(buffer);
+	singleGrid.ShadowPropagation();
+	comparison.m_singleGridTime = Times::Now() - startTime;
+
+	std::vector<float> maxLightErrors(m_trees.size(), 0.0f);
+	std::vector<double> totalLightErrors(m_trees.size(), 0.0);
+	std::vector<float> maxOccupancyErrors(m_trees.size(), 0.0f);
+	Jobs::ParallelFor(m_trees.size(), [&](unsigned treeIndex)
+		{
+			const auto& tree = m_trees[treeIndex];
+			const auto& tileGrid = m_tiles[tree.m_tileIndex].m_climateModel.m_environmentGrid;
+			const auto& skeleton = tree.m_treeModel.PeekShootSkeleton();
+			for (const auto& internodeHandle : skeleton.RefSortedNodeList())
+			{
+				const glm::vec3 position = tree.m_globalTransform * glm::vec4(skeleton.PeekNode(internodeHandle).m_info.m_globalPosition, 1.0f);
+				glm::vec3 lightDirection;
+				const auto lightError = glm::abs(tileGrid.IlluminationEstimation(position, lightDirection) - singleGrid.IlluminationEstimation(position, lightDirection));
+				maxLightErrors[treeIndex] = glm::max(maxLightErrors[treeIndex], lightError);
+				totalLightErrors[treeIndex] += lightError;
+				const auto occupancyError = glm::abs(tileGrid.m_voxel.Peek(position).m_totalBiomass - singleGrid.m_voxel.Peek(position).m_totalBiomass);
+				maxOccupancyErrors[treeIndex] = glm::max(maxOccupancyErrors[treeIndex], occupancyError);
+			}
+		}
+	);
+	double totalLightError = 0.0;
+	for (size_t treeIndex = 0; treeIndex < m_trees.size(); treeIndex++)
+	{
+		comparison.m_sampleCount += m_trees[treeIndex].m_treeModel.PeekShootSkeleton().RefSortedNodeList().size();
+		comparison.m_maxLightIntensityError = glm::max(comparison.m_maxLightIntensityError, maxLightErrors[treeIndex]);
+		comparison.m_maxSpaceOccupancyError = glm::max(comparison.m_maxSpaceOccupancyError, maxOccupancyErrors[treeIndex]);
+		totalLightError += totalLightErrors[treeIndex];
+	}
+	if (comparison.m_sampleCount != 0) comparison.m_meanLightIntensityError = static_cast<float>(totalLightError / comparison.m_sampleCount);
+	return comparison;
+}
+
+void ForestPatchSimulator::InstantiateTrees(const bool setParent)
+{
+	const auto scene = Application::GetActiveScene();
+	Entity parent;
+	if (setParent) parent = scene->CreateEntity("Forest (" + std::to_string(m_trees.size()) + ") - Headless");
+	for (size_t treeIndex = 0; treeIndex < m_trees.size(); treeIndex++)
+	{
+		auto& simulatedTree = m_trees[treeIndex];
+		const auto treeEntity = scene->CreateEntity("Tree No." + std::to_string(treeIndex));
+		GlobalTransform globalTransform{};
+		globalTransform.m_value = simulatedTree.m_globalTransform;
+		scene->SetDataComponent(treeEntity, globalTransform);
+		const auto tree = scene->GetOrSetPrivateComponent<Tree>(treeEntity).lock();
+		tree->m_treeDescriptor = simulatedTree.m_treeDescriptor;
+		tree->m_treeModel = std::move(simulatedTree.m_treeModel);
+		tree->m_treeVisualizer.m_needUpdate = true;
+		if (setParent) scene->SetParent(treeEntity, parent);
+	}
+	m_trees.clear();
+	m_tiles.clear();
+}
+
+float ForestPatchSimulator::GetTime() const
+{
+	return m_time;
+}
+
+const std::vector<ForestPatchSimulationTree>& ForestPatchSimulator::PeekTrees() const
+{
+	return m_trees;
+}
+
+const std::vector<ForestPatchSimulationTile>& ForestPatchSimulator::PeekTiles() const
+{
+	return m_tiles;
+}
+
+void ForestPatchSimulator::UpdateTileGrids()
+{
+	const float voxelSize = m_tiles.front().m_climateModel.m_environmentGrid.m_voxelSize;
+	//The bounds are computed the same way as Climate::PrepareForGrowth, the height is shared by all tiles so the shadow
+	//of a tall tree next to a short tile still reaches its halo.
+	std::vector<glm::vec3> tileMins(m_tiles.size());
+	std::vector<glm::vec3> tileMaxs(m_tiles.size());
+	for (size_t tileIndex = 0; tileIndex < m_tiles.size(); tileIndex++)
+	{
+		const auto& tile = m_tiles[tileIndex];
+		tileMins[tileIndex] = glm::vec3(tile.m_min.x - m_settings.m_haloSize, std::numeric_limits<float>::max(), tile.m_min.y - m_settings.m_haloSize);
+		tileMaxs[tileIndex] = glm::vec3(tile.m_max.x + m_settings.m_haloSize, -std::numeric_limits<float>::max(), tile.m_max.y + m_settings.m_haloSize);
+	}
+	float minHeight = std::numeric_limits<float>::max();
+	float maxHeight = -std::numeric_limits<float>::max();
+	for (auto& tree : m_trees)
+	{
+		const auto& shootSkeleton = tree.m_treeModel.RefShootSkeleton();
+		const glm::vec3 boundA = tree.m_globalTransform * glm::vec4(shootSkeleton.m_min, 1.0f);
+		const glm::vec3 boundB = tree.m_globalTransform * glm::vec4(shootSkeleton.m_max, 1.0f);
+		const auto treeMin = glm::min(boundA, boundB) - glm::vec3(1.0f, 0.1f, 1.0f);
+		const auto treeMax = glm::max(boundA, boundB) + glm::vec3(1.0f);
+		tileMins[tree.m_tileIndex] = glm::min(tileMins[tree.m_tileIndex], treeMin);
+		tileMaxs[tree.m_tileIndex] = glm::max(tileMaxs[tree.m_tileIndex], treeMax);
+		minHeight = glm::min(minHeight, treeMin.y);
+		maxHeight = glm::max(maxHeight, treeMax.y);
+		tree.m_treeModel.m_crownShynessDistance = m_settings.m_crownShynessDistance;
+	}
+	bool boundChanged = false;
+	for (size_t tileIndex = 0; tileIndex < m_tiles.size(); tileIndex++)
+	{
+		auto& tile = m_tiles[tileIndex];
+		auto& environmentGrid = tile.m_climateModel.m_environmentGrid;
+		environmentGrid.m_settings = m_settings.m_shadowEstimationSettings;
+		tile.m_climateModel.m_time = m_time;
+		tileMins[tileIndex].y = minHeight;
+		tileMaxs[tileIndex].y = maxHeight;
+		auto minCoordinate = glm::ivec3(glm::floor(tileMins[tileIndex] / voxelSize));
+		auto maxCoordinate = glm::ivec3(glm::ceil(tileMaxs[tileIndex] / voxelSize));
+		//Like the grid of the climate, the grids only grow.
+		if (environmentGrid.m_voxel.GetVoxelCount() != 0)
+		{
+			minCoordinate = glm::min(minCoordinate, tile.m_minCoordinate);
+			maxCoordinate = glm::max(maxCoordinate, tile.m_maxCoordinate);
+			if (minCoordinate == tile.m_minCoordinate && maxCoordinate == tile.m_maxCoordinate) continue;
+		}
+		tile.m_minCoordinate = minCoordinate;
+		tile.m_maxCoordinate = maxCoordinate;
+		environmentGrid.m_voxel.Initialize(voxelSize, maxCoordinate - minCoordinate, glm::vec3(minCoordinate) * voxelSize);
+		boundChanged = true;
+	}
+	if (!boundChanged) return;
+	for (size_t tileIndex = 0; tileIndex < m_tiles.size(); tileIndex++)
+	{
+		auto& tile = m_tiles[tileIndex];
+		tile.m_neighborTileIndices.clear();
+		for (size_t otherTileIndex = 0; otherTileIndex < m_tiles.size(); otherTileIndex++)
+		{
+			if (otherTileIndex == tileIndex) continue;
+			const auto& otherTile = m_tiles[otherTileIndex];
+			if (tile.m_minCoordinate.x < otherTile.m_maxCoordinate.x && otherTile.m_minCoordinate.x < tile.m_maxCoordinate.x
+				&& tile.m_minCoordinate.z < otherTile.m_maxCoordinate.z && otherTile.m_minCoordinate.z < tile.m_maxCoordinate.z)
+			{
+				tile.m_neighborTileIndices.emplace_back(otherTileIndex);
+			}
+		}
+		tile.m_exports.resize(tile.m_neighborTileIndices.size());
+	}
+}
+
+void ForestPatchSimulator::DepositShadow(const unsigned tileIndex)
+{
+	auto& tile = m_tiles[tileIndex];
+	auto& environmentGrid = tile.m_climateModel.m_environmentGrid;
+	environmentGrid.m_voxel.Reset();
+	tile.m_buffer.m_contributions.clear();
+	tile.m_buffer.m_registrations.clear();
+	//Node registrations are only read by crown shyness.
+	const bool registerNodes = m_settings.m_crownShynessDistance > 0.0f;
+	for (const auto& treeIndex : tile.m_treeIndices)
+	{
+		const auto& tree = m_trees[treeIndex];
+		tree.m_treeModel.RegisterVoxel(tree.m_globalTransform, tile.m_climateModel, tree.m_shootGrowthController, tile.m_buffer, registerNodes);
+	}
+	environmentGrid.ApplyBuffer(tile.m_buffer);
+
+	for (auto& exports : tile.m_exports) exports.clear();
+	for (const auto& contribution : tile.m_buffer.m_contributions)
+	{
+		const auto coordinate = tile.m_minCoordinate + environmentGrid.m_voxel.GetCoordinate(contribution.m_voxelIndex);
+		for (size_t i = 0; i < tile.m_neighborTileIndices.size(); i++)
+		{
+			const auto& neighbor = m_tiles[tile.m_neighborTileIndices[i]];
+			if (coordinate.x < neighbor.m_minCoordinate.x || coordinate.x >= neighbor.m_maxCoordinate.x
+				|| coordinate.z < neighbor.m_minCoordinate.z || coordinate.z >= neighbor.m_maxCoordinate.z) continue;
+			auto& boundaryContribution = tile.m_exports[i].emplace_back();
+			boundaryContribution.m_coordinate = coordinate;
+			boundaryContribution.m_shadowIntensity = contribution.m_shadowIntensity;
+			boundaryContribution.m_biomass = contribution.m_biomass;
+			boundaryContribution.m_registrationIndex = contribution.m_registrationIndex;
+		}
+	}
+}
+
+void ForestPatchSimulator::ReceiveBoundaries(const unsigned tileIndex)
+{
+	auto& tile = m_tiles[tileIndex];
+	auto& voxelGrid = tile.m_climateModel.m_environmentGrid.m_voxel;
+	for (const auto& neighborTileIndex : tile.m_neighborTileIndices)
+	{
+		const auto& neighbor = m_tiles[neighborTileIndex];
+		const auto slot = std::find(neighbor.m_neighborTileIndices.begin(), neighbor.m_neighborTileIndices.end(), tileIndex) - neighbor.m_neighborTileIndices.begin();
+		for (const auto& boundaryContribution : neighbor.m_exports[slot])
+		{
+			auto& data = voxelGrid.Ref(boundaryContribution.m_coordinate - tile.m_minCoordinate);
+			data.m_shadowIntensity += boundaryContribution.m_shadowIntensity;
+			data.m_totalBiomass += boundaryContribution.m_biomass;
+			if (boundaryContribution.m_registrationIndex != -1)
+			{
+				data.m_internodeVoxelRegistrations.emplace_back(neighbor.m_buffer.m_registrations[boundaryContribution.m_registrationIndex]);
+			}
+		}
+	}
+}
@@ -4,7 +4,7 @@
 
 using namespace EcoSysLab;
 
-float HeightField::GetValue(const glm::vec2& position)
+float HeightField::GetValue(const glm::vec2& position) const
 {
 	float retVal = 0.0f;
 	if(position.x < 0)
@@ -15,12 +15,142 @@ float HeightField::GetValue(const glm::vec2& position)
 	return retVal;
 }
 
+float HeightFieldLevel::Fetch(const int x, const int y) const
+{
+	return m_heights[glm::clamp(x, 0, m_resolution.x - 1) + glm::clamp(y, 0, m_resolution.y - 1) * m_resolution.x];
+}
+
+size_t HeightField::GetNoiseFingerprint() const
+{
+	size_t fingerprint = 0;
+	const auto combine = [&](const float value)
+		{
+			fingerprint ^= std::hash<float>()(value) + 0x9e3779b9 + (fingerprint << 6) + (fingerprint >> 2);
+		};
+	combine(m_noises2D.m_minMax.x);
+	combine(m_noises2D.m_minMax.y);
+	for (const auto& noiseDescriptor : m_noises2D.m_noiseDescriptors)
+	{
+		combine(static_cast<float>(noiseDescriptor.m_type));
+		combine(noiseDescriptor.m_frequency);
+		combine(noiseDescriptor.m_intensity);
+		combine(noiseDescriptor.m_multiplier);
+		combine(noiseDescriptor.m_min);
+		combine(noiseDescriptor.m_max);
+		combine(noiseDescriptor.m_offset);
+		combine(noiseDescriptor.m_shift.x);
+		combine(noiseDescriptor.m_shift.y);
+		combine(noiseDescriptor.m_shift.z);
+		combine(noiseDescriptor.m_ridgid ? 1.0f : 0.0f);
+	}
+	return fingerprint;
+}
+
+const HeightFieldBake* HeightField::FindBake(const float cellSize) const
+{
+	for (const auto& bake : m_bakes)
+	{
+		if (bake.m_levels[0].m_cellSize == cellSize) return &bake;
+	}
+	return nullptr;
+}
+
+void HeightField::Bake(const glm::vec2& min, const glm::vec2& max, const float cellSize, const int levelCount)
+{
+	if (cellSize <= 0.0f) return;
+	const auto fingerprint = GetNoiseFingerprint();
+	const auto resolution = glm::max(glm::ivec2(glm::ceil((max - min) / cellSize)) + 1, glm::ivec2(1));
+	auto* bake = const_cast<HeightFieldBake*>(FindBake(cellSize));
+	if (bake && bake->m_fingerprint == fingerprint && bake->m_levels.size() == static_cast<size_t>(glm::max(levelCount, 1))
+		&& bake->m_levels[0].m_origin == min && bake->m_levels[0].m_resolution == resolution) return;
+	if (!bake) bake = &m_bakes.emplace_back();
+
+	auto& levels = bake->m_levels;
+	levels.resize(glm::max(levelCount, 1));
+	auto& baseLevel = levels[0];
+	baseLevel.m_origin = min;
+	baseLevel.m_cellSize = cellSize;
+	baseLevel.m_resolution = resolution;
+	baseLevel.m_heights.resize(resolution.x * resolution.y);
+	Jobs::ParallelFor(resolution.y, [&](unsigned y)
+		{
+			std::vector<glm::vec2> positions(resolution.x);
+			for (int x = 0; x < resolution.x; x++) positions[x] = min + cellSize * glm::vec2(x, y);
+			std::vector<float> heights;
+			m_noises2D.GetValues(positions, heights);
+			std::copy(heights.begin(), heights.end(), baseLevel.m_heights.begin() + y * resolution.x);
+		}
+	);
+	//Each coarser sample averages the 2x2 finer samples it covers.
+	for (int levelIndex = 1; levelIndex < levels.size(); levelIndex++)
+	{
+		const auto& finerLevel = levels[levelIndex - 1];
+		auto& level = levels[levelIndex];
+		level.m_origin = finerLevel.m_origin + 0.5f * finerLevel.m_cellSize;
+		level.m_cellSize = finerLevel.m_cellSize * 2.0f;
+		level.m_resolution = glm::max((finerLevel.m_resolution + 1) / 2, glm::ivec2(1));
+		level.m_heights.resize(level.m_resolution.x * level.m_resolution.y);
+		Jobs::ParallelFor(level.m_resolution.y, [&](unsigned y)
+			{
+				for (int x = 0; x < level.m_resolution.x; x++)
+				{
+					level.m_heights[x + y * level.m_resolution.x] = 0.25f * (
+						finerLevel.Fetch(2 * x, 2 * y) + finerLevel.Fetch(2 * x + 1, 2 * y)
+						+ finerLevel.Fetch(2 * x, 2 * y + 1) + finerLevel.Fetch(2 * x + 1, 2 * y + 1));
+				}
+			}
+		);
+	}
+	bake->m_fingerprint = fingerprint;
+}
+
+void HeightField::InvalidateCache()
+{
+	m_bakes.clear();
+}
+
+float HeightField::Sample(const glm::vec2& position, const float cellSize, const int level, const bool bicubic) const
+{
+	const auto* bake = FindBake(cellSize);
+	//The fingerprint catches edits of the noise that bypass the inspector.
+	if (!bake || bake->m_fingerprint != GetNoiseFingerprint()) return GetValue(position);
+	const auto& cacheLevel = bake->m_levels[glm::clamp(level, 0, static_cast<int>(bake->m_levels.size()) - 1)];
+	const auto coordinate = (position - cacheLevel.m_origin) / cacheLevel.m_cellSize;
+	if (coordinate.x < 0.0f || coordinate.y < 0.0f
+		|| coordinate.x > cacheLevel.m_resolution.x - 1 || coordinate.y > cacheLevel.m_resolution.y - 1) return GetValue(position);
+	const auto base = glm::max(glm::min(glm::ivec2(glm::floor(coordinate)), cacheLevel.m_resolution - 2), glm::ivec2(0));
+	const auto t = coordinate - glm::vec2(base);
+	if (t.x == 0.0f && t.y == 0.0f) return cacheLevel.Fetch(base.x, base.y);
+	if (!bicubic)
+	{
+		const auto h0 = glm::mix(cacheLevel.Fetch(base.x, base.y), cacheLevel.Fetch(base.x + 1, base.y), t.x);
+		const auto h1 = glm::mix(cacheLevel.Fetch(base.x, base.y + 1), cacheLevel.Fetch(base.x + 1, base.y + 1), t.x);
+		return glm::mix(h0, h1, t.y);
+	}
+	const auto catmullRom = [](const float p0, const float p1, const float p2, const float p3, const float x)
+		{
+			return p1 + 0.5f * x * (p2 - p0 + x * (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3 + x * (3.0f * (p1 - p2) + p3 - p0)));
+		};
+	float rows[4];
+	for (int i = 0; i < 4; i++)
+	{
+		const auto y = base.y - 1 + i;
+		rows[i] = catmullRom(cacheLevel.Fetch(base.x - 1, y), cacheLevel.Fetch(base.x, y),
+			cacheLevel.Fetch(base.x + 1, y), cacheLevel.Fetch(base.x + 2, y), t.x);
+	}
+	return catmullRom(rows[0], rows[1], rows[2], rows[3], t.y);
+}
+
 void HeightField::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 {
 	bool changed = false;
 	changed = ImGui::DragInt("Precision level", &m_precisionLevel) || changed;
 	changed = m_noises2D.OnInspect() | changed;
-	if (changed) m_saved = false;
+	if (changed)
+	{
+		m_saved = false;
+		InvalidateCache();
+	}
 }
 
 void HeightField::Serialize(YAML::Emitter& out)
@@ -34,30 +164,60 @@ void HeightField::Deserialize(const YAML::Node& in)
 	if (in["m_precisionLevel"])
 		m_precisionLevel = in["m_precisionLevel"].as<int>();
 	m_noises2D.Load("m_noises2D", in);
+	InvalidateCache();
 }
 
 void HeightField::GenerateMesh(const glm::vec2& start, const glm::uvec2& resolution, float unitSize, std::vector<Vertex>& vertices, std::vector<glm::uvec3>& triangles, float xDepth, float zDepth)
 {
-	for (unsigned i = 0; i < resolution.x * m_precisionLevel; i++) {
-		for (unsigned j = 0; j < resolution.y * m_precisionLevel; j++) {
-			Vertex archetype;
-			archetype.m_position.x = start.x + unitSize * i / m_precisionLevel;
-			archetype.m_position.z = start.y + unitSize * j / m_precisionLevel;
-			archetype.m_position.y = GetValue({ archetype.m_position.x , archetype.m_position.z });
-			archetype.m_texCoord = glm::vec2(static_cast<float>(i) / (resolution.x * m_precisionLevel),
-				static_cast<float>(j) / (resolution.y * m_precisionLevel));
-			vertices.push_back(archetype);
+	const int xSize = resolution.x * m_precisionLevel;
+	const int ySize = resolution.y * m_precisionLevel;
+	const auto vertexOffset = vertices.size();
+	vertices.resize(vertexOffset + xSize * ySize);
+	Jobs::ParallelFor(xSize, [&](unsigned i)
+		{
+			std::vector<glm::vec2> positions(ySize);
+			for (int j = 0; j < ySize; j++)
+			{
+				positions[j] = glm::vec2(start.x + unitSize * i / m_precisionLevel, start.y + unitSize * j / m_precisionLevel);
+			}
+			std::vector<float> heights;
+			m_noises2D.GetValues(positions, heights);
+			for (int j = 0; j < ySize; j++)
+			{
+				auto& vertex = vertices[vertexOffset + i * ySize + j];
+				vertex = Vertex();
+				vertex.m_position = glm::vec3(positions[j].x, heights[j], positions[j].y);
+				vertex.m_texCoord = glm::vec2(static_cast<float>(i) / xSize, static_cast<float>(j) / ySize);
+			}
 		}
-	}
+	);
+	//Central differences, one sided at the borders.
+	Jobs::ParallelFor(xSize, [&](unsigned i)
+		{
+			const int i0 = glm::max(static_cast<int>(i) - 1, 0);
+			const int i1 = glm::min(static_cast<int>(i) + 1, xSize - 1);
+			for (int j = 0; j < ySize; j++)
+			{
+				const int j0 = glm::max(j - 1, 0);
+				const int j1 = glm::min(j + 1, ySize - 1);
+				const auto& p = vertices[vertexOffset + i * ySize + j].m_position;
+				const auto dx = vertices[vertexOffset + i1 * ySize + j].m_position - vertices[vertexOffset + i0 * ySize + j].m_position;
+				const auto dz = vertices[vertexOffset + i * ySize + j1].m_position - vertices[vertexOffset + i * ySize + j0].m_position;
+				auto normal = glm::vec3(0, 1, 0);
+				if (i1 != i0 && j1 != j0) normal = glm::normalize(glm::cross(dz, dx));
+				vertices[vertexOffset + i * ySize + j].m_normal = normal;
+			}
+		}
+	);
 
-	for (int i = 0; i < resolution.x * m_precisionLevel - 1; i++) {
-		for (int j = 0; j < resolution.y * m_precisionLevel - 1; j++) {
-			if (static_cast<float>(i) / (resolution.x * m_precisionLevel - 2) > (1.0 - zDepth) && static_cast<float>(j) / (resolution.y * m_precisionLevel - 2) < xDepth) continue;
-			const int n = resolution.x * m_precisionLevel;
+	triangles.reserve(triangles.size() + 2 * glm::max(xSize - 1, 0) * glm::max(ySize - 1, 0));
+	for (int i = 0; i < xSize - 1; i++) {
+		for (int j = 0; j < ySize - 1; j++) {
+			if (static_cast<float>(i) / (xSize - 2) > (1.0 - zDepth) && static_cast<float>(j) / (ySize - 2) < xDepth) continue;
+			const int n = xSize;
 			triangles.emplace_back(i + j * n, i + 1 + j * n, i + (j + 1) * n);
 			triangles.emplace_back(i + 1 + (j + 1) * n, i + (j + 1) * n,
 				i + 1 + j * n);
 		}
 	}
 }
-
@@ -2,6 +2,82 @@
 #include "glm/gtc/noise.hpp"
 using namespace EcoSysLab;
 
+/**
+ * Shared batched evaluation. Unlike GetValue, the loops run per descriptor over all positions, so the type switch is
+ * taken once per descriptor and the clamp/accumulate passes are straight loops over contiguous floats. Perlin and simplex
+ * are still one scalar glm call per position, the batch only saves the per position dispatch, it is not a SIMD kernel.
+ */
+template <typename T>
+void EvaluateNoises(const std::vector<NoiseDescriptor>& noiseDescriptors, const glm::vec2& minMax,
+	const std::vector<T>& positions, std::vector<float>& values)
+{
+	const auto size = positions.size();
+	values.resize(size);
+	std::fill(values.begin(), values.end(), 0.0f);
+	std::vector<float> noises(size);
+	for (const auto& noiseDescriptor : noiseDescriptors)
+	{
+		const auto shift = T(noiseDescriptor.m_shift);
+		const auto offset = T(noiseDescriptor.m_offset);
+		bool clamp = true;
+		switch (static_cast<NoiseType>(noiseDescriptor.m_type))
+		{
+		case NoiseType::Perlin:
+			for (size_t i = 0; i < size; i++)
+			{
+				noises[i] = glm::perlin(noiseDescriptor.m_frequency * (positions[i] + shift) + offset) * noiseDescriptor.m_multiplier;
+			}
+			break;
+		case NoiseType::Simplex:
+			for (size_t i = 0; i < size; i++)
+			{
+				noises[i] = glm::simplex(noiseDescriptor.m_frequency * (positions[i] + shift) + offset) * noiseDescriptor.m_multiplier;
+			}
+			break;
+		case NoiseType::Constant:
+			std::fill(noises.begin(), noises.end(), noiseDescriptor.m_offset);
+			clamp = false;
+			break;
+		case NoiseType::Linear:
+			for (size_t i = 0; i < size; i++)
+			{
+				const auto actualPosition = positions[i] + shift;
+				if constexpr (std::is_same_v<T, glm::vec3>)
+				{
+					noises[i] = noiseDescriptor.m_offset + noiseDescriptor.m_frequency * actualPosition.x + noiseDescriptor.m_intensity * actualPosition.y + noiseDescriptor.m_multiplier * actualPosition.z;
+				}
+				else
+				{
+					noises[i] = noiseDescriptor.m_offset + noiseDescriptor.m_frequency * actualPosition.x + noiseDescriptor.m_intensity * actualPosition.y;
+				}
+			}
+			break;
+		default:
+			std::fill(noises.begin(), noises.end(), 0.0f);
+			clamp = false;
+			break;
+		}
+		if (clamp)
+		{
+			for (size_t i = 0; i < size; i++) noises[i] = glm::clamp(noises[i], noiseDescriptor.m_min, noiseDescriptor.m_max);
+		}
+		//pow(x, 1) is x, which is the common case.
+		if (noiseDescriptor.m_intensity != 1.0f)
+		{
+			for (size_t i = 0; i < size; i++) noises[i] = glm::pow(noises[i], noiseDescriptor.m_intensity);
+		}
+		if (noiseDescriptor.m_ridgid)
+		{
+			for (size_t i = 0; i < size; i++) values[i] -= glm::abs(noises[i]);
+		}
+		else
+		{
+			for (size_t i = 0; i < size; i++) values[i] += noises[i];
+		}
+	}
+	for (size_t i = 0; i < size; i++) values[i] = glm::clamp(values[i], minMax.x, minMax.y);
+}
+
 
 void NoiseDescriptor::Serialize(YAML::Emitter& out) const
 {
@@ -227,6 +303,11 @@ float Noises2D::GetValue(const glm::vec2& position) const
 	return glm::clamp(retVal, m_minMax.x, m_minMax.y);
 }
 
+void Noises2D::GetValues(const std::vector<glm::vec2>& positions, std::vector<float>& values) const
+{
+	EvaluateNoises(m_noiseDescriptors, m_minMax, positions, values);
+}
+
 
 bool Noises3D::OnInspect() {
 	bool changed = false;
@@ -350,4 +431,9 @@ float Noises3D::GetValue(const glm::vec3& position) const
 		retVal += noise;
 	}
 	return glm::clamp(retVal, m_minMax.x, m_minMax.y);
-}
\ No newline at end of file
+}
+
+void Noises3D::GetValues(const std::vector<glm::vec3>& positions, std::vector<float>& values) const
+{
+	EvaluateNoises(m_noiseDescriptors, m_minMax, positions, values);
+}
@@ -2,22 +2,55 @@
 // Created by lllll on 2/23/2022.
 //
 #include <Jobs.hpp>
-#ifdef BUILD_WITH_RAYTRACER
 #include "PARSensorGroup.hpp"
+#ifdef BUILD_WITH_RAYTRACER
 #include "RayTracerLayer.hpp"
+#endif
 #include "Graphics.hpp"
+#include "SorghumLayer.hpp"
 
 using namespace EcoSysLab;
+#ifdef BUILD_WITH_RAYTRACER
 void EcoSysLab::PARSensorGroup::CalculateIllumination(
     const RayProperties &rayProperties, int seed, float pushNormalDistance) {
-  if (m_samplers.empty())
+  if (m_sensors.empty())
     return;
+  std::vector<IlluminationSampler<glm::vec3>> samplers(m_sensors.size());
+  for (size_t i = 0; i < m_sensors.size(); i++) {
+    samplers[i].m_a.m_position = samplers[i].m_b.m_position = samplers[i].m_c.m_position = m_sensors[i].m_position;
+    samplers[i].m_a.m_normal = samplers[i].m_b.m_normal = samplers[i].m_c.m_normal = m_sensors[i].m_normal;
+    samplers[i].m_frontFace = true;
+    samplers[i].m_backFace = false;
+  }
   CudaModule::EstimateIlluminationRayTracing(
       Application::GetLayer<RayTracerLayer>()->m_environmentProperties,
-      rayProperties, m_samplers, seed, pushNormalDistance);
+      rayProperties, samplers, seed, pushNormalDistance);
+  for (size_t i = 0; i < m_sensors.size(); i++) {
+    m_sensors[i].m_energy = samplers[i].m_energy;
+    m_sensors[i].m_direction = samplers[i].m_direction;
+  }
+}
+#endif
+void PARSensorGroup::CalculateIllumination(const CanopyIlluminationEstimator &estimator,
+                                           const CanopyIlluminationSettings &settings,
+                                           const SkyIlluminanceSnapshot &snapshot) {
+  if (m_sensors.empty())
+    return;
+  std::vector<glm::vec3> positions(m_sensors.size());
+  std::vector<glm::vec3> normals(m_sensors.size());
+  for (size_t i = 0; i < m_sensors.size(); i++) {
+    positions[i] = m_sensors[i].m_position;
+    normals[i] = m_sensors[i].m_normal;
+  }
+  std::vector<CanopyIrradiance> irradiances;
+  estimator.EstimatePoints(positions, normals, settings, snapshot, irradiances);
+  for (size_t i = 0; i < m_sensors.size(); i++) {
+    m_sensors[i].m_energy = irradiances[i].m_energy;
+    m_sensors[i].m_direction = irradiances[i].m_direction;
+  }
 }
 void PARSensorGroup::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
-  ImGui::Text("Sampler size: %llu", m_samplers.size());
+  ImGui::Text("Sensor size: %llu", m_sensors.size());
   if (ImGui::TreeNode("Grid settings")) {
     static auto minRange = glm::vec3(-25, 0, -25);
     static auto maxRange = glm::vec3(25, 3, 25);
@@ -36,7 +69,7 @@ void PARSensorGroup::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
       const int sy = (int)((maxRange.y - minRange.y + step) / step);
       const int sz = (int)((maxRange.z - minRange.z + step) / step);
       auto voxelSize = sx * sy * sz;
-      m_samplers.resize(voxelSize);
+      m_sensors.resize(voxelSize);
       std::vector<std::shared_future<void>> results;
       Jobs::ParallelFor(
           voxelSize,
@@ -45,10 +78,8 @@ void PARSensorGroup::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
             float y = ((i / sz) % sy) * step + minRange.y;
             float x = ((i / sz / sy) % sx) * step + minRange.x;
             glm::vec3 start = {x, y, z};
-            m_samplers[i].m_a.m_position = m_samplers[i].m_b.m_position = m_samplers[i].m_c.m_position = start;
-            m_samplers[i].m_frontFace = true;
-						m_samplers[i].m_backFace = false;
-						m_samplers[i].m_a.m_normal = m_samplers[i].m_b.m_normal = m_samplers[i].m_c.m_normal = glm::vec3(0, 1, 0);
+            m_sensors[i].m_position = start;
+            m_sensors[i].m_normal = glm::vec3(0, 1, 0);
           },
           results);
       for (const auto &i : results)
@@ -57,15 +88,20 @@ void PARSensorGroup::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
     ImGui::TreePop();
   }
   if (ImGui::TreeNode("Estimation")) {
+#ifdef BUILD_WITH_RAYTRACER
     static RayProperties rayProperties = {8, 1000};
     rayProperties.OnInspect();
     if (ImGui::Button("Run!"))
       CalculateIllumination(rayProperties, 0, 0.0f);
+#endif
+    if (ImGui::Button("Run on CPU"))
+      Application::GetLayer<SorghumLayer>()->CalculateIlluminationCpu(
+          std::dynamic_pointer_cast<PARSensorGroup>(GetSelf()));
     ImGui::TreePop();
   }
   static bool draw = true;
   ImGui::Checkbox("Render field", &draw);
-  if (draw && !m_samplers.empty()) {
+  if (draw && !m_sensors.empty()) {
     static float lineWidth = 0.05f;
     static float lineLengthFactor = 3.0f;
     static float pointSize = 0.1f;
@@ -81,21 +117,21 @@ void PARSensorGroup::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
     
     static glm::vec4 color = {0.0f, 1.0f, 0.0f, 0.5f};
     static glm::vec4 pointColor = {1.0f, 0.0f, 0.0f, 0.75f};
-    starts.resize(m_samplers.size());
-    ends.resize(m_samplers.size());
-    rayParticleInfoList->m_particleInfos.resize(m_samplers.size());
-    pointParticleInfoList->m_particleInfos.resize(m_samplers.size());
+    starts.resize(m_sensors.size());
+    ends.resize(m_sensors.size());
+    rayParticleInfoList->m_particleInfos.resize(m_sensors.size());
+    pointParticleInfoList->m_particleInfos.resize(m_sensors.size());
     ImGui::DragFloat("Vector width", &lineWidth, 0.01f);
     ImGui::DragFloat("Vector length factor", &lineLengthFactor, 0.01f);
     ImGui::ColorEdit4("Vector Color", &color.x);
     ImGui::DragFloat("Point Size", &pointSize, 0.01f);
     ImGui::ColorEdit4("Point Color", &pointColor.x);
     Jobs::ParallelFor(
-        m_samplers.size(),
+        m_sensors.size(),
         [&](unsigned i) {
-          const auto start = m_samplers[i].m_a.m_position;
+          const auto start = m_sensors[i].m_position;
           starts[i] = start;
-          ends[i] = start + m_samplers[i].m_direction * lineLengthFactor * m_samplers[i].m_energy;
+          ends[i] = start + m_sensors[i].m_direction * lineLengthFactor * m_sensors[i].m_energy;
           pointParticleInfoList->m_particleInfos[i].m_instanceMatrix.m_value =
               glm::translate(start) * glm::scale(glm::vec3(pointSize));
           pointParticleInfoList->m_particleInfos[i].m_instanceColor = pointColor;
@@ -106,18 +142,33 @@ void PARSensorGroup::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
   }
 }
 void PARSensorGroup::Serialize(YAML::Emitter &out) {
-  if (!m_samplers.empty())
+  if (!m_sensors.empty())
   {
-    out << YAML::Key << "m_samplers" << YAML::Value
-        << YAML::Binary((const unsigned char *)m_samplers.data(), m_samplers.size() * sizeof(IlluminationSampler<glm::vec3>));
+    out << YAML::Key << "m_sensors" << YAML::Value
+        << YAML::Binary((const unsigned char *)m_sensors.data(), m_sensors.size() * sizeof(PARSensor));
   }
 }
 void PARSensorGroup::Deserialize(const YAML::Node &in) {
-  if (in["m_samplers"])
+  if (in["m_sensors"])
   {
+    auto binaryList = in["m_sensors"].as<YAML::Binary>();
+    m_sensors.resize(binaryList.size() / sizeof(PARSensor));
+    std::memcpy(m_sensors.data(), binaryList.data(), binaryList.size());
+  }
+#ifdef BUILD_WITH_RAYTRACER
+  else if (in["m_samplers"])
+  {
+    // Groups saved before the sensors were split from the ray tracer samplers.
     auto binaryList = in["m_samplers"].as<YAML::Binary>();
-    m_samplers.resize(binaryList.size() / sizeof(IlluminationSampler<glm::vec3>));
-    std::memcpy(m_samplers.data(), binaryList.data(), binaryList.size());
+    std::vector<IlluminationSampler<glm::vec3>> samplers(binaryList.size() / sizeof(IlluminationSampler<glm::vec3>));
+    std::memcpy(samplers.data(), binaryList.data(), binaryList.size());
+    m_sensors.resize(samplers.size());
+    for (size_t i = 0; i < samplers.size(); i++) {
+      m_sensors[i].m_position = samplers[i].m_a.m_position;
+      m_sensors[i].m_normal = samplers[i].m_a.m_normal;
+      m_sensors[i].m_energy = samplers[i].m_energy;
+      m_sensors[i].m_direction = samplers[i].m_direction;
+    }
   }
+#endif
 }
-#endif
\ No newline at end of file
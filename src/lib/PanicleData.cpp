@@ -4,6 +4,7 @@
 
 #include "PanicleData.hpp"
 #include "IVolume.hpp"
+#include <random>
 using namespace EcoSysLab;
 void PanicleData::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 
@@ -18,7 +19,7 @@ void PanicleData::Serialize(YAML::Emitter &out) {
 void PanicleData::Deserialize(const YAML::Node &in) {
   ISerializable::Deserialize(in);
 }
-void PanicleData::FormPanicle(const SorghumStatePair &sorghumStatePair) {
+void PanicleData::FormPanicle(const SorghumStatePair &sorghumStatePair, const unsigned seed) {
   m_vertices.clear();
   m_triangles.clear();
   auto pinnacleSize = glm::mix(sorghumStatePair.m_left.m_panicle.m_panicleSize, sorghumStatePair.m_right.m_panicle.m_panicleSize, sorghumStatePair.m_a);
@@ -29,12 +30,17 @@ void PanicleData::FormPanicle(const SorghumStatePair &sorghumStatePair) {
   SphereMeshGenerator::Icosahedron(icosahedronVertices, icosahedronTriangles);
   int offset = 0;
   EvoEngine::Vertex archetype = {};
-  SphericalVolume volume;
-  volume.m_radius = pinnacleSize;
+  // Panicles are formed on the workers, so the seeds are scattered with an engine of their own instead of the global rand.
+  std::mt19937 random(seed * 2654435761u + 1u);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
   for (int seedIndex = 0;
        seedIndex < seedAmount;
        seedIndex++) {
-    glm::vec3 positionOffset = volume.GetRandomPoint();
+    glm::vec3 positionOffset;
+    do {
+      positionOffset = glm::vec3(unit(random), unit(random), unit(random));
+    } while (glm::dot(positionOffset, positionOffset) > 1.0f);
+    positionOffset *= pinnacleSize;
     for (const auto position : icosahedronVertices) {
       archetype.m_position =
           position * seedRadius + glm::vec3(0, pinnacleSize.y, 0) +
@@ -28,7 +28,7 @@ void ParticleCell::UnregisterParticle(ParticleHandle handle)
 	}
 }
 
-void ParticleGrid2D::ApplyBoundaries(const ProfileConstraints& profileBoundaries)
+void ParticleGrid2D::ApplyBoundaries(const ProfileConstraints& profileBoundaries, const bool parallel)
 {
 	auto& cells = m_cells;
 	if (profileBoundaries.m_boundaries.empty() && profileBoundaries.m_attractors.empty())
@@ -39,10 +39,22 @@ void ParticleGrid2D::ApplyBoundaries(const ProfileConstraints& profileBoundaries
 		}
 	}
 	else {
-		for (int cellIndex = 0; cellIndex < m_cells.size(); cellIndex++) {
-			auto& cell = cells[cellIndex];
-			const auto cellPosition = GetPosition(cellIndex);
-			cell.m_target = profileBoundaries.GetTarget(cellPosition);
+		CompiledProfileConstraints compiledConstraints{};
+		compiledConstraints.Compile(profileBoundaries);
+		if (parallel)
+		{
+			Jobs::ParallelFor(m_cells.size(), [&](unsigned cellIndex)
+				{
+					cells[cellIndex].m_target = compiledConstraints.GetTarget(GetPosition(cellIndex));
+				}
+			);
+		}
+		else {
+			for (int cellIndex = 0; cellIndex < m_cells.size(); cellIndex++) {
+				auto& cell = cells[cellIndex];
+				const auto cellPosition = GetPosition(cellIndex);
+				cell.m_target = compiledConstraints.GetTarget(cellPosition);
+			}
 		}
 	}
 }
@@ -172,7 +172,7 @@ void ParticlePhysics2DDemo::FixedUpdate()
 	m_particlePhysics2D.Simulate(Times::TimeStep() / m_particlePhysics2D.GetDeltaTime(),
 		[&](auto& grid, bool gridResized)
 		{
-			if (gridResized || m_boundariesUpdated) grid.ApplyBoundaries(m_profileBoundaries);
+			if (gridResized || m_boundariesUpdated) grid.ApplyBoundaries(m_profileBoundaries, m_particlePhysics2D.m_parallel);
 			m_boundariesUpdated = false;
 		},
 		[&](auto& particle)
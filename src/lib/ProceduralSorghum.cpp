@@ -14,25 +14,95 @@
 using namespace EcoSysLab;
 static const char *StateModes[]{"Default", "Cubic-Bezier"};
 
+size_t ProceduralSorghum::UpperBound(const float time, size_t &cursor) const {
+  const auto size = m_sorghumStates.size();
+  const auto isUpperBound = [&](const size_t index) {
+    return index <= size &&
+           (index == 0 || m_sorghumStates[index - 1].first <= time) &&
+           (index == size || m_sorghumStates[index].first > time);
+  };
+  // Animations query forward in time, so the result is usually the previous
+  // one or the one after it.
+  if (isUpperBound(cursor))
+    return cursor;
+  if (isUpperBound(cursor + 1))
+    return ++cursor;
+  cursor = std::upper_bound(m_sorghumStates.begin(), m_sorghumStates.end(),
+                            time,
+                            [](const float t, const auto &state) {
+                              return t < state.first;
+                            }) -
+           m_sorghumStates.begin();
+  return cursor;
+}
+
+void ProceduralSorghum::SortStates() {
+  std::stable_sort(
+      m_sorghumStates.begin(), m_sorghumStates.end(),
+      [](const auto &a, const auto &b) { return a.first < b.first; });
+}
+
 SorghumStatePair ProceduralSorghum::Get(float time) const {
   SorghumStatePair retVal;
-  retVal.m_mode = m_mode;
-  if (m_sorghumStates.empty())
+  size_t cursor = 0;
+  Get(time, retVal, cursor);
+  return retVal;
+}
+
+void ProceduralSorghum::Get(float time, SorghumStatePair &statePair,
+                            size_t &cursor) const {
+  statePair.m_mode = m_mode;
+  if (m_sorghumStates.empty()) {
+    statePair.m_left = statePair.m_right = SorghumState();
+    statePair.m_a = 1.0f;
+    return;
+  }
+  auto actualTime = glm::clamp(time, 0.0f, 99999.0f);
+  const auto next = UpperBound(actualTime, cursor);
+  if (next == 0) {
+    // Get from zero state to first state.
+    statePair.m_left = SorghumState();
+    statePair.m_left.m_leaves.clear();
+    statePair.m_left.m_stem.m_length = 0;
+    statePair.m_right = m_sorghumStates.front().second;
+    statePair.m_a = actualTime / m_sorghumStates.front().first;
+    return;
+  }
+  if (next == m_sorghumStates.size()) {
+    statePair.m_left = m_sorghumStates.back().second;
+    statePair.m_right = m_sorghumStates.back().second;
+    statePair.m_a = 1.0f;
+    return;
+  }
+  const auto &[previousTime, previousState] = m_sorghumStates[next - 1];
+  const auto &[nextTime, nextState] = m_sorghumStates[next];
+  statePair.m_left = previousState;
+  statePair.m_right = nextState;
+  statePair.m_a = (actualTime - previousTime) / (nextTime - previousTime);
+}
+
+/**
+ * The lookup before the binary search, a linear scan that copies every state it passes. Kept as the reference for
+ * BenchmarkGet.
+ */
+static SorghumStatePair LinearGet(const std::vector<std::pair<float, SorghumState>> &sorghumStates, const int mode,
+                                  const float time) {
+  SorghumStatePair retVal;
+  retVal.m_mode = mode;
+  if (sorghumStates.empty())
     return retVal;
   auto actualTime = glm::clamp(time, 0.0f, 99999.0f);
-  float previousTime = m_sorghumStates.begin()->first;
-  SorghumState previousState = m_sorghumStates.begin()->second;
+  float previousTime = sorghumStates.begin()->first;
+  SorghumState previousState = sorghumStates.begin()->second;
   if (actualTime < previousTime) {
-    // Get from zero state to first state.
     retVal.m_left = SorghumState();
     retVal.m_left.m_leaves.clear();
     retVal.m_left.m_stem.m_length = 0;
-    retVal.m_right = m_sorghumStates.begin()->second;
+    retVal.m_right = sorghumStates.begin()->second;
     retVal.m_a = actualTime / previousTime;
     return retVal;
   }
-  for (auto it = (++m_sorghumStates.begin()); it != m_sorghumStates.end();
-       it++) {
+  for (auto it = (++sorghumStates.begin()); it != sorghumStates.end(); it++) {
     if (it->first > actualTime) {
       retVal.m_left = previousState;
       retVal.m_right = it->second;
@@ -42,13 +112,63 @@ SorghumStatePair ProceduralSorghum::Get(float time) const {
     previousTime = it->first;
     previousState = it->second;
   }
-
-  retVal.m_left = (--m_sorghumStates.end())->second;
-  retVal.m_right = (--m_sorghumStates.end())->second;
+  retVal.m_left = (--sorghumStates.end())->second;
+  retVal.m_right = (--sorghumStates.end())->second;
   retVal.m_a = 1.0f;
   return retVal;
 }
 
+void ProceduralSorghum::BenchmarkGet(const int queryCount) const {
+  if (m_sorghumStates.empty() || queryCount <= 0) {
+    EVOENGINE_ERROR("No states to look up!");
+    return;
+  }
+  const float endTime = m_sorghumStates.back().first;
+  const auto queryTime = [&](const int i) {
+    return endTime * static_cast<float>(i) / static_cast<float>(queryCount);
+  };
+  std::vector<SorghumStatePair> linear(queryCount);
+  double startTime = Times::Now();
+  for (int i = 0; i < queryCount; i++)
+    linear[i] = LinearGet(m_sorghumStates, m_mode, queryTime(i));
+  const double linearTime = Times::Now() - startTime;
+
+  std::vector<SorghumStatePair> searched(queryCount);
+  startTime = Times::Now();
+  for (int i = 0; i < queryCount; i++)
+    searched[i] = Get(queryTime(i));
+  const double searchTime = Times::Now() - startTime;
+
+  // The cursor pass writes into one pair, the way SorghumData uses it.
+  SorghumStatePair statePair;
+  size_t cursor = 0;
+  startTime = Times::Now();
+  for (int i = 0; i < queryCount; i++)
+    Get(queryTime(i), statePair, cursor);
+  const double cursorTime = Times::Now() - startTime;
+
+  int mismatches = 0;
+  cursor = 0;
+  for (int i = 0; i < queryCount; i++) {
+    Get(queryTime(i), statePair, cursor);
+    for (const auto *actual : {&statePair, &searched[i]}) {
+      const auto &expected = linear[i];
+      if (actual->m_a != expected.m_a ||
+          actual->m_left.m_leaves.size() != expected.m_left.m_leaves.size() ||
+          actual->m_right.m_leaves.size() != expected.m_right.m_leaves.size() ||
+          actual->m_left.m_stem.m_length != expected.m_left.m_stem.m_length ||
+          actual->m_right.m_stem.m_length != expected.m_right.m_stem.m_length) {
+        mismatches++;
+        break;
+      }
+    }
+  }
+  EVOENGINE_LOG(std::to_string(queryCount) + " lookups over " + std::to_string(m_sorghumStates.size()) +
+                " states: linear scan " + std::to_string(linearTime * 1000.0) + "ms, binary search " +
+                std::to_string(searchTime * 1000.0) + "ms, cursor " + std::to_string(cursorTime * 1000.0) + "ms, " +
+                std::to_string(mismatches) + " mismatches");
+}
+
 bool ProceduralPanicleState::OnInspect() {
   bool changed = false;
   if (ImGui::DragFloat("Panicle width", &m_panicleSize.x, 0.001f)) {
@@ -492,6 +612,11 @@ void ProceduralSorghum::OnInspect(const std::shared_ptr<EditorLayer>& editorLaye
     ImGui::Text("[Changed unsaved!]");
     ImGui::PopStyleColor();
   }
+  static int benchmarkQueryCount = 10000;
+  ImGui::DragInt("Benchmark queries", &benchmarkQueryCount, 100, 1, 1000000);
+  if (ImGui::Button("Benchmark lookups")) {
+    BenchmarkGet(benchmarkQueryCount);
+  }
   bool changed = false;
   FileUtils::OpenFile(
       "Import CSV", "CSV", {".csv", ".CSV"},
@@ -646,6 +771,7 @@ void ProceduralSorghum::Deserialize(const YAML::Node &in) {
       state.Deserialize(inState);
       m_sorghumStates.emplace_back(inState["Time"].as<float>(), state);
     }
+    SortStates();
   }
 }
 
@@ -668,6 +794,7 @@ void ProceduralSorghum::ResetTime(float previousTime, float newTime) {
   for (auto &i : m_sorghumStates) {
     if (i.first == previousTime) {
       i.first = newTime;
+      SortStates();
       return;
     }
   }
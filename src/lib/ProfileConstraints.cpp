@@ -325,4 +325,184 @@ glm::vec2 ProfileConstraints::GetTarget(const glm::vec2& position) const
 		}
 	}
 	return closestPoint - position;
-}
\ No newline at end of file
+}
+
+void CompiledProfileConstraints::Compile(const ProfileConstraints& profileConstraints)
+{
+	m_edges.clear();
+	m_polygons.clear();
+	m_binOffsets.clear();
+	m_binEdges.clear();
+	m_attractorSegments.clear();
+
+	m_polygons.resize(profileConstraints.m_boundaries.size());
+	for (int boundaryIndex = 0; boundaryIndex < profileConstraints.m_boundaries.size(); boundaryIndex++)
+	{
+		const auto& points = profileConstraints.m_boundaries[boundaryIndex].m_points;
+		auto& polygon = m_polygons[boundaryIndex];
+		polygon.m_center = profileConstraints.m_boundaries[boundaryIndex].m_center;
+		polygon.m_edgeOffset = m_edges.size();
+		polygon.m_edgeSize = points.size();
+		for (int lineIndex = 0; lineIndex < points.size(); lineIndex++)
+		{
+			auto& edge = m_edges.emplace_back();
+			edge.m_p1 = points[lineIndex];
+			edge.m_p2 = points[(lineIndex + 1) % points.size()];
+			edge.m_min = glm::min(edge.m_p1, edge.m_p2);
+			edge.m_max = glm::max(edge.m_p1, edge.m_p2);
+			polygon.m_min = glm::min(polygon.m_min, edge.m_min);
+			polygon.m_max = glm::max(polygon.m_max, edge.m_max);
+		}
+		if (polygon.m_edgeSize == 0) continue;
+
+		//Bin the edges into rows by their vertical extent.
+		polygon.m_binSize = polygon.m_edgeSize;
+		polygon.m_binHeight = glm::max((polygon.m_max.y - polygon.m_min.y) / polygon.m_binSize, FLT_MIN);
+		polygon.m_binOffset = m_binOffsets.size();
+		const auto getBin = [&](const float y)
+			{
+				return glm::clamp(static_cast<int>((y - polygon.m_min.y) / polygon.m_binHeight), 0, static_cast<int>(polygon.m_binSize) - 1);
+			};
+		std::vector<unsigned> binCounts(polygon.m_binSize + 1, 0);
+		for (unsigned edgeIndex = polygon.m_edgeOffset; edgeIndex < polygon.m_edgeOffset + polygon.m_edgeSize; edgeIndex++)
+		{
+			const auto& edge = m_edges[edgeIndex];
+			for (int bin = getBin(edge.m_min.y); bin <= getBin(edge.m_max.y); bin++) binCounts[bin + 1]++;
+		}
+		for (unsigned bin = 0; bin < polygon.m_binSize; bin++)
+		{
+			binCounts[bin + 1] += binCounts[bin];
+		}
+		const auto binEdgeOffset = m_binEdges.size();
+		m_binEdges.resize(binEdgeOffset + binCounts.back());
+		for (unsigned bin = 0; bin < polygon.m_binSize; bin++)
+		{
+			m_binOffsets.emplace_back(binEdgeOffset + binCounts[bin]);
+		}
+		m_binOffsets.emplace_back(binEdgeOffset + binCounts.back());
+		for (unsigned edgeIndex = polygon.m_edgeOffset; edgeIndex < polygon.m_edgeOffset + polygon.m_edgeSize; edgeIndex++)
+		{
+			const auto& edge = m_edges[edgeIndex];
+			for (int bin = getBin(edge.m_min.y); bin <= getBin(edge.m_max.y); bin++)
+			{
+				m_binEdges[binEdgeOffset + binCounts[bin]] = edgeIndex;
+				binCounts[bin]++;
+			}
+		}
+	}
+
+	for (const auto& attractor : profileConstraints.m_attractors)
+	{
+		if (attractor.m_attractorPoints.empty())
+		{
+			auto& segment = m_attractorSegments.emplace_back();
+			segment.m_p1 = segment.m_p2 = glm::vec2(0.0f);
+			segment.m_point = true;
+			continue;
+		}
+		for (const auto& attractorPoint : attractor.m_attractorPoints)
+		{
+			auto& segment = m_attractorSegments.emplace_back();
+			segment.m_p1 = attractorPoint.first;
+			segment.m_p2 = attractorPoint.second;
+		}
+	}
+}
+
+bool CompiledProfileConstraints::InPolygon(const Polygon& polygon, const glm::vec2& position) const
+{
+	if (polygon.m_edgeSize == 0
+		|| position.x < polygon.m_min.x || position.x > polygon.m_max.x
+		|| position.y < polygon.m_min.y || position.y > polygon.m_max.y) return false;
+	const auto bin = glm::clamp(static_cast<int>((position.y - polygon.m_min.y) / polygon.m_binHeight), 0, static_cast<int>(polygon.m_binSize) - 1);
+	const auto binStart = m_binOffsets[polygon.m_binOffset + bin];
+	const auto binEnd = m_binOffsets[polygon.m_binOffset + bin + 1];
+	//Crossing number of a ray towards +x, with half-open edges so shared vertices count once.
+	bool inside = false;
+	for (auto i = binStart; i < binEnd; i++)
+	{
+		const auto& edge = m_edges[m_binEdges[i]];
+		const auto& p1 = edge.m_p1;
+		const auto& p2 = edge.m_p2;
+		if ((p1.y > position.y) == (p2.y > position.y)) continue;
+		const auto x = p1.x + (position.y - p1.y) * (p2.x - p1.x) / (p2.y - p1.y);
+		if (position.x < x) inside = !inside;
+	}
+	return inside;
+}
+
+glm::vec2 CompiledProfileConstraints::GetTarget(const glm::vec2& position) const
+{
+	auto closestPoint = glm::vec2(0.0f);
+	int boundaryIndex = -1;
+	auto distanceToClosestPointOnBoundary = FLT_MAX;
+	auto distanceToClosestBoundaryCenter = FLT_MAX;
+	for (int currentBoundaryIndex = 0; currentBoundaryIndex < m_polygons.size(); currentBoundaryIndex++)
+	{
+		const auto& polygon = m_polygons[currentBoundaryIndex];
+		if (InPolygon(polygon, position))
+		{
+			const auto currentDistanceToBoundaryCenter = glm::distance(position, polygon.m_center);
+			if (currentDistanceToBoundaryCenter < distanceToClosestBoundaryCenter)
+			{
+				distanceToClosestBoundaryCenter = currentDistanceToBoundaryCenter;
+				boundaryIndex = currentBoundaryIndex;
+			}
+			continue;
+		}
+		if (polygon.m_edgeSize == 0)
+		{
+			const auto currentDistance = glm::length(position);
+			if (currentDistance < distanceToClosestPointOnBoundary)
+			{
+				distanceToClosestPointOnBoundary = currentDistance;
+				closestPoint = glm::vec2(0.0f);
+			}
+			continue;
+		}
+		//Skip the boundary if even its bounding box is further than the current closest point.
+		if (glm::distance(position, glm::clamp(position, polygon.m_min, polygon.m_max)) >= distanceToClosestPointOnBoundary) continue;
+		auto currentDistance = FLT_MAX;
+		glm::vec2 currentClosestPoint;
+		for (unsigned edgeIndex = polygon.m_edgeOffset; edgeIndex < polygon.m_edgeOffset + polygon.m_edgeSize; edgeIndex++)
+		{
+			const auto& edge = m_edges[edgeIndex];
+			const auto lowerBound = glm::distance(position, glm::clamp(position, edge.m_min, edge.m_max));
+			if (lowerBound > currentDistance || lowerBound >= distanceToClosestPointOnBoundary) continue;
+			const auto testPoint = glm::closestPointOnLine(position, edge.m_p1, edge.m_p2);
+			const auto newDistance = glm::distance(testPoint, position);
+			if (currentDistance > newDistance)
+			{
+				currentDistance = newDistance;
+				currentClosestPoint = testPoint;
+			}
+		}
+		if (currentDistance < distanceToClosestPointOnBoundary)
+		{
+			distanceToClosestPointOnBoundary = currentDistance;
+			closestPoint = currentClosestPoint;
+		}
+	}
+	if (boundaryIndex != -1)
+	{
+		if (m_attractorSegments.empty())
+		{
+			closestPoint = m_polygons[boundaryIndex].m_center;
+		}
+		else
+		{
+			auto distanceToAttractor = FLT_MAX;
+			for (const auto& segment : m_attractorSegments)
+			{
+				const auto currentClosestPoint = segment.m_point ? segment.m_p1 : glm::closestPointOnLine(position, segment.m_p1, segment.m_p2);
+				const float currentDistanceToAttractor = glm::distance(currentClosestPoint, position);
+				if (currentDistanceToAttractor < distanceToAttractor)
+				{
+					distanceToAttractor = currentDistanceToAttractor;
+					closestPoint = currentClosestPoint;
+				}
+			}
+		}
+	}
+	return closestPoint - position;
+}
@@ -0,0 +1,1069 @@
+#include "ShootSkeletonSnapshot.hpp"
+#include "Jobs.hpp"
+#include "glm/gtc/packing.hpp"
+using namespace EcoSysLab;
+
+enum class SnapshotColumn
+{
+	NodeStructure = 1,
+	NodeInfo,
+	InternodeGrowth,
+	InternodeTransform,
+	Bud,
+	Organ,
+	FlowStructure,
+	FlowInfo,
+	Pool,
+	ShootData,
+	Count
+};
+
+static constexpr size_t SnapshotColumnCount = static_cast<size_t>(SnapshotColumn::Count) - 1;
+static constexpr uint8_t SnapshotMagic[4] = { 'E', 'S', 'K', 'S' };
+static constexpr uint8_t SnapshotQuantized = 1;
+static constexpr uint8_t ColumnRaw = 0;
+static constexpr uint8_t ColumnCompressed = 1;
+static constexpr uint8_t MatrixZero = 0;
+static constexpr uint8_t MatrixAffine = 1;
+static constexpr uint8_t MatrixRaw = 2;
+
+static void ForEachColumn(const size_t count, const bool parallel, const std::function<void(unsigned)>& func)
+{
+	if (parallel) Jobs::ParallelFor(count, func);
+	else for (unsigned i = 0; i < count; i++) func(i);
+}
+
+#pragma region Codec
+static void WriteVarint(std::vector<uint8_t>& bytes, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		bytes.emplace_back(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	bytes.emplace_back(static_cast<uint8_t>(value));
+}
+
+static bool ReadVarint(const uint8_t* data, const size_t size, size_t& offset, uint64_t& value)
+{
+	value = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (offset >= size) return false;
+		const auto byte = data[offset++];
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if (!(byte & 0x80)) return true;
+	}
+	return false;
+}
+
+static uint64_t ZigZag(const int64_t value)
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+static int64_t UnZigZag(const uint64_t value)
+{
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * A byte oriented LZ77 block in the spirit of LZ4: every sequence is a token with the literal length in the high and the match
+ * length minus 4 in the low nibble, the literals and a 16 bit back reference. A nibble of 15 is continued by a varint.
+ * The last sequence only holds literals.
+ */
+static void CompressBlock(const std::vector<uint8_t>& input, std::vector<uint8_t>& output)
+{
+	constexpr int hashBits = 12;
+	constexpr size_t minMatch = 4;
+	constexpr size_t maxOffset = 65535;
+	std::vector<int64_t> table(size_t(1) << hashBits, -1);
+	const auto hashAt = [&](const size_t position)
+		{
+			uint32_t word;
+			std::memcpy(&word, input.data() + position, sizeof(uint32_t));
+			return (word * 2654435761u) >> (32 - hashBits);
+		};
+	const auto writeLength = [&](const size_t length)
+		{
+			if (length >= 15) WriteVarint(output, length - 15);
+		};
+	const auto size = input.size();
+	size_t anchor = 0;
+	size_t position = 0;
+	while (size >= minMatch && position + minMatch <= size)
+	{
+		const auto hash = hashAt(position);
+		const auto candidate = table[hash];
+		table[hash] = static_cast<int64_t>(position);
+		if (candidate < 0 || position - candidate > maxOffset
+			|| std::memcmp(input.data() + candidate, input.data() + position, minMatch) != 0)
+		{
+			//Skip faster through data that does not repeat, like LZ4 does.
+			position += 1 + ((position - anchor) >> 6);
+			continue;
+		}
+		size_t matchLength = minMatch;
+		while (position + matchLength < size && input[candidate + matchLength] == input[position + matchLength]) matchLength++;
+		const size_t literalLength = position - anchor;
+		const size_t matchCode = matchLength - minMatch;
+		output.emplace_back(static_cast<uint8_t>((glm::min(literalLength, size_t(15)) << 4) | glm::min(matchCode, size_t(15))));
+		writeLength(literalLength);
+		output.insert(output.end(), input.begin() + anchor, input.begin() + position);
+		const auto offset = position - candidate;
+		output.emplace_back(static_cast<uint8_t>(offset & 0xff));
+		output.emplace_back(static_cast<uint8_t>(offset >> 8));
+		writeLength(matchCode);
+		position += matchLength;
+		anchor = position;
+	}
+	const size_t literalLength = size - anchor;
+	output.emplace_back(static_cast<uint8_t>(glm::min(literalLength, size_t(15)) << 4));
+	writeLength(literalLength);
+	output.insert(output.end(), input.begin() + anchor, input.end());
+}
+
+static bool DecompressBlock(const uint8_t* data, const size_t size, const size_t rawSize, std::vector<uint8_t>& output)
+{
+	output.clear();
+	//The size is only trusted as far as the compressed data can plausibly expand.
+	output.reserve(glm::min(rawSize, size * 16));
+	size_t offset = 0;
+	const auto readLength = [&](size_t& length)
+		{
+			if (length != 15) return true;
+			uint64_t extra;
+			if (!ReadVarint(data, size, offset, extra)) return false;
+			length += extra;
+			return true;
+		};
+	while (offset < size)
+	{
+		const auto token = data[offset++];
+		size_t literalLength = token >> 4;
+		if (!readLength(literalLength) || literalLength > size - offset || output.size() + literalLength > rawSize) return false;
+		output.insert(output.end(), data + offset, data + offset + literalLength);
+		offset += literalLength;
+		if (offset == size) break;
+		if (offset + 2 > size) return false;
+		const size_t matchOffset = data[offset] | (static_cast<size_t>(data[offset + 1]) << 8);
+		offset += 2;
+		size_t matchLength = token & 0x0f;
+		if (!readLength(matchLength)) return false;
+		matchLength += 4;
+		if (matchOffset == 0 || matchOffset > output.size() || output.size() + matchLength > rawSize) return false;
+		//The match may overlap the bytes it produces, so it is copied byte by byte.
+		const auto matchStart = output.size() - matchOffset;
+		for (size_t i = 0; i < matchLength; i++) output.emplace_back(output[matchStart + i]);
+	}
+	return output.size() == rawSize;
+}
+#pragma endregion
+
+#pragma region Fields
+static int64_t QuantizeValue(const float value, const float precision)
+{
+	const double steps = static_cast<double>(value) / precision;
+	if (!std::isfinite(steps)) return 0;
+	return std::llround(glm::clamp(steps, -4.0e15, 4.0e15));
+}
+
+static int16_t QuantizeUnit(const float value)
+{
+	if (!std::isfinite(value)) return 0;
+	return static_cast<int16_t>(std::lround(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static uint8_t QuantizeByte(const float value)
+{
+	if (!std::isfinite(value)) return 0;
+	return static_cast<uint8_t>(std::lround(glm::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+struct SnapshotWriter
+{
+	std::vector<uint8_t> m_bytes{};
+	bool m_quantize = false;
+	float m_precision = 0.0001f;
+
+	void Varint(const uint64_t value)
+	{
+		WriteVarint(m_bytes, value);
+	}
+	void Signed(const int64_t value)
+	{
+		WriteVarint(m_bytes, ZigZag(value));
+	}
+	template<typename T>
+	void Raw(const T& value)
+	{
+		const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+		m_bytes.insert(m_bytes.end(), bytes, bytes + sizeof(T));
+	}
+	void Length(const float value)
+	{
+		if (m_quantize) Signed(QuantizeValue(value, m_precision));
+		else Raw(value);
+	}
+	/**
+	 * Write the position relative to the reference.
+	 * @return The position the reader will reconstruct.
+	 */
+	glm::vec3 Position(const glm::vec3& value, const glm::vec3& reference)
+	{
+		if (!m_quantize)
+		{
+			Raw(value);
+			return value;
+		}
+		glm::vec3 reconstructed;
+		for (int i = 0; i < 3; i++)
+		{
+			const auto steps = QuantizeValue(value[i] - reference[i], m_precision);
+			Signed(steps);
+			reconstructed[i] = reference[i] + static_cast<float>(static_cast<double>(steps) * m_precision);
+		}
+		return reconstructed;
+	}
+	void Rotation(const glm::quat& value)
+	{
+		if (!m_quantize)
+		{
+			Raw(value);
+			return;
+		}
+		const auto length = glm::length(value);
+		const auto normalized = length > 0.0f ? value / length : value;
+		for (int i = 0; i < 4; i++) Raw(QuantizeUnit(normalized[i]));
+	}
+	void Direction(const glm::vec3& value)
+	{
+		if (!m_quantize)
+		{
+			Raw(value);
+			return;
+		}
+		for (int i = 0; i < 3; i++) Raw(QuantizeUnit(value[i]));
+	}
+	void Color(const glm::vec4& value)
+	{
+		if (!m_quantize)
+		{
+			Raw(value);
+			return;
+		}
+		for (int i = 0; i < 4; i++) Raw(QuantizeByte(value[i]));
+	}
+	/**
+	 * Affine matrices of the quantized mode keep the upper 3x3 part as half floats and the translation relative to the reference.
+	 */
+	void Matrix(const glm::mat4& value, const glm::vec3& reference)
+	{
+		if (value == glm::mat4(0.0f))
+		{
+			m_bytes.emplace_back(MatrixZero);
+			return;
+		}
+		if (m_quantize && value[0][3] == 0.0f && value[1][3] == 0.0f && value[2][3] == 0.0f && value[3][3] == 1.0f)
+		{
+			m_bytes.emplace_back(MatrixAffine);
+			for (int column = 0; column < 3; column++)
+			{
+				for (int row = 0; row < 3; row++) Raw(static_cast<uint16_t>(glm::packHalf1x16(value[column][row])));
+			}
+			Position(glm::vec3(value[3]), reference);
+			return;
+		}
+		m_bytes.emplace_back(MatrixRaw);
+		Raw(value);
+	}
+};
+
+/**
+ * Reads a column, any read past the end marks the reader invalid and returns a default value.
+ */
+struct SnapshotReader
+{
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	size_t m_offset = 0;
+	bool m_valid = true;
+	bool m_quantize = false;
+	float m_precision = 0.0001f;
+
+	uint64_t Varint()
+	{
+		uint64_t value = 0;
+		if (m_valid && !ReadVarint(m_data, m_size, m_offset, value)) m_valid = false;
+		return m_valid ? value : 0;
+	}
+	int64_t Signed()
+	{
+		return UnZigZag(Varint());
+	}
+	/**
+	 * Read the size of a list, every element takes at least one byte so larger sizes are invalid.
+	 */
+	size_t Count()
+	{
+		const auto value = Varint();
+		if (value > m_size - m_offset)
+		{
+			m_valid = false;
+			return 0;
+		}
+		return static_cast<size_t>(value);
+	}
+	template<typename T>
+	T Raw()
+	{
+		T value{};
+		if (!m_valid || m_size - m_offset < sizeof(T))
+		{
+			m_valid = false;
+			return value;
+		}
+		std::memcpy(&value, m_data + m_offset, sizeof(T));
+		m_offset += sizeof(T);
+		return value;
+	}
+	float Length()
+	{
+		if (m_quantize) return static_cast<float>(static_cast<double>(Signed()) * m_precision);
+		return Raw<float>();
+	}
+	glm::vec3 Position(const glm::vec3& reference)
+	{
+		if (!m_quantize) return Raw<glm::vec3>();
+		glm::vec3 value;
+		for (int i = 0; i < 3; i++) value[i] = reference[i] + static_cast<float>(static_cast<double>(Signed()) * m_precision);
+		return value;
+	}
+	glm::quat Rotation()
+	{
+		if (!m_quantize) return Raw<glm::quat>();
+		glm::quat value;
+		for (int i = 0; i < 4; i++) value[i] = static_cast<float>(Raw<int16_t>()) / 32767.0f;
+		const auto length = glm::length(value);
+		return length > 0.0f ? value / length : value;
+	}
+	glm::vec3 Direction()
+	{
+		if (!m_quantize) return Raw<glm::vec3>();
+		glm::vec3 value;
+		for (int i = 0; i < 3; i++) value[i] = static_cast<float>(Raw<int16_t>()) / 32767.0f;
+		return value;
+	}
+	glm::vec4 Color()
+	{
+		if (!m_quantize) return Raw<glm::vec4>();
+		glm::vec4 value;
+		for (int i = 0; i < 4; i++) value[i] = static_cast<float>(Raw<uint8_t>()) / 255.0f;
+		return value;
+	}
+	glm::mat4 Matrix(const glm::vec3& reference)
+	{
+		const auto type = Raw<uint8_t>();
+		if (type == MatrixZero) return glm::mat4(0.0f);
+		if (type == MatrixRaw) return Raw<glm::mat4>();
+		if (type != MatrixAffine || !m_quantize)
+		{
+			m_valid = false;
+			return glm::mat4(0.0f);
+		}
+		glm::mat4 value(1.0f);
+		for (int column = 0; column < 3; column++)
+		{
+			for (int row = 0; row < 3; row++) value[column][row] = glm::unpackHalf1x16(Raw<uint16_t>());
+		}
+		value[3] = glm::vec4(Position(reference), 1.0f);
+		return value;
+	}
+	/**
+	 * @return Whether the whole column is read without error.
+	 */
+	[[nodiscard]] bool Finish() const
+	{
+		return m_valid && m_offset == m_size;
+	}
+};
+
+/**
+ * Whether the children reachable from the first element lead back to one of their ancestors.
+ */
+template<typename T>
+static bool HasCycle(const std::vector<T>& elements)
+{
+	std::vector<unsigned char> states(elements.size(), 0);
+	std::vector<std::pair<int, size_t>> stack;
+	stack.emplace_back(0, 0);
+	states[0] = 1;
+	while (!stack.empty())
+	{
+		auto& [handle, childIndex] = stack.back();
+		const auto& childHandles = elements[handle].RefChildHandles();
+		if (childIndex == childHandles.size())
+		{
+			states[handle] = 2;
+			stack.pop_back();
+			continue;
+		}
+		const auto childHandle = childHandles[childIndex++];
+		if (states[childHandle] == 1) return true;
+		if (states[childHandle] == 2) continue;
+		states[childHandle] = 1;
+		stack.emplace_back(childHandle, 0);
+	}
+	return false;
+}
+
+/**
+ * The order the per node columns are written in: breadth first from the root, so the parent of a node always comes before it.
+ * Nodes that can not be reached from the root follow in the order of their handles.
+ * @return The amount of nodes reached from the root.
+ */
+static size_t TraversalOrder(const ShootSkeleton& skeleton, std::vector<NodeHandle>& order)
+{
+	const auto& nodes = skeleton.RefRawNodes();
+	order.clear();
+	order.reserve(nodes.size());
+	std::vector<unsigned char> visited(nodes.size(), 0);
+	if (!nodes.empty() && !nodes[0].IsRecycled())
+	{
+		order.emplace_back(0);
+		visited[0] = 1;
+	}
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		for (const auto& childHandle : nodes[order[i]].RefChildHandles())
+		{
+			if (visited[childHandle]) continue;
+			visited[childHandle] = 1;
+			order.emplace_back(childHandle);
+		}
+	}
+	const auto reachedCount = order.size();
+	for (const auto& node : nodes)
+	{
+		if (!node.IsRecycled() && !visited[node.GetHandle()]) order.emplace_back(node.GetHandle());
+	}
+	return reachedCount;
+}
+#pragma endregion
+
+void ShootSkeletonSnapshot::Encode(const ShootSkeleton& skeleton, const bool quantize, const bool compress, const float positionPrecision, const bool parallel)
+{
+	const float precision = glm::max(positionPrecision, 1e-7f);
+	const auto& nodes = skeleton.m_nodes;
+	const auto& flows = skeleton.m_flows;
+	std::vector<NodeHandle> order;
+	const auto reachedCount = TraversalOrder(skeleton, order);
+
+	std::vector<SnapshotWriter> columns(SnapshotColumnCount);
+	for (auto& column : columns)
+	{
+		column.m_quantize = quantize;
+		column.m_precision = precision;
+	}
+	const auto refColumn = [&](const SnapshotColumn id) -> SnapshotWriter&
+		{
+			return columns[static_cast<size_t>(id) - 1];
+		};
+	//The other columns store positions relative to the ones the reader reconstructs, so the node info goes first.
+	std::vector<glm::vec3> positions(nodes.size(), glm::vec3(0.0f));
+	{
+		auto& writer = refColumn(SnapshotColumn::NodeInfo);
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			const auto& node = nodes[order[i]];
+			const auto& info = node.m_info;
+			const auto reference = i < reachedCount && node.m_parentHandle != -1 ? positions[node.m_parentHandle] : glm::vec3(0.0f);
+			positions[order[i]] = writer.Position(info.m_globalPosition, reference);
+			writer.Rotation(info.m_globalRotation);
+			writer.Direction(info.m_globalDirection);
+			writer.Length(info.m_length);
+			writer.Raw(info.m_thickness);
+			writer.Length(info.m_rootDistance);
+			writer.Length(info.m_endDistance);
+			writer.Rotation(info.m_regulatedGlobalRotation);
+			writer.Color(info.m_color);
+		}
+	}
+
+	std::vector<std::vector<uint8_t>> storedColumns(SnapshotColumnCount);
+	std::vector<uint8_t> codecs(SnapshotColumnCount, ColumnRaw);
+	std::vector<size_t> rawSizes(SnapshotColumnCount, 0);
+	ForEachColumn(SnapshotColumnCount, parallel, [&](unsigned columnIndex)
+		{
+			auto& writer = columns[columnIndex];
+			switch (static_cast<SnapshotColumn>(columnIndex + 1))
+			{
+			case SnapshotColumn::NodeStructure:
+				for (const auto& node : nodes)
+				{
+					writer.m_bytes.emplace_back(static_cast<uint8_t>((node.m_recycled ? 1 : 0) | (node.m_endNode ? 2 : 0) | (node.m_apical ? 4 : 0)));
+					if (node.m_recycled) continue;
+					writer.Signed(node.m_flowHandle);
+					writer.Signed(node.m_handle - node.m_parentHandle);
+					writer.Varint(node.m_childHandles.size());
+					for (const auto& childHandle : node.m_childHandles) writer.Signed(childHandle - node.m_handle);
+					writer.Signed(node.m_index - node.m_handle);
+				}
+				break;
+			case SnapshotColumn::InternodeGrowth:
+				for (const auto& nodeHandle : order)
+				{
+					const auto& data = nodes[nodeHandle].m_data;
+					writer.Length(data.m_internodeLength);
+					writer.Signed(data.m_indexOfParentBud);
+					writer.m_bytes.emplace_back(static_cast<uint8_t>((data.m_maxChild ? 1 : 0) | (data.m_lateral ? 2 : 0)));
+					writer.Raw(data.m_startAge);
+					writer.Raw(data.m_finishAge);
+					writer.Raw(data.m_inhibitorSink);
+					writer.Raw(data.m_sagging);
+					writer.Signed(data.m_order);
+					writer.Signed(data.m_level);
+					writer.Raw(data.m_descendentTotalBiomass);
+					writer.Raw(data.m_biomass);
+					writer.Raw(data.m_extraMass);
+					writer.Raw(data.m_temperature);
+					writer.Raw(data.m_lightIntensity);
+					writer.Raw(data.m_lightDirection);
+					writer.Raw(data.m_pipeResistance);
+					writer.Raw(data.m_growthPotential);
+					writer.Raw(data.m_apicalControl);
+					writer.Raw(data.m_desiredGrowthRate);
+					writer.Raw(data.m_growthRate);
+					writer.Raw(data.m_spaceOccupancy);
+				}
+				break;
+			case SnapshotColumn::InternodeTransform:
+				for (const auto& nodeHandle : order)
+				{
+					const auto& data = nodes[nodeHandle].m_data;
+					writer.Rotation(data.m_desiredLocalRotation);
+					writer.Rotation(data.m_desiredGlobalRotation);
+					writer.Position(data.m_desiredGlobalPosition, positions[nodeHandle]);
+				}
+				break;
+			case SnapshotColumn::Bud:
+				for (const auto& nodeHandle : order)
+				{
+					const auto& buds = nodes[nodeHandle].m_data.m_buds;
+					writer.Varint(buds.size());
+					for (const auto& bud : buds)
+					{
+						writer.Raw(bud.m_flushingRate);
+						writer.Raw(bud.m_extinctionRate);
+						writer.m_bytes.emplace_back(static_cast<uint8_t>(static_cast<int>(bud.m_type) | static_cast<int>(bud.m_status) << 4));
+						writer.Rotation(bud.m_localRotation);
+						writer.Raw(bud.m_reproductiveModule.m_maturity);
+						writer.Raw(bud.m_reproductiveModule.m_health);
+						writer.Matrix(bud.m_reproductiveModule.m_transform, positions[nodeHandle]);
+						writer.Raw(bud.m_markerDirection);
+						writer.Varint(bud.m_markerCount);
+						writer.Raw(bud.m_shootFlux);
+					}
+				}
+				break;
+			case SnapshotColumn::Organ:
+				for (const auto& nodeHandle : order)
+				{
+					const auto& data = nodes[nodeHandle].m_data;
+					writer.Varint(data.m_leaves.size());
+					for (const auto& leaf : data.m_leaves) writer.Matrix(leaf, positions[nodeHandle]);
+					writer.Varint(data.m_fruits.size());
+					for (const auto& fruit : data.m_fruits) writer.Matrix(fruit, positions[nodeHandle]);
+				}
+				break;
+			case SnapshotColumn::FlowStructure:
+				for (const auto& flow : flows)
+				{
+					writer.m_bytes.emplace_back(static_cast<uint8_t>((flow.m_recycled ? 1 : 0) | (flow.m_apical ? 2 : 0)));
+					if (flow.m_recycled) continue;
+					writer.Signed(flow.m_handle - flow.m_parentHandle);
+					writer.Varint(flow.m_childHandles.size());
+					for (const auto& childHandle : flow.m_childHandles) writer.Signed(childHandle - flow.m_handle);
+					writer.Varint(flow.m_nodes.size());
+					NodeHandle previousHandle = 0;
+					for (const auto& nodeHandle : flow.m_nodes)
+					{
+						writer.Signed(nodeHandle - previousHandle);
+						previousHandle = nodeHandle;
+					}
+					writer.Signed(flow.m_data.m_order);
+				}
+				break;
+			case SnapshotColumn::FlowInfo:
+				for (const auto& flow : flows)
+				{
+					if (flow.m_recycled) continue;
+					const auto& info = flow.m_info;
+					const auto startReference = flow.m_nodes.empty() ? glm::vec3(0.0f) : positions[flow.m_nodes.front()];
+					const auto start = writer.Position(info.m_globalStartPosition, startReference);
+					writer.Rotation(info.m_globalStartRotation);
+					writer.Raw(info.m_startThickness);
+					writer.Position(info.m_globalEndPosition, start);
+					writer.Rotation(info.m_globalEndRotation);
+					writer.Raw(info.m_endThickness);
+					writer.Length(info.m_flowLength);
+				}
+				break;
+			case SnapshotColumn::Pool:
+			{
+				auto nodePool = skeleton.m_nodePool;
+				writer.Varint(nodePool.size());
+				for (; !nodePool.empty(); nodePool.pop()) writer.Varint(nodePool.front());
+				auto flowPool = skeleton.m_flowPool;
+				writer.Varint(flowPool.size());
+				for (; !flowPool.empty(); flowPool.pop()) writer.Varint(flowPool.front());
+			}
+			break;
+			case SnapshotColumn::ShootData:
+			{
+				const auto& data = skeleton.m_data;
+				writer.Varint(data.m_maxMarkerCount);
+				for (const auto* modules : { &data.m_droppedLeaves, &data.m_droppedFruits })
+				{
+					writer.Varint(modules->size());
+					for (const auto& module : *modules)
+					{
+						writer.Raw(module.m_maturity);
+						writer.Raw(module.m_health);
+						writer.Matrix(module.m_transform, glm::vec3(0.0f));
+					}
+				}
+				writer.Raw(data.m_desiredMin);
+				writer.Raw(data.m_desiredMax);
+				writer.Signed(data.m_maxLevel);
+				writer.m_bytes.emplace_back(static_cast<uint8_t>(data.m_parallelScheduling ? 1 : 0));
+				writer.Raw(skeleton.m_min);
+				writer.Raw(skeleton.m_max);
+			}
+			break;
+			default:
+				break;
+			}
+			auto& stored = storedColumns[columnIndex];
+			rawSizes[columnIndex] = writer.m_bytes.size();
+			if (compress) CompressBlock(writer.m_bytes, stored);
+			if (compress && stored.size() < writer.m_bytes.size()) codecs[columnIndex] = ColumnCompressed;
+			else stored = std::move(writer.m_bytes);
+		}
+	);
+
+	SnapshotWriter header{};
+	header.m_bytes.insert(header.m_bytes.end(), std::begin(SnapshotMagic), std::end(SnapshotMagic));
+	header.Varint(m_schemaVersion);
+	header.m_bytes.emplace_back(quantize ? SnapshotQuantized : 0);
+	header.Raw(precision);
+	header.Varint(nodes.size());
+	header.Varint(flows.size());
+	header.Signed(skeleton.m_maxIndex);
+	header.Signed(skeleton.m_newVersion);
+	header.Signed(skeleton.m_changeVersion);
+	header.Varint(SnapshotColumnCount);
+	size_t totalSize = header.m_bytes.size();
+	for (const auto& stored : storedColumns) totalSize += stored.size() + 32;
+	header.m_bytes.reserve(totalSize);
+	for (size_t columnIndex = 0; columnIndex < SnapshotColumnCount; columnIndex++)
+	{
+		const auto& stored = storedColumns[columnIndex];
+		header.Varint(columnIndex + 1);
+		header.m_bytes.emplace_back(codecs[columnIndex]);
+		header.Varint(rawSizes[columnIndex]);
+		header.Varint(stored.size());
+		header.m_bytes.insert(header.m_bytes.end(), stored.begin(), stored.end());
+	}
+	m_bytes = std::move(header.m_bytes);
+}
+
+bool ShootSkeletonSnapshot::Decode(ShootSkeleton& skeleton, const bool parallel) const
+{
+	if (m_bytes.size() < sizeof(SnapshotMagic) || std::memcmp(m_bytes.data(), SnapshotMagic, sizeof(SnapshotMagic)) != 0)
+	{
+		EVOENGINE_ERROR("ShootSkeletonSnapshot: the data is not a shoot skeleton snapshot!");
+		return false;
+	}
+	SnapshotReader header{ m_bytes.data(), m_bytes.size(), sizeof(SnapshotMagic) };
+	const auto schemaVersion = header.Varint();
+	if (schemaVersion > m_schemaVersion)
+	{
+		EVOENGINE_ERROR("ShootSkeletonSnapshot: schema version " + std::to_string(schemaVersion) + " is newer than the supported version "
+			+ std::to_string(m_schemaVersion) + "!");
+		return false;
+	}
+	const auto flags = header.Raw<uint8_t>();
+	const auto precision = header.Raw<float>();
+	const auto nodeCount = header.Varint();
+	const auto flowCount = header.Varint();
+	const auto maxIndex = static_cast<int>(header.Signed());
+	const auto newVersion = static_cast<int>(header.Signed());
+	const auto changeVersion = static_cast<int>(header.Signed());
+	const auto columnCount = header.Varint();
+	const auto fail = [](const std::string& reason)
+		{
+			EVOENGINE_ERROR("ShootSkeletonSnapshot: " + reason + "!");
+			return false;
+		};
+	if (!header.m_valid || !(precision > 0.0f) || nodeCount == 0 || flowCount == 0
+		|| nodeCount > std::numeric_limits<int>::max() || flowCount > std::numeric_limits<int>::max()) return fail("the header is corrupted");
+
+	//Columns of unknown ids are from a newer schema and skipped.
+	struct ColumnBlock
+	{
+		bool m_present = false;
+		uint8_t m_codec = ColumnRaw;
+		size_t m_rawSize = 0;
+		size_t m_offset = 0;
+		size_t m_storedSize = 0;
+	};
+	std::vector<ColumnBlock> blocks(SnapshotColumnCount);
+	for (uint64_t i = 0; i < columnCount; i++)
+	{
+		const auto id = header.Varint();
+		const auto codec = header.Raw<uint8_t>();
+		const auto rawSize = header.Varint();
+		const auto storedSize = header.Varint();
+		if (!header.m_valid || storedSize > header.m_size - header.m_offset || rawSize > std::numeric_limits<uint32_t>::max()) return fail("the column table is corrupted");
+		if (id >= 1 && id <= SnapshotColumnCount)
+		{
+			auto& block = blocks[id - 1];
+			if (block.m_present || (codec != ColumnRaw && codec != ColumnCompressed)
+				|| (codec == ColumnRaw && rawSize != storedSize)) return fail("column " + std::to_string(id) + " is corrupted");
+			block.m_present = true;
+			block.m_codec = codec;
+			block.m_rawSize = static_cast<size_t>(rawSize);
+			block.m_offset = header.m_offset;
+			block.m_storedSize = static_cast<size_t>(storedSize);
+		}
+		header.m_offset += static_cast<size_t>(storedSize);
+	}
+	if (!blocks[static_cast<size_t>(SnapshotColumn::NodeStructure) - 1].m_present
+		|| !blocks[static_cast<size_t>(SnapshotColumn::FlowStructure) - 1].m_present) return fail("the structure columns are missing");
+
+	std::vector<std::vector<uint8_t>> buffers(SnapshotColumnCount);
+	std::vector<unsigned char> decompressed(SnapshotColumnCount, 1);
+	ForEachColumn(SnapshotColumnCount, parallel, [&](unsigned columnIndex)
+		{
+			const auto& block = blocks[columnIndex];
+			if (!block.m_present || block.m_codec != ColumnCompressed) return;
+			decompressed[columnIndex] = DecompressBlock(m_bytes.data() + block.m_offset, block.m_storedSize, block.m_rawSize, buffers[columnIndex]) ? 1 : 0;
+		}
+	);
+	for (size_t columnIndex = 0; columnIndex < SnapshotColumnCount; columnIndex++)
+	{
+		if (!decompressed[columnIndex]) return fail("column " + std::to_string(columnIndex + 1) + " can not be decompressed");
+	}
+	const auto structureSize = [&](const SnapshotColumn id)
+		{
+			const auto columnIndex = static_cast<size_t>(id) - 1;
+			return blocks[columnIndex].m_codec == ColumnCompressed ? buffers[columnIndex].size() : blocks[columnIndex].m_storedSize;
+		};
+	//Every node and flow takes at least one byte of its structure column.
+	if (nodeCount > structureSize(SnapshotColumn::NodeStructure) || flowCount > structureSize(SnapshotColumn::FlowStructure)) return fail("the header is corrupted");
+	const bool quantized = flags & SnapshotQuantized;
+	const auto getReader = [&](const SnapshotColumn id)
+		{
+			const auto columnIndex = static_cast<size_t>(id) - 1;
+			const auto& block = blocks[columnIndex];
+			SnapshotReader reader{};
+			if (block.m_codec == ColumnCompressed)
+			{
+				reader.m_data = buffers[columnIndex].data();
+				reader.m_size = buffers[columnIndex].size();
+			}
+			else if (block.m_present)
+			{
+				reader.m_data = m_bytes.data() + block.m_offset;
+				reader.m_size = block.m_storedSize;
+			}
+			reader.m_quantize = quantized;
+			reader.m_precision = precision;
+			return reader;
+		};
+	const auto isPresent = [&](const SnapshotColumn id)
+		{
+			return blocks[static_cast<size_t>(id) - 1].m_present;
+		};
+
+	ShootSkeleton result{};
+	result.m_nodes.clear();
+	result.m_flows.clear();
+	result.m_nodes.reserve(nodeCount);
+	result.m_flows.reserve(flowCount);
+	for (NodeHandle handle = 0; handle < static_cast<NodeHandle>(nodeCount); handle++) result.m_nodes.emplace_back(handle);
+	for (FlowHandle handle = 0; handle < static_cast<FlowHandle>(flowCount); handle++) result.m_flows.emplace_back(handle);
+	const auto validNode = [&](const int64_t handle) { return handle >= 0 && handle < static_cast<int64_t>(nodeCount); };
+	const auto validFlow = [&](const int64_t handle) { return handle >= 0 && handle < static_cast<int64_t>(flowCount); };
+
+#pragma region Structure
+	{
+		auto reader = getReader(SnapshotColumn::NodeStructure);
+		for (auto& node : result.m_nodes)
+		{
+			const auto nodeFlags = reader.Raw<uint8_t>();
+			node.m_recycled = nodeFlags & 1;
+			node.m_endNode = nodeFlags & 2;
+			node.m_apical = nodeFlags & 4;
+			if (node.m_recycled) continue;
+			const auto flowHandle = reader.Signed();
+			const auto parentHandle = node.m_handle - reader.Signed();
+			if (!validFlow(flowHandle) || (parentHandle != -1 && !validNode(parentHandle))) return fail("the node structure is corrupted");
+			node.m_flowHandle = static_cast<FlowHandle>(flowHandle);
+			node.m_parentHandle = static_cast<NodeHandle>(parentHandle);
+			node.m_childHandles.resize(reader.Count());
+			for (auto& childHandle : node.m_childHandles)
+			{
+				const auto handle = node.m_handle + reader.Signed();
+				if (!validNode(handle)) return fail("the node structure is corrupted");
+				childHandle = static_cast<NodeHandle>(handle);
+			}
+			node.m_index = static_cast<int>(node.m_handle + reader.Signed());
+		}
+		if (!reader.Finish()) return fail("the node structure is corrupted");
+	}
+	{
+		auto reader = getReader(SnapshotColumn::FlowStructure);
+		for (auto& flow : result.m_flows)
+		{
+			const auto flowFlags = reader.Raw<uint8_t>();
+			flow.m_recycled = flowFlags & 1;
+			flow.m_apical = flowFlags & 2;
+			if (flow.m_recycled) continue;
+			const auto parentHandle = flow.m_handle - reader.Signed();
+			if (parentHandle != -1 && !validFlow(parentHandle)) return fail("the flow structure is corrupted");
+			flow.m_parentHandle = static_cast<FlowHandle>(parentHandle);
+			flow.m_childHandles.resize(reader.Count());
+			for (auto& childHandle : flow.m_childHandles)
+			{
+				const auto handle = flow.m_handle + reader.Signed();
+				if (!validFlow(handle)) return fail("the flow structure is corrupted");
+				childHandle = static_cast<FlowHandle>(handle);
+			}
+			flow.m_nodes.resize(reader.Count());
+			int64_t nodeHandle = 0;
+			for (auto& handle : flow.m_nodes)
+			{
+				nodeHandle += reader.Signed();
+				if (!validNode(nodeHandle)) return fail("the flow structure is corrupted");
+				handle = static_cast<NodeHandle>(nodeHandle);
+			}
+			flow.m_data.m_order = static_cast<int>(reader.Signed());
+		}
+		if (!reader.Finish()) return fail("the flow structure is corrupted");
+	}
+	//Recycling a flow leaves the handle of its first node in the parent node, so the children are not checked against their
+	//parents. Only a cycle is rejected, as sorting the lists would never end.
+	if (result.m_nodes[0].m_recycled || result.m_flows[0].m_recycled
+		|| HasCycle(result.m_nodes) || HasCycle(result.m_flows)) return fail("the structure is not a tree");
+#pragma endregion
+
+	std::vector<NodeHandle> order;
+	const auto reachedCount = TraversalOrder(result, order);
+	if (isPresent(SnapshotColumn::NodeInfo))
+	{
+		auto reader = getReader(SnapshotColumn::NodeInfo);
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			auto& node = result.m_nodes[order[i]];
+			auto& info = node.m_info;
+			const auto reference = i < reachedCount && node.m_parentHandle != -1 ? result.m_nodes[node.m_parentHandle].m_info.m_globalPosition : glm::vec3(0.0f);
+			info.m_globalPosition = reader.Position(reference);
+			info.m_globalRotation = reader.Rotation();
+			info.m_globalDirection = reader.Direction();
+			info.m_length = reader.Length();
+			info.m_thickness = reader.Raw<float>();
+			info.m_rootDistance = reader.Length();
+			info.m_endDistance = reader.Length();
+			info.m_regulatedGlobalRotation = reader.Rotation();
+			info.m_color = reader.Color();
+		}
+		if (!reader.Finish()) return fail("the node info is corrupted");
+	}
+
+	//The remaining columns write disjoint fields and may be decoded in parallel.
+	constexpr SnapshotColumn parallelColumns[] = {
+		SnapshotColumn::InternodeGrowth, SnapshotColumn::InternodeTransform, SnapshotColumn::Bud, SnapshotColumn::Organ,
+		SnapshotColumn::FlowInfo, SnapshotColumn::Pool, SnapshotColumn::ShootData
+	};
+	constexpr size_t parallelColumnCount = std::size(parallelColumns);
+	std::vector<unsigned char> decoded(parallelColumnCount, 1);
+	ForEachColumn(parallelColumnCount, parallel, [&](unsigned i)
+		{
+			const auto id = parallelColumns[i];
+			if (!isPresent(id)) return;
+			auto reader = getReader(id);
+			switch (id)
+			{
+			case SnapshotColumn::InternodeGrowth:
+				for (const auto& nodeHandle : order)
+				{
+					auto& data = result.m_nodes[nodeHandle].m_data;
+					data.m_internodeLength = reader.Length();
+					data.m_indexOfParentBud = static_cast<int>(reader.Signed());
+					const auto dataFlags = reader.Raw<uint8_t>();
+					data.m_maxChild = dataFlags & 1;
+					data.m_lateral = dataFlags & 2;
+					data.m_startAge = reader.Raw<float>();
+					data.m_finishAge = reader.Raw<float>();
+					data.m_inhibitorSink = reader.Raw<float>();
+					data.m_sagging = reader.Raw<float>();
+					data.m_order = static_cast<int>(reader.Signed());
+					data.m_level = static_cast<int>(reader.Signed());
+					data.m_descendentTotalBiomass = reader.Raw<float>();
+					data.m_biomass = reader.Raw<float>();
+					data.m_extraMass = reader.Raw<float>();
+					data.m_temperature = reader.Raw<float>();
+					data.m_lightIntensity = reader.Raw<float>();
+					data.m_lightDirection = reader.Raw<glm::vec3>();
+					data.m_pipeResistance = reader.Raw<float>();
+					data.m_growthPotential = reader.Raw<float>();
+					data.m_apicalControl = reader.Raw<float>();
+					data.m_desiredGrowthRate = reader.Raw<float>();
+					data.m_growthRate = reader.Raw<float>();
+					data.m_spaceOccupancy = reader.Raw<float>();
+				}
+				break;
+			case SnapshotColumn::InternodeTransform:
+				for (const auto& nodeHandle : order)
+				{
+					auto& node = result.m_nodes[nodeHandle];
+					node.m_data.m_desiredLocalRotation = reader.Rotation();
+					node.m_data.m_desiredGlobalRotation = reader.Rotation();
+					node.m_data.m_desiredGlobalPosition = reader.Position(node.m_info.m_globalPosition);
+				}
+				break;
+			case SnapshotColumn::Bud:
+				for (const auto& nodeHandle : order)
+				{
+					auto& node = result.m_nodes[nodeHandle];
+					node.m_data.m_buds.resize(reader.Count());
+					for (auto& bud : node.m_data.m_buds)
+					{
+						bud.m_flushingRate = reader.Raw<float>();
+						bud.m_extinctionRate = reader.Raw<float>();
+						const auto budState = reader.Raw<uint8_t>();
+						if ((budState & 0x0f) > static_cast<int>(BudType::Fruit) || (budState >> 4) > static_cast<int>(BudStatus::Removed)) reader.m_valid = false;
+						bud.m_type = static_cast<BudType>(budState & 0x0f);
+						bud.m_status = static_cast<BudStatus>(budState >> 4);
+						bud.m_localRotation = reader.Rotation();
+						bud.m_reproductiveModule.m_maturity = reader.Raw<float>();
+						bud.m_reproductiveModule.m_health = reader.Raw<float>();
+						bud.m_reproductiveModule.m_transform = reader.Matrix(node.m_info.m_globalPosition);
+						bud.m_markerDirection = reader.Raw<glm::vec3>();
+						bud.m_markerCount = static_cast<size_t>(reader.Varint());
+						bud.m_shootFlux = reader.Raw<float>();
+					}
+				}
+				break;
+			case SnapshotColumn::Organ:
+				for (const auto& nodeHandle : order)
+				{
+					auto& node = result.m_nodes[nodeHandle];
+					node.m_data.m_leaves.resize(reader.Count());
+					for (auto& leaf : node.m_data.m_leaves) leaf = reader.Matrix(node.m_info.m_globalPosition);
+					node.m_data.m_fruits.resize(reader.Count());
+					for (auto& fruit : node.m_data.m_fruits) fruit = reader.Matrix(node.m_info.m_globalPosition);
+				}
+				break;
+			case SnapshotColumn::FlowInfo:
+				for (auto& flow : result.m_flows)
+				{
+					if (flow.m_recycled) continue;
+					auto& info = flow.m_info;
+					const auto startReference = flow.m_nodes.empty() ? glm::vec3(0.0f) : result.m_nodes[flow.m_nodes.front()].m_info.m_globalPosition;
+					info.m_globalStartPosition = reader.Position(startReference);
+					info.m_globalStartRotation = reader.Rotation();
+					info.m_startThickness = reader.Raw<float>();
+					info.m_globalEndPosition = reader.Position(info.m_globalStartPosition);
+					info.m_globalEndRotation = reader.Rotation();
+					info.m_endThickness = reader.Raw<float>();
+					info.m_flowLength = reader.Length();
+				}
+				break;
+			case SnapshotColumn::Pool:
+			{
+				for (auto nodePoolSize = reader.Count(); nodePoolSize > 0; nodePoolSize--)
+				{
+					const auto handle = reader.Varint();
+					if (handle >= nodeCount || !result.m_nodes[handle].m_recycled) reader.m_valid = false;
+					else result.m_nodePool.emplace(static_cast<NodeHandle>(handle));
+				}
+				for (auto flowPoolSize = reader.Count(); flowPoolSize > 0; flowPoolSize--)
+				{
+					const auto handle = reader.Varint();
+					if (handle >= flowCount || !result.m_flows[handle].m_recycled) reader.m_valid = false;
+					else result.m_flowPool.emplace(static_cast<FlowHandle>(handle));
+				}
+			}
+			break;
+			case SnapshotColumn::ShootData:
+			{
+				auto& data = result.m_data;
+				data.m_maxMarkerCount = static_cast<size_t>(reader.Varint());
+				for (auto* modules : { &data.m_droppedLeaves, &data.m_droppedFruits })
+				{
+					modules->resize(reader.Count());
+					for (auto& module : *modules)
+					{
+						module.m_maturity = reader.Raw<float>();
+						module.m_health = reader.Raw<float>();
+						module.m_transform = reader.Matrix(glm::vec3(0.0f));
+					}
+				}
+				data.m_desiredMin = reader.Raw<glm::vec3>();
+				data.m_desiredMax = reader.Raw<glm::vec3>();
+				data.m_maxLevel = static_cast<int>(reader.Signed());
+				data.m_parallelScheduling = reader.Raw<uint8_t>() != 0;
+				result.m_min = reader.Raw<glm::vec3>();
+				result.m_max = reader.Raw<glm::vec3>();
+			}
+			break;
+			default:
+				break;
+			}
+			decoded[i] = reader.Finish() ? 1 : 0;
+		}
+	);
+	for (size_t i = 0; i < parallelColumnCount; i++)
+	{
+		if (!decoded[i]) return fail("column " + std::to_string(static_cast<int>(parallelColumns[i])) + " is corrupted");
+	}
+
+	result.m_maxIndex = maxIndex;
+	result.m_newVersion = newVersion;
+	result.m_version = newVersion - 1;
+	result.SortLists();
+	result.m_changeVersion = changeVersion;
+	result.m_fullChangeVersion = changeVersion;
+	for (auto& node : result.m_nodes) node.m_changeVersion = node.m_inputChangeVersion = changeVersion;
+	skeleton = std::move(result);
+	return true;
+}
+
+const std::vector<uint8_t>& ShootSkeletonSnapshot::RefBytes() const
+{
+	return m_bytes;
+}
+
+void ShootSkeletonSnapshot::SetBytes(const uint8_t* data, const size_t size)
+{
+	m_bytes.assign(data, data + size);
+}
+
+size_t ShootSkeletonSnapshot::GetSize() const
+{
+	return m_bytes.size();
+}
+
+bool ShootSkeletonSnapshot::Empty() const
+{
+	return m_bytes.empty();
+}
+
+void ShootSkeletonSnapshot::Clear()
+{
+	m_bytes.clear();
+	m_bytes.shrink_to_fit();
+}
@@ -3,6 +3,7 @@
 //
 #include "rapidcsv.h"
 #include "SkyIlluminance.hpp"
+#include "Times.hpp"
 #ifdef BUILD_WITH_RAYTRACER
 #include "RayTracerLayer.hpp"
 #endif
@@ -15,32 +16,108 @@ SkyIlluminanceSnapshotLerp(const SkyIlluminanceSnapshot &l,
   if (a > 1.0f)
     return r;
   SkyIlluminanceSnapshot snapshot;
-  snapshot.m_ghi = l.m_ghi * a + r.m_ghi * (1.0f - a);
-  snapshot.m_azimuth = l.m_azimuth * a + r.m_azimuth * (1.0f - a);
-  snapshot.m_zenith = l.m_zenith * a + r.m_zenith * (1.0f - a);
+  snapshot.m_ghi = l.m_ghi * (1.0f - a) + r.m_ghi * a;
+  snapshot.m_azimuth = l.m_azimuth * (1.0f - a) + r.m_azimuth * a;
+  snapshot.m_zenith = l.m_zenith * (1.0f - a) + r.m_zenith * a;
   return snapshot;
 }
 
-SkyIlluminanceSnapshot SkyIlluminance::Get(float time) {
+SkyIlluminanceSnapshot SkyIlluminance::Get(const float time) const {
+  size_t cursor = 0;
+  return Get(time, cursor);
+}
+SkyIlluminanceSnapshot SkyIlluminance::Get(const float time, size_t &cursor) const {
   if (m_snapshots.empty()) {
     return {};
   }
-  if (time <= m_snapshots.begin()->first)
-    return m_snapshots.begin()->second;
-  SkyIlluminanceSnapshot lastShot;
-  lastShot = m_snapshots.begin()->second;
-  float lastTime = m_snapshots.begin()->first;
-  for (const auto &pair : m_snapshots) {
-    if (time < pair.first) {
-      if (pair.first - lastTime == 0)
-        return lastShot;
-      return SkyIlluminanceSnapshotLerp(
-          lastShot, pair.second, (time - lastTime) / (pair.first - lastTime));
+  if (time <= m_times.front())
+    return m_snapshots.front();
+  if (time >= m_times.back())
+    return m_snapshots.back();
+  // The time is inside the series here, so the upper bound is never the first or past the last snapshot.
+  const auto isUpperBound = [&](const size_t index) {
+    return index > 0 && index < m_times.size() && m_times[index - 1] <= time && m_times[index] > time;
+  };
+  if (!isUpperBound(cursor)) {
+    if (isUpperBound(cursor + 1))
+      cursor++;
+    else
+      cursor = std::upper_bound(m_times.begin(), m_times.end(), time) - m_times.begin();
+  }
+  const auto lastTime = m_times[cursor - 1];
+  const auto nextTime = m_times[cursor];
+  return SkyIlluminanceSnapshotLerp(m_snapshots[cursor - 1], m_snapshots[cursor],
+                                    (time - lastTime) / (nextTime - lastTime));
+}
+void SkyIlluminance::SetSnapshots(const std::map<float, SkyIlluminanceSnapshot> &snapshots) {
+  m_times.clear();
+  m_snapshots.clear();
+  m_times.reserve(snapshots.size());
+  m_snapshots.reserve(snapshots.size());
+  for (const auto &[time, snapshot] : snapshots) {
+    m_times.emplace_back(time);
+    m_snapshots.emplace_back(snapshot);
+  }
+}
+void SkyIlluminance::BenchmarkGet(const int queryCount) const {
+  if (m_snapshots.empty() || queryCount <= 0) {
+    EVOENGINE_ERROR("No snapshots to look up!");
+    return;
+  }
+  // The layout before the flat arrays, scanned the way Get used to.
+  std::map<float, SkyIlluminanceSnapshot> snapshots;
+  for (size_t i = 0; i < m_snapshots.size(); i++)
+    snapshots[m_times[i]] = m_snapshots[i];
+  const auto linearGet = [&](const float time) {
+    if (time <= snapshots.begin()->first)
+      return snapshots.begin()->second;
+    SkyIlluminanceSnapshot lastShot = snapshots.begin()->second;
+    float lastTime = snapshots.begin()->first;
+    for (const auto &pair : snapshots) {
+      if (time < pair.first) {
+        if (pair.first - lastTime == 0)
+          return lastShot;
+        return SkyIlluminanceSnapshotLerp(
+            lastShot, pair.second, (time - lastTime) / (pair.first - lastTime));
+      }
+      lastShot = pair.second;
+      lastTime = pair.first;
+    }
+    return std::prev(snapshots.end())->second;
+  };
+  const float startTime = m_times.front();
+  const float endTime = m_times.back();
+  const auto queryTime = [&](const int i) {
+    return startTime + (endTime - startTime) * static_cast<float>(i) / static_cast<float>(queryCount);
+  };
+  std::vector<SkyIlluminanceSnapshot> linear(queryCount), searched(queryCount), cursored(queryCount);
+  double timer = Times::Now();
+  for (int i = 0; i < queryCount; i++)
+    linear[i] = linearGet(queryTime(i));
+  const double linearTime = Times::Now() - timer;
+  timer = Times::Now();
+  for (int i = 0; i < queryCount; i++)
+    searched[i] = Get(queryTime(i));
+  const double searchTime = Times::Now() - timer;
+  size_t cursor = 0;
+  timer = Times::Now();
+  for (int i = 0; i < queryCount; i++)
+    cursored[i] = Get(queryTime(i), cursor);
+  const double cursorTime = Times::Now() - timer;
+  int mismatches = 0;
+  for (int i = 0; i < queryCount; i++) {
+    for (const auto *actual : {&searched[i], &cursored[i]}) {
+      if (actual->m_ghi != linear[i].m_ghi || actual->m_azimuth != linear[i].m_azimuth ||
+          actual->m_zenith != linear[i].m_zenith) {
+        mismatches++;
+        break;
+      }
     }
-    lastShot = pair.second;
-    lastTime = pair.first;
   }
-  return std::prev(m_snapshots.end())->second;
+  EVOENGINE_LOG(std::to_string(queryCount) + " lookups over " + std::to_string(m_snapshots.size()) +
+                " snapshots: map scan " + std::to_string(linearTime * 1000.0) + "ms, binary search " +
+                std::to_string(searchTime * 1000.0) + "ms, cursor " + std::to_string(cursorTime * 1000.0) + "ms, " +
+                std::to_string(mismatches) + " mismatches");
 }
 void SkyIlluminance::ImportCSV(const std::filesystem::path& path) {
   rapidcsv::Document doc(path.string());
@@ -49,7 +126,7 @@ void SkyIlluminance::ImportCSV(const std::filesystem::path& path) {
   std::vector<float> azimuthSeries = doc.GetColumn<float>("Azimuth");
   std::vector<float> zenithSeries = doc.GetColumn<float>("Zenith");
   assert(timeSeries.size() == ghiSeries.size() && azimuthSeries.size() == zenithSeries.size() && timeSeries.size() == azimuthSeries.size());
-  m_snapshots.clear();
+  std::map<float, SkyIlluminanceSnapshot> snapshots;
   m_maxTime = 0;
   m_minTime = 999999;
   for(int i = 0; i < timeSeries.size(); i++) {
@@ -58,7 +135,7 @@ void SkyIlluminance::ImportCSV(const std::filesystem::path& path) {
     snapshot.m_azimuth = azimuthSeries[i];
     snapshot.m_zenith = zenithSeries[i];
     auto time = timeSeries[i];
-    m_snapshots[time] = snapshot;
+    snapshots[time] = snapshot;
     if (m_maxTime < time) {
       m_maxTime = time;
     }
@@ -66,7 +143,7 @@ void SkyIlluminance::ImportCSV(const std::filesystem::path& path) {
       m_minTime = time;
     }
   }
-
+  SetSnapshots(snapshots);
 }
 void SkyIlluminance::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
   FileUtils::OpenFile("Import CSV", "CSV", {".csv"}, [&](const std::filesystem::path &path){
@@ -89,6 +166,11 @@ void SkyIlluminance::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
   ImGui::Text("Ghi: %.3f", snapshot.m_ghi);
   ImGui::Text("Azimuth: %.3f", snapshot.m_azimuth);
   ImGui::Text("Zenith: %.3f", snapshot.m_zenith);
+  static int benchmarkQueryCount = 100000;
+  ImGui::DragInt("Benchmark queries", &benchmarkQueryCount, 100, 1, 10000000);
+  if (ImGui::Button("Benchmark lookups")) {
+    BenchmarkGet(benchmarkQueryCount);
+  }
 
 }
 void SkyIlluminance::Serialize(YAML::Emitter &out) {
@@ -96,12 +178,12 @@ void SkyIlluminance::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_maxTime" << YAML::Value << m_maxTime;
   if(!m_snapshots.empty()) {
     out << YAML::Key << "m_snapshots" << YAML::Value << YAML::BeginSeq;
-    for (const auto &pair : m_snapshots) {
+    for (size_t i = 0; i < m_snapshots.size(); i++) {
       out << YAML::BeginMap;
-      out << YAML::Key << "time" << YAML::Value << pair.first;
-      out << YAML::Key << "m_ghi" << YAML::Value << pair.second.m_ghi;
-      out << YAML::Key << "m_azimuth" << YAML::Value << pair.second.m_azimuth;
-      out << YAML::Key << "m_zenith" << YAML::Value << pair.second.m_zenith;
+      out << YAML::Key << "time" << YAML::Value << m_times[i];
+      out << YAML::Key << "m_ghi" << YAML::Value << m_snapshots[i].m_ghi;
+      out << YAML::Key << "m_azimuth" << YAML::Value << m_snapshots[i].m_azimuth;
+      out << YAML::Key << "m_zenith" << YAML::Value << m_snapshots[i].m_zenith;
       out << YAML::EndMap;
     }
     out << YAML::EndSeq;
@@ -111,14 +193,15 @@ void SkyIlluminance::Deserialize(const YAML::Node &in) {
   if(in["m_minTime"]) m_minTime = in["m_minTime"].as<float>();
   if(in["m_maxTime"]) m_maxTime = in["m_maxTime"].as<float>();
   if(in["m_snapshots"]) {
-    m_snapshots.clear();
+    std::map<float, SkyIlluminanceSnapshot> snapshots;
     for(const auto& data : in["m_snapshots"]){
       SkyIlluminanceSnapshot snapshot;
       snapshot.m_ghi = data["m_ghi"].as<float>();
       snapshot.m_azimuth = data["m_azimuth"].as<float>();
       snapshot.m_zenith = data["m_zenith"].as<float>();
-      m_snapshots[data["time"].as<float>()] = snapshot;
+      snapshots[data["time"].as<float>()] = snapshot;
     }
+    SetSnapshots(snapshots);
   }
 }
 
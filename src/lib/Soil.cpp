@@ -331,27 +331,18 @@ void Soil::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 		static float waterFactor = 20.f;
 		static float nutrientFactor = 1.f;
 		static bool groundSurface = false;
+		static int textureLevel = 0;
+		static bool liveCutOut = false;
 		ImGui::DragFloat("Cutout X Depth", &xDepth, 0.01f, 0.0f, 1.0f, "%.2f");
 		ImGui::DragFloat("Cutout Z Depth", &zDepth, 0.01f, 0.0f, 1.0f, "%.2f");
 		ImGui::DragFloat("Water factor", &waterFactor, 0.0001f, 0.0f, 1.0f, "%.4f");
 		ImGui::DragFloat("Nutrient factor", &nutrientFactor, 0.0001f, 0.0f, 1.0f, "%.4f");
 		ImGui::Checkbox("Ground surface", &groundSurface);
-		if (ImGui::Button("Generate Cutout"))
+		ImGui::SliderInt("Cutout texture level", &textureLevel, 0, 3);
+		ImGui::Checkbox("Live cutout", &liveCutOut);
+		if (ImGui::Button("Generate Cutout") || (liveCutOut && Application::GetActiveScene()->IsEntityValid(m_cutOutEntity)))
 		{
-			auto scene = Application::GetActiveScene();
-			auto owner = GetOwner();
-			for (const auto& child : scene->GetChildren(owner))
-			{
-				if (scene->GetEntityName(child) == "CutOut")
-				{
-					scene->DeleteEntity(child);
-					break;
-				}
-			}
-
-			auto cutOutEntity = GenerateCutOut(xDepth, zDepth, waterFactor, nutrientFactor, groundSurface);
-
-			scene->SetParent(cutOutEntity, owner);
+			UpdateCutOut(xDepth, zDepth, waterFactor, nutrientFactor, groundSurface, textureLevel);
 		}
 		if (ImGui::Button("Generate Cube"))
 		{
@@ -366,7 +357,7 @@ void Soil::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 				}
 			}
 
-			auto cutOutEntity = GenerateFullBox(waterFactor, nutrientFactor, groundSurface);
+			auto cutOutEntity = GenerateFullBox(waterFactor, nutrientFactor, groundSurface, textureLevel);
 
 			scene->SetParent(cutOutEntity, owner);
 		}
@@ -587,7 +578,7 @@ void Soil::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 		
 	}
 }
-Entity Soil::GenerateSurfaceQuadX(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor)
+Entity Soil::GenerateSurfaceQuadX(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor, int textureLevel)
 {
 	auto scene = Application::GetActiveScene();
 	auto quadEntity = scene->CreateEntity("Slice");
@@ -601,7 +592,7 @@ Entity Soil::GenerateSurfaceQuadX(bool backFacing, float depth, const glm::vec2&
 	std::vector<float> metallicData;
 	std::vector<float> roughnessData;
 	glm::ivec2 textureResolution;
-	m_soilModel.GetSoilTextureSlideX(backFacing, depth, minXY, maxXY, albedoData, normalData, roughnessData, metallicData, textureResolution, waterFactor, nutrientFactor);
+	m_soilModel.GetSoilTextureSlideX(backFacing, depth, minXY, maxXY, albedoData, normalData, roughnessData, metallicData, textureResolution, waterFactor, nutrientFactor, 1.0f, textureLevel);
 	albedoTex->SetRgbaChannelData(albedoData, textureResolution);
 	normalTex->SetRgbChannelData(normalData, textureResolution);
 	metallicTex->SetRedChannelData(metallicData, textureResolution);
@@ -631,7 +622,7 @@ Entity Soil::GenerateSurfaceQuadX(bool backFacing, float depth, const glm::vec2&
 	return quadEntity;
 }
 
-Entity Soil::GenerateSurfaceQuadZ(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor)
+Entity Soil::GenerateSurfaceQuadZ(bool backFacing, float depth, const glm::vec2& minXY, const glm::vec2 maxXY, float waterFactor, float nutrientFactor, int textureLevel)
 {
 	auto scene = Application::GetActiveScene();
 	auto quadEntity = scene->CreateEntity("Slice");
@@ -647,7 +638,7 @@ Entity Soil::GenerateSurfaceQuadZ(bool backFacing, float depth, const glm::vec2&
 	std::vector<float> metallicData;
 	std::vector<float> roughnessData;
 	glm::ivec2 textureResolution;
-	m_soilModel.GetSoilTextureSlideZ(backFacing, depth, minXY, maxXY, albedoData, normalData, roughnessData, metallicData, textureResolution, waterFactor, nutrientFactor);
+	m_soilModel.GetSoilTextureSlideZ(backFacing, depth, minXY, maxXY, albedoData, normalData, roughnessData, metallicData, textureResolution, waterFactor, nutrientFactor, 1.0f, textureLevel);
 	albedoTex->SetRgbaChannelData(albedoData, textureResolution);
 	normalTex->SetRgbChannelData(normalData, textureResolution);
 	metallicTex->SetRedChannelData(metallicData, textureResolution);
@@ -679,96 +670,180 @@ Entity Soil::GenerateSurfaceQuadZ(bool backFacing, float depth, const glm::vec2&
 	return quadEntity;
 }
 
-Entity Soil::GenerateCutOut(float xDepth, float zDepth, float waterFactor, float nutrientFactor, bool groundSurface)
+std::vector<Soil::CutOutQuad> Soil::GetCutOutQuads(float xDepth, float zDepth)
 {
-	auto scene = Application::GetActiveScene();
-	auto combinedEntity = scene->CreateEntity("CutOut");
-
+	std::vector<CutOutQuad> quads;
+	CutOutQuad quad;
 	if (zDepth <= 0.99f) {
-		auto quad1 = GenerateSurfaceQuadX(false, 0, { 0, 0 }, { 1.0 - zDepth , 1 }, waterFactor, nutrientFactor);
-		scene->SetParent(quad1, combinedEntity);
+		quad.m_xAxis = true;
+		quad.m_backFacing = false;
+		quad.m_depth = 0;
+		quad.m_min = { 0, 0 };
+		quad.m_max = { 1.0f - zDepth, 1 };
+		quads.emplace_back(quad);
 	}
 	if (zDepth >= 0.01f && xDepth <= 0.99f) {
-		auto quad2 = GenerateSurfaceQuadX(true, xDepth, { 1.0 - zDepth, 0 }, { 1 , 1 }, waterFactor, nutrientFactor);
-		scene->SetParent(quad2, combinedEntity);
+		quad.m_xAxis = true;
+		quad.m_backFacing = true;
+		quad.m_depth = xDepth;
+		quad.m_min = { 1.0f - zDepth, 0 };
+		quad.m_max = { 1, 1 };
+		quads.emplace_back(quad);
 	}
 	if (xDepth >= 0.01f) {
-		auto quad3 = GenerateSurfaceQuadZ(false, 1.0 - zDepth, { 0, 0 }, { xDepth , 1 }, waterFactor, nutrientFactor);
-		scene->SetParent(quad3, combinedEntity);
+		quad.m_xAxis = false;
+		quad.m_backFacing = false;
+		quad.m_depth = 1.0f - zDepth;
+		quad.m_min = { 0, 0 };
+		quad.m_max = { xDepth, 1 };
+		quads.emplace_back(quad);
 	}
 	if (xDepth <= 0.99f) {
-		auto quad4 = GenerateSurfaceQuadZ(true, 1.0, { xDepth, 0 }, { 1 , 1 }, waterFactor, nutrientFactor);
-		scene->SetParent(quad4, combinedEntity);
+		quad.m_xAxis = false;
+		quad.m_backFacing = true;
+		quad.m_depth = 1.0f;
+		quad.m_min = { xDepth, 0 };
+		quad.m_max = { 1, 1 };
+		quads.emplace_back(quad);
+	}
+	return quads;
+}
+
+Entity Soil::GenerateSurfaceQuad(const CutOutQuad& quad, float waterFactor, float nutrientFactor, int textureLevel)
+{
+	if (quad.m_xAxis) return GenerateSurfaceQuadX(quad.m_backFacing, quad.m_depth, quad.m_min, quad.m_max, waterFactor, nutrientFactor, textureLevel);
+	return GenerateSurfaceQuadZ(quad.m_backFacing, quad.m_depth, quad.m_min, quad.m_max, waterFactor, nutrientFactor, textureLevel);
+}
+
+void Soil::GenerateGroundSurface(float xDepth, float zDepth)
+{
+	auto scene = Application::GetActiveScene();
+	auto groundSurface = GenerateMesh(xDepth, zDepth);
+	if (!scene->IsEntityValid(groundSurface)) return;
+	auto soilDescriptor = m_soilDescriptor.Get<SoilDescriptor>();
+	if (soilDescriptor)
+	{
+		auto& soilLayerDescriptors = soilDescriptor->m_soilLayerDescriptors;
+
+		if (!soilLayerDescriptors.empty())
+		{
+			auto firstDescriptor = soilLayerDescriptors[0].Get<SoilLayerDescriptor>();
+			if (firstDescriptor)
+			{
+				auto mmr = scene->GetOrSetPrivateComponent<MeshRenderer>(groundSurface).lock();
+				auto mat = mmr->m_material.Get<Material>();
+				mat->SetAlbedoTexture(firstDescriptor->m_albedoTexture.Get<Texture2D>());
+				mat->SetNormalTexture(firstDescriptor->m_normalTexture.Get<Texture2D>());
+				mat->SetRoughnessTexture(firstDescriptor->m_roughnessTexture.Get<Texture2D>());
+				mat->SetMetallicTexture(firstDescriptor->m_metallicTexture.Get<Texture2D>());
+			}
+		}
+	}
+}
+
+Entity Soil::GenerateCutOut(float xDepth, float zDepth, float waterFactor, float nutrientFactor, bool groundSurface, int textureLevel)
+{
+	auto scene = Application::GetActiveScene();
+	auto combinedEntity = scene->CreateEntity("CutOut");
+
+	for (const auto& quad : GetCutOutQuads(xDepth, zDepth))
+	{
+		auto quadEntity = GenerateSurfaceQuad(quad, waterFactor, nutrientFactor, textureLevel);
+		scene->SetParent(quadEntity, combinedEntity);
 	}
-	
-	
 	
 	if (groundSurface) {
-		auto groundSurface = GenerateMesh(xDepth, zDepth);
-		auto soilDescriptor = m_soilDescriptor.Get<SoilDescriptor>();
-		if (soilDescriptor)
+		GenerateGroundSurface(xDepth, zDepth);
+	}
+	return combinedEntity;
+}
+
+Entity Soil::UpdateCutOut(float xDepth, float zDepth, float waterFactor, float nutrientFactor, bool groundSurface, int textureLevel)
+{
+	auto scene = Application::GetActiveScene();
+	auto owner = GetOwner();
+	if (!scene->IsEntityValid(m_cutOutEntity))
+	{
+		// replace a cut-out that was not made by this function
+		for (const auto& child : scene->GetChildren(owner))
 		{
-			auto& soilLayerDescriptors = soilDescriptor->m_soilLayerDescriptors;
+			if (scene->GetEntityName(child) == "CutOut")
+			{
+				scene->DeleteEntity(child);
+				break;
+			}
+		}
+		m_cutOutEntity = scene->CreateEntity("CutOut");
+		scene->SetParent(m_cutOutEntity, owner);
+		m_cutOutQuads.clear();
+	}
 
-			if (!soilLayerDescriptors.empty())
+	const bool texturesChanged = m_cutOutWaterFactor != waterFactor || m_cutOutNutrientFactor != nutrientFactor
+		|| m_cutOutTextureLevel != textureLevel || m_cutOutSoilVersion != m_soilModel.m_version;
+	auto quads = GetCutOutQuads(xDepth, zDepth);
+	for (auto& quad : quads)
+	{
+		if (!texturesChanged)
+		{
+			for (auto& previousQuad : m_cutOutQuads)
 			{
-				auto firstDescriptor = soilLayerDescriptors[0].Get<SoilLayerDescriptor>();
-				if (firstDescriptor)
+				if (previousQuad.m_xAxis == quad.m_xAxis && previousQuad.m_backFacing == quad.m_backFacing
+					&& previousQuad.m_depth == quad.m_depth && previousQuad.m_min == quad.m_min && previousQuad.m_max == quad.m_max
+					&& scene->IsEntityValid(previousQuad.m_entity))
 				{
-					auto mmr = scene->GetOrSetPrivateComponent<MeshRenderer>(groundSurface).lock();
-					auto mat = mmr->m_material.Get<Material>();
-					mat->SetAlbedoTexture(firstDescriptor->m_albedoTexture.Get<Texture2D>());
-					mat->SetNormalTexture(firstDescriptor->m_normalTexture.Get<Texture2D>());
-					mat->SetRoughnessTexture(firstDescriptor->m_roughnessTexture.Get<Texture2D>());
-					mat->SetMetallicTexture(firstDescriptor->m_metallicTexture.Get<Texture2D>());
+					quad.m_entity = previousQuad.m_entity;
+					previousQuad.m_entity = Entity();
+					break;
 				}
 			}
 		}
+		if (!scene->IsEntityValid(quad.m_entity))
+		{
+			quad.m_entity = GenerateSurfaceQuad(quad, waterFactor, nutrientFactor, textureLevel);
+			scene->SetParent(quad.m_entity, m_cutOutEntity);
+		}
 	}
-	return combinedEntity;
+	for (const auto& previousQuad : m_cutOutQuads)
+	{
+		if (scene->IsEntityValid(previousQuad.m_entity)) scene->DeleteEntity(previousQuad.m_entity);
+	}
+	m_cutOutQuads = std::move(quads);
+	m_cutOutWaterFactor = waterFactor;
+	m_cutOutNutrientFactor = nutrientFactor;
+	m_cutOutTextureLevel = textureLevel;
+	m_cutOutSoilVersion = m_soilModel.m_version;
+
+	if (groundSurface && (!m_cutOutGroundSurface || m_cutOutGroundDepth != glm::vec2(xDepth, zDepth)))
+	{
+		GenerateGroundSurface(xDepth, zDepth);
+		m_cutOutGroundDepth = glm::vec2(xDepth, zDepth);
+	}
+	m_cutOutGroundSurface = groundSurface;
+	return m_cutOutEntity;
 }
 
-Entity Soil::GenerateFullBox(float waterFactor, float nutrientFactor, bool groundSurface)
+Entity Soil::GenerateFullBox(float waterFactor, float nutrientFactor, bool groundSurface, int textureLevel)
 {
 	auto scene = Application::GetActiveScene();
 	auto combinedEntity = scene->CreateEntity("Cube");
 
 	
-	auto quad1 = GenerateSurfaceQuadX(false, 0, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor);
+	auto quad1 = GenerateSurfaceQuadX(false, 0, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor, textureLevel);
 	scene->SetParent(quad1, combinedEntity);
 	
 	
-	auto quad2 = GenerateSurfaceQuadX(true, 1, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor);
+	auto quad2 = GenerateSurfaceQuadX(true, 1, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor, textureLevel);
 	scene->SetParent(quad2, combinedEntity);
 	
 	
-	auto quad3 = GenerateSurfaceQuadZ(true, 0, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor);
+	auto quad3 = GenerateSurfaceQuadZ(true, 0, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor, textureLevel);
 	scene->SetParent(quad3, combinedEntity);
 
-	auto quad4 = GenerateSurfaceQuadZ(false, 1, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor);
+	auto quad4 = GenerateSurfaceQuadZ(false, 1, { 0, 0 }, { 1 , 1 }, waterFactor, nutrientFactor, textureLevel);
 	scene->SetParent(quad4, combinedEntity);
 
 	if (groundSurface) {
-		auto groundSurface = GenerateMesh(0, 0);
-		auto soilDescriptor = m_soilDescriptor.Get<SoilDescriptor>();
-		if (soilDescriptor)
-		{
-			auto& soilLayerDescriptors = soilDescriptor->m_soilLayerDescriptors;
-
-			if (!soilLayerDescriptors.empty())
-			{
-				auto firstDescriptor = soilLayerDescriptors[0].Get<SoilLayerDescriptor>();
-				if (firstDescriptor)
-				{
-					auto mmr = scene->GetOrSetPrivateComponent<MeshRenderer>(groundSurface).lock();
-					auto mat = mmr->m_material.Get<Material>();
-					mat->SetAlbedoTexture(firstDescriptor->m_albedoTexture.Get<Texture2D>());
-					mat->SetNormalTexture(firstDescriptor->m_normalTexture.Get<Texture2D>());
-					mat->SetRoughnessTexture(firstDescriptor->m_roughnessTexture.Get<Texture2D>());
-					mat->SetMetallicTexture(firstDescriptor->m_metallicTexture.Get<Texture2D>());
-				}
-			}
-		}
+		GenerateGroundSurface(0, 0);
 	}
 	return combinedEntity;
 }
@@ -830,6 +905,7 @@ Entity Soil::GenerateMesh(float xDepth, float zDepth)
 	const auto mesh = ProjectManager::CreateTemporaryAsset<Mesh>();
 	const auto material = ProjectManager::CreateTemporaryAsset<Material>();
 	VertexAttributes vertexAttributes{};
+	vertexAttributes.m_normal = true;
 	vertexAttributes.m_texCoord = true;
 	mesh->SetVertices(vertexAttributes, vertices, triangles);
 	meshRenderer->m_mesh = mesh;
@@ -857,9 +933,14 @@ void Soil::InitializeSoilModel()
 
 		if (heightField)
 		{
-			soilSurface.m_height = [heightField](const glm::vec2& position)
+			//Bake the height at the voxel column centers, so the columns and later lookups read from the cache.
+			const auto columnStart = glm::vec2(params.m_boundingBoxMin.x, params.m_boundingBoxMin.z) + 0.5f * params.m_deltaX;
+			heightField->Bake(columnStart,
+				columnStart + glm::vec2(params.m_voxelResolution.x - 1, params.m_voxelResolution.z - 1) * params.m_deltaX,
+				params.m_deltaX);
+			soilSurface.m_height = [heightField, cellSize = params.m_deltaX](const glm::vec2& position)
 			{
-				return heightField->GetValue(glm::vec2(position.x, position.y));
+				return heightField->Sample(glm::vec2(position.x, position.y), cellSize);
 			};
 		}
 		else {
@@ -914,6 +995,14 @@ void Soil::InitializeSoilModel()
 				soilLayer.m_mat.m_d = [=](const glm::vec3& position) { return soilLayerDescriptor->m_density.GetValue(position); };
 				soilLayer.m_mat.m_n = [=](const glm::vec3& position) { return soilLayerDescriptor->m_initialNutrients.GetValue(position); };
 				soilLayer.m_mat.m_w = [=](const glm::vec3& position) { return soilLayerDescriptor->m_initialWater.GetValue(position); };
+				soilLayer.m_mat.m_batch = [=](const std::vector<glm::vec3>& positions, SoilPhysicalProperties& properties)
+				{
+					soilLayerDescriptor->m_capacity.GetValues(positions, properties.m_c);
+					soilLayerDescriptor->m_permeability.GetValues(positions, properties.m_p);
+					soilLayerDescriptor->m_density.GetValues(positions, properties.m_d);
+					soilLayerDescriptor->m_initialNutrients.GetValues(positions, properties.m_n);
+					soilLayerDescriptor->m_initialWater.GetValues(positions, properties.m_w);
+				};
 				soilLayer.m_mat.m_id = materialIndex;
 				soilLayer.m_thickness = [soilLayerDescriptor](const glm::vec2& position)
 				{
@@ -1003,7 +1092,7 @@ void Soil::SplitRootTestSetup()
 			bool underGround = true;
 			if (heightField)
 			{
-				auto height = heightField->GetValue(glm::vec2(position.x, position.z));
+				auto height = heightField->Sample(glm::vec2(position.x, position.z), m_soilModel.m_dx);
 				if (position.y >= height) underGround = false;
 			}
 			if (underGround) {
@@ -1029,6 +1118,7 @@ void Soil::SplitRootTestSetup()
 				m_soilModel.m_n[i] = 0.0f;
 			}
 		}
+		m_soilModel.m_version++;
 	}
 }
 
@@ -1036,18 +1126,7 @@ void Soil::FixedUpdate()
 {
 	if (m_temporalProgression) {
 		if (m_temporalProgressionProgress < 1.0f) {
-			auto scene = Application::GetActiveScene();
-			auto owner = GetOwner();
-			for (const auto& child : scene->GetChildren(owner))
-			{
-				if (scene->GetEntityName(child) == "CutOut")
-				{
-					scene->DeleteEntity(child);
-					break;
-				}
-			}
-			auto cutOutEntity = GenerateCutOut(m_temporalProgressionProgress, 0.99f, 0, 0, true);
-			scene->SetParent(cutOutEntity, owner);
+			UpdateCutOut(m_temporalProgressionProgress, 0.99f, 0, 0, true);
 			m_temporalProgressionProgress += 0.01f;
 		}
 		else
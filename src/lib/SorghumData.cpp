@@ -15,6 +15,7 @@
 #include "EditorLayer.hpp"
 #include "Material.hpp"
 #include "Mesh.hpp"
+#include "Jobs.hpp"
 
 using namespace EcoSysLab;
 
@@ -146,10 +147,8 @@ void SorghumData::CollectAssetRef(std::vector<AssetRef>& list) {
 	list.push_back(m_descriptor);
 }
 
-void SorghumData::FormPlant() {
+SorghumStatePair SorghumData::GetStatePair() {
 	SorghumStatePair statePair;
-	auto sorghumLayer = Application::GetLayer<SorghumLayer>();
-	auto scene = GetScene();
 	switch ((SorghumMode)m_mode) {
 	case SorghumMode::ProceduralSorghum: {
 		auto descriptor = m_descriptor.Get<ProceduralSorghum>();
@@ -157,7 +156,7 @@ void SorghumData::FormPlant() {
 			break;
 		m_currentTime =
 			glm::clamp(m_currentTime, 0.0f, descriptor->GetCurrentEndTime());
-		statePair = descriptor->Get(m_currentTime);
+		descriptor->Get(m_currentTime, statePair, m_stateCursor);
 		m_recordedVersion = descriptor->GetVersion();
 	} break;
 	case SorghumMode::SorghumStateGenerator: {
@@ -169,26 +168,73 @@ void SorghumData::FormPlant() {
 		m_recordedVersion = descriptor->GetVersion();
 	} break;
 	}
+	return statePair;
+}
 
+void SorghumData::CreateOrgans(const SorghumStatePair& statePair, std::shared_ptr<StemData>& stemData,
+	std::vector<std::shared_ptr<LeafData>>& leafData, std::shared_ptr<PanicleData>& panicleData) {
+	auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+	auto scene = GetScene();
 	// 1. Set owner's spline
 	auto children = scene->GetChildren(GetOwner());
 	for (int i = 0; i < children.size(); i++) {
 		scene->DeleteEntity(children[i]);
 	}
 	auto stem = sorghumLayer->CreateSorghumStem(GetOwner());
-	auto stemData = scene->GetOrSetPrivateComponent<StemData>(stem).lock();
-	stemData->FormStem(statePair, m_skeleton);
+	stemData = scene->GetOrSetPrivateComponent<StemData>(stem).lock();
 	auto leafSize = statePair.GetLeafSize();
+	leafData.resize(leafSize);
 	for (int i = 0; i < leafSize; i++) {
 		Entity leaf = sorghumLayer->CreateSorghumLeaf(GetOwner(), i);
-		auto leafData = scene->GetOrSetPrivateComponent<LeafData>(leaf).lock();
-		leafData->FormLeaf(statePair, m_skeleton, sorghumLayer->m_bottomFace);
+		leafData[i] = scene->GetOrSetPrivateComponent<LeafData>(leaf).lock();
 	}
 	auto panicle = sorghumLayer->CreateSorghumPanicle(GetOwner());
-	auto panicleData =
+	panicleData =
 		scene->GetOrSetPrivateComponent<PanicleData>(panicle).lock();
-	panicleData->FormPanicle(statePair);
 }
+
+void SorghumData::FormPlant() {
+	auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+	const auto statePair = GetStatePair();
+	std::shared_ptr<StemData> stemData;
+	std::vector<std::shared_ptr<LeafData>> leafData;
+	std::shared_ptr<PanicleData> panicleData;
+	CreateOrgans(statePair, stemData, leafData, panicleData);
+	stemData->FormStem(statePair, m_skeleton);
+	for (const auto& leaf : leafData) {
+		leaf->FormLeaf(statePair, m_skeleton, sorghumLayer->m_bottomFace);
+	}
+	panicleData->FormPanicle(statePair, m_seed);
+}
+
+void SorghumData::FormPlants(const std::shared_ptr<Scene>& scene, const std::vector<Entity>& plants) {
+	auto sorghumLayer = Application::GetLayer<SorghumLayer>();
+	std::vector<SorghumStatePair> statePairs(plants.size());
+	std::vector<bool> skeletons(plants.size());
+	std::vector<unsigned> seeds(plants.size());
+	std::vector<std::shared_ptr<StemData>> stemData(plants.size());
+	std::vector<std::shared_ptr<PanicleData>> panicleData(plants.size());
+	std::vector<std::pair<unsigned, std::shared_ptr<LeafData>>> leafData;
+	for (unsigned plantIndex = 0; plantIndex < plants.size(); plantIndex++) {
+		const auto sorghumData = scene->GetOrSetPrivateComponent<SorghumData>(plants[plantIndex]).lock();
+		statePairs[plantIndex] = sorghumData->GetStatePair();
+		skeletons[plantIndex] = sorghumData->m_skeleton;
+		seeds[plantIndex] = sorghumData->m_seed;
+		std::vector<std::shared_ptr<LeafData>> leaves;
+		sorghumData->CreateOrgans(statePairs[plantIndex], stemData[plantIndex], leaves, panicleData[plantIndex]);
+		for (const auto& leaf : leaves) leafData.emplace_back(plantIndex, leaf);
+	}
+	//Plants have far fewer stems than leaves, so the leaves are spread over the workers on their own.
+	Jobs::ParallelFor(plants.size(), [&](unsigned plantIndex) {
+		stemData[plantIndex]->FormStem(statePairs[plantIndex], skeletons[plantIndex]);
+		panicleData[plantIndex]->FormPanicle(statePairs[plantIndex], seeds[plantIndex]);
+		});
+	Jobs::ParallelFor(leafData.size(), [&](unsigned leafIndex) {
+		const auto& [plantIndex, leaf] = leafData[leafIndex];
+		leaf->FormLeaf(statePairs[plantIndex], skeletons[plantIndex], sorghumLayer->m_bottomFace);
+		});
+}
+
 void SorghumData::ApplyGeometry() {
 	auto scene = GetScene();
 	auto owner = GetOwner();
@@ -10,8 +10,49 @@
 #include "Scene.hpp"
 #include "EditorLayer.hpp"
 #include "TransformGraph.hpp"
+#include "Jobs.hpp"
 
 using namespace EcoSysLab;
+
+/**
+ * The parameters of a generated state that shape its geometry, rounded to the tolerance so that plants which would look the
+ * same compare equal.
+ */
+static std::vector<float> QuantizeState(const SorghumState &state, const float tolerance) {
+  std::vector<float> key;
+  const auto push = [&](const float value) {
+    key.emplace_back(tolerance > 0.0f ? std::round(value / tolerance) : value);
+  };
+  const auto pushPlot = [&](const Plot2D<float> &plot) {
+    for (const float t : {0.0f, 0.25f, 0.5f, 0.75f, 1.0f})
+      push(plot.GetValue(t));
+  };
+  push(state.m_stem.m_length);
+  for (int i = 0; i < 3; i++)
+    push(state.m_stem.m_direction[i]);
+  pushPlot(state.m_stem.m_widthAlongStem);
+  for (int i = 0; i < 3; i++)
+    push(state.m_panicle.m_panicleSize[i]);
+  push(static_cast<float>(state.m_panicle.m_seedAmount));
+  push(state.m_panicle.m_seedRadius);
+  push(static_cast<float>(state.m_leaves.size()));
+  for (const auto &leaf : state.m_leaves) {
+    push(leaf.m_startingPoint);
+    push(leaf.m_length);
+    push(leaf.m_rollAngle);
+    push(leaf.m_branchingAngle);
+    for (int i = 0; i < 2; i++) {
+      push(leaf.m_wavinessPeriodStart[i]);
+      push(leaf.m_wavinessFrequency[i]);
+    }
+    pushPlot(leaf.m_widthAlongLeaf);
+    pushPlot(leaf.m_curlingAlongLeaf);
+    pushPlot(leaf.m_bendingAlongLeaf);
+    pushPlot(leaf.m_wavinessAlongLeaf);
+  }
+  return key;
+}
+
 void RectangularSorghumFieldPattern::GenerateField(
     std::vector<std::vector<glm::mat4>> &matricesList) {
   const int size = matricesList.size();
@@ -36,6 +77,9 @@ void SorghumField::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
   
   ImGui::DragInt("Size limit", &m_sizeLimit, 1, 0, 10000);
   ImGui::DragFloat("Sorghum size", &m_sorghumSize, 0.01f, 0, 10);
+  ImGui::Checkbox("Share variants", &m_shareVariants);
+  if (m_shareVariants)
+    ImGui::DragFloat("Variant tolerance", &m_variantTolerance, 0.001f, 0, 1);
   if (ImGui::Button("Refresh matrices")) {
     GenerateMatrices();
   }
@@ -48,6 +92,8 @@ void SorghumField::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 void SorghumField::Serialize(YAML::Emitter &out) {
   out << YAML::Key << "m_sizeLimit" << YAML::Value << m_sizeLimit;
   out << YAML::Key << "m_sorghumSize" << YAML::Value << m_sorghumSize;
+  out << YAML::Key << "m_shareVariants" << YAML::Value << m_shareVariants;
+  out << YAML::Key << "m_variantTolerance" << YAML::Value << m_variantTolerance;
 
   out << YAML::Key << "m_newSorghums" << YAML::Value << YAML::BeginSeq;
   for (auto &i : m_newSorghums) {
@@ -63,6 +109,10 @@ void SorghumField::Deserialize(const YAML::Node &in) {
     m_sizeLimit = in["m_sizeLimit"].as<int>();
   if (in["m_sorghumSize"])
     m_sorghumSize = in["m_sorghumSize"].as<float>();
+  if (in["m_shareVariants"])
+    m_shareVariants = in["m_shareVariants"].as<bool>();
+  if (in["m_variantTolerance"])
+    m_variantTolerance = in["m_variantTolerance"].as<float>();
 
   m_newSorghums.clear();
   if (in["m_newSorghums"]) {
@@ -90,32 +140,143 @@ Entity SorghumField::InstantiateField() {
   auto sorghumLayer = Application::GetLayer<SorghumLayer>();
   auto scene = sorghumLayer->GetScene();
   if (sorghumLayer) {
+    const float startTime = Times::Now();
     auto fieldAsset = std::dynamic_pointer_cast<SorghumField>(GetSelf());
+    const auto plantSize = glm::min(
+        static_cast<int>(fieldAsset->m_newSorghums.size()), m_sizeLimit);
+    if (plantSize <= 0) {
+      EVOENGINE_ERROR("Size limit is 0, no plants to instantiate!");
+      return {};
+    }
+    // The shared variants are formed from the descriptors directly, so they
+    // are checked before any entity is created.
+    if (m_shareVariants) {
+      for (int i = 0; i < plantSize; i++) {
+        if (!fieldAsset->m_newSorghums[i].first.Get<SorghumStateGenerator>()) {
+          EVOENGINE_ERROR("Field contains a plant without a sorghum state generator!");
+          return {};
+        }
+      }
+    }
     auto field = scene->CreateEntity("Field");
+    std::vector<Transform> plantTransforms(plantSize);
+    for (int i = 0; i < plantSize; i++) {
+      plantTransforms[i].m_value = fieldAsset->m_newSorghums[i].second;
+      plantTransforms[i].SetScale(glm::vec3(m_sorghumSize));
+    }
     // Create sorghums here.
-    int size = 0;
-    for (auto &newSorghum : fieldAsset->m_newSorghums) {
-      Entity sorghumEntity = sorghumLayer->CreateSorghum();
-      auto sorghumTransform = scene->GetDataComponent<Transform>(sorghumEntity);
-      sorghumTransform.m_value = newSorghum.second;
-      sorghumTransform.SetScale(glm::vec3(m_sorghumSize));
-      scene->SetDataComponent(sorghumEntity, sorghumTransform);
+    if (!m_shareVariants) {
+      std::vector<Entity> plants(plantSize);
+      for (int i = 0; i < plantSize; i++) {
+        Entity sorghumEntity = sorghumLayer->CreateSorghum();
+        scene->SetDataComponent(sorghumEntity, plantTransforms[i]);
+        auto sorghumData =
+            scene->GetOrSetPrivateComponent<SorghumData>(sorghumEntity).lock();
+        sorghumData->m_mode = (int)SorghumMode::SorghumStateGenerator;
+        sorghumData->m_descriptor = fieldAsset->m_newSorghums[i].first;
+        sorghumData->m_seed = i;
+        scene->SetParent(sorghumEntity, field);
+        plants[i] = sorghumEntity;
+      }
+      SorghumData::FormPlants(scene, plants);
+      for (const auto &plant : plants) {
+        scene->GetOrSetPrivateComponent<SorghumData>(plant).lock()->ApplyGeometry();
+      }
+      TransformGraph::CalculateTransformGraphForDescendents(scene, field);
+      EVOENGINE_LOG("Field instantiated: " + std::to_string(plantSize) +
+                    " plants in " + std::to_string(Times::Now() - startTime) +
+                    "s");
+      return field;
+    }
+    // Every plant gets the state of its own seed, plants whose quantized states match are formed once, as a prototype with
+    // the seed of the first of them. Generate reseeds the global rand, so the states are generated here, serially.
+    std::map<std::pair<std::shared_ptr<SorghumStateGenerator>, std::vector<float>>, unsigned>
+        prototypeIndices;
+    std::vector<Entity> prototypes;
+    std::vector<unsigned> plantPrototypeIndices(plantSize);
+    for (int i = 0; i < plantSize; i++) {
+      const auto descriptor = fieldAsset->m_newSorghums[i].first.Get<SorghumStateGenerator>();
+      auto key = std::make_pair(descriptor, QuantizeState(descriptor->Generate(i), m_variantTolerance));
+      const auto search = prototypeIndices.find(key);
+      if (search != prototypeIndices.end()) {
+        plantPrototypeIndices[i] = search->second;
+        continue;
+      }
+      Entity prototype = sorghumLayer->CreateSorghum();
       auto sorghumData =
-          scene->GetOrSetPrivateComponent<SorghumData>(sorghumEntity).lock();
+          scene->GetOrSetPrivateComponent<SorghumData>(prototype).lock();
       sorghumData->m_mode = (int)SorghumMode::SorghumStateGenerator;
-      sorghumData->m_descriptor = newSorghum.first;
-      sorghumData->m_seed = size;
-      sorghumData->SetTime(1.0f);
-      scene->SetParent(sorghumEntity, field);
-      size++;
-      if (size >= m_sizeLimit)
-        break;
+      sorghumData->m_descriptor = fieldAsset->m_newSorghums[i].first;
+      sorghumData->m_seed = i;
+      plantPrototypeIndices[i] = prototypeIndices[std::move(key)] =
+          prototypes.size();
+      prototypes.emplace_back(prototype);
+    }
+    SorghumData::FormPlants(scene, prototypes);
+    // Every mesh of a prototype becomes one instanced draw for all the plants
+    // that share it, the prototypes are removed afterwards.
+    std::vector<std::vector<unsigned>> prototypePlants(prototypes.size());
+    for (int i = 0; i < plantSize; i++) {
+      prototypePlants[plantPrototypeIndices[i]].emplace_back(i);
+    }
+    int instancedMeshSize = 0;
+    // Geometry held by the shared meshes, against what one hierarchy per plant would have held.
+    size_t sharedMeshBytes = 0;
+    size_t unsharedMeshBytes = 0;
+    for (unsigned prototypeIndex = 0; prototypeIndex < prototypes.size();
+         prototypeIndex++) {
+      const auto prototype = prototypes[prototypeIndex];
+      scene->GetOrSetPrivateComponent<SorghumData>(prototype).lock()->ApplyGeometry();
+      TransformGraph::CalculateTransformGraphForDescendents(scene, prototype);
+      const auto inversePrototypeTransform = glm::inverse(
+          scene->GetDataComponent<GlobalTransform>(prototype).m_value);
+      scene->ForEachDescendant(prototype, [&](Entity child) {
+        if (!scene->HasPrivateComponent<MeshRenderer>(child))
+          return;
+        const auto meshRenderer =
+            scene->GetOrSetPrivateComponent<MeshRenderer>(child).lock();
+        if (!meshRenderer->IsEnabled() || !meshRenderer->m_mesh.Get<Mesh>())
+          return;
+        const auto relativeTransform =
+            inversePrototypeTransform *
+            scene->GetDataComponent<GlobalTransform>(child).m_value;
+        const auto instancesEntity =
+            scene->CreateEntity(scene->GetEntityName(child));
+        scene->SetParent(instancesEntity, field);
+        const auto particleInfoList =
+            ProjectManager::CreateTemporaryAsset<ParticleInfoList>();
+        const auto &plantIndices = prototypePlants[prototypeIndex];
+        particleInfoList->m_particleInfos.resize(plantIndices.size());
+        Jobs::ParallelFor(plantIndices.size(), [&](unsigned i) {
+          particleInfoList->m_particleInfos[i].m_instanceMatrix.m_value =
+              plantTransforms[plantIndices[i]].m_value * relativeTransform;
+        });
+        particleInfoList->SetPendingUpdate();
+        const auto particles =
+            scene->GetOrSetPrivateComponent<Particles>(instancesEntity).lock();
+        particles->m_mesh = meshRenderer->m_mesh;
+        particles->m_material = meshRenderer->m_material;
+        particles->m_particleInfoList = particleInfoList;
+        instancedMeshSize++;
+        const auto mesh = meshRenderer->m_mesh.Get<Mesh>();
+        const size_t meshBytes =
+            mesh->UnsafeGetVertices().size() * sizeof(Vertex) +
+            mesh->UnsafeGetTriangles().size() * sizeof(glm::uvec3);
+        sharedMeshBytes += meshBytes;
+        unsharedMeshBytes += meshBytes * plantIndices.size();
+      });
+      scene->DeleteEntity(prototype);
     }
-
-    Application::GetLayer<SorghumLayer>()->GenerateMeshForAllSorghums();
 
     TransformGraph::CalculateTransformGraphForDescendents(scene,
                                                 field);
+    EVOENGINE_LOG("Field instantiated: " + std::to_string(plantSize) +
+                  " plants sharing " + std::to_string(instancedMeshSize) +
+                  " meshes of " + std::to_string(prototypes.size()) +
+                  " variants in " +
+                  std::to_string(Times::Now() - startTime) + "s, " +
+                  std::to_string(sharedMeshBytes / 1024) + "KB of geometry instead of " +
+                  std::to_string(unsharedMeshBytes / 1024) + "KB");
     return field;
   } else {
     EVOENGINE_ERROR("No sorghum layer!");
@@ -17,8 +17,8 @@
 #ifdef BUILD_WITH_RAYTRACER
 #include "CBTFGroup.hpp"
 #include "DoubleCBTF.hpp"
-#include "PARSensorGroup.hpp"
 #endif
+#include "PARSensorGroup.hpp"
 using namespace EcoSysLab;
 using namespace EvoEngine;
 
@@ -45,9 +45,9 @@ void SorghumLayer::OnCreate() {
 	ClassRegistry::RegisterAsset<SorghumStateGenerator>(
 		"SorghumStateGenerator", { ".sorghumstategenerator" });
 	ClassRegistry::RegisterAsset<SorghumField>("SorghumField", { ".sorghumfield" });
-#ifdef BUILD_WITH_RAYTRACER
 	ClassRegistry::RegisterAsset<PARSensorGroup>("PARSensorGroup",
 		{ ".parsensorgroup" });
+#ifdef BUILD_WITH_RAYTRACER
 	ClassRegistry::RegisterAsset<CBTFGroup>("CBTFGroup", { ".cbtfg" });
 	ClassRegistry::RegisterAsset<DoubleCBTF>("DoubleCBTF", { ".dcbtf" });
 #endif
@@ -255,6 +255,19 @@ void SorghumLayer::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 
 		ImGui::Checkbox("Enable BTF", &m_enableCompressedBTF);
 #endif
+		if (ImGui::TreeNodeEx("CPU Illumination Estimation")) {
+			editorLayer->DragAndDropButton<SkyIlluminance>(m_skyIlluminance, "Sky illuminance");
+			ImGui::DragFloat("Time", &m_skyIlluminanceTime, 0.01f);
+			m_canopyIlluminationSettings.OnInspect();
+			if (ImGui::Button("Calculate illumination on CPU")) {
+				CalculateIlluminationCpu();
+			}
+			if (!m_canopyIlluminationResults.empty()) {
+				ImGui::Text("Plants: %llu, triangles: %llu, time: %.3fs", m_canopyIlluminationResults.size(),
+					m_canopyTriangleIrradiances.size(), m_canopyIlluminationTime);
+			}
+			ImGui::TreePop();
+		}
 		ImGui::Separator();
 		ImGui::Checkbox("Auto regenerate sorghum", &m_autoRefreshSorghums);
 		ImGui::Checkbox("Bottom Face", &m_bottomFace);
@@ -509,6 +522,61 @@ void SorghumLayer::CalculateIllumination() {
 	}
 }
 #endif
+void SorghumLayer::CalculateIlluminationCpu(const std::shared_ptr<PARSensorGroup>& sensorGroup) {
+	const auto skyIlluminance = m_skyIlluminance.Get<SkyIlluminance>();
+	if (!skyIlluminance) {
+		EVOENGINE_ERROR("No sky illuminance!");
+		return;
+	}
+	const float startTime = Times::Now();
+	const auto snapshot = skyIlluminance->Get(m_skyIlluminanceTime);
+	const auto scene = GetScene();
+	std::vector<Entity> plants;
+	scene->GetEntityArray(m_sorghumQuery, plants);
+	// All meshes of all plants go into one canopy in world space. The bottom faces of the leaves are skipped, they
+	// would shade the top faces they are offset from.
+	std::vector<glm::vec3> positions;
+	std::vector<glm::uvec3> triangles;
+	m_canopyIlluminationResults.clear();
+	for (const auto& plant : plants) {
+		auto& result = m_canopyIlluminationResults.emplace_back();
+		result.m_plant = plant;
+		result.m_triangleStart = triangles.size();
+		scene->ForEachDescendant(plant, [&](Entity child) {
+			if (scene->HasDataComponent<LeafBottomFaceGeometryTag>(child) || !scene->HasPrivateComponent<MeshRenderer>(child))
+				return;
+			const auto mesh = scene->GetOrSetPrivateComponent<MeshRenderer>(child).lock()->m_mesh.Get<Mesh>();
+			if (!mesh)
+				return;
+			const auto globalTransform = scene->GetDataComponent<GlobalTransform>(child).m_value;
+			const auto vertexStart = static_cast<unsigned>(positions.size());
+			for (const auto& vertex : mesh->UnsafeGetVertices()) {
+				positions.emplace_back(globalTransform * glm::vec4(vertex.m_position, 1.0f));
+			}
+			for (const auto& triangle : mesh->UnsafeGetTriangles()) {
+				triangles.emplace_back(triangle + glm::uvec3(vertexStart));
+			}
+			});
+		result.m_triangleSize = triangles.size() - result.m_triangleStart;
+	}
+	CanopyIlluminationEstimator estimator;
+	estimator.Build(positions, triangles);
+	estimator.EstimateTriangles(m_canopyIlluminationSettings, snapshot, m_canopyTriangleIrradiances);
+	for (auto& result : m_canopyIlluminationResults) {
+		result.m_absorbedPAR = 0.0f;
+		for (size_t i = result.m_triangleStart; i < result.m_triangleStart + result.m_triangleSize; i++) {
+			const auto& triangle = triangles[i];
+			const float area = glm::length(glm::cross(positions[triangle.y] - positions[triangle.x],
+				positions[triangle.z] - positions[triangle.x])) * 0.5f;
+			result.m_absorbedPAR += m_canopyTriangleIrradiances[i] * area;
+		}
+	}
+	if (sensorGroup) {
+		sensorGroup->CalculateIllumination(estimator, m_canopyIlluminationSettings, snapshot);
+	}
+	m_canopyIlluminationTime = Times::Now() - startTime;
+}
+
 void SorghumLayer::Update() {
 	auto scene = GetScene();
 #ifdef BUILD_WITH_RAYTRACER
@@ -17,6 +17,7 @@
 #include "EcoSysLabLayer.hpp"
 #include "HeightField.hpp"
 #include "StrandsRenderer.hpp"
+#include "Times.hpp"
 using namespace EcoSysLab;
 void Tree::SerializeTreeGrowthSettings(const TreeGrowthSettings& treeGrowthSettings, YAML::Emitter& out)
 {
@@ -27,6 +28,8 @@ void Tree::SerializeTreeGrowthSettings(const TreeGrowthSettings& treeGrowthSetti
 	out << YAML::Key << "m_spaceColonizationRemovalDistanceFactor" << YAML::Value << treeGrowthSettings.m_spaceColonizationRemovalDistanceFactor;
 	out << YAML::Key << "m_spaceColonizationDetectionDistanceFactor" << YAML::Value << treeGrowthSettings.m_spaceColonizationDetectionDistanceFactor;
 	out << YAML::Key << "m_spaceColonizationTheta" << YAML::Value << treeGrowthSettings.m_spaceColonizationTheta;
+	out << YAML::Key << "m_incrementalShootUpdate" << YAML::Value << treeGrowthSettings.m_incrementalShootUpdate;
+	out << YAML::Key << "m_saggingTolerance" << YAML::Value << treeGrowthSettings.m_saggingTolerance;
 }
 void Tree::DeserializeTreeGrowthSettings(TreeGrowthSettings& treeGrowthSettings, const YAML::Node& param) {
 	if (param["m_nodeDevelopmentalVigorFillingRate"]) treeGrowthSettings.m_nodeDevelopmentalVigorFillingRate = param["m_nodeDevelopmentalVigorFillingRate"].as<float>();
@@ -35,113 +38,37 @@ void Tree::DeserializeTreeGrowthSettings(TreeGrowthSettings& treeGrowthSettings,
 	if (param["m_spaceColonizationRemovalDistanceFactor"]) treeGrowthSettings.m_spaceColonizationRemovalDistanceFactor = param["m_spaceColonizationRemovalDistanceFactor"].as<float>();
 	if (param["m_spaceColonizationDetectionDistanceFactor"]) treeGrowthSettings.m_spaceColonizationDetectionDistanceFactor = param["m_spaceColonizationDetectionDistanceFactor"].as<float>();
 	if (param["m_spaceColonizationTheta"]) treeGrowthSettings.m_spaceColonizationTheta = param["m_spaceColonizationTheta"].as<float>();
+	if (param["m_incrementalShootUpdate"]) treeGrowthSettings.m_incrementalShootUpdate = param["m_incrementalShootUpdate"].as<bool>();
+	if (param["m_saggingTolerance"]) treeGrowthSettings.m_saggingTolerance = param["m_saggingTolerance"].as<float>();
 }
 
 bool Tree::ParseBinvox(const std::filesystem::path& filePath, VoxelGrid<TreeOccupancyGridBasicData>& voxelGrid, float voxelSize)
 {
-	std::ifstream input(filePath, std::ios::in | std::ios::binary);
-	if (!input.is_open()) {
-		std::cout << "Error: could not open file " << filePath << std::endl;
-		return false;
-	}
-
-	// Read header
-	std::string line;
-	input >> line;  // #binvox
-	if (line.compare("#binvox") != 0) {
-		std::cout << "Error: first line reads [" << line << "] instead of [#binvox]" << std::endl;
-		return false;
-	}
-	int version;
-	input >> version;
-#ifndef NDEBUG
-	std::cout << "reading binvox version " << version << std::endl;
-#endif
-	int depth, height, width;
-	depth = -1;
-	bool done = false;
-	while (input.good() && !done) {
-		input >> line;
-		if (line.compare("data") == 0) done = true;
-		else if (line.compare("dim") == 0) {
-			input >> depth >> height >> width;
-		}
-		else {
-#ifndef NDEBUG
-			std::cout << "  unrecognized keyword [" << line << "], skipping" << std::endl;
-#endif
-			char c;
-			do {  // skip until end of line
-				c = input.get();
-			} while (input.good() && (c != '\n'));
-		}
-	}
-
-	if (!done) {
-		std::cout << "  error reading header" << std::endl;
-		return false;
-	}
-	if (depth == -1) {
-		std::cout << "  missing dimensions in header" << std::endl;
-		return false;
-	}
-
-	// Initialize the voxel grid based on the dimensions read
-	glm::vec3 minBound(0, 0, 0);  // Assuming starting from origin
-	glm::ivec3 resolution(width, height, depth);
-	voxelGrid.Initialize(voxelSize, resolution, minBound, {});  // Assuming voxelSize is globally defined or passed as an argument
-
-	// Read voxel data
-	unsigned char value;
-	unsigned char count;
-	int index = 0;
-	int end_index = 0;
-	int nr_voxels = 0;
-
-	input.unsetf(std::ios::skipws);  // need to read every byte now (!)
-	input >> value;  // read the linefeed char
-	glm::vec3 lowSum = glm::ivec3(0.0f);
-	size_t lowSumCount = 0;
-	while (end_index < width * height * depth && input.good()) {
-		input >> value >> count;
-
-		if (input.good()) {
-			end_index = index + count;
-			if (end_index > (width * height * depth)) return false;
-
-			for (int i = index; i < end_index; i++) {
-				// Convert 1D index to 3D coordinates
-				const int x = (i / width) % height;
-				const int y = i % width;
-				const int z = i / (width * height);
-
-				if (value) {
-					voxelGrid.Ref(glm::ivec3(x, y, z)).m_occupied = true;
-					nr_voxels++;
-
-					if (y < (height * 0.2f))
-					{
-						lowSum += voxelGrid.GetPosition(glm::ivec3(x, y, z));
-						lowSumCount++;
-					}
-				}
-			}
-
-			index = end_index;
-		}
-	}
-	lowSum /= lowSumCount;
-	voxelGrid.ShiftMinBound(-glm::vec3(lowSum.x, 0, lowSum.z));
+	BinvoxVolume volume;
+	if (!volume.Load(filePath, voxelSize)) return false;
+	volume.ToVoxelGrid(voxelGrid);
+	return true;
+}
 
-	input.close();
-#ifndef NDEBUG
-	std::cout << "  read " << nr_voxels << " voxels" << std::endl;
-#endif
+bool Tree::ApplyEnvelope(const BinvoxVolume& volume, const float radius, const int markersPerVoxel)
+{
+	const auto treeDescriptor = m_treeDescriptor.Get<TreeDescriptor>();
+	if (!treeDescriptor) return false;
+	m_treeModel.m_treeOccupancyGrid.Initialize(volume,
+		glm::vec3(-radius, 0, -radius),
+		glm::vec3(radius, 2.0f * radius, radius),
+		treeDescriptor->m_shootGrowthParameters.m_internodeLength,
+		m_treeModel.m_treeGrowthSettings.m_spaceColonizationRemovalDistanceFactor,
+		m_treeModel.m_treeGrowthSettings.m_spaceColonizationTheta,
+		m_treeModel.m_treeGrowthSettings.m_spaceColonizationDetectionDistanceFactor, markersPerVoxel);
 	return true;
 }
 
 void Tree::Reset()
 {
+	m_pendingShootSnapshot.Clear();
+	m_shootGrowthTime = 0.0f;
+	m_meshIteration = m_meshChangeVersion = -1;
 	m_treeModel.Clear();
 	m_treeModel.m_index = GetOwner().GetIndex();
 	m_treeVisualizer.Reset(m_treeModel);
@@ -273,6 +200,7 @@ void Tree::InitializeSkeletalGraph(NodeHandle baseNodeHandle,
 
 void Tree::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 
+	LoadShootSnapshot();
 	bool modelChanged = false;
 	const auto ecoSysLabLayer = Application::GetLayer<EcoSysLabLayer>();
 	const auto scene = GetScene();
@@ -301,9 +229,26 @@ void Tree::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 			if (m_enableHistory)
 			{
 				ImGui::DragInt("History per iteration", &m_historyIteration, 1, 1, 1000);
+				ImGui::Text(("History memory: " + std::to_string(m_treeModel.GetHistoryMemoryUsage() / 1024) + " KB").c_str());
+			}
+			ImGui::Checkbox("Quantize saved shoot", &m_quantizeShootSnapshot);
+			ImGui::Text(("Growth time: " + std::to_string(m_shootGrowthTime) + "s").c_str());
+			if (m_shootSnapshotDecodeTime > 0.0f)
+			{
+				ImGui::Text(("Snapshot load time: " + std::to_string(m_shootSnapshotDecodeTime) + "s").c_str());
 			}
+			if (ImGui::Button("Compare load with regrowth")) CompareShootLoadWithRegrowth();
+			ImGui::SameLine();
+			if (ImGui::Button("Verify shoot round trip")) VerifyShootSnapshotRoundTrip();
+			ImGui::Text(("Last shoot post process: " + std::to_string(m_treeModel.m_lastPostProcessTime * 1000.0) + "ms"
+				+ (m_treeModel.m_lastPostProcessIncremental ? " (incremental)" : " (full)")).c_str());
 			OnInspectTreeGrowthSettings(m_treeModel.m_treeGrowthSettings);
 
+			if (m_treeModel.m_treeGrowthSettings.m_useSpaceColonization)
+			{
+				ImGui::Text(("Marker count: " + std::to_string(m_treeModel.m_treeOccupancyGrid.PeekMarkers().size())).c_str());
+				ImGui::Text(("Marker grid memory: " + std::to_string(m_treeModel.m_treeOccupancyGrid.GetMemoryUsage() / 1024) + " KB").c_str());
+			}
 			if (m_treeModel.m_treeGrowthSettings.m_useSpaceColonization && !m_treeModel.m_treeGrowthSettings.m_spaceColonizationAutoResize)
 			{
 				static float radius = 1.5f;
@@ -311,20 +256,18 @@ void Tree::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 				ImGui::DragFloat("Import radius", &radius, 0.01f, 0.01f, 10.0f);
 				ImGui::DragInt("Markers per voxel", &markersPerVoxel);
 				FileUtils::OpenFile("Load Voxel Data", "Binvox", { ".binvox" }, [&](const std::filesystem::path& path) {
-					auto& occupancyGrid = m_treeModel.m_treeOccupancyGrid;
-					VoxelGrid<TreeOccupancyGridBasicData> inputGrid{};
-					if (ParseBinvox(path, inputGrid, 1.f))
+					const float loadStartTime = Times::Now();
+					BinvoxVolume volume;
+					if (volume.Load(path, 1.f))
 					{
-						const auto treeDescriptor = m_treeDescriptor.Get<TreeDescriptor>();
-						occupancyGrid.Initialize(inputGrid,
-							glm::vec3(-radius, 0, -radius),
-							glm::vec3(radius, 2.0f * radius, radius),
-							treeDescriptor->m_shootGrowthParameters.m_internodeLength,
-							m_treeModel.m_treeGrowthSettings.m_spaceColonizationRemovalDistanceFactor,
-							m_treeModel.m_treeGrowthSettings.m_spaceColonizationTheta,
-							m_treeModel.m_treeGrowthSettings.m_spaceColonizationDetectionDistanceFactor, markersPerVoxel);
+						const float loadTime = Times::Now() - loadStartTime;
+						const float envelopeStartTime = Times::Now();
+						ApplyEnvelope(volume, radius, markersPerVoxel);
+						const auto resolution = volume.GetResolution();
+						EVOENGINE_LOG("Envelope: " + std::to_string(resolution.x) + "x" + std::to_string(resolution.y) + "x" + std::to_string(resolution.z)
+							+ " voxels, " + std::to_string(volume.GetOccupiedCount()) + " occupied, loaded in " + std::to_string(loadTime)
+							+ "s, markers placed in " + std::to_string(Times::Now() - envelopeStartTime) + "s");
 					}
-
 					}, false);
 
 				static PrivateComponentRef privateComponentRef{};
@@ -372,31 +315,20 @@ void Tree::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 			if (showSpaceColonizationGrid && needGridUpdate) {
 				auto& occupancyGrid = m_treeModel.m_treeOccupancyGrid;
 				auto& voxelGrid = occupancyGrid.RefGrid();
-				const auto numVoxels = voxelGrid.GetVoxelCount();
 				auto& scalarMatrices = spaceColonizationGridParticleInfoList->m_particleInfos;
-
-				if (scalarMatrices.size() != numVoxels) {
-					scalarMatrices.resize(numVoxels);
-				}
-
-				if (scalarMatrices.size() != numVoxels) {
-					scalarMatrices.reserve(occupancyGrid.GetMarkersPerVoxel() * numVoxels);
-				}
-				int i = 0;
-				for (const auto& voxel : voxelGrid.RefData())
+				const auto& markers = occupancyGrid.PeekMarkers();
+				scalarMatrices.resize(markers.size());
+				for (int i = 0; i < markers.size(); i++)
 				{
-					for (const auto& marker : voxel.m_markers) {
-						scalarMatrices.resize(i + 1);
-						scalarMatrices[i].m_instanceMatrix.m_value =
-							glm::translate(marker.m_position)
-							* glm::mat4_cast(glm::quat(glm::vec3(0.0f)))
-							* glm::scale(glm::vec3(voxelGrid.GetVoxelSize() * 0.2f));
-						if (marker.m_nodeHandle == -1) scalarMatrices[i].m_instanceColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.75f);
-						else
-						{
-							scalarMatrices[i].m_instanceColor = glm::vec4(ecoSysLabLayer->RandomColors()[marker.m_nodeHandle], 1.0f);
-						}
-						i++;
+					const auto& marker = markers[i];
+					scalarMatrices[i].m_instanceMatrix.m_value =
+						glm::translate(marker.m_position)
+						* glm::mat4_cast(glm::quat(glm::vec3(0.0f)))
+						* glm::scale(glm::vec3(voxelGrid.GetVoxelSize() * 0.2f));
+					if (marker.m_nodeHandle == -1) scalarMatrices[i].m_instanceColor = glm::vec4(1.0f, 1.0f, 1.0f, 0.75f);
+					else
+					{
+						scalarMatrices[i].m_instanceColor = glm::vec4(ecoSysLabLayer->RandomColors()[marker.m_nodeHandle], 1.0f);
 					}
 				}
 				spaceColonizationGridParticleInfoList->SetPendingUpdate();
@@ -500,6 +432,28 @@ void Tree::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer) {
 	{
 		PrepareProfiles();
 	}
+	if (ImGui::Button("Benchmark strands"))
+	{
+		//Builds the strands of the current profiles on the workers and on this thread, and checks both give the same points.
+		const auto& pipeGroup = m_treeModel.PeekShootSkeleton().m_data.m_pipeGroup;
+		std::vector<glm::uint> parallelStrands, serialStrands;
+		std::vector<StrandPoint> parallelPoints, serialPoints;
+		float startTime = Times::Now();
+		pipeGroup.BuildStrands(pipeModelParameters.m_controlPointRatio, parallelStrands, parallelPoints, pipeModelParameters.m_triplePoints, pipeModelParameters.m_nodeMaxCount);
+		const float parallelTime = Times::Now() - startTime;
+		startTime = Times::Now();
+		pipeGroup.BuildStrands(pipeModelParameters.m_controlPointRatio, serialStrands, serialPoints, pipeModelParameters.m_triplePoints, pipeModelParameters.m_nodeMaxCount, false);
+		const float serialTime = Times::Now() - startTime;
+		bool identical = parallelStrands == serialStrands && parallelPoints.size() == serialPoints.size();
+		for (size_t i = 0; identical && i < parallelPoints.size(); i++)
+		{
+			identical = parallelPoints[i].m_position == serialPoints[i].m_position && parallelPoints[i].m_thickness == serialPoints[i].m_thickness
+				&& parallelPoints[i].m_color == serialPoints[i].m_color;
+		}
+		EVOENGINE_LOG("Strands: " + std::to_string(parallelStrands.size()) + " strands, " + std::to_string(parallelPoints.size())
+			+ " points, parallel " + std::to_string(parallelTime * 1000.0f) + "ms, serial " + std::to_string(serialTime * 1000.0f)
+			+ "ms, " + (identical ? "identical" : "different"));
+	}
 	if (ImGui::Button("Create StrandsRenderer"))
 	{
 		InitializeStrandRenderer();
@@ -570,6 +524,9 @@ void Tree::OnCreate() {
 
 void Tree::OnDestroy() {
 	m_treeModel.Clear();
+	m_pendingShootSnapshot.Clear();
+	m_shootGrowthTime = 0.0f;
+	m_shootSnapshotDecodeTime = 0.0f;
 	m_treeDescriptor.Clear();
 	m_soil.Clear();
 	m_climate.Clear();
@@ -590,6 +547,12 @@ bool Tree::OnInspectTreeGrowthSettings(TreeGrowthSettings& treeGrowthSettings)
 	{
 		if (ImGui::Checkbox("Space colonization auto resize", &treeGrowthSettings.m_spaceColonizationAutoResize))changed = true;
 	}
+	if (ImGui::Checkbox("Incremental shoot update", &treeGrowthSettings.m_incrementalShootUpdate))changed = true;
+	if (treeGrowthSettings.m_incrementalShootUpdate)
+	{
+		ImGui::Checkbox("Verify incremental shoot update", &treeGrowthSettings.m_verifyIncrementalShootUpdate);
+	}
+	if (ImGui::DragFloat("Sagging tolerance", &treeGrowthSettings.m_saggingTolerance, 0.0001f, 0.0f, 0.1f, "%.4f"))changed = true;
 
 
 	return changed;
@@ -630,6 +593,7 @@ std::shared_ptr<Mesh> Tree::GenerateBranchMesh(const TreeMeshGeneratorSettings&
 		{
 			branchShape = treeDescriptor->m_shootBranchShape.Get<BranchShape>();
 		}
+		const double startTime = Times::Now();
 		meshGenerator.Generate(m_treeModel.PeekShootSkeleton(), vertices, indices, meshGeneratorSettings, [&](float xFactor, float distanceToRoot)
 			{
 				if (branchShape)
@@ -638,6 +602,12 @@ std::shared_ptr<Mesh> Tree::GenerateBranchMesh(const TreeMeshGeneratorSettings&
 				}
 				return 1.0f;
 			});
+		if (meshGeneratorSettings.m_logCylindricalMeshTime)
+		{
+			EVOENGINE_LOG("Cylindrical branch mesh: " + std::to_string(m_treeModel.PeekShootSkeleton().RefSortedNodeList().size()) + " internodes, "
+				+ std::to_string(vertices.size()) + " vertices, " + std::to_string(indices.size() / 3) + " triangles in "
+				+ std::to_string(Times::Now() - startTime) + "s");
+		}
 	}
 	else
 	{
@@ -658,169 +628,85 @@ std::shared_ptr<Mesh> Tree::GenerateBranchMesh(const TreeMeshGeneratorSettings&
 	return mesh;
 }
 
-std::shared_ptr<Mesh> Tree::GenerateFoliageMesh(const TreeMeshGeneratorSettings& meshGeneratorSettings)
+void Tree::GenerateFoliageTransforms(const FoliageParameters& foliageParameters, const bool adjustedTransforms,
+	std::vector<glm::mat4>& leafTransforms) const
 {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-
-	auto quadMesh = Resources::GetResource<Mesh>("PRIMITIVE_QUAD");
-	auto& quadTriangles = quadMesh->UnsafeGetTriangles();
-	auto quadVerticesSize = quadMesh->GetVerticesAmount();
-	size_t offset = 0;
-	auto treeDescriptor = m_treeDescriptor.Get<TreeDescriptor>();
-	const auto& foliageParameters = (!meshGeneratorSettings.m_foliageOverride && treeDescriptor) ? treeDescriptor->m_foliageParameters : meshGeneratorSettings.m_foliageOverrideSettings;
-	const auto& nodeList = m_treeModel.PeekShootSkeleton().RefSortedNodeList();
-	for (const auto& internodeHandle : nodeList) {
-		const auto& internode = m_treeModel.PeekShootSkeleton().PeekNode(internodeHandle);
-		const auto& internodeInfo = internode.m_info;
+	const auto& shootSkeleton = m_treeModel.PeekShootSkeleton();
+	const auto& nodeList = shootSkeleton.RefSortedNodeList();
+	const auto leafCountPerInternode = glm::max(foliageParameters.m_leafCountPerInternode, 0);
+	std::vector<size_t> leafStartIndices(nodeList.size() + 1, 0);
+	for (size_t i = 0; i < nodeList.size(); i++)
+	{
+		const auto& internodeInfo = shootSkeleton.PeekNode(nodeList[i]).m_info;
+		leafStartIndices[i + 1] = leafStartIndices[i];
 		if (internodeInfo.m_thickness < foliageParameters.m_maxNodeThickness
 			&& internodeInfo.m_rootDistance > foliageParameters.m_minRootDistance
-			&& internodeInfo.m_endDistance < foliageParameters.m_maxEndDistance) {
-			for (int i = 0; i < foliageParameters.m_leafCountPerInternode; i++)
+			&& internodeInfo.m_endDistance < foliageParameters.m_maxEndDistance) leafStartIndices[i + 1] += leafCountPerInternode;
+	}
+	leafTransforms.resize(leafStartIndices.back());
+	Jobs::ParallelFor(nodeList.size(), [&](unsigned i)
+		{
+			if (leafStartIndices[i + 1] == leafStartIndices[i]) return;
+			const auto& internode = shootSkeleton.PeekNode(nodeList[i]);
+			const auto& internodeInfo = internode.m_info;
+			//The generator is seeded by the node, so the leaves of a node stay the same no matter how the nodes are scheduled.
+			std::mt19937 random(static_cast<unsigned>(nodeList[i]) * 2654435761u + 1u);
+			std::normal_distribution<float> gaussian(0.0f, 1.0f);
+			std::uniform_real_distribution<float> uniform(0.0f, 360.0f);
+			const auto baseRotation = adjustedTransforms ? internode.m_data.m_adjustedGlobalRotation : internodeInfo.m_globalRotation;
+			const auto basePosition = adjustedTransforms ? internode.m_data.m_adjustedGlobalPosition : internodeInfo.GetGlobalEndPosition();
+			const auto leafSize = foliageParameters.m_leafSize * internode.m_data.m_lightIntensity;
+			for (size_t leafIndex = leafStartIndices[i]; leafIndex < leafStartIndices[i + 1]; leafIndex++)
 			{
-				auto leafSize = foliageParameters.m_leafSize * internode.m_data.m_lightIntensity;
-				glm::quat rotation = internodeInfo.m_globalRotation * glm::quat(glm::radians(glm::vec3(glm::gaussRand(0.0f, foliageParameters.m_rotationVariance), foliageParameters.m_branchingAngle, glm::linearRand(0.0f, 360.0f))));
-				auto front = rotation * glm::vec3(0, 0, -1);
-				auto foliagePosition = internodeInfo.GetGlobalEndPosition() + front * (leafSize.y + glm::gaussRand(0.0f, foliageParameters.m_positionVariance));
-				auto leafTransform = glm::translate(foliagePosition) * glm::mat4_cast(rotation) * glm::scale(glm::vec3(leafSize.x, 1.0f, leafSize.y));
-
-				auto& matrix = leafTransform;
-				Vertex archetype;
-				for (auto i = 0; i < quadMesh->GetVerticesAmount(); i++) {
-					archetype.m_position =
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_position, 1.0f);
-					archetype.m_normal = glm::normalize(glm::vec3(
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_normal, 0.0f)));
-					archetype.m_tangent = glm::normalize(glm::vec3(
-						matrix *
-						glm::vec4(quadMesh->UnsafeGetVertices()[i].m_tangent, 0.0f)));
-					archetype.m_texCoord =
-						quadMesh->UnsafeGetVertices()[i].m_texCoord;
-					vertices.push_back(archetype);
-				}
-				for (auto triangle : quadTriangles) {
-					triangle.x += offset;
-					triangle.y += offset;
-					triangle.z += offset;
-					indices.push_back(triangle.x);
-					indices.push_back(triangle.y);
-					indices.push_back(triangle.z);
-				}
-
-				offset += quadVerticesSize;
-
-
-				for (auto i = 0; i < quadMesh->GetVerticesAmount(); i++) {
-					archetype.m_position =
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_position, 1.0f);
-					archetype.m_normal = glm::normalize(glm::vec3(
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_normal, 0.0f)));
-					archetype.m_tangent = glm::normalize(glm::vec3(
-						matrix *
-						glm::vec4(quadMesh->UnsafeGetVertices()[i].m_tangent, 0.0f)));
-					archetype.m_texCoord =
-						quadMesh->UnsafeGetVertices()[i].m_texCoord;
-					vertices.push_back(archetype);
-				}
-				for (auto triangle : quadTriangles) {
-					triangle.x += offset;
-					triangle.y += offset;
-					triangle.z += offset;
-					indices.push_back(triangle.z);
-					indices.push_back(triangle.y);
-					indices.push_back(triangle.x);
-				}
-				offset += quadVerticesSize;
+				const float rollAngle = gaussian(random) * foliageParameters.m_rotationVariance;
+				const float yawAngle = uniform(random);
+				const glm::quat rotation = baseRotation * glm::quat(glm::radians(glm::vec3(rollAngle, foliageParameters.m_branchingAngle, yawAngle)));
+				const auto front = rotation * glm::vec3(0, 0, -1);
+				const auto foliagePosition = basePosition + front * (leafSize.y + gaussian(random) * foliageParameters.m_positionVariance);
+				leafTransforms[leafIndex] = glm::translate(foliagePosition) * glm::mat4_cast(rotation) * glm::scale(glm::vec3(leafSize.x, 1.0f, leafSize.y));
 			}
 		}
-
-	}
-
-	auto mesh = ProjectManager::CreateTemporaryAsset<Mesh>();
-	VertexAttributes attributes{};
-	attributes.m_texCoord = true;
-	mesh->SetVertices(attributes, vertices, indices);
-	return mesh;
+	);
 }
 
-std::shared_ptr<Mesh> Tree::GeneratePipeModelFoliageMesh(
-	const PipeModelMeshGeneratorSettings& pipeModelMeshGeneratorSettings)
+std::shared_ptr<Mesh> Tree::GenerateFoliageMesh(const std::vector<glm::mat4>& leafTransforms)
 {
-	std::vector<Vertex> vertices;
-	std::vector<unsigned int> indices;
-
-	auto quadMesh = Resources::GetResource<Mesh>("PRIMITIVE_QUAD");
-	auto& quadTriangles = quadMesh->UnsafeGetTriangles();
-	auto quadVerticesSize = quadMesh->GetVerticesAmount();
-	size_t offset = 0;
-	auto treeDescriptor = m_treeDescriptor.Get<TreeDescriptor>();
-	const auto& foliageParameters = pipeModelMeshGeneratorSettings.m_foliageSettings;
-	const auto& nodeList = m_treeModel.PeekShootSkeleton().RefSortedNodeList();
-	for (const auto& internodeHandle : nodeList) {
-		const auto& internode = m_treeModel.PeekShootSkeleton().PeekNode(internodeHandle);
-		const auto& internodeInfo = internode.m_info;
-		if (internodeInfo.m_thickness < foliageParameters.m_maxNodeThickness
-			&& internodeInfo.m_rootDistance > foliageParameters.m_minRootDistance
-			&& internodeInfo.m_endDistance < foliageParameters.m_maxEndDistance) {
-			for (int i = 0; i < foliageParameters.m_leafCountPerInternode; i++)
+	const auto quadMesh = Resources::GetResource<Mesh>("PRIMITIVE_QUAD");
+	const auto& quadVertices = quadMesh->UnsafeGetVertices();
+	const auto& quadTriangles = quadMesh->UnsafeGetTriangles();
+	const auto quadVerticesSize = quadVertices.size();
+	const auto quadTrianglesSize = quadTriangles.size();
+	//Every leaf is the quad twice, the back face shares the vertices of the front face with the winding reversed.
+	std::vector<Vertex> vertices(leafTransforms.size() * quadVerticesSize * 2);
+	std::vector<unsigned int> indices(leafTransforms.size() * quadTrianglesSize * 6);
+	Jobs::ParallelFor(leafTransforms.size(), [&](unsigned leafIndex)
+		{
+			const auto& matrix = leafTransforms[leafIndex];
+			const auto normalMatrix = glm::mat3(matrix);
+			const auto vertexStart = leafIndex * quadVerticesSize * 2;
+			for (size_t i = 0; i < quadVerticesSize; i++)
 			{
-				auto leafSize = foliageParameters.m_leafSize * internode.m_data.m_lightIntensity;
-				glm::quat rotation = internode.m_data.m_adjustedGlobalRotation * glm::quat(glm::radians(glm::vec3(glm::gaussRand(0.0f, foliageParameters.m_rotationVariance), foliageParameters.m_branchingAngle, glm::linearRand(0.0f, 360.0f))));
-				auto front = rotation * glm::vec3(0, 0, -1);
-				auto foliagePosition = internode.m_data.m_adjustedGlobalPosition + front * (leafSize.y + glm::gaussRand(0.0f, foliageParameters.m_positionVariance));
-				auto leafTransform = glm::translate(foliagePosition) * glm::mat4_cast(rotation) * glm::scale(glm::vec3(leafSize.x, 1.0f, leafSize.y));
-
-				auto& matrix = leafTransform;
-				Vertex archetype;
-				for (auto i = 0; i < quadMesh->GetVerticesAmount(); i++) {
-					archetype.m_position =
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_position, 1.0f);
-					archetype.m_normal = glm::normalize(glm::vec3(
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_normal, 0.0f)));
-					archetype.m_tangent = glm::normalize(glm::vec3(
-						matrix *
-						glm::vec4(quadMesh->UnsafeGetVertices()[i].m_tangent, 0.0f)));
-					archetype.m_texCoord =
-						quadMesh->UnsafeGetVertices()[i].m_texCoord;
-					vertices.push_back(archetype);
-				}
-				for (auto triangle : quadTriangles) {
-					triangle.x += offset;
-					triangle.y += offset;
-					triangle.z += offset;
-					indices.push_back(triangle.x);
-					indices.push_back(triangle.y);
-					indices.push_back(triangle.z);
-				}
-
-				offset += quadVerticesSize;
-
-
-				for (auto i = 0; i < quadMesh->GetVerticesAmount(); i++) {
-					archetype.m_position =
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_position, 1.0f);
-					archetype.m_normal = glm::normalize(glm::vec3(
-						matrix * glm::vec4(quadMesh->UnsafeGetVertices()[i].m_normal, 0.0f)));
-					archetype.m_tangent = glm::normalize(glm::vec3(
-						matrix *
-						glm::vec4(quadMesh->UnsafeGetVertices()[i].m_tangent, 0.0f)));
-					archetype.m_texCoord =
-						quadMesh->UnsafeGetVertices()[i].m_texCoord;
-					vertices.push_back(archetype);
-				}
-				for (auto triangle : quadTriangles) {
-					triangle.x += offset;
-					triangle.y += offset;
-					triangle.z += offset;
-					indices.push_back(triangle.z);
-					indices.push_back(triangle.y);
-					indices.push_back(triangle.x);
-				}
-				offset += quadVerticesSize;
+				auto& vertex = vertices[vertexStart + i];
+				vertex.m_position = matrix * glm::vec4(quadVertices[i].m_position, 1.0f);
+				vertex.m_normal = glm::normalize(normalMatrix * quadVertices[i].m_normal);
+				vertex.m_tangent = glm::normalize(normalMatrix * quadVertices[i].m_tangent);
+				vertex.m_texCoord = quadVertices[i].m_texCoord;
+				vertices[vertexStart + quadVerticesSize + i] = vertex;
+			}
+			const auto indexStart = leafIndex * quadTrianglesSize * 6;
+			const auto backIndexStart = indexStart + quadTrianglesSize * 3;
+			for (size_t i = 0; i < quadTrianglesSize; i++)
+			{
+				const auto& triangle = quadTriangles[i];
+				indices[indexStart + i * 3] = vertexStart + triangle.x;
+				indices[indexStart + i * 3 + 1] = vertexStart + triangle.y;
+				indices[indexStart + i * 3 + 2] = vertexStart + triangle.z;
+				indices[backIndexStart + i * 3] = vertexStart + quadVerticesSize + triangle.z;
+				indices[backIndexStart + i * 3 + 1] = vertexStart + quadVerticesSize + triangle.y;
+				indices[backIndexStart + i * 3 + 2] = vertexStart + quadVerticesSize + triangle.x;
 			}
 		}
-
-	}
+	);
 
 	auto mesh = ProjectManager::CreateTemporaryAsset<Mesh>();
 	VertexAttributes attributes{};
@@ -829,6 +715,23 @@ std::shared_ptr<Mesh> Tree::GeneratePipeModelFoliageMesh(
 	return mesh;
 }
 
+std::shared_ptr<Mesh> Tree::GenerateFoliageMesh(const TreeMeshGeneratorSettings& meshGeneratorSettings)
+{
+	const auto treeDescriptor = m_treeDescriptor.Get<TreeDescriptor>();
+	const auto& foliageParameters = (!meshGeneratorSettings.m_foliageOverride && treeDescriptor) ? treeDescriptor->m_foliageParameters : meshGeneratorSettings.m_foliageOverrideSettings;
+	std::vector<glm::mat4> leafTransforms;
+	GenerateFoliageTransforms(foliageParameters, false, leafTransforms);
+	return GenerateFoliageMesh(leafTransforms);
+}
+
+std::shared_ptr<Mesh> Tree::GeneratePipeModelFoliageMesh(
+	const PipeModelMeshGeneratorSettings& pipeModelMeshGeneratorSettings)
+{
+	std::vector<glm::mat4> leafTransforms;
+	GenerateFoliageTransforms(pipeModelMeshGeneratorSettings.m_foliageSettings, true, leafTransforms);
+	return GenerateFoliageMesh(leafTransforms);
+}
+
 std::shared_ptr<Mesh> Tree::GeneratePipeModelBranchMesh(const PipeModelMeshGeneratorSettings& treePipeMeshGeneratorSettings)
 {
 	m_treeModel.CalculatePipeProfileAdjustedTransforms(m_pipeModelParameters);
@@ -966,7 +869,7 @@ void Tree::ExportOBJ(const std::filesystem::path& path, const TreeMeshGeneratorS
 	}
 }
 
-bool Tree::TryGrow(const float deltaTime, const NodeHandle baseInternodeHandle, const bool pruning, const float overrideGrowthRate) {
+bool Tree::TryGrow(const float deltaTime, const NodeHandle baseInternodeHandle, const bool pruning, const float overrideGrowthRate, const bool parallel) {
 	const auto scene = GetScene();
 	const auto treeDescriptor = m_treeDescriptor.Get<TreeDescriptor>();
 	const auto ecoSysLabLayer = Application::GetLayer<EcoSysLabLayer>();
@@ -999,6 +902,13 @@ bool Tree::TryGrow(const float deltaTime, const NodeHandle baseInternodeHandle,
 		return false;
 	}
 
+	//Loading the snapshot resets the visualizer and logs, a tree grown from a job is loaded on the main thread beforehand.
+	if (parallel)
+	{
+		if (!LoadShootSnapshot()) return false;
+	}
+	else if (!m_pendingShootSnapshot.Empty()) return false;
+	const float startTime = Times::Now();
 	const auto owner = GetOwner();
 	PrepareControllers(treeDescriptor);
 	const bool grown = m_treeModel.Grow(deltaTime, baseInternodeHandle, scene->GetDataComponent<GlobalTransform>(owner).m_value, climate->m_climateModel, m_shootGrowthController, pruning, overrideGrowthRate);
@@ -1007,19 +917,197 @@ bool Tree::TryGrow(const float deltaTime, const NodeHandle baseInternodeHandle,
 		if (pruning) m_treeVisualizer.ClearSelections();
 		m_treeVisualizer.m_needUpdate = true;
 	}
-	if (m_enableHistory && m_treeModel.m_iteration % m_historyIteration == 0) m_treeModel.Step();
+	if (m_enableHistory && m_treeModel.m_iteration % m_historyIteration == 0) m_treeModel.Step(parallel);
 	if (m_recordBiomassHistory)
 	{
 		const auto& baseShootNode = m_treeModel.RefShootSkeleton().RefNode(0);
 		m_shootBiomassHistory.emplace_back(baseShootNode.m_data.m_biomass + baseShootNode.m_data.m_descendentTotalBiomass);
 	}
+	m_shootGrowthTime += Times::Now() - startTime;
 	return grown;
 }
 
+bool Tree::LoadShootSnapshot()
+{
+	if (m_pendingShootSnapshot.Empty()) return true;
+	const float startTime = Times::Now();
+	const bool decoded = m_pendingShootSnapshot.Decode(m_treeModel.m_shootSkeleton);
+	m_shootSnapshotDecodeTime = Times::Now() - startTime;
+	const auto snapshotSize = m_pendingShootSnapshot.GetSize();
+	m_pendingShootSnapshot.Clear();
+	if (!decoded)
+	{
+		Reset();
+		return false;
+	}
+	m_treeModel.m_initialized = true;
+	m_treeModel.m_postProcessedChangeVersion = -1;
+	m_treeModel.RecountShoot();
+	m_treeVisualizer.Reset(m_treeModel);
+	EVOENGINE_LOG("Tree: loaded " + std::to_string(m_treeModel.m_shootSkeleton.RefSortedNodeList().size()) + " internodes from "
+		+ std::to_string(snapshotSize / 1024) + " KB in " + std::to_string(m_shootSnapshotDecodeTime) + "s, growing them took "
+		+ std::to_string(m_shootGrowthTime) + "s");
+	return true;
+}
+
+static int CountShootMismatches(const ShootSkeleton& expected, const ShootSkeleton& actual, const float tolerance, NodeHandle& firstMismatch)
+{
+	firstMismatch = -1;
+	const auto& sortedInternodeList = expected.RefSortedNodeList();
+	if (sortedInternodeList != actual.RefSortedNodeList())
+	{
+		firstMismatch = 0;
+		return static_cast<int>(sortedInternodeList.size());
+	}
+	const auto close = [&](const float a, const float b) { return glm::abs(a - b) <= tolerance; };
+	int mismatchCount = 0;
+	for (const auto& internodeHandle : sortedInternodeList)
+	{
+		const auto& e = expected.PeekNode(internodeHandle);
+		const auto& a = actual.PeekNode(internodeHandle);
+		if (e.GetParentHandle() == a.GetParentHandle()
+			&& e.GetFlowHandle() == a.GetFlowHandle()
+			&& e.RefChildHandles() == a.RefChildHandles()
+			&& e.IsEndNode() == a.IsEndNode()
+			&& e.IsApical() == a.IsApical()
+			&& glm::distance(e.m_info.m_globalPosition, a.m_info.m_globalPosition) <= tolerance
+			&& glm::abs(glm::dot(e.m_info.m_globalRotation, a.m_info.m_globalRotation)) >= 1.0f - tolerance
+			&& close(e.m_info.m_length, a.m_info.m_length)
+			&& e.m_info.m_thickness == a.m_info.m_thickness
+			&& close(e.m_data.m_internodeLength, a.m_data.m_internodeLength)
+			&& e.m_data.m_biomass == a.m_data.m_biomass
+			&& e.m_data.m_level == a.m_data.m_level
+			&& e.m_data.m_buds.size() == a.m_data.m_buds.size()) continue;
+		if (firstMismatch == -1) firstMismatch = internodeHandle;
+		mismatchCount++;
+	}
+	return mismatchCount;
+}
+
+bool Tree::VerifyShootSnapshotRoundTrip()
+{
+	if (!LoadShootSnapshot() || !m_treeModel.m_initialized)
+	{
+		EVOENGINE_ERROR("Tree: there is no shoot to round trip!");
+		return false;
+	}
+	const auto& skeleton = m_treeModel.m_shootSkeleton;
+	const auto internodeCount = std::to_string(skeleton.RefSortedNodeList().size());
+	bool matched = true;
+	NodeHandle firstMismatch = -1;
+	const auto report = [&](const std::string& path, const int mismatchCount)
+		{
+			if (mismatchCount == 0) return;
+			matched = false;
+			EVOENGINE_ERROR("Tree: " + path + " differs at " + std::to_string(mismatchCount) + " of " + internodeCount
+				+ " internodes, first at handle " + std::to_string(firstMismatch));
+		};
+
+	//The saved shoot is quantized on request, the history is always lossless.
+	YAML::Emitter out;
+	out << YAML::BeginMap;
+	Serialize(out);
+	out << YAML::EndMap;
+	const auto loadedTree = std::make_shared<Tree>();
+	loadedTree->Deserialize(YAML::Load(out.c_str()));
+	ShootSkeleton loadedSkeleton{};
+	//Decode and Reverse log their own errors.
+	if (!loadedTree->m_pendingShootSnapshot.Decode(loadedSkeleton)) matched = false;
+	else report("Serialize and Deserialize", CountShootMismatches(skeleton, loadedSkeleton, m_quantizeShootSnapshot ? 1e-3f : 0.0f, firstMismatch));
+	if (loadedTree->m_treeModel.m_iteration != m_treeModel.m_iteration || loadedTree->m_treeModel.m_currentSeedValue != m_treeModel.m_currentSeedValue)
+	{
+		matched = false;
+		EVOENGINE_ERROR("Tree: Serialize and Deserialize lose the iteration or the seed");
+	}
+
+	//The checkpoint is peeked first, so Reverse restores it from the cache, then it is reversed again from the snapshot.
+	TreeModel checkpointModel{};
+	checkpointModel.m_shootSkeleton = skeleton;
+	checkpointModel.m_initialized = true;
+	checkpointModel.Step();
+	checkpointModel.Step();
+	checkpointModel.m_shootSkeleton = {};
+	report("PeekShootSkeleton", CountShootMismatches(skeleton, checkpointModel.PeekShootSkeleton(1), 0.0f, firstMismatch));
+	if (!checkpointModel.Reverse(1)) matched = false;
+	else report("Step and Reverse from the cache", CountShootMismatches(skeleton, checkpointModel.m_shootSkeleton, 0.0f, firstMismatch));
+	checkpointModel.m_shootSkeleton = {};
+	if (!checkpointModel.Reverse(0)) matched = false;
+	else report("Step and Reverse", CountShootMismatches(skeleton, checkpointModel.m_shootSkeleton, 0.0f, firstMismatch));
+	if (checkpointModel.GetInternodeCount() != m_treeModel.GetInternodeCount())
+	{
+		matched = false;
+		EVOENGINE_ERROR("Tree: Reverse counts " + std::to_string(checkpointModel.GetInternodeCount()) + " internodes instead of "
+			+ std::to_string(m_treeModel.GetInternodeCount()));
+	}
+	if (matched) EVOENGINE_LOG("Tree: the shoot round trips through Serialize, Deserialize, Step and Reverse on " + internodeCount + " internodes");
+	return matched;
+}
+
+void Tree::CompareShootLoadWithRegrowth()
+{
+	const auto treeDescriptor = m_treeDescriptor.Get<TreeDescriptor>();
+	const auto climate = m_climate.Get<Climate>();
+	const auto ecoSysLabLayer = Application::GetLayer<EcoSysLabLayer>();
+	if (!LoadShootSnapshot() || !m_treeModel.m_initialized || !treeDescriptor || !climate || !ecoSysLabLayer)
+	{
+		EVOENGINE_ERROR("Tree: a grown shoot, a tree descriptor and a climate are needed to compare loading with regrowing!");
+		return;
+	}
+	ShootSkeletonSnapshot snapshot{};
+	snapshot.Encode(m_treeModel.m_shootSkeleton, m_quantizeShootSnapshot);
+	ShootSkeleton loadedSkeleton{};
+	const float loadStartTime = Times::Now();
+	if (!snapshot.Decode(loadedSkeleton)) return;
+	const float loadTime = Times::Now() - loadStartTime;
+
+	//The tree regrows in a copy of the climate so the scene is left untouched. The climate and the neighbours may have changed
+	//since the tree grew, so the regrown shoot is comparable in cost but not in shape.
+	ClimateModel climateModel = climate->m_climateModel;
+	ShootGrowthController shootGrowthController{};
+	PrepareControllers(treeDescriptor, climateModel, shootGrowthController);
+	TreeModel regrownModel{};
+	regrownModel.m_seed = m_treeModel.m_seed;
+	regrownModel.m_treeGrowthSettings = m_treeModel.m_treeGrowthSettings;
+	regrownModel.m_treeGrowthSettings.m_verifyIncrementalShootUpdate = false;
+	const auto globalTransform = GetScene()->GetDataComponent<GlobalTransform>(GetOwner()).m_value;
+	const float regrowStartTime = Times::Now();
+	for (int i = 0; i < m_treeModel.m_iteration; i++)
+	{
+		regrownModel.Grow(ecoSysLabLayer->m_simulationSettings.m_deltaTime, 0, globalTransform, climateModel, shootGrowthController);
+	}
+	const float regrowTime = Times::Now() - regrowStartTime;
+	EVOENGINE_LOG("Tree: loading " + std::to_string(m_treeModel.m_shootSkeleton.RefSortedNodeList().size()) + " internodes from "
+		+ std::to_string(snapshot.GetSize() / 1024) + " KB took " + std::to_string(loadTime) + "s, regrowing "
+		+ std::to_string(m_treeModel.m_iteration) + " iterations from the descriptor took " + std::to_string(regrowTime) + "s for "
+		+ std::to_string(regrownModel.GetInternodeCount()) + " internodes");
+}
+
 
 void Tree::Serialize(YAML::Emitter& out)
 {
 	m_treeDescriptor.Save("m_treeDescriptor", out);
+	out << YAML::Key << "m_enableHistory" << YAML::Value << m_enableHistory;
+	out << YAML::Key << "m_historyIteration" << YAML::Value << m_historyIteration;
+	out << YAML::Key << "m_quantizeShootSnapshot" << YAML::Value << m_quantizeShootSnapshot;
+	out << YAML::Key << "m_treeGrowthSettings" << YAML::Value << YAML::BeginMap;
+	SerializeTreeGrowthSettings(m_treeModel.m_treeGrowthSettings, out);
+	out << YAML::EndMap;
+	out << YAML::Key << "m_seed" << YAML::Value << m_treeModel.m_seed;
+	if (m_pendingShootSnapshot.Empty() && !m_treeModel.m_initialized) return;
+	//A tree that is not loaded yet saves the snapshot it is loaded with.
+	ShootSkeletonSnapshot encodedSnapshot{};
+	if (m_pendingShootSnapshot.Empty()) encodedSnapshot.Encode(m_treeModel.m_shootSkeleton, m_quantizeShootSnapshot);
+	const auto& snapshot = m_pendingShootSnapshot.Empty() ? encodedSnapshot : m_pendingShootSnapshot;
+	out << YAML::Key << "m_shootSnapshot" << YAML::Value
+		<< YAML::Binary(snapshot.RefBytes().data(), snapshot.RefBytes().size());
+	out << YAML::Key << "m_shootGrowthTime" << YAML::Value << m_shootGrowthTime;
+	out << YAML::Key << "m_iteration" << YAML::Value << m_treeModel.m_iteration;
+	out << YAML::Key << "m_age" << YAML::Value << m_treeModel.m_age;
+	out << YAML::Key << "m_ageInYear" << YAML::Value << m_treeModel.m_ageInYear;
+	out << YAML::Key << "m_currentSeedValue" << YAML::Value << m_treeModel.m_currentSeedValue;
+	out << YAML::Key << "m_leafCount" << YAML::Value << m_treeModel.m_leafCount;
+	out << YAML::Key << "m_fruitCount" << YAML::Value << m_treeModel.m_fruitCount;
+	out << YAML::Key << "m_twigCount" << YAML::Value << m_treeModel.m_twigCount;
 }
 
 
@@ -1027,10 +1115,29 @@ void Tree::Serialize(YAML::Emitter& out)
 void Tree::Deserialize(const YAML::Node& in)
 {
 	m_treeDescriptor.Load("m_treeDescriptor", in);
+	if (in["m_enableHistory"]) m_enableHistory = in["m_enableHistory"].as<bool>();
+	if (in["m_historyIteration"]) m_historyIteration = in["m_historyIteration"].as<int>();
+	if (in["m_quantizeShootSnapshot"]) m_quantizeShootSnapshot = in["m_quantizeShootSnapshot"].as<bool>();
+	if (in["m_treeGrowthSettings"]) DeserializeTreeGrowthSettings(m_treeModel.m_treeGrowthSettings, in["m_treeGrowthSettings"]);
+	if (in["m_seed"]) m_treeModel.m_seed = in["m_seed"].as<int>();
+	m_pendingShootSnapshot.Clear();
+	if (!in["m_shootSnapshot"]) return;
+	//The shoot is decoded when the tree is first used.
+	const auto snapshot = in["m_shootSnapshot"].as<YAML::Binary>();
+	m_pendingShootSnapshot.SetBytes(snapshot.data(), snapshot.size());
+	if (in["m_shootGrowthTime"]) m_shootGrowthTime = in["m_shootGrowthTime"].as<float>();
+	if (in["m_iteration"]) m_treeModel.m_iteration = in["m_iteration"].as<int>();
+	if (in["m_age"]) m_treeModel.m_age = in["m_age"].as<float>();
+	if (in["m_ageInYear"]) m_treeModel.m_ageInYear = in["m_ageInYear"].as<int>();
+	if (in["m_currentSeedValue"]) m_treeModel.m_currentSeedValue = in["m_currentSeedValue"].as<int>();
+	if (in["m_leafCount"]) m_treeModel.m_leafCount = in["m_leafCount"].as<int>();
+	if (in["m_fruitCount"]) m_treeModel.m_fruitCount = in["m_fruitCount"].as<int>();
+	if (in["m_twigCount"]) m_treeModel.m_twigCount = in["m_twigCount"].as<int>();
 }
 
-void Tree::ClearMeshRenderer() const
+void Tree::ClearMeshRenderer()
 {
+	m_meshIteration = m_meshChangeVersion = -1;
 	const auto scene = GetScene();
 	const auto self = GetOwner();
 	const auto children = scene->GetChildren(self);
@@ -1051,6 +1158,11 @@ void Tree::ClearMeshRenderer() const
 	}
 }
 
+bool Tree::IsMeshUpToDate() const
+{
+	return m_meshIteration == m_treeModel.CurrentIteration() && m_meshChangeVersion == m_treeModel.PeekShootSkeleton().GetChangeVersion();
+}
+
 void Tree::ClearTwigsStrandRenderer() const
 {
 	const auto scene = GetScene();
@@ -1081,6 +1193,7 @@ void Tree::ClearStrandRenderer() const
 }
 
 void Tree::InitializeMeshRenderer(const TreeMeshGeneratorSettings& meshGeneratorSettings, int iteration) {
+	LoadShootSnapshot();
 	const auto scene = GetScene();
 	const auto self = GetOwner();
 	const auto children = scene->GetChildren(self);
@@ -1092,6 +1205,11 @@ void Tree::InitializeMeshRenderer(const TreeMeshGeneratorSettings& meshGenerator
 	{
 		actualIteration = m_treeModel.CurrentIteration();
 	}
+	if (actualIteration == m_treeModel.CurrentIteration())
+	{
+		m_meshIteration = actualIteration;
+		m_meshChangeVersion = m_treeModel.PeekShootSkeleton().GetChangeVersion();
+	}
 	if (meshGeneratorSettings.m_enableBranch)
 	{
 		Entity branchEntity;
@@ -1273,7 +1391,6 @@ void Tree::InitializeMeshRenderer(const TreeMeshGeneratorSettings& meshGenerator
 		foliageEntity = scene->CreateEntity("Foliage Mesh");
 		scene->SetParent(foliageEntity, self);
 
-		auto mesh = GenerateFoliageMesh(meshGeneratorSettings);
 		auto material = ProjectManager::CreateTemporaryAsset<Material>();
 		VertexAttributes vertexAttributes{};
 		vertexAttributes.m_texCoord = true;
@@ -1335,9 +1452,28 @@ void Tree::InitializeMeshRenderer(const TreeMeshGeneratorSettings& meshGenerator
 		}
 		material->m_materialProperties.m_roughness = 1.0f;
 		material->m_materialProperties.m_metallic = 0.0f;
-		auto meshRenderer = scene->GetOrSetPrivateComponent<MeshRenderer>(foliageEntity).lock();
-		meshRenderer->m_mesh = mesh;
-		meshRenderer->m_material = material;
+		if (meshGeneratorSettings.m_foliageInstancing)
+		{
+			const auto& foliageParameters = (!meshGeneratorSettings.m_foliageOverride && treeDescriptor) ? treeDescriptor->m_foliageParameters : meshGeneratorSettings.m_foliageOverrideSettings;
+			std::vector<glm::mat4> leafTransforms;
+			GenerateFoliageTransforms(foliageParameters, false, leafTransforms);
+			const auto particleInfoList = ProjectManager::CreateTemporaryAsset<ParticleInfoList>();
+			particleInfoList->m_particleInfos.resize(leafTransforms.size());
+			for (size_t i = 0; i < leafTransforms.size(); i++)
+			{
+				particleInfoList->m_particleInfos[i].m_instanceMatrix.m_value = leafTransforms[i];
+			}
+			particleInfoList->SetPendingUpdate();
+			const auto particles = scene->GetOrSetPrivateComponent<Particles>(foliageEntity).lock();
+			particles->m_mesh = GenerateFoliageMesh(std::vector<glm::mat4>{ glm::mat4(1.0f) });
+			particles->m_material = material;
+			particles->m_particleInfoList = particleInfoList;
+		}
+		else {
+			auto meshRenderer = scene->GetOrSetPrivateComponent<MeshRenderer>(foliageEntity).lock();
+			meshRenderer->m_mesh = GenerateFoliageMesh(meshGeneratorSettings);
+			meshRenderer->m_material = material;
+		}
 
 	}
 	if (meshGeneratorSettings.m_enableFruit)
@@ -1405,13 +1541,13 @@ void Tree::InitializeMeshRenderer(const TreeMeshGeneratorSettings& meshGenerator
 	}
 }
 
-void Tree::RegisterVoxel()
+void Tree::RegisterVoxel(EnvironmentGridBuffer& buffer, const bool registerNodes)
 {
 	const auto scene = GetScene();
 	const auto owner = GetOwner();
 	const auto globalTransform = scene->GetDataComponent<GlobalTransform>(owner).m_value;
 	m_treeModel.m_index = owner.GetIndex();
-	m_treeModel.RegisterVoxel(globalTransform, m_climate.Get<Climate>()->m_climateModel, m_shootGrowthController);
+	m_treeModel.RegisterVoxel(globalTransform, m_climate.Get<Climate>()->m_climateModel, m_shootGrowthController, buffer, registerNodes);
 }
 
 void Tree::FromLSystemString(const std::shared_ptr<LSystemString>& lSystemString)
@@ -1748,32 +1884,38 @@ void SkeletalGraphSettings::OnInspect()
 
 void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescriptor)
 {
-	const auto soil = m_soil.Get<Soil>();
 	const auto climate = m_climate.Get<Climate>();
+	PrepareControllers(treeDescriptor, climate->m_climateModel, m_shootGrowthController);
+}
+
+void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescriptor, const ClimateModel& climateModel,
+	ShootGrowthController& shootGrowthController)
+{
+	const auto climate = &climateModel;
 	{
-		m_shootGrowthController.m_internodeGrowthRate = treeDescriptor->m_shootGrowthParameters.m_growthRate / treeDescriptor->m_shootGrowthParameters.m_internodeLength;
+		shootGrowthController.m_internodeGrowthRate = treeDescriptor->m_shootGrowthParameters.m_growthRate / treeDescriptor->m_shootGrowthParameters.m_internodeLength;
 
-		m_shootGrowthController.m_branchingAngle = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_branchingAngle = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return glm::gaussRand(treeDescriptor->m_shootGrowthParameters.m_branchingAngleMeanVariance.x, treeDescriptor->m_shootGrowthParameters.m_branchingAngleMeanVariance.y);
 			};
-		m_shootGrowthController.m_rollAngle = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_rollAngle = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return glm::gaussRand(treeDescriptor->m_shootGrowthParameters.m_rollAngleMeanVariance.x, treeDescriptor->m_shootGrowthParameters.m_rollAngleMeanVariance.y);
 			};
-		m_shootGrowthController.m_apicalAngle = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_apicalAngle = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return glm::gaussRand(0.0f, treeDescriptor->m_shootGrowthParameters.m_apicalAngleVariance);
 			};
-		m_shootGrowthController.m_gravitropism = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_gravitropism = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return treeDescriptor->m_shootGrowthParameters.m_gravitropism;
 			};
-		m_shootGrowthController.m_phototropism = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_phototropism = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return treeDescriptor->m_shootGrowthParameters.m_phototropism;
 			};
-		m_shootGrowthController.m_sagging = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_sagging = [=](const Node<InternodeGrowthData>& internode)
 			{
 				const auto& shootGrowthParameters = treeDescriptor->m_shootGrowthParameters;
 				const auto newSagging = glm::min(
@@ -1786,15 +1928,16 @@ void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescrip
 						shootGrowthParameters.m_saggingFactorThicknessReductionMax.y));
 				return glm::max(internode.m_data.m_sagging, newSagging);
 			};
-		m_shootGrowthController.m_internodeLength = treeDescriptor->m_shootGrowthParameters.m_internodeLength;
-		m_shootGrowthController.m_internodeLengthThicknessFactor = treeDescriptor->m_shootGrowthParameters.m_internodeLengthThicknessFactor;
-		m_shootGrowthController.m_endNodeThickness = treeDescriptor->m_shootGrowthParameters.m_endNodeThickness;
-		m_shootGrowthController.m_thicknessAccumulationFactor = treeDescriptor->m_shootGrowthParameters.m_thicknessAccumulationFactor;
-		m_shootGrowthController.m_thicknessAccumulateAgeFactor = treeDescriptor->m_shootGrowthParameters.m_thicknessAccumulateAgeFactor;
-		m_shootGrowthController.m_internodeShadowFactor = treeDescriptor->m_shootGrowthParameters.m_internodeShadowFactor;
-
-		m_shootGrowthController.m_lateralBudCount = treeDescriptor->m_shootGrowthParameters.m_lateralBudCount;
-		m_shootGrowthController.m_budExtinctionRate = [=](const Node<InternodeGrowthData>& internode, Bud& bud)
+		shootGrowthController.m_saggingFactorThicknessReductionMax = treeDescriptor->m_shootGrowthParameters.m_saggingFactorThicknessReductionMax;
+		shootGrowthController.m_internodeLength = treeDescriptor->m_shootGrowthParameters.m_internodeLength;
+		shootGrowthController.m_internodeLengthThicknessFactor = treeDescriptor->m_shootGrowthParameters.m_internodeLengthThicknessFactor;
+		shootGrowthController.m_endNodeThickness = treeDescriptor->m_shootGrowthParameters.m_endNodeThickness;
+		shootGrowthController.m_thicknessAccumulationFactor = treeDescriptor->m_shootGrowthParameters.m_thicknessAccumulationFactor;
+		shootGrowthController.m_thicknessAccumulateAgeFactor = treeDescriptor->m_shootGrowthParameters.m_thicknessAccumulateAgeFactor;
+		shootGrowthController.m_internodeShadowFactor = treeDescriptor->m_shootGrowthParameters.m_internodeShadowFactor;
+
+		shootGrowthController.m_lateralBudCount = treeDescriptor->m_shootGrowthParameters.m_lateralBudCount;
+		shootGrowthController.m_budExtinctionRate = [=](const Node<InternodeGrowthData>& internode, Bud& bud)
 			{
 				const auto& shootGrowthParameters = treeDescriptor->m_shootGrowthParameters;
 				bud.m_extinctionRate = 0.0f;
@@ -1806,7 +1949,7 @@ void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescrip
 					bud.m_extinctionRate = 0.0f;
 				}
 			};
-		m_shootGrowthController.m_budFlushingRate = [=](const Node<InternodeGrowthData>& internode, Bud& bud)
+		shootGrowthController.m_budFlushingRate = [=](const Node<InternodeGrowthData>& internode, Bud& bud)
 			{
 				const auto& shootGrowthParameters = treeDescriptor->m_shootGrowthParameters;
 				bud.m_flushingRate = 1.0f;
@@ -1822,17 +1965,17 @@ void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescrip
 					if (internode.m_data.m_inhibitorSink > 0.0f) bud.m_flushingRate *= glm::exp(-internode.m_data.m_inhibitorSink);
 				}
 			};
-		m_shootGrowthController.m_pipeResistance = treeDescriptor->m_shootGrowthParameters.m_pipeResistance;
-		m_shootGrowthController.m_apicalControl = treeDescriptor->m_shootGrowthParameters.m_apicalControl;
-		m_shootGrowthController.m_apicalDominance = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_pipeResistance = treeDescriptor->m_shootGrowthParameters.m_pipeResistance;
+		shootGrowthController.m_apicalControl = treeDescriptor->m_shootGrowthParameters.m_apicalControl;
+		shootGrowthController.m_apicalDominance = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return treeDescriptor->m_shootGrowthParameters.m_apicalDominance * internode.m_data.m_lightIntensity;
 			};
-		m_shootGrowthController.m_apicalDominanceLoss = treeDescriptor->m_shootGrowthParameters.m_apicalDominanceLoss;
+		shootGrowthController.m_apicalDominanceLoss = treeDescriptor->m_shootGrowthParameters.m_apicalDominanceLoss;
 
-		m_shootGrowthController.m_lowBranchPruning = treeDescriptor->m_shootGrowthParameters.m_lowBranchPruning;
-		m_shootGrowthController.m_lowBranchPruningThicknessFactor = treeDescriptor->m_shootGrowthParameters.m_lowBranchPruningThicknessFactor;
-		m_shootGrowthController.m_pruningFactor = [=](const float deltaTime, const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_lowBranchPruning = treeDescriptor->m_shootGrowthParameters.m_lowBranchPruning;
+		shootGrowthController.m_lowBranchPruningThicknessFactor = treeDescriptor->m_shootGrowthParameters.m_lowBranchPruningThicknessFactor;
+		shootGrowthController.m_pruningFactor = [=](const float deltaTime, const Node<InternodeGrowthData>& internode)
 			{
 				float pruningProbability = 0.0f;
 				if (internode.IsEndNode() && internode.m_data.m_lightIntensity == 0.0f)
@@ -1848,13 +1991,13 @@ void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescrip
 			};
 
 
-		m_shootGrowthController.m_leafGrowthRate = treeDescriptor->m_shootGrowthParameters.m_leafGrowthRate;
-		m_shootGrowthController.m_fruitGrowthRate = treeDescriptor->m_shootGrowthParameters.m_fruitGrowthRate;
+		shootGrowthController.m_leafGrowthRate = treeDescriptor->m_shootGrowthParameters.m_leafGrowthRate;
+		shootGrowthController.m_fruitGrowthRate = treeDescriptor->m_shootGrowthParameters.m_fruitGrowthRate;
 
-		m_shootGrowthController.m_fruitBudCount = treeDescriptor->m_shootGrowthParameters.m_fruitBudCount;
-		m_shootGrowthController.m_leafBudCount = treeDescriptor->m_shootGrowthParameters.m_leafBudCount;
+		shootGrowthController.m_fruitBudCount = treeDescriptor->m_shootGrowthParameters.m_fruitBudCount;
+		shootGrowthController.m_leafBudCount = treeDescriptor->m_shootGrowthParameters.m_leafBudCount;
 
-		m_shootGrowthController.m_leafBudFlushingProbability = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_leafBudFlushingProbability = [=](const Node<InternodeGrowthData>& internode)
 			{
 				const auto& shootGrowthParameters = treeDescriptor->m_shootGrowthParameters;
 				const auto& internodeData = internode.m_data;
@@ -1864,7 +2007,7 @@ void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescrip
 				flushProbability *= internodeData.m_lightIntensity;
 				return flushProbability;
 			};
-		m_shootGrowthController.m_fruitBudFlushingProbability = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_fruitBudFlushingProbability = [=](const Node<InternodeGrowthData>& internode)
 			{
 				const auto& shootGrowthParameters = treeDescriptor->m_shootGrowthParameters;
 				const auto& internodeData = internode.m_data;
@@ -1875,40 +2018,40 @@ void Tree::PrepareControllers(const std::shared_ptr<TreeDescriptor>& treeDescrip
 				return flushProbability;
 			};
 
-		m_shootGrowthController.m_leafVigorRequirement = treeDescriptor->m_shootGrowthParameters.m_leafVigorRequirement;
-		m_shootGrowthController.m_fruitVigorRequirement = treeDescriptor->m_shootGrowthParameters.m_fruitVigorRequirement;
+		shootGrowthController.m_leafVigorRequirement = treeDescriptor->m_shootGrowthParameters.m_leafVigorRequirement;
+		shootGrowthController.m_fruitVigorRequirement = treeDescriptor->m_shootGrowthParameters.m_fruitVigorRequirement;
 
 
 
-		m_shootGrowthController.m_maxLeafSize = treeDescriptor->m_shootGrowthParameters.m_maxLeafSize;
-		m_shootGrowthController.m_leafPositionVariance = treeDescriptor->m_shootGrowthParameters.m_leafPositionVariance;
-		m_shootGrowthController.m_leafRotationVariance = treeDescriptor->m_shootGrowthParameters.m_leafRotationVariance;
-		m_shootGrowthController.m_leafDamage = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_maxLeafSize = treeDescriptor->m_shootGrowthParameters.m_maxLeafSize;
+		shootGrowthController.m_leafPositionVariance = treeDescriptor->m_shootGrowthParameters.m_leafPositionVariance;
+		shootGrowthController.m_leafRotationVariance = treeDescriptor->m_shootGrowthParameters.m_leafRotationVariance;
+		shootGrowthController.m_leafDamage = [=](const Node<InternodeGrowthData>& internode)
 			{
 				const auto& shootGrowthParameters = treeDescriptor->m_shootGrowthParameters;
 				const auto& internodeData = internode.m_data;
 				float leafDamage = 0.0f;
-				if (climate->m_climateModel.m_time - glm::floor(climate->m_climateModel.m_time) > 0.5f && internodeData.m_temperature < shootGrowthParameters.m_leafChlorophyllSynthesisFactorTemperature)
+				if (climate->m_time - glm::floor(climate->m_time) > 0.5f && internodeData.m_temperature < shootGrowthParameters.m_leafChlorophyllSynthesisFactorTemperature)
 				{
 					leafDamage += shootGrowthParameters.m_leafChlorophyllLoss;
 				}
 				return leafDamage;
 			};
-		m_shootGrowthController.m_leafFallProbability = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_leafFallProbability = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return treeDescriptor->m_shootGrowthParameters.m_leafFallProbability;
 			};
-		m_shootGrowthController.m_maxFruitSize = treeDescriptor->m_shootGrowthParameters.m_maxFruitSize;
-		m_shootGrowthController.m_fruitPositionVariance = treeDescriptor->m_shootGrowthParameters.m_fruitPositionVariance;
-		m_shootGrowthController.m_fruitRotationVariance = treeDescriptor->m_shootGrowthParameters.m_fruitRotationVariance;
-		m_shootGrowthController.m_fruitDamage = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_maxFruitSize = treeDescriptor->m_shootGrowthParameters.m_maxFruitSize;
+		shootGrowthController.m_fruitPositionVariance = treeDescriptor->m_shootGrowthParameters.m_fruitPositionVariance;
+		shootGrowthController.m_fruitRotationVariance = treeDescriptor->m_shootGrowthParameters.m_fruitRotationVariance;
+		shootGrowthController.m_fruitDamage = [=](const Node<InternodeGrowthData>& internode)
 			{
 				const auto& shootGrowthParameters = treeDescriptor->m_shootGrowthParameters;
 				const auto& internodeData = internode.m_data;
 				float fruitDamage = 0.0f;
 				return fruitDamage;
 			};
-		m_shootGrowthController.m_fruitFallProbability = [=](const Node<InternodeGrowthData>& internode)
+		shootGrowthController.m_fruitFallProbability = [=](const Node<InternodeGrowthData>& internode)
 			{
 				return treeDescriptor->m_shootGrowthParameters.m_fruitFallProbability;
 			};
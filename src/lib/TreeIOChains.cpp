@@ -37,6 +37,10 @@ bool TreeChains::buildTree(const treeio::ArrayTree &tree)
     // Create copy of the provided tree, including its structure and base properties.
     mInternalTree = tree.copy<InternalNodeData>();
     mLeafNodes.clear();
+    mDepthOrder.clear();
+    mDepthLevels.clear();
+    mHeightOrder.clear();
+    mHeightLevels.clear();
     mChains.clear();
     mLeafChains.clear();
 
@@ -44,10 +48,10 @@ bool TreeChains::buildTree(const treeio::ArrayTree &tree)
     { std::cout << "Failed to generate upward-pass information!" << std::endl; return false; }
     if (!generateDownwardPassInformation(mInternalTree))
     { std::cout << "Failed to generate downward-pass information!" << std::endl; return false; }
-    if (!generateOrthoBases(mInternalTree))
-    { std::cout << "Failed to generate orthonormal bases!" << std::endl; return false; }
     if (!generateNodeChains(mInternalTree, mChains, mLeafChains, mMaxChainDepth, mMaxChainGraveliusDepth))
     { std::cout << "Failed to generate node chains!" << std::endl; return false; }
+    if (!generateOrthoBases(mInternalTree))
+    { std::cout << "Failed to generate orthonormal bases!" << std::endl; return false; }
 
     return true;
 }
@@ -111,6 +115,30 @@ void TreeChains::cascadeDownwards(DownwardPropFunT fun)
     }
 }
 
+void TreeChains::cascadeUpwardsParallel(UpwardPropFunT fun)
+{
+    std::atomic<bool> prematureStop{ false };
+    for (std::size_t level = 0u; level + 1u < mDepthLevels.size() && !prematureStop; ++level)
+    { // Process the levels root to leaves, parents of the current level are all finished.
+        const auto levelBegin{ mDepthLevels[level] };
+        treeutil::parallelFor(mDepthLevels[level + 1u] - levelBegin, [&](std::size_t iii)
+        { if (fun(mInternalTree, mDepthOrder[levelBegin + iii])) { prematureStop = true; } },
+        PARALLEL_GRAIN_SIZE);
+    }
+}
+
+void TreeChains::cascadeDownwardsParallel(DownwardPropFunT fun)
+{
+    std::atomic<bool> prematureStop{ false };
+    for (std::size_t level = 0u; level + 1u < mHeightLevels.size() && !prematureStop; ++level)
+    { // Process the levels leaves to root, children of the current level are all finished.
+        const auto levelBegin{ mHeightLevels[level] };
+        treeutil::parallelFor(mHeightLevels[level + 1u] - levelBegin, [&](std::size_t iii)
+        { if (fun(mInternalTree, mHeightOrder[levelBegin + iii])) { prematureStop = true; } },
+        PARALLEL_GRAIN_SIZE);
+    }
+}
+
 const TreeChains::InternalArrayTree &TreeChains::internalTree() const
 { return mInternalTree; }
 
@@ -163,6 +191,12 @@ TreeChains::CompactChainStorage TreeChains::generateCompactChains(float maxLengt
         float accumulatedLength{ 0.0f };
     }; // struct ChildChainRecord
 
+    // Lengths of the chains do not depend on each other, so calculate all of them up front.
+    std::vector<float> chainLengths(allChains.size());
+    treeutil::parallelFor(allChains.size(), [&](std::size_t chainIdx)
+    { chainLengths[chainIdx] = allChains[chainIdx].calculateChainLength(mInternalTree); },
+    PARALLEL_GRAIN_SIZE);
+
     // Initialize processing with the root chain.
     std::stack<ChainRecord> toProcess{ };
     toProcess.push({ 0u });
@@ -195,10 +229,7 @@ TreeChains::CompactChainStorage TreeChains::generateCompactChains(float maxLengt
             const auto childChainRecord{ childChains.top() }; childChains.pop();
             const auto childChainIdx{ childChainRecord.srcChildIdx };
             const auto &srcChildChain{ allChains[childChainIdx] };
-            const auto chainLength{
-                childChainRecord.accumulatedLength +
-                srcChildChain.calculateChainLength(mInternalTree)
-            };
+            const auto chainLength{ childChainRecord.accumulatedLength + chainLengths[childChainIdx] };
 
             if (chainLength <= maxLength && !srcChildChain.childChains.empty())
             { // Compact child chain into this one, only in case when it is not a leaf.
@@ -323,201 +354,200 @@ bool TreeChains::applyChangesTo(treeio::ArrayTree &tree) const
 
 bool TreeChains::generateUpwardPassInformation(InternalArrayTree &tree)
 {
-    /// @brief Helper structure for computing the depth.
-    struct DepthHelper
-    {
-        /// The vertex itself.
-        NodeIdT vertex{ };
-        /// Parent vertex.
-        NodeIdT parent{ };
-        /// Depth from root.
-        std::size_t depth{ };
-        /// Accumulated distance from root.
-        float distance{ };
-    }; // struct DepthHelper
-
-    std::stack<DepthHelper> vertexStack{ };
-    vertexStack.emplace(DepthHelper{ tree.getRootId(), INVALID_NODE_ID, 0u, 0.0f });
-
+    // Flatten the tree depth-first, parents are always placed before their children.
+    NodeIdStorage preOrder{ };
+    preOrder.reserve(tree.nodeCount());
+    std::vector<NodeIdT> vertexStack{ };
+    vertexStack.push_back(tree.getRootId());
     while (!vertexStack.empty())
     { // Process all vertices root to leaves.
-        const auto currentHelper{ vertexStack.top() }; vertexStack.pop();
-        // Update depth and distance of the current vertex.
-        auto &currentNode{ tree.getNode(currentHelper.vertex) };
-        currentNode.data().depth = currentHelper.depth;
-        currentNode.data().distance = currentHelper.distance;
-
-        for (const auto &cId : tree.getNodeChildren(currentHelper.vertex))
-        { // Add child vertices.
-            const auto distanceFromParent{
-                (tree.getNode(cId).data().pos - currentNode.data().pos).length()
-            };
-            vertexStack.emplace(DepthHelper{
-                cId, currentHelper.vertex,
-                currentHelper.depth + 1u,
-                currentHelper.distance + distanceFromParent
-            });
-        }
+        const auto currentVertex{ vertexStack.back() }; vertexStack.pop_back();
+        preOrder.push_back(currentVertex);
 
-        if (tree.getNodeChildren(currentHelper.vertex).empty())
+        const auto &children{ tree.getNodeChildren(currentVertex) };
+        if (children.empty())
         { // We found a leaf node.
-            mLeafNodes.push_back(currentHelper.vertex);
+            mLeafNodes.push_back(currentVertex);
         }
+        vertexStack.insert(vertexStack.end(), children.begin(), children.end());
+    }
+
+    // Update depth and distance of the vertices, parents are already finished.
+    std::size_t maxDepth{ 0u };
+    for (const auto &currentVertex : preOrder)
+    {
+        auto &currentNode{ tree.getNode(currentVertex) };
+        const auto parent{ tree.getNodeParent(currentVertex) };
+        if (currentVertex == tree.getRootId() || parent == INVALID_NODE_ID)
+        { currentNode.data().depth = 0u; currentNode.data().distance = 0.0f; continue; }
+
+        const auto &parentNode{ tree.getNode(parent) };
+        const auto distanceFromParent{
+            (currentNode.data().pos - parentNode.data().pos).length()
+        };
+        currentNode.data().depth = parentNode.data().depth + 1u;
+        currentNode.data().distance = parentNode.data().distance + distanceFromParent;
+        maxDepth = std::max<std::size_t>(maxDepth, currentNode.data().depth);
     }
 
+    // Sort the vertices into depth levels, keeping the depth-first order within each level.
+    mDepthLevels.assign(maxDepth + 2u, 0u);
+    for (const auto &currentVertex : preOrder)
+    { mDepthLevels[tree.getNode(currentVertex).data().depth + 1u]++; }
+    for (std::size_t level = 1u; level < mDepthLevels.size(); ++level)
+    { mDepthLevels[level] += mDepthLevels[level - 1u]; }
+    mDepthOrder.resize(preOrder.size());
+    auto levelOffsets{ mDepthLevels };
+    for (const auto &currentVertex : preOrder)
+    { mDepthOrder[levelOffsets[tree.getNode(currentVertex).data().depth]++] = currentVertex; }
+
     return true;
 }
 
 bool TreeChains::generateDownwardPassInformation(InternalArrayTree &tree)
 {
-    // Initialize the set with leaf nodes:
-    std::set<NodeIdT> currentVertices{ mLeafNodes.begin(), mLeafNodes.end() };
-    std::set<NodeIdT> newVertices{ };
-    std::set<NodeIdT> finishedVertices{ };
-
-    while (!currentVertices.empty())
-    { // Proceed in waves from the leaf nodes while storing parent vertices to the newVertices.
-        for (const auto &currentVertex : currentVertices)
-        { // Calculate child count of this vertex.
-            auto &currentNode{ tree.getNode(currentVertex).data() };
-            if (finishedVertices.find(currentVertex) != finishedVertices.end())
-            { continue; }
-
-            std::size_t childCount{ 0u };
-            float childLength{ 0.0f };
-            std::size_t graveliusMaxChildren{ 0u };
-            std::size_t graveliusMaxChildOrder{ 1u };
-            auto foundUnfinished{ false };
-            const auto parent{ tree.getNodeParent(currentVertex) };
-
-            for (const auto &cId : tree.getNodeChildren(currentVertex))
-            { // Accumulate child counts for all child vertices and store parent for next iteration.
-                if (finishedVertices.find(cId) == finishedVertices.end())
-                { foundUnfinished = true; break; }
-                const auto &childNode{ tree.getNode(cId).data() };
-
-                childCount += childNode.totalChildCount;
-
-                const auto currentToChildLength{
-                    (childNode.pos - currentNode.pos).length()
-                };
-                childLength += childNode.totalChildLength + currentToChildLength;
-
-                if (childNode.graveliusOrder > graveliusMaxChildOrder)
-                { graveliusMaxChildOrder = childNode.graveliusOrder; graveliusMaxChildren = 0u; }
-                if (childNode.graveliusOrder == graveliusMaxChildOrder)
-                { graveliusMaxChildren++; }
-            }
-
-            // Skip this node until we have all required children calculated.
-            if (foundUnfinished)
-            { continue; }
+    // Going through the depth levels backwards finishes all children before their parent.
+    std::vector<std::size_t> heights(tree.nodeCount(), 0u);
+    std::size_t maxHeight{ 0u };
+    for (auto it = mDepthOrder.rbegin(); it != mDepthOrder.rend(); ++it)
+    { // Calculate child count of this vertex.
+        const auto currentVertex{ *it };
+        auto &currentNode{ tree.getNode(currentVertex).data() };
+
+        std::size_t childCount{ 0u };
+        float childLength{ 0.0f };
+        std::size_t graveliusMaxChildren{ 0u };
+        std::size_t graveliusMaxChildOrder{ 1u };
+        std::size_t height{ 0u };
+
+        for (const auto &cId : tree.getNodeChildren(currentVertex))
+        { // Accumulate child counts for all child vertices.
+            const auto &childNode{ tree.getNode(cId).data() };
+
+            childCount += childNode.totalChildCount;
+
+            const auto currentToChildLength{
+                (childNode.pos - currentNode.pos).length()
+            };
+            childLength += childNode.totalChildLength + currentToChildLength;
 
-            // We have all required children -> Continue with the parent node.
-            if (parent != INVALID_NODE_ID)
-            { newVertices.emplace(parent); }
+            if (childNode.graveliusOrder > graveliusMaxChildOrder)
+            { graveliusMaxChildOrder = childNode.graveliusOrder; graveliusMaxChildren = 0u; }
+            if (childNode.graveliusOrder == graveliusMaxChildOrder)
+            { graveliusMaxChildren++; }
 
-            // Add one for the current vertex.
-            childCount += 1u;
-            // Store for later use:
-            currentNode.totalChildCount = childCount;
-            currentNode.totalChildLength = childLength;
+            height = std::max<std::size_t>(height, heights[InternalArrayTree::nodeIdToIdx(cId)] + 1u);
+        }
 
-            if (graveliusMaxChildren > 1u)
-            { // We found a tributary joining.
-                currentNode.graveliusOrder = graveliusMaxChildOrder + 1u;
-            }
-            else
-            { // Continue with the same stream.
-                currentNode.graveliusOrder = graveliusMaxChildOrder;
-            }
+        // Add one for the current vertex.
+        childCount += 1u;
+        // Store for later use:
+        currentNode.totalChildCount = childCount;
+        currentNode.totalChildLength = childLength;
 
-            finishedVertices.emplace(currentVertex);
+        if (graveliusMaxChildren > 1u)
+        { // We found a tributary joining.
+            currentNode.graveliusOrder = graveliusMaxChildOrder + 1u;
         }
-        // Switch to the accumulated parent vertices and continue with the algorithm.
-        currentVertices.swap(newVertices);
-        newVertices.clear();
+        else
+        { // Continue with the same stream.
+            currentNode.graveliusOrder = graveliusMaxChildOrder;
+        }
+
+        heights[InternalArrayTree::nodeIdToIdx(currentVertex)] = height;
+        maxHeight = std::max(maxHeight, height);
     }
 
+    // Sort the vertices into height levels.
+    mHeightLevels.assign(maxHeight + 2u, 0u);
+    for (const auto &currentVertex : mDepthOrder)
+    { mHeightLevels[heights[InternalArrayTree::nodeIdToIdx(currentVertex)] + 1u]++; }
+    for (std::size_t level = 1u; level < mHeightLevels.size(); ++level)
+    { mHeightLevels[level] += mHeightLevels[level - 1u]; }
+    mHeightOrder.resize(mDepthOrder.size());
+    auto levelOffsets{ mHeightLevels };
+    for (const auto &currentVertex : mDepthOrder)
+    { mHeightOrder[levelOffsets[heights[InternalArrayTree::nodeIdToIdx(currentVertex)]]++] = currentVertex; }
+
     return true;
 }
 
 bool TreeChains::generateOrthoBases(InternalArrayTree &tree)
 {
-    /// @brief Helper structure for computing the orthonormal bases.
-    struct BasisHelper
-    {
-        /// The vertex itself.
-        NodeIdT vertex{ };
-        /// Parent vertex.
-        NodeIdT parent{ };
-    }; // struct BasisHelper
-
     // Calculate the initial basis for the root node.
     const auto rootBasis{ calculateBasisFromChildren(tree, tree.getRootId() )};
     tree.getNode(tree.getRootId()).data().basis = rootBasis;
 
-    // Start the algorithm with the root node.
-    std::stack<BasisHelper> vertexStack{ };
-    vertexStack.emplace(BasisHelper{ tree.getRootId(), INVALID_NODE_ID });
+    // Bases only depend on the parent, so chains of one depth are independent once the shallower ones are done.
+    std::vector<ChainIdxStorage> chainLevels(mMaxChainDepth + 1u);
+    std::vector<std::size_t> levelNodeCounts(mMaxChainDepth + 1u, 0u);
+    for (std::size_t chainIdx = 0u; chainIdx < mChains.size(); ++chainIdx)
+    {
+        chainLevels[mChains[chainIdx].chainDepth].push_back(chainIdx);
+        levelNodeCounts[mChains[chainIdx].chainDepth] += mChains[chainIdx].nodes.size();
+    }
 
-    while (!vertexStack.empty())
-    { // Process all vertices root to leaves.
-        const auto currentHelper{ vertexStack.top() }; vertexStack.pop();
+    for (std::size_t level = 0u; level < chainLevels.size(); ++level)
+    {
+        const auto &chainLevel{ chainLevels[level] };
+        // Small levels are not worth handing to the job system, they form a single chunk.
+        const auto grainSize{ levelNodeCounts[level] < PARALLEL_GRAIN_SIZE ? chainLevel.size() : 1u };
+        treeutil::parallelFor(chainLevel.size(), [&](std::size_t iii)
+        {
+            // The first node is shared with the parent chain, or it is the root node.
+            const auto &nodes{ mChains[chainLevel[iii]].nodes };
+            for (std::size_t nodeIdx = 1u; nodeIdx < nodes.size(); ++nodeIdx)
+            { calculateNodeBasis(tree, nodes[nodeIdx]); }
+        }, grainSize);
+    }
 
-        // Skip the root node, which has already been initialized.
-        if (currentHelper.parent != INVALID_NODE_ID)
-        { // Processing non-root node -> Minimize rotation frames.
-            const auto &parentNode{ tree.getNode(currentHelper.parent) };
-            auto &currentNode{ tree.getNode(currentHelper.vertex) };
+    return true;
+}
 
-            if (Vector3D::distance(currentNode.data().pos, parentNode.data().pos) < MINIMUM_MRF_DISTANCE)
-            { // The two nodes are nearly identical -> use same information as the parent does.
-                // Save the MRF as the new basis.
-                currentNode.data().basis = parentNode.data().basis;
-            }
-            else
-            { // The Two nodes are different -> calculate next step.
-                // Recover parent frame, which is already correctly rotated.
-                const FrenetFrame parentFrenetFrame{
-                    parentNode.data().pos,
-                    parentNode.data().basis.bitangent,
-                    //parentNode.data().basis.tangent
-                    parentNode.data().basis.direction
-                };
-
-                // Calculate tangent and build starting frame for the current node.
-                const auto currentBasis{
-                    calculateBasisFromParent(tree, currentHelper.vertex)
-                };
-                const FrenetFrame currentFrenetFrame{
-                    currentNode.data().pos,
-                    currentBasis.bitangent,
-                    //currentBasis.tangent
-                    currentBasis.direction
-                };
-
-                // Perform minimal rotation correction.
-                const auto minimalRotationFrame{
-                    doubleReflectionRMF(parentFrenetFrame, currentFrenetFrame)
-                };
-
-                // Save the MRF as the new basis.
-                currentNode.data().basis = OrthoBasis{
-                    currentBasis.direction,
-                    //minimalRotationFrame.tan,
-                    Vector3D::crossProduct(minimalRotationFrame.rot, minimalRotationFrame.tan),
-                    minimalRotationFrame.rot
-                };
-            }
-        }
+void TreeChains::calculateNodeBasis(InternalArrayTree &tree, const NodeIdT &nodeId) const
+{
+    const auto &parentNode{ tree.getNode(tree.getNodeParent(nodeId)) };
+    auto &currentNode{ tree.getNode(nodeId) };
 
-        // Move to the child vertices.
-        for (const auto &cId : tree.getNodeChildren(currentHelper.vertex))
-        { vertexStack.emplace(BasisHelper{ cId, currentHelper.vertex }); }
+    if (Vector3D::distance(currentNode.data().pos, parentNode.data().pos) < MINIMUM_MRF_DISTANCE)
+    { // The two nodes are nearly identical -> use same information as the parent does.
+        // Save the MRF as the new basis.
+        currentNode.data().basis = parentNode.data().basis;
+    }
+    else
+    { // The Two nodes are different -> calculate next step.
+        // Recover parent frame, which is already correctly rotated.
+        const FrenetFrame parentFrenetFrame{
+            parentNode.data().pos,
+            parentNode.data().basis.bitangent,
+            //parentNode.data().basis.tangent
+            parentNode.data().basis.direction
+        };
+
+        // Calculate tangent and build starting frame for the current node.
+        const auto currentBasis{
+            calculateBasisFromParent(tree, nodeId)
+        };
+        const FrenetFrame currentFrenetFrame{
+            currentNode.data().pos,
+            currentBasis.bitangent,
+            //currentBasis.tangent
+            currentBasis.direction
+        };
+
+        // Perform minimal rotation correction.
+        const auto minimalRotationFrame{
+            doubleReflectionRMF(parentFrenetFrame, currentFrenetFrame)
+        };
+
+        // Save the MRF as the new basis.
+        currentNode.data().basis = OrthoBasis{
+            currentBasis.direction,
+            //minimalRotationFrame.tan,
+            Vector3D::crossProduct(minimalRotationFrame.rot, minimalRotationFrame.tan),
+            minimalRotationFrame.rot
+        };
     }
-
-    return true;
 }
 
 bool TreeChains::generateNodeChains(const InternalArrayTree &tree,
@@ -6,10 +6,13 @@
  */
 
 #include "TreeIOUtils.hpp"
+#include "Jobs.hpp"
 
 #include <string>
 #include <fstream>
 #include <streambuf>
+#include <exception>
+#include <mutex>
 
 #include <base64/base64.h>
 
@@ -79,6 +82,31 @@ namespace treeutil {
         return copy;
     }
 
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &fun,
+                     std::size_t grainSize) {
+        grainSize = std::max<std::size_t>(grainSize, 1u);
+        const auto chunkCount{(count + grainSize - 1u) / grainSize};
+
+        if (chunkCount <= 1u) {
+            for (std::size_t idx = 0u; idx < count; ++idx) { fun(idx); }
+            return;
+        }
+
+        // An exception must not escape a job, keep the first one and hand it to the caller.
+        std::exception_ptr firstException{};
+        std::mutex exceptionMutex{};
+        EvoEngine::Jobs::ParallelFor(chunkCount, [&](unsigned chunk) {
+            try {
+                const auto end{std::min(count, (chunk + 1u) * grainSize)};
+                for (std::size_t idx = chunk * grainSize; idx < end; ++idx) { fun(idx); }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock{exceptionMutex};
+                if (!firstException) { firstException = std::current_exception(); }
+            }
+        });
+        if (firstException) { std::rethrow_exception(firstException); }
+    }
+
     bool equalCaseInsensitive(const std::string &first, const std::string &second) {
         if (first.size() != second.size()) { return false; }
 
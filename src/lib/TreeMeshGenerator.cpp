@@ -142,6 +142,7 @@ void TreeMeshGeneratorSettings::Save(const std::string& name, YAML::Emitter& out
 	out << YAML::Key << "m_enableBranch" << YAML::Value << m_enableBranch;
 	out << YAML::Key << "m_enableFruit" << YAML::Value << m_enableFruit;
 	out << YAML::Key << "m_enableTwig" << YAML::Value << m_enableTwig;
+	out << YAML::Key << "m_foliageInstancing" << YAML::Value << m_foliageInstancing;
 
 	out << YAML::Key << "m_smoothness" << YAML::Value << m_smoothness;
 	out << YAML::Key << "m_overrideRadius" << YAML::Value << m_overrideRadius;
@@ -178,6 +179,7 @@ void TreeMeshGeneratorSettings::Load(const std::string& name, const YAML::Node&
 		if (ms["m_enableBranch"]) m_enableBranch = ms["m_enableBranch"].as<bool>();
 		if (ms["m_enableFruit"]) m_enableFruit = ms["m_enableFruit"].as<bool>();
 		if (ms["m_enableTwig"]) m_enableTwig = ms["m_enableTwig"].as<bool>();
+		if (ms["m_foliageInstancing"]) m_foliageInstancing = ms["m_foliageInstancing"].as<bool>();
 
 		if (ms["m_smoothness"]) m_smoothness = ms["m_smoothness"].as<bool>();
 		if (ms["m_overrideRadius"]) m_overrideRadius = ms["m_overrideRadius"].as<bool>();
@@ -228,6 +230,7 @@ void TreeMeshGeneratorSettings::OnInspect(const std::shared_ptr<EditorLayer>& ed
 			if (m_overrideRadius) ImGui::DragFloat("Radius", &m_radius);
 			ImGui::DragFloat("Tree Part Base Distance", &m_treePartBaseDistance, 1, 0, 10);
 			ImGui::DragFloat("Tree Part End Distance", &m_treePartEndDistance, 1, 0, 10);
+			ImGui::Checkbox("Log generation time", &m_logCylindricalMeshTime);
 			ImGui::TreePop();
 		}
 		if(ImGui::TreeNode("Marching cubes settings"))
@@ -245,7 +248,7 @@ void TreeMeshGeneratorSettings::OnInspect(const std::shared_ptr<EditorLayer>& ed
 		}
 		if (m_enableFoliage && ImGui::TreeNode("Foliage settings"))
 		{
-
+			ImGui::Checkbox("Instancing", &m_foliageInstancing);
 			ImGui::TreePop();
 		}
 		
@@ -3,6 +3,7 @@
 //
 
 #include "TreeModel.hpp"
+#include "Times.hpp"
 
 using namespace EcoSysLab;
 void ReproductiveModule::Reset()
@@ -32,25 +33,28 @@ void TreeModel::ResetReproductiveModule()
 	m_fruitCount = m_leafCount = 0;
 }
 
-void TreeModel::RegisterVoxel(const glm::mat4& globalTransform, ClimateModel& climateModel, const ShootGrowthController& shootGrowthController)
+void TreeModel::RegisterVoxel(const glm::mat4& globalTransform, const ClimateModel& climateModel, const ShootGrowthController& shootGrowthController,
+	EnvironmentGridBuffer& buffer, const bool registerNodes) const
 {
 	const auto& sortedInternodeList = m_shootSkeleton.RefSortedNodeList();
-	auto& environmentGrid = climateModel.m_environmentGrid;
+	const auto& voxelGrid = climateModel.m_environmentGrid.m_voxel;
+	buffer.m_contributions.reserve(buffer.m_contributions.size() + sortedInternodeList.size());
 	for (auto it = sortedInternodeList.rbegin(); it != sortedInternodeList.rend(); ++it) {
-		const auto& internode = m_shootSkeleton.RefNode(*it);
+		const auto& internode = m_shootSkeleton.PeekNode(*it);
 		const auto& internodeInfo = internode.m_info;
-		const float shadowSize = shootGrowthController.m_internodeShadowFactor;
-		const float biomass = internodeInfo.m_thickness;
 		const glm::vec3 worldPosition = globalTransform * glm::vec4(internodeInfo.m_globalPosition, 1.0f);
-		environmentGrid.AddShadowValue(worldPosition, shadowSize);
-		environmentGrid.AddBiomass(worldPosition, biomass);
-		if (internode.IsEndNode()) {
-			InternodeVoxelRegistration registration;
+		if (!voxelGrid.IsValid(worldPosition)) continue;
+		auto& contribution = buffer.m_contributions.emplace_back();
+		contribution.m_voxelIndex = voxelGrid.GetIndex(worldPosition);
+		contribution.m_shadowIntensity = shootGrowthController.m_internodeShadowFactor;
+		contribution.m_biomass = internodeInfo.m_thickness;
+		if (registerNodes && internode.IsEndNode()) {
+			contribution.m_registrationIndex = static_cast<int>(buffer.m_registrations.size());
+			auto& registration = buffer.m_registrations.emplace_back();
 			registration.m_position = worldPosition;
 			registration.m_nodeHandle = *it;
 			registration.m_treeModelIndex = m_index;
 			registration.m_thickness = internodeInfo.m_thickness;
-			environmentGrid.AddNode(registration);
 		}
 	}
 }
@@ -60,9 +64,10 @@ void TreeModel::PruneInternode(NodeHandle internodeHandle)
 	auto& internode = m_shootSkeleton.RefNode(internodeHandle);
 
 	m_shootSkeleton.RecycleNode(internodeHandle,
-		[&](FlowHandle flowHandle) {},
+		[&](FlowHandle flowHandle) { m_shootStemCount--; },
 		[&](NodeHandle nodeHandle)
 		{
+			m_internodeCount--;
 			const auto& node = m_shootSkeleton.RefNode(nodeHandle);
 			const auto& physics2D = node.m_data.m_frontProfile;
 			for (const auto& particle : physics2D.PeekParticles())
@@ -145,10 +150,12 @@ bool TreeModel::Grow(const float deltaTime, const NodeHandle baseInternodeHandle
 		if (overrideGrowthRate > 0.0f) growthRate = overrideGrowthRate;
 		AdjustGrowthRate(sortedSubTreeInternodeList, growthRate);
 	}
+	m_budChangedInternodes.clear();
 	for (auto it = sortedSubTreeInternodeList.rbegin(); it != sortedSubTreeInternodeList.rend(); ++it) {
 		const bool graphChanged = GrowInternode(climateModel, *it, shootGrowthController);
 		anyBranchGrown = anyBranchGrown || graphChanged;
 	}
+	m_shootSkeleton.MarkStateChanged(m_budChangedInternodes);
 	if (anyBranchGrown) m_shootSkeleton.SortLists();
 	treeStructureChanged = treeStructureChanged || anyBranchGrown;
 	ShootGrowthPostProcess(shootGrowthController);
@@ -208,34 +215,91 @@ void TreeModel::CalculateShootFlux(const glm::mat4& globalTransform, ClimateMode
 			}
 		}
 		auto& voxelGrid = m_treeOccupancyGrid.RefGrid();
+		auto& markers = m_treeOccupancyGrid.RefMarkers();
+		const float removalDistance = m_treeGrowthSettings.m_spaceColonizationRemovalDistanceFactor * shootGrowthController.m_internodeLength;
+		const float detectionDistance = m_treeGrowthSettings.m_spaceColonizationDetectionDistanceFactor * shootGrowthController.m_internodeLength;
+		const auto dotMin = glm::cos(glm::radians(m_treeOccupancyGrid.GetTheta()));
+
+		//The markers are claimed in the order of the sorted list, we keep the order to resolve the competition between nodes.
+		std::vector<int> nodeOrders(m_shootSkeleton.RefRawNodes().size(), -1);
+		for (int i = 0; i < sortedInternodeList.size(); i++) nodeOrders[sortedInternodeList[i]] = i;
+
+		//Only nodes that moved to another voxel (or are new/removed) will touch the index.
 		for (const auto& internodeHandle : sortedInternodeList)
 		{
-			auto& internode = m_shootSkeleton.RefNode(internodeHandle);
-			auto& internodeData = internode.m_data;
-			for (auto& bud : internodeData.m_buds)
+			m_treeOccupancyGrid.UpdateNode(internodeHandle, m_shootSkeleton.PeekNode(internodeHandle).m_data.m_desiredGlobalPosition);
+		}
+		const auto& nodeVoxelIndices = m_treeOccupancyGrid.PeekNodeVoxelIndices();
+		for (NodeHandle nodeHandle = 0; nodeHandle < nodeVoxelIndices.size(); nodeHandle++)
+		{
+			if (nodeVoxelIndices[nodeHandle] != -1 && (nodeHandle >= nodeOrders.size() || nodeOrders[nodeHandle] == -1)) m_treeOccupancyGrid.RemoveNode(nodeHandle);
+		}
+
+		//1. Each marker is claimed by the first node (in sorted order) that has it within removal distance.
+		const auto resolution = voxelGrid.GetResolution();
+		const int searchRange = static_cast<int>(glm::ceil(removalDistance / voxelGrid.GetVoxelSize())) + 1;
+		Jobs::ParallelFor(voxelGrid.GetVoxelCount(), [&](unsigned i)
 			{
-				bud.m_markerDirection = glm::vec3(0.0f);
-				bud.m_markerCount = 0;
+				const auto& voxelData = voxelGrid.Peek(static_cast<int>(i));
+				if (voxelData.m_liveMarkerSize == 0) return;
+				const auto coordinate = voxelGrid.GetCoordinate(static_cast<int>(i));
+				const auto searchStart = glm::max(coordinate - searchRange, glm::ivec3(0));
+				const auto searchEnd = glm::min(coordinate + searchRange, resolution - 1);
+				std::vector<NodeHandle> candidates;
+				for (int x = searchStart.x; x <= searchEnd.x; x++) {
+					for (int y = searchStart.y; y <= searchEnd.y; y++) {
+						for (int z = searchStart.z; z <= searchEnd.z; z++) {
+							for (const auto& nodeHandle : m_treeOccupancyGrid.PeekNodes({ x, y, z }))
+							{
+								glm::ivec3 start, end;
+								voxelGrid.GetRange(m_shootSkeleton.PeekNode(nodeHandle).m_data.m_desiredGlobalPosition, removalDistance, start, end);
+								if (glm::all(glm::greaterThanEqual(coordinate, start)) && glm::all(glm::lessThanEqual(coordinate, end))) candidates.emplace_back(nodeHandle);
+							}
+						}
+					}
+				}
+				if (candidates.empty()) return;
+				for (unsigned m = voxelData.m_markerOffset; m < voxelData.m_markerOffset + voxelData.m_liveMarkerSize; m++)
+				{
+					auto& marker = markers[m];
+					int claimOrder = INT_MAX;
+					for (const auto& nodeHandle : candidates)
+					{
+						const auto distance = glm::length(marker.m_position - m_shootSkeleton.PeekNode(nodeHandle).m_data.m_desiredGlobalPosition);
+						if (distance < detectionDistance && distance < removalDistance && nodeOrders[nodeHandle] < claimOrder)
+						{
+							claimOrder = nodeOrders[nodeHandle];
+							marker.m_nodeHandle = nodeHandle;
+						}
+					}
+				}
 			}
-			internodeData.m_lightDirection = glm::vec3(0.0f);
-			const auto dotMin = glm::cos(glm::radians(m_treeOccupancyGrid.GetTheta()));
-			voxelGrid.ForEach(internodeData.m_desiredGlobalPosition, m_treeGrowthSettings.m_spaceColonizationRemovalDistanceFactor * shootGrowthController.m_internodeLength,
-				[&](TreeOccupancyGridVoxelData& voxelData)
+		);
+
+		//2. Each node collects the markers that were still free when it was visited in the sequential order.
+		Jobs::ParallelFor(sortedInternodeList.size(), [&](unsigned internodeIndex)
+			{
+				const auto internodeHandle = sortedInternodeList[internodeIndex];
+				auto& internode = m_shootSkeleton.RefNode(internodeHandle);
+				auto& internodeData = internode.m_data;
+				for (auto& bud : internodeData.m_buds)
 				{
-					for (auto& marker : voxelData.m_markers)
+					bud.m_markerDirection = glm::vec3(0.0f);
+					bud.m_markerCount = 0;
+				}
+				voxelGrid.ForEach(internodeData.m_desiredGlobalPosition, removalDistance,
+					[&](TreeOccupancyGridVoxelData& voxelData)
 					{
-						const auto diff = marker.m_position - internodeData.m_desiredGlobalPosition;
-						const auto distance = glm::length(diff);
-						const auto direction = glm::normalize(diff);
-						if (distance < m_treeGrowthSettings.m_spaceColonizationDetectionDistanceFactor * shootGrowthController.m_internodeLength)
+						for (unsigned m = voxelData.m_markerOffset; m < voxelData.m_markerOffset + voxelData.m_liveMarkerSize; m++)
 						{
-							if (marker.m_nodeHandle != -1) continue;
-							if (distance < m_treeGrowthSettings.m_spaceColonizationRemovalDistanceFactor * shootGrowthController.m_internodeLength)
-							{
-								marker.m_nodeHandle = internodeHandle;
-							}
-							else
+							const auto& marker = markers[m];
+							const auto diff = marker.m_position - internodeData.m_desiredGlobalPosition;
+							const auto distance = glm::length(diff);
+							const auto direction = glm::normalize(diff);
+							if (distance < detectionDistance)
 							{
+								if (marker.m_nodeHandle != -1 && nodeOrders[marker.m_nodeHandle] <= static_cast<int>(internodeIndex)) continue;
+								if (distance < removalDistance) continue;
 								for (auto& bud : internodeData.m_buds) {
 									auto budDirection = glm::normalize(internode.m_info.m_globalRotation * bud.m_localRotation * glm::vec3(0, 0, -1));
 									if (glm::dot(direction, budDirection) > dotMin)
@@ -246,16 +310,21 @@ void TreeModel::CalculateShootFlux(const glm::mat4& globalTransform, ClimateMode
 								}
 							}
 						}
-
 					}
-				}
-			);
-		}
+				);
+			}
+		);
+
+		//3. Consumed markers are moved out of the live lists at once.
+		m_treeOccupancyGrid.RemoveConsumedMarkers();
 	}
+	std::vector<NodeHandle> changedInternodes;
 	for (const auto& internodeHandle : sortedInternodeList) {
 		auto& internode = m_shootSkeleton.RefNode(internodeHandle);
 		auto& internodeData = internode.m_data;
 		auto& internodeInfo = internode.m_info;
+		const auto previousLightIntensity = internodeData.m_lightIntensity;
+		const auto previousLightDirection = internodeData.m_lightDirection;
 		internodeData.m_lightIntensity = 0.0f;
 		if (m_treeGrowthSettings.m_useSpaceColonization) {
 			for (const auto& bud : internodeData.m_buds)
@@ -270,7 +339,9 @@ void TreeModel::CalculateShootFlux(const glm::mat4& globalTransform, ClimateMode
 			internodeData.m_lightDirection = glm::normalize(internodeInfo.m_globalDirection);
 		}
 		internodeData.m_spaceOccupancy = climateModel.m_environmentGrid.m_voxel.Peek(position).m_totalBiomass;
+		if (internodeData.m_lightIntensity != previousLightIntensity || internodeData.m_lightDirection != previousLightDirection) changedInternodes.emplace_back(internodeHandle);
 	}
+	m_shootSkeleton.MarkStateChanged(changedInternodes);
 }
 ShootFlux TreeModel::CollectShootFlux(const std::vector<NodeHandle>& sortedInternodeList)
 {
@@ -286,17 +357,49 @@ ShootFlux TreeModel::CollectShootFlux(const std::vector<NodeHandle>& sortedInter
 
 void TreeModel::ShootGrowthPostProcess(const ShootGrowthController& shootGrowthController)
 {
+	const double startTime = Times::Now();
 	{
 		m_shootSkeleton.m_min = glm::vec3(FLT_MAX);
 		m_shootSkeleton.m_max = glm::vec3(FLT_MIN);
 		m_shootSkeleton.m_data.m_desiredMin = glm::vec3(FLT_MAX);
 		m_shootSkeleton.m_data.m_desiredMax = glm::vec3(FLT_MIN);
 
+		ShootUpdateParameters parameters{};
+		parameters.m_endNodeThickness = shootGrowthController.m_endNodeThickness;
+		parameters.m_thicknessAccumulationFactor = shootGrowthController.m_thicknessAccumulationFactor;
+		parameters.m_internodeLengthThicknessFactor = shootGrowthController.m_internodeLengthThicknessFactor;
+		parameters.m_internodeLength = shootGrowthController.m_internodeLength;
+		parameters.m_branchPush = shootGrowthController.m_branchPush;
+		parameters.m_gravityDirection = m_currentGravityDirection;
+		parameters.m_saggingTolerance = m_treeGrowthSettings.m_saggingTolerance;
+		parameters.m_saggingFactorThicknessReductionMax = shootGrowthController.m_saggingFactorThicknessReductionMax;
+		for (const auto& internodeHandle : m_shootSkeleton.RefSortedNodeList())
+		{
+			parameters.m_totalExtraMass += m_shootSkeleton.PeekNode(internodeHandle).m_data.m_extraMass;
+		}
+		//Only input changes are collected, the state the passes below mark does not feed back into them.
+		std::vector<NodeHandle> changedInternodes;
+		const bool incremental = m_treeGrowthSettings.m_incrementalShootUpdate
+			&& shootGrowthController.m_thicknessAccumulateAgeFactor == 0.0f
+			&& parameters == m_postProcessedParameters
+			&& m_postProcessedChangeVersion != -1
+			&& m_shootSkeleton.GetChangeVersion() >= m_postProcessedChangeVersion
+			&& m_shootSkeleton.CollectChangedNodes(m_postProcessedChangeVersion, changedInternodes, true);
+
 		m_shootSkeleton.CalculateDistance();
-		CalculateThickness(shootGrowthController);
-		CalculateBiomass(shootGrowthController);
-		CalculateLevel();
-		CalculateTransform(shootGrowthController, true);
+		if (incremental)
+		{
+			UpdateShootIncrementally(changedInternodes, shootGrowthController);
+			if (m_treeGrowthSettings.m_verifyIncrementalShootUpdate) VerifyIncrementalShootUpdate(shootGrowthController);
+		}
+		else {
+			CalculateThickness(shootGrowthController);
+			CalculateBiomass(shootGrowthController);
+			CalculateLevel();
+			CalculateTransform(shootGrowthController, true);
+		}
+		m_postProcessedParameters = parameters;
+		m_lastPostProcessIncremental = incremental;
 
 	};
 
@@ -321,10 +424,12 @@ void TreeModel::ShootGrowthPostProcess(const ShootGrowthController& shootGrowthC
 		m_internodeOrderCounts.resize(maxOrder + 1);
 		std::fill(m_internodeOrderCounts.begin(), m_internodeOrderCounts.end(), 0);
 		const auto& sortedInternodeList = m_shootSkeleton.RefSortedNodeList();
+		std::vector<NodeHandle> reorderedInternodes;
 		for (const auto& internodeHandle : sortedInternodeList)
 		{
 			auto& internode = m_shootSkeleton.RefNode(internodeHandle);
 			const auto order = m_shootSkeleton.RefFlow(internode.GetFlowHandle()).m_data.m_order;
+			if (internode.m_data.m_order != order) reorderedInternodes.emplace_back(internodeHandle);
 			internode.m_data.m_order = order;
 			m_internodeOrderCounts[order]++;
 
@@ -342,8 +447,11 @@ void TreeModel::ShootGrowthPostProcess(const ShootGrowthController& shootGrowthC
 			}
 
 		}
+		m_shootSkeleton.MarkStateChanged(reorderedInternodes);
 		m_shootSkeleton.CalculateFlows();
 	}
+	m_postProcessedChangeVersion = m_shootSkeleton.GetChangeVersion();
+	m_lastPostProcessTime = Times::Now() - startTime;
 }
 
 float TreeModel::GetSubTreeMaxAge(const NodeHandle baseInternodeHandle) const
@@ -388,74 +496,100 @@ bool TreeModel::Reduce(const ShootGrowthController& shootGrowthController, const
 void TreeModel::CalculateTransform(const ShootGrowthController& shootGrowthController, bool sagging)
 {
 	const auto& sortedInternodeList = m_shootSkeleton.RefSortedNodeList();
+	std::vector<NodeHandle> changedInternodes;
 	for (const auto& internodeHandle : sortedInternodeList) {
-		auto& internode = m_shootSkeleton.RefNode(internodeHandle);
-		auto& internodeData = internode.m_data;
-		auto& internodeInfo = internode.m_info;
+		if (UpdateInternodeTransform(internodeHandle, shootGrowthController, sagging)) changedInternodes.emplace_back(internodeHandle);
+		ExpandShootBounds(internodeHandle);
+	}
+	m_shootSkeleton.MarkStateChanged(changedInternodes);
+}
 
-		internodeInfo.m_length = internodeData.m_internodeLength * glm::pow(internodeInfo.m_thickness / shootGrowthController.m_endNodeThickness, shootGrowthController.m_internodeLengthThicknessFactor);
+bool TreeModel::UpdateInternodeTransform(const NodeHandle internodeHandle, const ShootGrowthController& shootGrowthController, const bool sagging)
+{
+	auto& internode = m_shootSkeleton.RefNode(internodeHandle);
+	auto& internodeData = internode.m_data;
+	auto& internodeInfo = internode.m_info;
+	const auto previousInfo = internodeInfo;
+	const auto previousSagging = internodeData.m_sagging;
+	const auto previousDesiredGlobalPosition = internodeData.m_desiredGlobalPosition;
+	const auto previousDesiredGlobalRotation = internodeData.m_desiredGlobalRotation;
 
-		if (internode.GetParentHandle() == -1) {
-			internodeInfo.m_globalPosition = internodeData.m_desiredGlobalPosition = glm::vec3(0.0f);
-			internodeData.m_desiredLocalRotation = glm::vec3(0.0f);
-			internodeInfo.m_globalRotation = internodeInfo.m_regulatedGlobalRotation = internodeData.m_desiredGlobalRotation = glm::vec3(glm::radians(90.0f), 0.0f, 0.0f);
-			internodeInfo.m_globalDirection = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 0, -1));
+	internodeInfo.m_length = internodeData.m_internodeLength * glm::pow(internodeInfo.m_thickness / shootGrowthController.m_endNodeThickness, shootGrowthController.m_internodeLengthThicknessFactor);
+
+	if (internode.GetParentHandle() == -1) {
+		internodeInfo.m_globalPosition = internodeData.m_desiredGlobalPosition = glm::vec3(0.0f);
+		internodeData.m_desiredLocalRotation = glm::vec3(0.0f);
+		internodeInfo.m_globalRotation = internodeInfo.m_regulatedGlobalRotation = internodeData.m_desiredGlobalRotation = glm::vec3(glm::radians(90.0f), 0.0f, 0.0f);
+		internodeInfo.m_globalDirection = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 0, -1));
+	}
+	else {
+		auto& parentInternode = m_shootSkeleton.RefNode(internode.GetParentHandle());
+		const auto newSagging = shootGrowthController.m_sagging(internode);
+		if (glm::abs(newSagging - internodeData.m_sagging) > m_treeGrowthSettings.m_saggingTolerance) internodeData.m_sagging = newSagging;
+		auto parentGlobalRotation = parentInternode.m_info.m_globalRotation;
+		internodeInfo.m_globalRotation = parentGlobalRotation * internodeData.m_desiredLocalRotation;
+		auto front = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 0, -1));
+		auto up = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 1, 0));
+		if (sagging) {
+			float dotP = glm::abs(glm::dot(front, m_currentGravityDirection));
+			ApplyTropism(m_currentGravityDirection, internodeData.m_sagging * (1.0f - dotP), front, up);
+			internodeInfo.m_globalRotation = glm::quatLookAt(front, up);
 		}
-		else {
-			auto& parentInternode = m_shootSkeleton.RefNode(internode.GetParentHandle());
-			internodeData.m_sagging = shootGrowthController.m_sagging(internode);
-			auto parentGlobalRotation = parentInternode.m_info.m_globalRotation;
-			internodeInfo.m_globalRotation = parentGlobalRotation * internodeData.m_desiredLocalRotation;
-			auto front = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 0, -1));
-			auto up = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 1, 0));
-			if (sagging) {
-				float dotP = glm::abs(glm::dot(front, m_currentGravityDirection));
-				ApplyTropism(m_currentGravityDirection, internodeData.m_sagging * (1.0f - dotP), front, up);
-				internodeInfo.m_globalRotation = glm::quatLookAt(front, up);
-			}
-			auto parentRegulatedUp = parentInternode.m_info.m_regulatedGlobalRotation * glm::vec3(0, 1, 0);
-			auto regulatedUp = glm::normalize(glm::cross(glm::cross(front, parentRegulatedUp), front));
-			internodeInfo.m_regulatedGlobalRotation = glm::quatLookAt(front, regulatedUp);
+		auto parentRegulatedUp = parentInternode.m_info.m_regulatedGlobalRotation * glm::vec3(0, 1, 0);
+		auto regulatedUp = glm::normalize(glm::cross(glm::cross(front, parentRegulatedUp), front));
+		internodeInfo.m_regulatedGlobalRotation = glm::quatLookAt(front, regulatedUp);
 
-			internodeInfo.m_globalDirection = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 0, -1));
-			internodeInfo.m_globalPosition =
-				parentInternode.m_info.m_globalPosition
-				+ parentInternode.m_info.m_length * parentInternode.m_info.m_globalDirection;
+		internodeInfo.m_globalDirection = glm::normalize(internodeInfo.m_globalRotation * glm::vec3(0, 0, -1));
+		internodeInfo.m_globalPosition =
+			parentInternode.m_info.m_globalPosition
+			+ parentInternode.m_info.m_length * parentInternode.m_info.m_globalDirection;
 
-			if (shootGrowthController.m_branchPush && !internode.IsApical())
-			{
-				const auto relativeFront = glm::inverse(parentInternode.m_info.m_globalRotation) * internodeInfo.m_globalRotation * glm::vec3(0, 0, -1);
-				auto parentUp = glm::normalize(parentInternode.m_info.m_globalRotation * glm::vec3(0, 1, 0));
-				auto parentLeft = glm::normalize(parentInternode.m_info.m_globalRotation * glm::vec3(1, 0, 0));
-				auto parentFront = glm::normalize(parentInternode.m_info.m_globalRotation * glm::vec3(0, 0, -1));
-				const auto sinValue = glm::sin(glm::acos(glm::dot(parentFront, front)));
-				const auto offset = glm::normalize(glm::vec2(relativeFront.x, relativeFront.y)) * sinValue;
-				internodeInfo.m_globalPosition += parentLeft * parentInternode.m_info.m_thickness * offset.x;
-				internodeInfo.m_globalPosition += parentUp * parentInternode.m_info.m_thickness * offset.y;
-				internodeInfo.m_globalPosition += parentFront * parentInternode.m_info.m_thickness * sinValue;
-			}
-
-			internodeData.m_desiredGlobalRotation = parentInternode.m_data.m_desiredGlobalRotation * internodeData.m_desiredLocalRotation;
-			auto parentDesiredFront = parentInternode.m_data.m_desiredGlobalRotation * glm::vec3(0, 0, -1);
-			internodeData.m_desiredGlobalPosition = parentInternode.m_data.m_desiredGlobalPosition +
-				parentInternode.m_info.m_length * parentDesiredFront;
+		if (shootGrowthController.m_branchPush && !internode.IsApical())
+		{
+			const auto relativeFront = glm::inverse(parentInternode.m_info.m_globalRotation) * internodeInfo.m_globalRotation * glm::vec3(0, 0, -1);
+			auto parentUp = glm::normalize(parentInternode.m_info.m_globalRotation * glm::vec3(0, 1, 0));
+			auto parentLeft = glm::normalize(parentInternode.m_info.m_globalRotation * glm::vec3(1, 0, 0));
+			auto parentFront = glm::normalize(parentInternode.m_info.m_globalRotation * glm::vec3(0, 0, -1));
+			const auto sinValue = glm::sin(glm::acos(glm::dot(parentFront, front)));
+			const auto offset = glm::normalize(glm::vec2(relativeFront.x, relativeFront.y)) * sinValue;
+			internodeInfo.m_globalPosition += parentLeft * parentInternode.m_info.m_thickness * offset.x;
+			internodeInfo.m_globalPosition += parentUp * parentInternode.m_info.m_thickness * offset.y;
+			internodeInfo.m_globalPosition += parentFront * parentInternode.m_info.m_thickness * sinValue;
 		}
 
-		m_shootSkeleton.m_min = glm::min(m_shootSkeleton.m_min, internodeInfo.m_globalPosition);
-		m_shootSkeleton.m_max = glm::max(m_shootSkeleton.m_max, internodeInfo.m_globalPosition);
-		const auto endPosition = internodeInfo.m_globalPosition
-			+ internodeInfo.m_length * internodeInfo.m_globalDirection;
-		m_shootSkeleton.m_min = glm::min(m_shootSkeleton.m_min, endPosition);
-		m_shootSkeleton.m_max = glm::max(m_shootSkeleton.m_max, endPosition);
+		internodeData.m_desiredGlobalRotation = parentInternode.m_data.m_desiredGlobalRotation * internodeData.m_desiredLocalRotation;
+		auto parentDesiredFront = parentInternode.m_data.m_desiredGlobalRotation * glm::vec3(0, 0, -1);
+		internodeData.m_desiredGlobalPosition = parentInternode.m_data.m_desiredGlobalPosition +
+			parentInternode.m_info.m_length * parentDesiredFront;
+	}
+	return internodeInfo.m_globalPosition != previousInfo.m_globalPosition
+		|| internodeInfo.m_globalRotation != previousInfo.m_globalRotation
+		|| internodeInfo.m_regulatedGlobalRotation != previousInfo.m_regulatedGlobalRotation
+		|| internodeInfo.m_length != previousInfo.m_length
+		|| internodeData.m_sagging != previousSagging
+		|| internodeData.m_desiredGlobalPosition != previousDesiredGlobalPosition
+		|| internodeData.m_desiredGlobalRotation != previousDesiredGlobalRotation;
+}
 
-		m_shootSkeleton.m_data.m_desiredMin = glm::min(m_shootSkeleton.m_data.m_desiredMin, internodeData.m_desiredGlobalPosition);
-		m_shootSkeleton.m_data.m_desiredMax = glm::max(m_shootSkeleton.m_data.m_desiredMax, internodeData.m_desiredGlobalPosition);
-		const auto desiredGlobalDirection = internodeData.m_desiredGlobalRotation * glm::vec3(0, 0, -1);
-		const auto desiredEndPosition = internodeData.m_desiredGlobalPosition
-			+ internodeInfo.m_length * desiredGlobalDirection;
-		m_shootSkeleton.m_data.m_desiredMin = glm::min(m_shootSkeleton.m_data.m_desiredMin, desiredEndPosition);
-		m_shootSkeleton.m_data.m_desiredMax = glm::max(m_shootSkeleton.m_data.m_desiredMax, desiredEndPosition);
-	}
+void TreeModel::ExpandShootBounds(const NodeHandle internodeHandle)
+{
+	const auto& internode = m_shootSkeleton.PeekNode(internodeHandle);
+	const auto& internodeData = internode.m_data;
+	const auto& internodeInfo = internode.m_info;
+	m_shootSkeleton.m_min = glm::min(m_shootSkeleton.m_min, internodeInfo.m_globalPosition);
+	m_shootSkeleton.m_max = glm::max(m_shootSkeleton.m_max, internodeInfo.m_globalPosition);
+	const auto endPosition = internodeInfo.m_globalPosition
+		+ internodeInfo.m_length * internodeInfo.m_globalDirection;
+	m_shootSkeleton.m_min = glm::min(m_shootSkeleton.m_min, endPosition);
+	m_shootSkeleton.m_max = glm::max(m_shootSkeleton.m_max, endPosition);
+
+	m_shootSkeleton.m_data.m_desiredMin = glm::min(m_shootSkeleton.m_data.m_desiredMin, internodeData.m_desiredGlobalPosition);
+	m_shootSkeleton.m_data.m_desiredMax = glm::max(m_shootSkeleton.m_data.m_desiredMax, internodeData.m_desiredGlobalPosition);
+	const auto desiredGlobalDirection = internodeData.m_desiredGlobalRotation * glm::vec3(0, 0, -1);
+	const auto desiredEndPosition = internodeData.m_desiredGlobalPosition
+		+ internodeInfo.m_length * desiredGlobalDirection;
+	m_shootSkeleton.m_data.m_desiredMin = glm::min(m_shootSkeleton.m_data.m_desiredMin, desiredEndPosition);
+	m_shootSkeleton.m_data.m_desiredMax = glm::max(m_shootSkeleton.m_data.m_desiredMax, desiredEndPosition);
 }
 
 bool TreeModel::ElongateInternode(float extendLength, NodeHandle internodeHandle,
@@ -466,6 +600,7 @@ bool TreeModel::ElongateInternode(float extendLength, NodeHandle internodeHandle
 	auto& internodeData = internode.m_data;
 	const auto& internodeInfo = internode.m_info;
 	internodeData.m_internodeLength += extendLength;
+	if (extendLength != 0.0f) m_shootSkeleton.MarkChanged(internodeHandle);
 	const float extraLength = internodeData.m_internodeLength - internodeLength;
 	auto& apicalBud = internodeData.m_buds.front();
 	//If we need to add a new end node
@@ -541,6 +676,7 @@ bool TreeModel::ElongateInternode(float extendLength, NodeHandle internodeHandle
 		}
 		//Create new internode
 		const auto newInternodeHandle = m_shootSkeleton.Extend(internodeHandle, false);
+		m_internodeCount++;
 		auto& oldInternode = m_shootSkeleton.RefNode(internodeHandle);
 		auto& newInternode = m_shootSkeleton.RefNode(newInternodeHandle);
 		newInternode.m_data = {};
@@ -606,6 +742,7 @@ bool TreeModel::GrowInternode(ClimateModel& climateModel, NodeHandle internodeHa
 				glm::clamp(1.0f - shootGrowthController.m_apicalDominanceLoss, 0.0f, 1.0f));
 		}
 	}
+	bool budChanged = false;
 	const auto budSize = m_shootSkeleton.RefNode(internodeHandle).m_data.m_buds.size();
 	for (int budIndex = 0; budIndex < budSize; budIndex++) {
 		auto& internode = m_shootSkeleton.RefNode(internodeHandle);
@@ -618,6 +755,7 @@ bool TreeModel::GrowInternode(ClimateModel& climateModel, NodeHandle internodeHa
 		if (bud.m_extinctionRate >= glm::linearRand(0.0f, 1.0f))
 		{
 			bud.m_status = BudStatus::Removed;
+			budChanged = true;
 			continue;
 		}
 		//Calculate vigor used for maintenance and development.
@@ -647,6 +785,7 @@ bool TreeModel::GrowInternode(ClimateModel& climateModel, NodeHandle internodeHa
 			}
 			if (flushProbability >= glm::linearRand(0.0f, 1.0f)) {
 				graphChanged = true;
+				budChanged = true;
 				bud.m_status = BudStatus::Removed;
 				//Prepare information for new internode
 				auto desiredGlobalRotation = internodeInfo.m_globalRotation * bud.m_localRotation;
@@ -656,7 +795,10 @@ bool TreeModel::GrowInternode(ClimateModel& climateModel, NodeHandle internodeHa
 					desiredGlobalUp);
 				ApplyTropism(internodeData.m_lightDirection, shootGrowthController.m_phototropism(internode),
 					desiredGlobalFront, desiredGlobalUp);
-				//Create new internode
+				//Create new internode, the stem of the parent is split in two unless the parent is its last internode.
+				const auto& parentFlow = m_shootSkeleton.PeekFlow(m_shootSkeleton.PeekNode(internodeHandle).GetFlowHandle());
+				m_shootStemCount += parentFlow.RefNodeHandles().back() == internodeHandle ? 1 : 2;
+				m_internodeCount++;
 				const auto newInternodeHandle = m_shootSkeleton.Extend(internodeHandle, true);
 				auto& oldInternode = m_shootSkeleton.RefNode(internodeHandle);
 				auto& newInternode = m_shootSkeleton.RefNode(newInternodeHandle);
@@ -746,10 +888,13 @@ bool TreeModel::GrowInternode(ClimateModel& climateModel, NodeHandle internodeHa
 				if (flushProbability >= glm::linearRand(0.0f, 1.0f))
 				{
 					bud.m_status = BudStatus::Died;
+					budChanged = true;
 				}
 			}
 			else if (bud.m_status == BudStatus::Died)
 			{
+				//The leaf moves with the internode and loses health every iteration.
+				budChanged = true;
 				//Make the leaf larger
 				//const float maxMaturityIncrease = availableDevelopmentVigor / shootGrowthController.m_leafVigorRequirement;
 				//const float maturityIncrease = glm::min(maxMaturityIncrease, glm::min(m_currentDeltaTime * shootGrowthController.m_leafGrowthRate, 1.0f - bud.m_reproductiveModule.m_maturity));
@@ -781,15 +926,19 @@ bool TreeModel::GrowInternode(ClimateModel& climateModel, NodeHandle internodeHa
 			}
 		}
 	}
+	if (budChanged) m_budChangedInternodes.emplace_back(internodeHandle);
 	return graphChanged;
 }
 
 void TreeModel::CalculateLevel()
 {
 	auto& sortedInternodeList = m_shootSkeleton.RefSortedNodeList();
+	std::vector<NodeHandle> changedInternodes;
 	for (const auto& internodeHandle : sortedInternodeList)
 	{
 		auto& node = m_shootSkeleton.RefNode(internodeHandle);
+		//The children are assigned below, when their parent is visited.
+		if (node.m_data.m_growthPotential != 0.0f) changedInternodes.emplace_back(internodeHandle);
 		node.m_data.m_growthPotential = 0.0f;
 		if (node.GetParentHandle() == -1)
 		{
@@ -812,6 +961,8 @@ void TreeModel::CalculateLevel()
 			for (const auto& childHandle : node.RefChildHandles())
 			{
 				auto& childNode = m_shootSkeleton.RefNode(childHandle);
+				const auto previousLevel = childNode.m_data.m_level;
+				const auto previousMaxChild = childNode.m_data.m_maxChild;
 				if (childHandle == maxChild)
 				{
 					childNode.m_data.m_level = node.m_data.m_level;
@@ -822,22 +973,28 @@ void TreeModel::CalculateLevel()
 					childNode.m_data.m_level = node.m_data.m_level + 1;
 					childNode.m_data.m_maxChild = false;
 				}
+				if (childNode.m_data.m_level != previousLevel || childNode.m_data.m_maxChild != previousMaxChild) changedInternodes.emplace_back(childHandle);
 			}
 		}
 		m_shootSkeleton.m_data.m_maxLevel = glm::max(m_shootSkeleton.m_data.m_maxLevel, node.m_data.m_level);
 	}
+	m_shootSkeleton.MarkStateChanged(changedInternodes);
 }
 
 
 void TreeModel::AdjustGrowthRate(const std::vector<NodeHandle>& sortedInternodeList, float factor)
 {
 	const float clampedFactor = glm::clamp(factor, 0.0f, 1.0f);
+	std::vector<NodeHandle> changedInternodes;
 	for (const auto& internodeHandle : sortedInternodeList)
 	{
 		auto& node = m_shootSkeleton.RefNode(internodeHandle);
 		//You cannot give more than enough resources.
-		node.m_data.m_growthRate = clampedFactor * node.m_data.m_desiredGrowthRate;
+		const auto growthRate = clampedFactor * node.m_data.m_desiredGrowthRate;
+		if (node.m_data.m_growthRate != growthRate) changedInternodes.emplace_back(internodeHandle);
+		node.m_data.m_growthRate = growthRate;
 	}
+	m_shootSkeleton.MarkStateChanged(changedInternodes);
 }
 
 float TreeModel::CalculateDesiredGrowthRate(const std::vector<NodeHandle>& sortedInternodeList, const ShootGrowthController& shootGrowthController)
@@ -862,6 +1019,13 @@ float TreeModel::CalculateDesiredGrowthRate(const std::vector<NodeHandle>& sorte
 		apicalControlValues[i] = apicalControlValues[i - 1] * apicalControl;
 	}
 
+	//The growth potential, apical control and desired growth rate of every internode before this pass.
+	std::vector<glm::vec3> previousRates(sortedInternodeList.size());
+	for (size_t i = 0; i < sortedInternodeList.size(); i++)
+	{
+		const auto& nodeData = m_shootSkeleton.PeekNode(sortedInternodeList[i]).m_data;
+		previousRates[i] = glm::vec3(nodeData.m_growthPotential, nodeData.m_apicalControl, nodeData.m_desiredGrowthRate);
+	}
 	for (const auto& internodeHandle : sortedInternodeList)
 	{
 		auto& node = m_shootSkeleton.RefNode(internodeHandle);
@@ -893,63 +1057,185 @@ float TreeModel::CalculateDesiredGrowthRate(const std::vector<NodeHandle>& sorte
 	}
 
 	float totalDesiredGrowthRate = 1.0f;
-	for (const auto& internodeHandle : sortedInternodeList)
+	std::vector<NodeHandle> changedInternodes;
+	for (size_t i = 0; i < sortedInternodeList.size(); i++)
 	{
-		auto& node = m_shootSkeleton.RefNode(internodeHandle);
+		auto& node = m_shootSkeleton.RefNode(sortedInternodeList[i]);
 		node.m_data.m_desiredGrowthRate /= maximumGrowthRate;
 		totalDesiredGrowthRate += node.m_data.m_desiredGrowthRate;
+		if (glm::vec3(node.m_data.m_growthPotential, node.m_data.m_apicalControl, node.m_data.m_desiredGrowthRate) != previousRates[i]) changedInternodes.emplace_back(sortedInternodeList[i]);
 	}
+	m_shootSkeleton.MarkStateChanged(changedInternodes);
 	return totalDesiredGrowthRate;
 
 }
 
 void TreeModel::CalculateThickness(const ShootGrowthController& shootGrowthController) {
 	auto& sortedInternodeList = m_shootSkeleton.RefSortedNodeList();
+	std::vector<NodeHandle> changedInternodes;
 	for (auto it = sortedInternodeList.rbegin(); it != sortedInternodeList.rend(); ++it) {
-		const auto internodeHandle = *it;
-		auto& internode = m_shootSkeleton.RefNode(internodeHandle);
-		const auto& internodeData = internode.m_data;
-		auto& internodeInfo = internode.m_info;
-		float childThicknessCollection = 0.0f;
-		for (const auto& i : internode.RefChildHandles()) {
-			const auto& childInternode = m_shootSkeleton.PeekNode(i);
-			childThicknessCollection += glm::pow(childInternode.m_info.m_thickness,
-				1.0f / shootGrowthController.m_thicknessAccumulationFactor);
-		}
-		childThicknessCollection += shootGrowthController.m_thicknessAccumulateAgeFactor * shootGrowthController.m_endNodeThickness * shootGrowthController.m_internodeGrowthRate * (m_age - internodeData.m_startAge);
-		if (childThicknessCollection != 0.0f) {
-			internodeInfo.m_thickness = glm::pow(childThicknessCollection, shootGrowthController.m_thicknessAccumulationFactor);
-		}
-		else
-		{
-			internodeInfo.m_thickness = glm::max(internodeInfo.m_thickness, shootGrowthController.m_endNodeThickness);
-		}
+		if (UpdateInternodeThickness(*it, shootGrowthController)) changedInternodes.emplace_back(*it);
+	}
+	m_shootSkeleton.MarkStateChanged(changedInternodes);
+}
+
+bool TreeModel::UpdateInternodeThickness(const NodeHandle internodeHandle, const ShootGrowthController& shootGrowthController)
+{
+	auto& internode = m_shootSkeleton.RefNode(internodeHandle);
+	const auto& internodeData = internode.m_data;
+	auto& internodeInfo = internode.m_info;
+	const auto previousThickness = internodeInfo.m_thickness;
+	float childThicknessCollection = 0.0f;
+	for (const auto& i : internode.RefChildHandles()) {
+		const auto& childInternode = m_shootSkeleton.PeekNode(i);
+		childThicknessCollection += glm::pow(childInternode.m_info.m_thickness,
+			1.0f / shootGrowthController.m_thicknessAccumulationFactor);
+	}
+	childThicknessCollection += shootGrowthController.m_thicknessAccumulateAgeFactor * shootGrowthController.m_endNodeThickness * shootGrowthController.m_internodeGrowthRate * (m_age - internodeData.m_startAge);
+	if (childThicknessCollection != 0.0f) {
+		internodeInfo.m_thickness = glm::pow(childThicknessCollection, shootGrowthController.m_thicknessAccumulationFactor);
+	}
+	else
+	{
+		internodeInfo.m_thickness = glm::max(internodeInfo.m_thickness, shootGrowthController.m_endNodeThickness);
 	}
+	return internodeInfo.m_thickness != previousThickness;
 }
+
 void TreeModel::CalculateBiomass(const ShootGrowthController& shootGrowthController)
 {
 	auto& sortedInternodeList = m_shootSkeleton.RefSortedNodeList();
+	std::vector<NodeHandle> changedInternodes;
 	for (auto it = sortedInternodeList.rbegin(); it != sortedInternodeList.rend(); ++it) {
-		const auto internodeHandle = *it;
-		auto& internode = m_shootSkeleton.RefNode(internodeHandle);
-		auto& internodeData = internode.m_data;
-		auto& internodeInfo = internode.m_info;
-		internodeData.m_descendentTotalBiomass = internodeData.m_biomass = 0.0f;
-		internodeData.m_biomass =
-			internodeInfo.m_thickness / shootGrowthController.m_endNodeThickness * internodeData.m_internodeLength /
-			shootGrowthController.m_internodeLength;
-		for (const auto& i : internode.RefChildHandles()) {
-			const auto& childInternode = m_shootSkeleton.RefNode(i);
-			internodeData.m_descendentTotalBiomass +=
-				childInternode.m_data.m_descendentTotalBiomass +
-				childInternode.m_data.m_biomass;
+		if (UpdateInternodeBiomass(*it, shootGrowthController)) changedInternodes.emplace_back(*it);
+	}
+	m_shootSkeleton.MarkStateChanged(changedInternodes);
+}
+
+bool TreeModel::UpdateInternodeBiomass(const NodeHandle internodeHandle, const ShootGrowthController& shootGrowthController)
+{
+	auto& internode = m_shootSkeleton.RefNode(internodeHandle);
+	auto& internodeData = internode.m_data;
+	const auto& internodeInfo = internode.m_info;
+	const auto previousBiomass = internodeData.m_biomass;
+	const auto previousDescendentTotalBiomass = internodeData.m_descendentTotalBiomass;
+	internodeData.m_descendentTotalBiomass = internodeData.m_biomass = 0.0f;
+	internodeData.m_biomass =
+		internodeInfo.m_thickness / shootGrowthController.m_endNodeThickness * internodeData.m_internodeLength /
+		shootGrowthController.m_internodeLength;
+	for (const auto& i : internode.RefChildHandles()) {
+		const auto& childInternode = m_shootSkeleton.PeekNode(i);
+		internodeData.m_descendentTotalBiomass +=
+			childInternode.m_data.m_descendentTotalBiomass +
+			childInternode.m_data.m_biomass;
+	}
+	return internodeData.m_biomass != previousBiomass || internodeData.m_descendentTotalBiomass != previousDescendentTotalBiomass;
+}
+
+bool TreeModel::ShootUpdateParameters::operator==(const ShootUpdateParameters& other) const
+{
+	return m_endNodeThickness == other.m_endNodeThickness
+		&& m_thicknessAccumulationFactor == other.m_thicknessAccumulationFactor
+		&& m_internodeLengthThicknessFactor == other.m_internodeLengthThicknessFactor
+		&& m_internodeLength == other.m_internodeLength
+		&& m_branchPush == other.m_branchPush
+		&& m_gravityDirection == other.m_gravityDirection
+		&& m_saggingTolerance == other.m_saggingTolerance
+		&& m_saggingFactorThicknessReductionMax == other.m_saggingFactorThicknessReductionMax
+		&& m_totalExtraMass == other.m_totalExtraMass;
+}
+
+void TreeModel::UpdateShootIncrementally(const std::vector<NodeHandle>& changedInternodes, const ShootGrowthController& shootGrowthController)
+{
+	//Bit 0: The internode or one of its descendants changed, so its thickness, biomass and sagging need an update.
+	//Bit 1: The transform of the internode changed, so its children need an update.
+	enum : unsigned char { OnChangedPath = 1, TransformChanged = 2 };
+	const auto& sortedInternodeList = m_shootSkeleton.RefSortedNodeList();
+	m_internodeUpdateFlags.assign(m_shootSkeleton.RefRawNodes().size(), 0);
+	for (const auto& internodeHandle : changedInternodes)
+	{
+		auto walker = internodeHandle;
+		while (walker != -1 && !(m_internodeUpdateFlags[walker] & OnChangedPath))
+		{
+			m_internodeUpdateFlags[walker] |= OnChangedPath;
+			walker = m_shootSkeleton.PeekNode(walker).GetParentHandle();
 		}
 	}
+	//Without the age term the thickness and biomass of an internode only depend on its subtree, the internodes off the
+	//changed paths would compute the same values again.
+	std::vector<NodeHandle> updatedInternodes;
+	for (auto it = sortedInternodeList.rbegin(); it != sortedInternodeList.rend(); ++it) {
+		if ((m_internodeUpdateFlags[*it] & OnChangedPath) && UpdateInternodeThickness(*it, shootGrowthController)) updatedInternodes.emplace_back(*it);
+	}
+	for (auto it = sortedInternodeList.rbegin(); it != sortedInternodeList.rend(); ++it) {
+		if ((m_internodeUpdateFlags[*it] & OnChangedPath) && UpdateInternodeBiomass(*it, shootGrowthController)) updatedInternodes.emplace_back(*it);
+	}
+	CalculateLevel();
+	for (const auto& internodeHandle : sortedInternodeList) {
+		auto& flags = m_internodeUpdateFlags[internodeHandle];
+		const auto parentHandle = m_shootSkeleton.PeekNode(internodeHandle).GetParentHandle();
+		//A changed path also changes the thickness of the parent, which moves its children through the length and the branch push.
+		if ((flags & OnChangedPath) || (parentHandle != -1 && m_internodeUpdateFlags[parentHandle] != 0))
+		{
+			if (UpdateInternodeTransform(internodeHandle, shootGrowthController, true))
+			{
+				flags |= TransformChanged;
+				updatedInternodes.emplace_back(internodeHandle);
+			}
+		}
+		ExpandShootBounds(internodeHandle);
+	}
+	m_shootSkeleton.MarkStateChanged(updatedInternodes);
+}
+
+void TreeModel::VerifyIncrementalShootUpdate(const ShootGrowthController& shootGrowthController)
+{
+	auto incrementalSkeleton = m_shootSkeleton;
+	CalculateThickness(shootGrowthController);
+	CalculateBiomass(shootGrowthController);
+	CalculateLevel();
+	CalculateTransform(shootGrowthController, true);
+	int mismatchCount = 0;
+	NodeHandle firstMismatch = -1;
+	float maxPositionError = 0.0f;
+	for (const auto& internodeHandle : m_shootSkeleton.RefSortedNodeList())
+	{
+		const auto& full = m_shootSkeleton.PeekNode(internodeHandle);
+		const auto& incremental = incrementalSkeleton.PeekNode(internodeHandle);
+		maxPositionError = glm::max(maxPositionError, glm::distance(full.m_info.m_globalPosition, incremental.m_info.m_globalPosition));
+		if (full.m_info.m_thickness == incremental.m_info.m_thickness
+			&& full.m_info.m_length == incremental.m_info.m_length
+			&& full.m_info.m_globalPosition == incremental.m_info.m_globalPosition
+			&& full.m_info.m_globalRotation == incremental.m_info.m_globalRotation
+			&& full.m_data.m_biomass == incremental.m_data.m_biomass
+			&& full.m_data.m_descendentTotalBiomass == incremental.m_data.m_descendentTotalBiomass
+			&& full.m_data.m_sagging == incremental.m_data.m_sagging
+			&& full.m_data.m_level == incremental.m_data.m_level) continue;
+		if (firstMismatch == -1) firstMismatch = internodeHandle;
+		mismatchCount++;
+	}
+	const auto internodeCount = std::to_string(m_shootSkeleton.RefSortedNodeList().size());
+	//Keep the incremental result, the check must not change what the tree grows into.
+	m_shootSkeleton = std::move(incrementalSkeleton);
+	if (mismatchCount != 0)
+	{
+		EVOENGINE_ERROR("Incremental shoot update differs from the full passes at " + std::to_string(mismatchCount) + " of " + internodeCount
+			+ " internodes, first at handle " + std::to_string(firstMismatch) + ", max position error " + std::to_string(maxPositionError));
+	}
+	else
+	{
+		EVOENGINE_LOG("Incremental shoot update matches the full passes on " + internodeCount + " internodes");
+	}
 }
+
 void TreeModel::Clear() {
 	m_shootSkeleton = {};
+	m_internodeCount = m_shootStemCount = 1;
 	m_history = {};
+	m_historyCache = {};
+	m_historyCacheIteration = -1;
 	m_initialized = false;
+	m_postProcessedChangeVersion = -1;
 
 	if (m_treeGrowthSettings.m_useSpaceColonization && !m_treeGrowthSettings.m_spaceColonizationAutoResize)
 	{
@@ -974,6 +1260,24 @@ int TreeModel::GetFruitCount() const
 	return m_fruitCount;
 }
 
+int TreeModel::GetInternodeCount() const
+{
+	return m_internodeCount;
+}
+
+int TreeModel::GetShootStemCount() const
+{
+	return m_shootStemCount;
+}
+
+void TreeModel::RecountShoot()
+{
+	m_internodeCount = 0;
+	m_shootStemCount = 0;
+	for (const auto& internode : m_shootSkeleton.RefRawNodes()) if (!internode.IsRecycled()) m_internodeCount++;
+	for (const auto& flow : m_shootSkeleton.RefRawFlows()) if (!flow.IsRecycled()) m_shootStemCount++;
+}
+
 bool TreeModel::PruneInternodes(const glm::mat4& globalTransform, ClimateModel& climateModel, const ShootGrowthController& shootGrowthController) {
 
 	const auto maxDistance = m_shootSkeleton.PeekNode(0).m_info.m_endDistance;
@@ -1074,34 +1378,61 @@ const ShootSkeleton&
 TreeModel::PeekShootSkeleton(const int iteration) const {
 	assert(iteration < 0 || iteration <= m_history.size());
 	if (iteration == m_history.size() || iteration < 0) return m_shootSkeleton;
-	return m_history.at(iteration);
+	if (m_historyCacheIteration != iteration) {
+		if (!m_history.at(iteration).Decode(m_historyCache)) m_historyCache = {};
+		m_historyCacheIteration = iteration;
+	}
+	return m_historyCache;
+}
+
+size_t TreeModel::GetHistoryMemoryUsage() const
+{
+	size_t memoryUsage = 0;
+	for (const auto& snapshot : m_history) memoryUsage += snapshot.GetSize();
+	return memoryUsage;
 }
 
 void TreeModel::ClearHistory() {
 	m_history.clear();
+	m_historyCacheIteration = -1;
 }
 
-void TreeModel::Step() {
-	m_history.emplace_back(m_shootSkeleton);
+void TreeModel::Step(const bool parallel) {
+	m_history.emplace_back().Encode(m_shootSkeleton, false, true, 0.0001f, parallel);
 	if (m_historyLimit > 0) {
 		while (m_history.size() > m_historyLimit) {
 			m_history.pop_front();
 		}
 	}
+	m_historyCacheIteration = -1;
 }
 
 void TreeModel::Pop() {
 	m_history.pop_back();
+	m_historyCacheIteration = -1;
 }
 
 int TreeModel::CurrentIteration() const {
 	return m_history.size();
 }
 
-void TreeModel::Reverse(int iteration) {
+bool TreeModel::Reverse(int iteration) {
 	assert(iteration >= 0 && iteration < m_history.size());
-	m_shootSkeleton = m_history[iteration];
+	const bool hadPipes = !m_shootSkeleton.m_data.m_pipeGroup.PeekPipes().empty();
+	//A checkpoint that failed to decode when peeked is cached as an empty skeleton.
+	if (m_historyCacheIteration == iteration && !m_historyCache.RefSortedNodeList().empty()) m_shootSkeleton = std::move(m_historyCache);
+	else if (!m_history[iteration].Decode(m_shootSkeleton))
+	{
+		EVOENGINE_ERROR("TreeModel: checkpoint " + std::to_string(iteration) + " can not be decoded, the tree is not reversed!");
+		return false;
+	}
+	if (hadPipes) EVOENGINE_WARNING("TreeModel: the checkpoints keep no pipe profiles, prepare the profiles again for checkpoint " + std::to_string(iteration) + ".");
+	RecountShoot();
+	m_historyCache = {};
+	m_historyCacheIteration = -1;
+	m_postProcessedChangeVersion = -1;
 	m_history.erase((m_history.begin() + iteration), m_history.end());
+	return true;
 }
 
 void TreeModel::ExportTreeIOSkeleton(treeio::ArrayTree& arrayTree) const
@@ -1418,7 +1749,7 @@ void TreeModel::PackTask(NodeHandle nodeHandle, const PipeModelParameters& pipeM
 		internodeData.m_frontProfile.Simulate(1,
 			[&](auto& grid, bool gridResized)
 			{
-				if (gridResized || internodeData.m_boundariesUpdated) grid.ApplyBoundaries(internodeData.m_profileConstraints);
+				if (gridResized || internodeData.m_boundariesUpdated) grid.ApplyBoundaries(internodeData.m_profileConstraints, parallel);
 				internodeData.m_boundariesUpdated = false;
 			},
 			[&](auto& particle)
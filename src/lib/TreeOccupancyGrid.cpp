@@ -1,21 +1,81 @@
 #include "TreeOccupancyGrid.hpp"
 
 #include "RadialBoundingVolume.hpp"
+#include "BinvoxVolume.hpp"
 using namespace EcoSysLab;
 
+void TreeOccupancyGrid::GenerateMarkers(const std::function<bool(unsigned voxelIndex)>& filter)
+{
+	const auto voxelCount = m_occupancyGrid.GetVoxelCount();
+	std::vector<unsigned char> selected(voxelCount);
+	Jobs::ParallelFor(voxelCount, [&](unsigned i)
+		{
+			selected[i] = filter(i) ? 1 : 0;
+		}
+	);
+	std::vector<unsigned> offsets(voxelCount + 1);
+	offsets[0] = 0;
+	for (size_t i = 0; i < voxelCount; i++)
+	{
+		offsets[i + 1] = offsets[i] + m_occupancyGrid.Peek(static_cast<int>(i)).m_markerSize + (selected[i] ? static_cast<unsigned>(m_markersPerVoxel) : 0);
+	}
+	std::vector<TreeOccupancyGridMarker> markers(offsets[voxelCount]);
+	const auto voxelSize = m_occupancyGrid.GetVoxelSize();
+	Jobs::ParallelFor(voxelCount, [&](unsigned i)
+		{
+			auto& voxelData = m_occupancyGrid.Ref(static_cast<int>(i));
+			const auto srcBegin = m_markers.begin() + voxelData.m_markerOffset;
+			auto dst = markers.begin() + offsets[i];
+			dst = std::copy(srcBegin, srcBegin + voxelData.m_liveMarkerSize, dst);
+			const unsigned newMarkerSize = selected[i] ? static_cast<unsigned>(m_markersPerVoxel) : 0;
+			const auto center = m_occupancyGrid.GetPosition(static_cast<int>(i));
+			for (unsigned v = 0; v < newMarkerSize; v++)
+			{
+				dst->m_position = center + glm::linearRand(-glm::vec3(voxelSize * 0.5f), glm::vec3(voxelSize * 0.5f));
+				dst->m_nodeHandle = -1;
+				++dst;
+			}
+			std::copy(srcBegin + voxelData.m_liveMarkerSize, srcBegin + voxelData.m_markerSize, dst);
+			voxelData.m_markerOffset = offsets[i];
+			voxelData.m_markerSize += newMarkerSize;
+			voxelData.m_liveMarkerSize += newMarkerSize;
+		}
+	);
+	m_markers.swap(markers);
+}
 
 void TreeOccupancyGrid::ResetMarkers()
 {
 	Jobs::ParallelFor(m_occupancyGrid.GetVoxelCount(), [&](unsigned i)
 		{
 			auto& voxelData = m_occupancyGrid.Ref(static_cast<int>(i));
-
-			for(auto& marker : voxelData.m_markers)
+			voxelData.m_liveMarkerSize = voxelData.m_markerSize;
+			for (unsigned m = voxelData.m_markerOffset; m < voxelData.m_markerOffset + voxelData.m_markerSize; m++)
 			{
-				marker.m_nodeHandle = -1;
+				m_markers[m].m_nodeHandle = -1;
 			}
 		}
 	);
+	ClearNodes();
+}
+
+void TreeOccupancyGrid::RemoveConsumedMarkers()
+{
+	Jobs::ParallelFor(m_occupancyGrid.GetVoxelCount(), [&](unsigned i)
+		{
+			auto& voxelData = m_occupancyGrid.Ref(static_cast<int>(i));
+			if (voxelData.m_liveMarkerSize == 0) return;
+			const auto begin = m_markers.begin() + voxelData.m_markerOffset;
+			//Stable so that the order (and thus the summation order) of the remaining markers is preserved.
+			const auto it = std::stable_partition(begin, begin + voxelData.m_liveMarkerSize, [](const TreeOccupancyGridMarker& marker) { return marker.m_nodeHandle == -1; });
+			voxelData.m_liveMarkerSize = static_cast<unsigned>(it - begin);
+		}
+	);
+}
+
+void TreeOccupancyGrid::Compact()
+{
+	GenerateMarkers([](unsigned) { return false; });
 }
 
 float TreeOccupancyGrid::GetRemovalDistanceFactor() const
@@ -52,17 +112,9 @@ void TreeOccupancyGrid::Initialize(const glm::vec3& min, const glm::vec3& max, c
 	m_internodeLength = internodeLength;
 	m_markersPerVoxel = markersPerVoxel;
 	m_occupancyGrid.Initialize(m_removalDistanceFactor * internodeLength, min, max, {});
-	const auto voxelSize = m_occupancyGrid.GetVoxelSize();
-	Jobs::ParallelFor(m_occupancyGrid.GetVoxelCount(), [&](unsigned i)
-		{
-			auto& voxelData = m_occupancyGrid.Ref(static_cast<int>(i));
-			for (int v = 0; v < m_markersPerVoxel; v++)
-			{
-				auto& newMarker = voxelData.m_markers.emplace_back();
-				newMarker.m_position = m_occupancyGrid.GetPosition(i) + glm::linearRand(-glm::vec3(voxelSize * 0.5f), glm::vec3(voxelSize * 0.5f));
-			}
-		}
-	);
+	m_markers.clear();
+	ClearNodes();
+	GenerateMarkers([](unsigned) { return true; });
 }
 
 void TreeOccupancyGrid::Resize(const glm::vec3& min, const glm::vec3& max)
@@ -71,21 +123,13 @@ void TreeOccupancyGrid::Resize(const glm::vec3& min, const glm::vec3& max)
 	const auto diffMin = glm::floor((min - m_occupancyGrid.GetMinBound() - m_detectionDistanceFactor * m_internodeLength) / voxelSize);
 	const auto diffMax = glm::ceil((max - m_occupancyGrid.GetMaxBound() + m_detectionDistanceFactor * m_internodeLength) / voxelSize);
 	m_occupancyGrid.Resize(-diffMin, diffMax);
+	ClearNodes();
 	const auto newResolution = m_occupancyGrid.GetResolution();
-	Jobs::ParallelFor(m_occupancyGrid.GetVoxelCount(), [&](unsigned i)
+	GenerateMarkers([&](unsigned i)
 		{
 			const auto coordinate = m_occupancyGrid.GetCoordinate(i);
-			
-			if (coordinate.x < -diffMin.x || coordinate.y < -diffMin.y || coordinate.z < -diffMin.z
-				|| coordinate.x >= newResolution.x - diffMax.x || coordinate.y >= newResolution.y - diffMax.y || coordinate.z >= newResolution.z - diffMax.z)
-			{
-				auto& voxelData = m_occupancyGrid.Ref(static_cast<int>(i));
-				for (int v = 0; v < m_markersPerVoxel; v++)
-				{
-					auto& newMarker = voxelData.m_markers.emplace_back();
-					newMarker.m_position = m_occupancyGrid.GetPosition(i) + glm::linearRand(-glm::vec3(voxelSize * 0.5f), glm::vec3(voxelSize * 0.5f));
-				}
-			}
+			return coordinate.x < -diffMin.x || coordinate.y < -diffMin.y || coordinate.z < -diffMin.z
+				|| coordinate.x >= newResolution.x - diffMax.x || coordinate.y >= newResolution.y - diffMax.y || coordinate.z >= newResolution.z - diffMax.z;
 		}
 	);
 }
@@ -99,26 +143,36 @@ void TreeOccupancyGrid::Initialize(const VoxelGrid<TreeOccupancyGridBasicData>&
 	m_internodeLength = internodeLength;
 	m_markersPerVoxel = markersPerVoxel;
 	m_occupancyGrid.Initialize(m_removalDistanceFactor * internodeLength, min, max, {});
-	const auto voxelSize = m_occupancyGrid.GetVoxelSize();
-
-	Jobs::ParallelFor(m_occupancyGrid.GetVoxelCount(), [&](unsigned i)
+	m_markers.clear();
+	ClearNodes();
+	const auto srcGridSize = srcGrid.GetMaxBound() - srcGrid.GetMinBound();
+	GenerateMarkers([&](unsigned i)
 		{
 			const glm::vec3 normalizedPosition = glm::vec3(m_occupancyGrid.GetCoordinate(i)) / glm::vec3(m_occupancyGrid.GetResolution()) - glm::vec3(0.5f, 0.0f, 0.5f);
-			const auto srcGridSize = srcGrid.GetMaxBound() - srcGrid.GetMinBound();
 			const auto srcGridPosition = normalizedPosition * srcGridSize;
-
-			if((srcGrid.IsValid(srcGridPosition) && srcGrid.Peek(srcGrid.GetIndex(srcGridPosition)).m_occupied) || (normalizedPosition.y < 0.8f && glm::length(glm::vec2(normalizedPosition.x, normalizedPosition.z)) < 0.02f))
-			{
-				auto& voxelData = m_occupancyGrid.Ref(static_cast<int>(i));
-				for (int v = 0; v < m_markersPerVoxel; v++)
-				{
-					auto& newMarker = voxelData.m_markers.emplace_back();
-					newMarker.m_position = m_occupancyGrid.GetPosition(i) + glm::linearRand(-glm::vec3(voxelSize * 0.5f), glm::vec3(voxelSize * 0.5f));
-				}
-			}
+			return (srcGrid.IsValid(srcGridPosition) && srcGrid.Peek(srcGrid.GetIndex(srcGridPosition)).m_occupied) || (normalizedPosition.y < 0.8f && glm::length(glm::vec2(normalizedPosition.x, normalizedPosition.z)) < 0.02f);
 		}
 	);
+}
 
+void TreeOccupancyGrid::Initialize(const BinvoxVolume& srcVolume, const glm::vec3& min, const glm::vec3& max, const float internodeLength,
+	const float removalDistanceFactor, const float theta, const float detectionDistanceFactor, const size_t markersPerVoxel)
+{
+	m_removalDistanceFactor = removalDistanceFactor;
+	m_detectionDistanceFactor = detectionDistanceFactor;
+	m_theta = theta;
+	m_internodeLength = internodeLength;
+	m_markersPerVoxel = markersPerVoxel;
+	m_occupancyGrid.Initialize(m_removalDistanceFactor * internodeLength, min, max, {});
+	m_markers.clear();
+	ClearNodes();
+	const auto srcVolumeSize = srcVolume.GetMaxBound() - srcVolume.GetMinBound();
+	GenerateMarkers([&](unsigned i)
+		{
+			const glm::vec3 normalizedPosition = glm::vec3(m_occupancyGrid.GetCoordinate(i)) / glm::vec3(m_occupancyGrid.GetResolution()) - glm::vec3(0.5f, 0.0f, 0.5f);
+			return srcVolume.IsOccupied(normalizedPosition * srcVolumeSize) || (normalizedPosition.y < 0.8f && glm::length(glm::vec2(normalizedPosition.x, normalizedPosition.z)) < 0.02f);
+		}
+	);
 }
 
 void TreeOccupancyGrid::Initialize(const std::shared_ptr<RadialBoundingVolume>& srcRadialBoundingVolume,
@@ -131,19 +185,11 @@ void TreeOccupancyGrid::Initialize(const std::shared_ptr<RadialBoundingVolume>&
 	m_internodeLength = internodeLength;
 	m_markersPerVoxel = markersPerVoxel;
 	m_occupancyGrid.Initialize(m_removalDistanceFactor * internodeLength, min, max, {});
-	const auto voxelSize = m_occupancyGrid.GetVoxelSize();
-
-	Jobs::ParallelFor(m_occupancyGrid.GetVoxelCount(), [&](unsigned i)
+	m_markers.clear();
+	ClearNodes();
+	GenerateMarkers([&](unsigned i)
 		{
-			if (srcRadialBoundingVolume->InVolume(m_occupancyGrid.GetPosition(i)))
-			{
-				auto& voxelData = m_occupancyGrid.Ref(static_cast<int>(i));
-				for (int v = 0; v < m_markersPerVoxel; v++)
-				{
-					auto& newMarker = voxelData.m_markers.emplace_back();
-					newMarker.m_position = m_occupancyGrid.GetPosition(i) + glm::linearRand(-glm::vec3(voxelSize * 0.5f), glm::vec3(voxelSize * 0.5f));
-				}
-			}
+			return srcRadialBoundingVolume->InVolume(m_occupancyGrid.GetPosition(i));
 		}
 	);
 }
@@ -153,6 +199,21 @@ VoxelGrid<TreeOccupancyGridVoxelData>& TreeOccupancyGrid::RefGrid()
 	return m_occupancyGrid;
 }
 
+std::vector<TreeOccupancyGridMarker>& TreeOccupancyGrid::RefMarkers()
+{
+	return m_markers;
+}
+
+const std::vector<TreeOccupancyGridMarker>& TreeOccupancyGrid::PeekMarkers() const
+{
+	return m_markers;
+}
+
+size_t TreeOccupancyGrid::GetMemoryUsage() const
+{
+	return m_occupancyGrid.GetVoxelCount() * sizeof(TreeOccupancyGridVoxelData) + m_markers.capacity() * sizeof(TreeOccupancyGridMarker);
+}
+
 glm::vec3 TreeOccupancyGrid::GetMin() const
 {
 	return m_occupancyGrid.GetMinBound();
@@ -170,8 +231,57 @@ void TreeOccupancyGrid::InsertObstacle(const GlobalTransform &globalTransform, c
 			const auto center = m_occupancyGrid.GetPosition(i);
 			if(cubeVolume->InVolume(globalTransform, center))
 			{
-				m_occupancyGrid.Ref(i).m_markers.clear();
+				auto& voxelData = m_occupancyGrid.Ref(i);
+				voxelData.m_markerSize = voxelData.m_liveMarkerSize = 0;
 			}
 		}
 	);
+	Compact();
+}
+
+void TreeOccupancyGrid::UpdateNode(const NodeHandle nodeHandle, const glm::vec3& position)
+{
+	if (m_occupancyGrid.GetVoxelCount() == 0) return;
+	if (m_nodeBuckets.size() != m_occupancyGrid.GetVoxelCount())
+	{
+		ClearNodes();
+		m_nodeBuckets.resize(m_occupancyGrid.GetVoxelCount());
+	}
+	if (m_nodeVoxelIndices.size() <= nodeHandle) m_nodeVoxelIndices.resize(nodeHandle + 1, -1);
+	const auto coordinate = glm::clamp(m_occupancyGrid.GetCoordinate(position), glm::ivec3(0), m_occupancyGrid.GetResolution() - 1);
+	const auto voxelIndex = m_occupancyGrid.GetIndex(coordinate);
+	if (m_nodeVoxelIndices[nodeHandle] == voxelIndex) return;
+	RemoveNode(nodeHandle);
+	m_nodeBuckets[voxelIndex].emplace_back(nodeHandle);
+	m_nodeVoxelIndices[nodeHandle] = voxelIndex;
+}
+
+void TreeOccupancyGrid::RemoveNode(const NodeHandle nodeHandle)
+{
+	if (m_nodeVoxelIndices.size() <= nodeHandle || m_nodeVoxelIndices[nodeHandle] == -1) return;
+	auto& bucket = m_nodeBuckets[m_nodeVoxelIndices[nodeHandle]];
+	for (auto& handle : bucket)
+	{
+		if (handle != nodeHandle) continue;
+		handle = bucket.back();
+		bucket.pop_back();
+		break;
+	}
+	m_nodeVoxelIndices[nodeHandle] = -1;
+}
+
+void TreeOccupancyGrid::ClearNodes()
+{
+	for (auto& bucket : m_nodeBuckets) bucket.clear();
+	m_nodeVoxelIndices.clear();
 }
+
+const std::vector<int>& TreeOccupancyGrid::PeekNodeVoxelIndices() const
+{
+	return m_nodeVoxelIndices;
+}
+
+const std::vector<NodeHandle>& TreeOccupancyGrid::PeekNodes(const glm::ivec3& coordinate) const
+{
+	return m_nodeBuckets[m_occupancyGrid.GetIndex(coordinate)];
+}
\ No newline at end of file
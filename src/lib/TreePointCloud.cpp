@@ -1,8 +1,10 @@
 #include "TreePointCloud.hpp"
 #include <unordered_set>
+#include <set>
 #include "Graphics.hpp"
 #include "EcoSysLabLayer.hpp"
 #include "rapidcsv.h"
+#include "Times.hpp"
 using namespace EcoSysLab;
 
 void TreePointCloud::ApplyCurve(const OperatorBranch& branch) {
@@ -715,8 +717,28 @@ void TreePointCloud::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
 			BuildVoxelGrid();
 		}
 		if (ImGui::Button("Build Skeleton")) {
+			float startTime = Times::Now();
 			EstablishConnectivityGraph();
+			const float graphTime = Times::Now() - startTime;
+			startTime = Times::Now();
 			BuildSkeletons();
+			const float skeletonTime = Times::Now() - startTime;
+			//The node count and position sum identify the result, so scans can be compared between builds.
+			size_t nodeCount = 0;
+			glm::vec3 positionSum = glm::vec3(0.0f);
+			for (const auto& skeleton : m_skeletons)
+			{
+				for (const auto& node : skeleton.RefRawNodes())
+				{
+					if (node.IsRecycled()) continue;
+					nodeCount++;
+					positionSum += node.m_info.m_globalPosition;
+				}
+			}
+			EVOENGINE_LOG("Connectivity graph: " + std::to_string(graphTime * 1000.0f) + "ms, skeletons: " + std::to_string(skeletonTime * 1000.0f)
+				+ "ms, " + std::to_string(m_skeletons.size()) + " skeletons, " + std::to_string(m_branchConnections.size()) + " branch connections, "
+				+ std::to_string(nodeCount) + " nodes, position sum (" + std::to_string(positionSum.x) + ", " + std::to_string(positionSum.y) + ", "
+				+ std::to_string(positionSum.z) + ")");
 			refreshData = true;
 		}
 		m_treeMeshGeneratorSettings.OnInspect(editorLayer);
@@ -1467,41 +1489,53 @@ void TreePointCloud::BuildSkeletons() {
 			shortenedLength * 0.25f;
 	}
 
-	bool branchRemoved = true;
-	while (branchRemoved)
+	//For every branch, the branches that list it as a parent candidate, once per entry.
+	std::vector<std::vector<BranchHandle>> childCandidateHandles(m_operatingBranches.size());
+	for (const auto& operatingBranch : m_operatingBranches)
 	{
-		branchRemoved = false;
-		std::vector<BranchHandle> removeList{};
-		for (int i = 0; i < m_operatingBranches.size(); i++)
+		for (const auto& parentCandidate : operatingBranch.m_parentCandidates)
 		{
-			if (rootBranchHandleSet.find(i) != rootBranchHandleSet.end()) continue;
-			auto& operatingBranch = m_operatingBranches[i];
-			if (!operatingBranch.m_orphan && operatingBranch.m_parentCandidates.empty())
-			{
-				operatingBranch.m_orphan = true;
-				removeList.emplace_back(i);
-			}
+			childCandidateHandles[parentCandidate.first].emplace_back(operatingBranch.m_handle);
 		}
-		if (!removeList.empty())
+	}
+	//A branch without parent candidates that is not a root becomes orphan, which in turn removes it from the candidates of
+	//its children. Each candidate entry is visited once.
+	std::vector<size_t> remainingCandidateSizes(m_operatingBranches.size());
+	std::vector<BranchHandle> removeList{};
+	for (int i = 0; i < m_operatingBranches.size(); i++)
+	{
+		remainingCandidateSizes[i] = m_operatingBranches[i].m_parentCandidates.size();
+		if (rootBranchHandleSet.find(i) != rootBranchHandleSet.end()) continue;
+		if (remainingCandidateSizes[i] == 0)
+		{
+			m_operatingBranches[i].m_orphan = true;
+			removeList.emplace_back(i);
+		}
+	}
+	while (!removeList.empty())
+	{
+		const auto removeHandle = removeList.back();
+		removeList.pop_back();
+		for (const auto& childHandle : childCandidateHandles[removeHandle])
 		{
-			branchRemoved = true;
-			for (auto& operatingBranch : m_operatingBranches)
+			auto& childBranch = m_operatingBranches[childHandle];
+			remainingCandidateSizes[childHandle]--;
+			if (remainingCandidateSizes[childHandle] == 0 && !childBranch.m_orphan
+				&& rootBranchHandleSet.find(childHandle) == rootBranchHandleSet.end())
 			{
-				for (int i = 0; i < operatingBranch.m_parentCandidates.size(); i++)
-				{
-					for (const auto& removeHandle : removeList) {
-						if (operatingBranch.m_parentCandidates[i].first == removeHandle)
-						{
-							operatingBranch.m_parentCandidates.erase(operatingBranch.m_parentCandidates.begin() + i);
-							i--;
-							break;
-						}
-					}
-				}
+				childBranch.m_orphan = true;
+				removeList.emplace_back(childHandle);
 			}
 		}
 	}
 	for (auto& operatingBranch : m_operatingBranches)
+	{
+		auto& parentCandidates = operatingBranch.m_parentCandidates;
+		parentCandidates.erase(std::remove_if(parentCandidates.begin(), parentCandidates.end(),
+			[&](const std::pair<BranchHandle, float>& parentCandidate) { return m_operatingBranches[parentCandidate.first].m_orphan; }),
+			parentCandidates.end());
+	}
+	for (auto& operatingBranch : m_operatingBranches)
 	{
 		for (const auto& parentCandidate : operatingBranch.m_parentCandidates) {
 			const auto& parentBranch = m_predictedBranches[parentCandidate.first];
@@ -1527,19 +1561,32 @@ void TreePointCloud::BuildSkeletons() {
 		ApplyCurve(processingBranch);
 	}
 
-	std::multimap<float, BranchHandle> heightSortedBranches{};
-	for (const auto& i : m_operatingBranches)
+	std::vector<BranchHandle> heightSortedBranches(m_operatingBranches.size());
+	for (int i = 0; i < m_operatingBranches.size(); i++) heightSortedBranches[i] = m_operatingBranches[i].m_handle;
+	std::stable_sort(heightSortedBranches.begin(), heightSortedBranches.end(), [&](const BranchHandle a, const BranchHandle b)
+		{
+			return m_operatingBranches[a].m_bezierCurve.m_p0.y < m_operatingBranches[b].m_bezierCurve.m_p0.y;
+		});
+	std::vector<size_t> heightOrders(m_operatingBranches.size());
+	for (size_t i = 0; i < heightSortedBranches.size(); i++) heightOrders[heightSortedBranches[i]] = i;
+
+	//Branches are allocated in sweeps over the height sorted branches, a branch can only find a parent after one of its candidates
+	//got used. So instead of rescanning all branches, a branch is only visited once a candidate is used: later in the same sweep
+	//if it comes after that candidate, in the next sweep otherwise. This allocates in the same order as repeated full sweeps.
+	std::set<size_t> currentSweep{};
+	std::set<size_t> nextSweep{};
+	for (const auto& rootBranchHandle : rootBranchHandles)
 	{
-		heightSortedBranches.insert({ i.m_bezierCurve.m_p0.y, i.m_handle });
+		for (const auto& childHandle : childCandidateHandles[rootBranchHandle.second]) currentSweep.emplace(heightOrders[childHandle]);
 	}
-
-	bool newBranchAllocated = true;
-	while (newBranchAllocated)
+	while (!currentSweep.empty())
 	{
-		newBranchAllocated = false;
-		for (const auto& branchPair : heightSortedBranches)
+		while (!currentSweep.empty())
 		{
-			auto& childBranch = m_operatingBranches[branchPair.second];
+			const auto heightOrder = *currentSweep.begin();
+			currentSweep.erase(currentSweep.begin());
+			const auto childHandle = heightSortedBranches[heightOrder];
+			auto& childBranch = m_operatingBranches[childHandle];
 			if (childBranch.m_orphan || childBranch.m_used || childBranch.m_parentCandidates.empty()) continue;
 			BranchHandle bestParentHandle = -1;
 			float bestDistance = FLT_MAX;
@@ -1570,13 +1617,19 @@ void TreePointCloud::BuildSkeletons() {
 			{
 				childBranch.m_parentCandidates[maxIndex] = childBranch.m_parentCandidates.back();
 				childBranch.m_parentCandidates.pop_back();
-				newBranchAllocated = true;
-				Link(branchPair.second, bestParentHandle);
+				Link(childHandle, bestParentHandle);
 				childBranch.m_rootDistance = bestRootDistance;
 				childBranch.m_bestDistance = bestDistance;
 				childBranch.m_distanceToParentBranch = bestParentDistance;
+				for (const auto& grandChildHandle : childCandidateHandles[childHandle])
+				{
+					const auto grandChildHeightOrder = heightOrders[grandChildHandle];
+					if (grandChildHeightOrder > heightOrder) currentSweep.emplace(grandChildHeightOrder);
+					else nextSweep.emplace(grandChildHeightOrder);
+				}
 			}
 		}
+		std::swap(currentSweep, nextSweep);
 	}
 	bool optimized = true;
 	int iteration = 0;
@@ -1627,7 +1680,6 @@ void TreePointCloud::BuildSkeletons() {
 			{
 				childBranch.m_parentCandidates[maxIndex] = childBranch.m_parentCandidates.back();
 				childBranch.m_parentCandidates.pop_back();
-				newBranchAllocated = true;
 				Unlink(childBranch.m_handle, childBranch.m_parentHandle);
 				Link(childBranch.m_handle, bestParentHandle);
 				childBranch.m_rootDistance = bestRootDistance;
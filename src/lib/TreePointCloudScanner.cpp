@@ -11,10 +11,10 @@ using namespace tinyply;
 using namespace EcoSysLab;
 
 
-void TreePointCloudScanner::Capture(const std::filesystem::path& savePath, const std::shared_ptr<PointCloudCaptureSettings>& captureSettings) const
+bool TreePointCloudScanner::Scan(const std::shared_ptr<PointCloudCaptureSettings>& captureSettings, ScannedPointCloud& pointCloud) const
 {
 #ifdef BUILD_WITH_RAYTRACER
-	
+
 	const auto ecoSysLabLayer = Application::GetLayer<EcoSysLabLayer>();
 	std::shared_ptr<Soil> soil;
 	const auto soilCandidate = EcoSysLabLayer::FindSoil();
@@ -22,7 +22,7 @@ void TreePointCloudScanner::Capture(const std::filesystem::path& savePath, const
 	if(!soil)
 	{
 		EVOENGINE_ERROR("No soil!");
-		return;
+		return false;
 	}
 	std::unordered_map<Handle, Handle> branchMeshRendererHandles, foliageMeshRendererHandles;
 	Bound plantBound{};
@@ -32,7 +32,7 @@ void TreePointCloudScanner::Capture(const std::filesystem::path& savePath, const
 	if(treeEntities == nullptr)
 	{
 		EVOENGINE_ERROR("No trees!");
-		return;
+		return false;
 	}
 	for (const auto& treeEntity : *treeEntities) {
 		if (scene->IsEntityValid(treeEntity)) {
@@ -92,16 +92,21 @@ void TreePointCloudScanner::Capture(const std::filesystem::path& savePath, const
 		Application::GetLayer<RayTracerLayer>()->m_environmentProperties,
 		pcSamples);
 	
-	std::vector<glm::vec3> points;
+	auto& points = pointCloud.m_points;
+	auto& internodeIndex = pointCloud.m_internodeIndex;
+	auto& branchIndex = pointCloud.m_branchIndex;
+	auto& treePartIndex = pointCloud.m_treePartIndex;
+	auto& lineIndex = pointCloud.m_lineIndex;
+	auto& instanceIndex = pointCloud.m_instanceIndex;
+	auto& typeIndex = pointCloud.m_typeIndex;
+	points.clear();
+	internodeIndex.clear();
+	branchIndex.clear();
+	treePartIndex.clear();
+	lineIndex.clear();
+	instanceIndex.clear();
+	typeIndex.clear();
 
-	std::vector<int> internodeIndex;
-	std::vector<int> branchIndex;
-	std::vector<int> treePartIndex;
-	std::vector<int> lineIndex;
-	std::vector<int> instanceIndex;
-	std::vector<int> typeIndex;
-
-	
 
 	for (const auto& sample : pcSamples) {
 		if (!sample.m_hit) continue;
@@ -177,6 +182,25 @@ void TreePointCloudScanner::Capture(const std::filesystem::path& savePath, const
 			}
 		}
 	}
+	return true;
+#else
+	EVOENGINE_ERROR("Point cloud scanning requires the ray tracer!");
+	return false;
+#endif
+}
+
+void TreePointCloudScanner::Capture(const std::filesystem::path& savePath, const std::shared_ptr<PointCloudCaptureSettings>& captureSettings) const
+{
+	ScannedPointCloud pointCloud;
+	if (!Scan(captureSettings, pointCloud)) return;
+	auto& points = pointCloud.m_points;
+	auto& internodeIndex = pointCloud.m_internodeIndex;
+	auto& branchIndex = pointCloud.m_branchIndex;
+	auto& treePartIndex = pointCloud.m_treePartIndex;
+	auto& lineIndex = pointCloud.m_lineIndex;
+	auto& instanceIndex = pointCloud.m_instanceIndex;
+	auto& typeIndex = pointCloud.m_typeIndex;
+
 	std::filebuf fb_binary;
 	fb_binary.open(savePath.string(), std::ios::out | std::ios::binary);
 	std::ostream outstream_binary(&fb_binary);
@@ -230,7 +254,6 @@ void TreePointCloudScanner::Capture(const std::filesystem::path& savePath, const
 	}
 	// Write a binary file
 	cube_file.write(outstream_binary, true);
-#endif
 }
 
 void TreePointCloudScanner::OnInspect(const std::shared_ptr<EditorLayer>& editorLayer)
@@ -232,22 +232,69 @@ void TreeVisualizer::SyncMatrices(const ShootSkeleton& skeleton, const std::shar
 	particleInfoList->SetPendingUpdate();
 	matrices.resize(sortedNodeList.size());
 	Jobs::ParallelFor(sortedNodeList.size(), [&](unsigned i) {
-		const auto nodeHandle = sortedNodeList[i];
+		matrices[i].m_instanceMatrix.m_value = GetInternodeMatrix(skeleton.PeekNode(sortedNodeList[i]).m_info);
+		});
+}
+
+glm::mat4 TreeVisualizer::GetInternodeMatrix(const NodeInfo& nodeInfo)
+{
+	const glm::vec3 position = nodeInfo.m_globalPosition;
+	const auto direction = nodeInfo.m_globalDirection;
+	auto rotation = glm::quatLookAt(
+		direction, glm::vec3(direction.y, direction.z, direction.x));
+	rotation *= glm::quat(glm::vec3(glm::radians(90.0f), 0.0f, 0.0f));
+	const glm::mat4 rotationTransform = glm::mat4_cast(rotation);
+	return glm::translate(position + (nodeInfo.m_length / 2.0f) * direction) *
+		rotationTransform *
+		glm::scale(glm::vec3(
+			nodeInfo.m_thickness * 2.0f,
+			nodeInfo.m_length,
+			nodeInfo.m_thickness * 2.0f));
+}
+
+bool TreeVisualizer::SyncChangedInternodes(const ShootSkeleton& skeleton)
+{
+	//The instances follow the sorted node list, so only a skeleton with unchanged structure can be patched in place.
+	auto& matrices = m_internodeMatrices->m_particleInfos;
+	if (m_syncedIteration != m_checkpointIteration || m_syncedVersion != skeleton.GetVersion()
+		|| m_syncedChangeVersion > skeleton.GetChangeVersion() || matrices.size() != skeleton.RefSortedNodeList().size()
+		|| m_randomColors.empty()) return false;
+	if (!skeleton.CollectChangedNodes(m_syncedChangeVersion, m_changedInternodes)) return false;
+	if (m_changedInternodes.empty()) return true;
+	Jobs::ParallelFor(m_changedInternodes.size(), [&](unsigned i) {
+		const auto nodeHandle = m_changedInternodes[i];
 		const auto& node = skeleton.PeekNode(nodeHandle);
-		const glm::vec3 position = node.m_info.m_globalPosition;
-		const auto direction = node.m_info.m_globalDirection;
-		auto rotation = glm::quatLookAt(
-			direction, glm::vec3(direction.y, direction.z, direction.x));
-		rotation *= glm::quat(glm::vec3(glm::radians(90.0f), 0.0f, 0.0f));
-		const glm::mat4 rotationTransform = glm::mat4_cast(rotation);
-		matrices[i].m_instanceMatrix.m_value =
-			glm::translate(position + (node.m_info.m_length / 2.0f) * direction) *
-			rotationTransform *
-			glm::scale(glm::vec3(
-				node.m_info.m_thickness * 2.0f,
-				node.m_info.m_length,
-				node.m_info.m_thickness * 2.0f));
+		auto& particleInfo = matrices[m_internodeInstanceIndices[nodeHandle]];
+		particleInfo.m_instanceMatrix.m_value = GetInternodeMatrix(node.m_info);
+		particleInfo.m_instanceColor = GetInternodeColor(node);
+		});
+	m_internodeMatrices->SetPendingUpdate();
+	return true;
+}
+
+void TreeVisualizer::VerifyInternodeInstances(const ShootSkeleton& skeleton) const
+{
+	const auto& sortedNodeList = skeleton.RefSortedNodeList();
+	const auto& matrices = m_internodeMatrices->m_particleInfos;
+	std::vector<int> mismatches(sortedNodeList.size(), 0);
+	Jobs::ParallelFor(sortedNodeList.size(), [&](unsigned i) {
+		const auto& node = skeleton.PeekNode(sortedNodeList[i]);
+		if (matrices[i].m_instanceMatrix.m_value != GetInternodeMatrix(node.m_info)
+			|| matrices[i].m_instanceColor != GetInternodeColor(node)) mismatches[i] = 1;
 		});
+	int mismatchCount = 0;
+	NodeHandle firstMismatch = -1;
+	for (int i = 0; i < sortedNodeList.size(); i++) {
+		if (!mismatches[i]) continue;
+		if (firstMismatch == -1) firstMismatch = sortedNodeList[i];
+		mismatchCount++;
+	}
+	if (mismatchCount != 0) {
+		EVOENGINE_ERROR("Incremental sync differs from a full sync at " + std::to_string(mismatchCount) + " internodes, first at handle " + std::to_string(firstMismatch));
+	}
+	else {
+		EVOENGINE_LOG("Incremental sync matches a full sync, " + std::to_string(m_changedInternodes.size()) + " of " + std::to_string(sortedNodeList.size()) + " internodes patched");
+	}
 }
 
 bool TreeVisualizer::DrawInternodeInspectionGui(
@@ -320,7 +367,10 @@ TreeVisualizer::OnInspect(
 			m_needUpdate = true;
 		}
 		if (m_checkpointIteration != treeModel.CurrentIteration() && ImGui::Button("Reverse")) {
-			treeModel.Reverse(m_checkpointIteration);
+			//The tree stays at the current iteration if the checkpoint can not be decoded, so the slider goes back to it.
+			if (!treeModel.Reverse(m_checkpointIteration)) m_checkpointIteration = treeModel.CurrentIteration();
+			m_selectedInternodeHandle = -1;
+			m_selectedInternodeHierarchyList.clear();
 			m_needUpdate = true;
 		}
 		if (ImGui::Button("Clear checkpoints")) {
@@ -357,6 +407,7 @@ TreeVisualizer::OnInspect(
 		ImGui::Checkbox("Front Profile", &m_frontProfileGui);
 		ImGui::Checkbox("Back Profile", &m_backProfileGui);
 		ImGui::Checkbox("Tree Hierarchy", &m_treeHierarchyGui);
+		ImGui::Checkbox("Verify incremental sync", &m_verifyIncrementalSync);
 
 		if (m_visualization) {
 			const auto& treeSkeleton = treeModel.PeekShootSkeleton(m_checkpointIteration);
@@ -406,8 +457,20 @@ void TreeVisualizer::Visualize(TreeModel& treeModel, const GlobalTransform& glob
 		const auto editorLayer = Application::GetLayer<EditorLayer>();
 		const auto ecoSysLabLayer = Application::GetLayer<EcoSysLabLayer>();
 		if (m_needUpdate) {
-			SyncMatrices(treeSkeleton, m_internodeMatrices);
-			SyncColors(treeSkeleton, m_selectedInternodeHandle);
+			if (!m_needShootColorUpdate && SyncChangedInternodes(treeSkeleton)) {
+				if (m_verifyIncrementalSync) VerifyInternodeInstances(treeSkeleton);
+			}
+			else {
+				SyncMatrices(treeSkeleton, m_internodeMatrices);
+				SyncColors(treeSkeleton, m_selectedInternodeHandle);
+				const auto& sortedNodeList = treeSkeleton.RefSortedNodeList();
+				m_internodeInstanceIndices.resize(treeSkeleton.RefRawNodes().size());
+				for (int i = 0; i < sortedNodeList.size(); i++) m_internodeInstanceIndices[sortedNodeList[i]] = i;
+				m_needShootColorUpdate = false;
+			}
+			m_syncedIteration = m_checkpointIteration;
+			m_syncedVersion = treeSkeleton.GetVersion();
+			m_syncedChangeVersion = treeSkeleton.GetChangeVersion();
 			m_needUpdate = false;
 		}
 		else {
@@ -772,6 +835,7 @@ TreeVisualizer::InspectInternode(
 		}
 		ImGui::TreePop();
 	}
+	if (changed) shootSkeleton.MarkChanged(internodeHandle);
 	return changed;
 }
 
@@ -872,6 +936,7 @@ void TreeVisualizer::Reset(TreeModel& treeModel) {
 	m_checkpointIteration = treeModel.CurrentIteration();
 	m_internodeMatrices->m_particleInfos.clear();
 	m_internodeMatrices->SetPendingUpdate();
+	m_syncedIteration = -1;
 	m_needUpdate = true;
 }
 
@@ -881,6 +946,7 @@ void TreeVisualizer::Clear() {
 	m_checkpointIteration = 0;
 	m_internodeMatrices->m_particleInfos.clear();
 	m_internodeMatrices->SetPendingUpdate();
+	m_syncedIteration = -1;
 }
 
 
@@ -907,47 +973,51 @@ void TreeVisualizer::SyncColors(const ShootSkeleton& shootSkeleton, const NodeHa
 	m_internodeMatrices->SetPendingUpdate();
 	matrices.resize(sortedNodeList.size());
 	Jobs::ParallelFor(sortedNodeList.size(), [&](unsigned i) {
-		const auto nodeHandle = sortedNodeList[i];
-		const auto& node = shootSkeleton.PeekNode(nodeHandle);
-		switch (static_cast<ShootVisualizerMode>(m_settings.m_shootVisualizationMode)) {
-		case ShootVisualizerMode::Default:
-			matrices[i].m_instanceColor = m_randomColors[nodeHandle % m_randomColors.size()];
-			break;
-		case ShootVisualizerMode::Order:
-			matrices[i].m_instanceColor = m_randomColors[node.m_data.m_order];
-			break;
-		case ShootVisualizerMode::Level:
-			matrices[i].m_instanceColor = m_randomColors[node.m_data.m_level];
-			break;
-		case ShootVisualizerMode::LightIntensity:
-			matrices[i].m_instanceColor = glm::vec4(
-				glm::clamp(glm::pow(node.m_data.m_lightIntensity, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
-			break;
-		case ShootVisualizerMode::LightDirection:
-			matrices[i].m_instanceColor = glm::vec4(glm::vec3(glm::clamp(node.m_data.m_lightDirection, 0.0f, 1.f)),
-				1.0f);
-			break;
-		case ShootVisualizerMode::IsMaxChild:
-			matrices[i].m_instanceColor = glm::vec4(glm::vec3(node.m_data.m_maxChild ? 1.0f : 0.0f), 1.0f);
-			break;
-		case ShootVisualizerMode::GrowthPotential:
-			matrices[i].m_instanceColor = glm::vec4(
-				glm::clamp(glm::pow(node.m_data.m_growthPotential, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
-			break;
-		case ShootVisualizerMode::ApicalControl:
-			matrices[i].m_instanceColor = glm::vec4(
-				glm::clamp(glm::pow(node.m_data.m_apicalControl, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
-			break;
-		case ShootVisualizerMode::DesiredGrowthRate:
-			matrices[i].m_instanceColor = glm::vec4(
-				glm::clamp(glm::pow(node.m_data.m_desiredGrowthRate, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
-			break;
-		default:
-			matrices[i].m_instanceColor = m_randomColors[node.m_data.m_order];
-			break;
-		}
-		matrices[i].m_instanceColor.a = 1.0f;
-		if (selectedNodeHandle != -1) matrices[i].m_instanceColor.a = 1.0f;
+		matrices[i].m_instanceColor = GetInternodeColor(shootSkeleton.PeekNode(sortedNodeList[i]));
 		}
 	);
 }
+
+glm::vec4 TreeVisualizer::GetInternodeColor(const Node<InternodeGrowthData>& node) const
+{
+	glm::vec4 color;
+	switch (static_cast<ShootVisualizerMode>(m_settings.m_shootVisualizationMode)) {
+	case ShootVisualizerMode::Default:
+		color = m_randomColors[node.GetHandle() % m_randomColors.size()];
+		break;
+	case ShootVisualizerMode::Order:
+		color = m_randomColors[node.m_data.m_order];
+		break;
+	case ShootVisualizerMode::Level:
+		color = m_randomColors[node.m_data.m_level];
+		break;
+	case ShootVisualizerMode::LightIntensity:
+		color = glm::vec4(
+			glm::clamp(glm::pow(node.m_data.m_lightIntensity, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
+		break;
+	case ShootVisualizerMode::LightDirection:
+		color = glm::vec4(glm::vec3(glm::clamp(node.m_data.m_lightDirection, 0.0f, 1.f)),
+			1.0f);
+		break;
+	case ShootVisualizerMode::IsMaxChild:
+		color = glm::vec4(glm::vec3(node.m_data.m_maxChild ? 1.0f : 0.0f), 1.0f);
+		break;
+	case ShootVisualizerMode::GrowthPotential:
+		color = glm::vec4(
+			glm::clamp(glm::pow(node.m_data.m_growthPotential, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
+		break;
+	case ShootVisualizerMode::ApicalControl:
+		color = glm::vec4(
+			glm::clamp(glm::pow(node.m_data.m_apicalControl, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
+		break;
+	case ShootVisualizerMode::DesiredGrowthRate:
+		color = glm::vec4(
+			glm::clamp(glm::pow(node.m_data.m_desiredGrowthRate, m_settings.m_shootColorMultiplier), 0.0f, 1.f));
+		break;
+	default:
+		color = m_randomColors[node.m_data.m_order];
+		break;
+	}
+	color.a = 1.0f;
+	return color;
+}
@@ -213,11 +213,14 @@ void EcoSysLab::VoxelSoilModel::BuildFromLayers()
 	auto rain_field = Field(m_w.size());
 	rain_field = 0.f;
 	// Height axis is Y:
-	
-	for(auto x=0; x<m_resolution.x; ++x)
-	{
-		for(auto z=0; z<m_resolution.z; ++z)
+
+	// The layer boundaries only depend on the column, so find the material of every voxel column by column.
+	const auto layerSize = static_cast<int>(m_soilLayers.size());
+	std::vector<int> layerIndices(m_w.size());
+	Jobs::ParallelFor(m_resolution.x * m_resolution.z, [&](unsigned columnIndex)
 		{
+			const int x = columnIndex % m_resolution.x;
+			const int z = columnIndex / m_resolution.x;
 			auto pos = GetPositionFromCoordinate({x, 0, z}); // y value does not matter
 			vec2 pos_2d(pos.x, pos.z);
 			auto groundHeight = glm::clamp(m_soilSurface.m_height({pos.x, pos.z}), m_boundingBoxMin.y, m_boundingBoxMin.y + m_resolution.y * m_dx);
@@ -228,22 +231,79 @@ void EcoSysLab::VoxelSoilModel::BuildFromLayers()
 			if(CoordinateInsideVolume(rain_coord))
 				rain_field[Index(rain_coord)] = 0.1;
 
+			// top of each layer, layer 0 starts at the ground
+			std::vector<float> layerHeights(layerSize);
+			layerHeights[0] = groundHeight;
+			for(auto idx = 1; idx < layerSize; ++idx)
+			{
+				layerHeights[idx] = layerHeights[idx - 1] - glm::max(0.f, m_soilLayers[idx].m_thickness(pos_2d));
+			}
+
 			for(auto y= m_resolution.y - 1; y >= 0; --y)
 			{
-				float current_height = groundHeight;
 				auto voxel_height = m_boundingBoxMin.y + y*m_dx + (m_dx/2.0);
 
 				// find material index:
 				auto idx = 0;
-				while(voxel_height < current_height && idx < m_soilLayers.size()-1)
+				while(voxel_height < layerHeights[idx] && idx < layerSize-1)
 				{
 					idx++;
-					current_height -= glm::max(0.f, m_soilLayers[idx].m_thickness(pos_2d));
 				}
-
-				SetVoxel({x, y, z}, m_soilLayers[idx].m_mat);
+				layerIndices[Index(x, y, z)] = idx;
 			}
 		}
+	);
+
+	// Group the voxels by layer, then evaluate each layer's material in slabs.
+	std::vector<int> layerOffsets(layerSize + 1, 0);
+	for (const auto& layerIndex : layerIndices) layerOffsets[layerIndex + 1]++;
+	for (auto idx = 0; idx < layerSize; ++idx) layerOffsets[idx + 1] += layerOffsets[idx];
+	std::vector<int> voxelIndices(layerIndices.size());
+	{
+		auto layerCursors = layerOffsets;
+		for (int i = 0; i < layerIndices.size(); ++i) voxelIndices[layerCursors[layerIndices[i]]++] = i;
+	}
+
+	constexpr int slabSize = 4096;
+	for (auto idx = 0; idx < layerSize; ++idx)
+	{
+		const auto& material = m_soilLayers[idx].m_mat;
+		const auto layerStart = layerOffsets[idx];
+		const auto layerEnd = layerOffsets[idx + 1];
+		const auto slabCount = (layerEnd - layerStart + slabSize - 1) / slabSize;
+		Jobs::ParallelFor(slabCount, [&](unsigned slabIndex)
+			{
+				const auto slabStart = layerStart + static_cast<int>(slabIndex) * slabSize;
+				const auto slabEnd = glm::min(slabStart + slabSize, layerEnd);
+				std::vector<glm::vec3> positions(slabEnd - slabStart);
+				for (auto i = slabStart; i < slabEnd; ++i)
+				{
+					positions[i - slabStart] = GetPositionFromCoordinate(GetCoordinateFromIndex(voxelIndices[i]));
+				}
+				if (material.m_batch)
+				{
+					SoilPhysicalProperties properties;
+					material.m_batch(positions, properties);
+					for (auto i = slabStart; i < slabEnd; ++i)
+					{
+						const auto voxelIndex = voxelIndices[i];
+						m_material_id[voxelIndex] = material.m_id;
+						m_c[voxelIndex] = properties.m_c[i - slabStart];
+						m_p[voxelIndex] = properties.m_p[i - slabStart];
+						m_d[voxelIndex] = properties.m_d[i - slabStart];
+						m_n[voxelIndex] = properties.m_n[i - slabStart];
+						m_w[voxelIndex] = properties.m_w[i - slabStart];
+					}
+				}
+				else
+				{
+					for (auto i = slabStart; i < slabEnd; ++i)
+					{
+						SetVoxel(GetCoordinateFromIndex(voxelIndices[i]), material);
+					}
+				}
+			}
+		);
 	}
 
 	// blur everything to make it smooth
@@ -926,6 +986,8 @@ void VoxelSoilModel::ChangeField(Field& field, const vec3& center, float amount_
 			}
 		}
 	}
+	//Update version so the visualization and cached texture slices are also updated.
+	m_version++;
 }
 
 
@@ -1177,113 +1239,163 @@ void VoxelSoilModel::GetSoilTextureSlideZ(bool backFacing, float z, const glm::v
 	std::vector<float> &metallicData,
 	glm::ivec2& outputResolution, 
 	float waterFactor, float nutrientFactor,
-	float blur_width)
+	float blur_width, int level)
 {
-	const float rangeX = glm::clamp(xyMax.x, 0.0f, 0.99f) - glm::clamp(xyMin.x, 0.0f, 0.99f);
-	const float rangeY = glm::clamp(xyMax.y, 0.0f, 0.99f) - glm::clamp(xyMin.y, 0.0f, 0.99f);
-	outputResolution.x = rangeX * m_materialTextureResolution.x;
-	outputResolution.y = rangeY * m_materialTextureResolution.y;
+	const int layer = glm::clamp(z, 0.0f, 0.99f) * m_resolution.z;
+	const auto& slice = GetTextureSlice(2, layer, level, waterFactor, nutrientFactor, blur_width);
+	CopyTextureSlice(slice, backFacing, xyMin, xyMax, albedoData, normalData, roughnessData, metallicData, outputResolution);
+}
 
-	const float slize_z_position = GetPositionFromCoordinate(ivec3(0, 0, glm::clamp(z, 0.0f, 0.99f) * m_resolution.z)).z;
-	const float tex_dx = m_dx * static_cast<float>(m_resolution.x) / static_cast<float>(m_materialTextureResolution.x);
-	const float tex_dy = m_dx * static_cast<float>(m_resolution.y) / static_cast<float>(m_materialTextureResolution.y);
 
-	const int texCoordXStart = glm::clamp(xyMin.x, 0.0f, 0.99f) * static_cast<float>(m_materialTextureResolution.x);
-	const int texCoordYStart = glm::clamp(xyMin.y, 0.0f, 0.99f) * static_cast<float>(m_materialTextureResolution.y);
+void VoxelSoilModel::GetSoilTextureSlideX(bool backFacing, float x, const glm::vec2& yzMin, const glm::vec2& yzMax, std::vector<glm::vec4> &albedoData,
+	std::vector<glm::vec3> &normalData,
+	std::vector<float> &roughnessData,
+	std::vector<float> &metallicData,
+	glm::ivec2& outputResolution,
+	float waterFactor, float nutrientFactor,
+	float blur_width, int level)
+{
+	const int layer = glm::clamp(x, 0.0f, 0.99f) * m_resolution.x;
+	const auto& slice = GetTextureSlice(0, layer, level, waterFactor, nutrientFactor, blur_width);
+	CopyTextureSlice(slice, backFacing, yzMin, yzMax, albedoData, normalData, roughnessData, metallicData, outputResolution);
+}
+
+void VoxelSoilModel::ClearTextureSlices()
+{
+	m_textureSlices.clear();
+}
 
-	albedoData.resize(outputResolution.x * outputResolution.y);
-	normalData.resize(outputResolution.x * outputResolution.y);
-	roughnessData.resize(outputResolution.x * outputResolution.y);
-	metallicData.resize(outputResolution.x * outputResolution.y);
+const VoxelSoilModel::SoilTextureSlice& VoxelSoilModel::GetTextureSlice(int axis, int layer, int level, float waterFactor, float nutrientFactor, float blur_width)
+{
+	// slices of an older state of the soil are of no use anymore
+	m_textureSlices.erase(std::remove_if(m_textureSlices.begin(), m_textureSlices.end(),
+		[&](const SoilTextureSlice& slice) { return slice.m_version != m_version; }), m_textureSlices.end());
 
-	for (auto texCoordX = 0; texCoordX < outputResolution.x; ++texCoordX)
+	level = glm::clamp(level, 0, 8);
+	for (auto it = m_textureSlices.begin(); it != m_textureSlices.end(); ++it)
 	{
-		for (auto texCoordY = 0; texCoordY < outputResolution.y; ++texCoordY)
+		if (it->m_axis == axis && it->m_layer == layer && it->m_level == level && it->m_waterFactor == waterFactor
+			&& it->m_nutrientFactor == nutrientFactor && it->m_blurWidth == blur_width)
 		{
-			auto outputTex_idx = (backFacing ? outputResolution.x - texCoordX - 1 : texCoordX) + texCoordY * outputResolution.x;
-			auto texture_idx = texCoordXStart + texCoordX + (texCoordYStart + texCoordY) * m_materialTextureResolution.x;
-			int gridCoordX = texCoordXStart + texCoordX;
-			int gridCoordY = texCoordYStart + texCoordY;
-			glm::vec3 texel_position = GetPositionFromCoordinate(ivec3(gridCoordX, gridCoordY, 0), tex_dx, tex_dy, m_dx);
-			texel_position.z = slize_z_position;
-			if (!PositionInsideVolume(texel_position))
+			// move to the back so it is the last one to be evicted
+			std::rotate(it, it + 1, m_textureSlices.end());
+			return m_textureSlices.back();
+		}
+	}
+
+	SoilTextureSlice slice;
+	if (!m_textureSlices.empty() && m_textureSlices.size() >= static_cast<size_t>(glm::max(m_maxCachedTextureSlices, 1)))
+	{
+		// recycle the buffers of the least recently used slice
+		slice = std::move(m_textureSlices.front());
+		m_textureSlices.erase(m_textureSlices.begin());
+	}
+	slice.m_axis = axis;
+	slice.m_layer = layer;
+	slice.m_level = level;
+	slice.m_waterFactor = waterFactor;
+	slice.m_nutrientFactor = nutrientFactor;
+	slice.m_blurWidth = blur_width;
+	slice.m_version = m_version;
+	GenerateTextureSlice(slice);
+	m_textureSlices.emplace_back(std::move(slice));
+	return m_textureSlices.back();
+}
+
+void VoxelSoilModel::GenerateTextureSlice(SoilTextureSlice& slice) const
+{
+	const int stride = 1 << slice.m_level;
+	slice.m_resolution = glm::max((m_materialTextureResolution + stride - 1) / stride, ivec2(1));
+	const auto texelCount = slice.m_resolution.x * slice.m_resolution.y;
+	slice.m_albedo.resize(texelCount);
+	slice.m_normal.resize(texelCount);
+	slice.m_roughness.resize(texelCount);
+	slice.m_metallic.resize(texelCount);
+
+	// the horizontal texture axis runs along z for x slices and along x for z slices, the vertical one along y
+	const float tex_dh = m_dx * static_cast<float>(slice.m_axis == 0 ? m_resolution.z : m_resolution.x) / static_cast<float>(m_materialTextureResolution.x);
+	const float tex_dy = m_dx * static_cast<float>(m_resolution.y) / static_cast<float>(m_materialTextureResolution.y);
+	const float slice_position = slice.m_axis == 0
+		? GetPositionFromCoordinate(ivec3(slice.m_layer, 0, 0)).x
+		: GetPositionFromCoordinate(ivec3(0, 0, slice.m_layer)).z;
+
+	Jobs::ParallelFor(slice.m_resolution.y, [&](unsigned row)
+		{
+			for (auto column = 0; column < slice.m_resolution.x; ++column)
 			{
-				albedoData[outputTex_idx] = glm::vec4(0.f);
-				normalData[outputTex_idx] = glm::vec3(0, 0, 1);
-				roughnessData[outputTex_idx] = 0.8f;
-				metallicData[outputTex_idx] = 0.2f;
-			}else{
-				GetSoilTextureColorForPosition(texel_position, texture_idx, blur_width,
-					albedoData[outputTex_idx],
-					normalData[outputTex_idx],
-					roughnessData[outputTex_idx],
-					metallicData[outputTex_idx], waterFactor, nutrientFactor
-				);
-				albedoData[outputTex_idx] = glm::vec4(1.0f);
-				if(texel_position.y > m_soilSurface.m_height({ texel_position.x, texel_position.z }) + 0.01f)
+				const auto slice_idx = column + row * slice.m_resolution.x;
+				const int texCoordX = glm::min(column * stride, m_materialTextureResolution.x - 1);
+				const int texCoordY = glm::min(static_cast<int>(row) * stride, m_materialTextureResolution.y - 1);
+				const auto texture_idx = texCoordX + texCoordY * m_materialTextureResolution.x;
+				glm::vec3 texel_position;
+				if (slice.m_axis == 0)
 				{
-					albedoData[outputTex_idx].w = 0.0f;
+					texel_position = GetPositionFromCoordinate(ivec3(0, texCoordY, texCoordX), m_dx, tex_dy, tex_dh);
+					texel_position.x = slice_position;
+				}
+				else
+				{
+					texel_position = GetPositionFromCoordinate(ivec3(texCoordX, texCoordY, 0), tex_dh, tex_dy, m_dx);
+					texel_position.z = slice_position;
+				}
+				if (!PositionInsideVolume(texel_position))
+				{
+					slice.m_albedo[slice_idx] = glm::vec4(0.f);
+					slice.m_normal[slice_idx] = glm::vec3(0, 0, 1);
+					slice.m_roughness[slice_idx] = 0.8f;
+					slice.m_metallic[slice_idx] = 0.2f;
+				}
+				else
+				{
+					GetSoilTextureColorForPosition(texel_position, texture_idx, slice.m_blurWidth,
+						slice.m_albedo[slice_idx],
+						slice.m_normal[slice_idx],
+						slice.m_roughness[slice_idx],
+						slice.m_metallic[slice_idx], slice.m_waterFactor, slice.m_nutrientFactor
+					);
+					slice.m_albedo[slice_idx] = glm::vec4(1.0f);
+					if (texel_position.y > m_soilSurface.m_height({ texel_position.x, texel_position.z }) + 0.01f)
+					{
+						slice.m_albedo[slice_idx].w = 0.0f;
+					}
 				}
 			}
 		}
-	}
+	);
 }
 
-
-void VoxelSoilModel::GetSoilTextureSlideX(bool backFacing, float x, const glm::vec2& yzMin, const glm::vec2& yzMax, std::vector<glm::vec4> &albedoData,
-	std::vector<glm::vec3> &normalData,
-	std::vector<float> &roughnessData,
-	std::vector<float> &metallicData,
-	glm::ivec2& outputResolution,
-	float waterFactor, float nutrientFactor,
-	float blur_width)
-{
-	const float rangeZ = glm::clamp(yzMax.x, 0.0f, 0.99f) - glm::clamp(yzMin.x, 0.0f, 0.99f);
-	const float rangeY = glm::clamp(yzMax.y, 0.0f, 0.99f) - glm::clamp(yzMin.y, 0.0f, 0.99f);
-	outputResolution.x = rangeZ * m_materialTextureResolution.x;
-	outputResolution.y = rangeY * m_materialTextureResolution.y;
-	const float slize_x_position = GetPositionFromCoordinate(ivec3(glm::clamp(x, 0.0f, 0.99f) * m_resolution.x, 0, 0)).x;
-	const float tex_dz = m_dx * static_cast<float>(m_resolution.z) / static_cast<float>(m_materialTextureResolution.x);
-	const float tex_dy = m_dx * static_cast<float>(m_resolution.y) / static_cast<float>(m_materialTextureResolution.y);
-
-	const int texCoordXStart = glm::clamp(yzMin.x, 0.0f, 0.99f) * static_cast<float>(m_materialTextureResolution.x);
-	const int texCoordYStart = glm::clamp(yzMin.y, 0.0f, 0.99f) * static_cast<float>(m_materialTextureResolution.y);
+void VoxelSoilModel::CopyTextureSlice(const SoilTextureSlice& slice, bool backFacing, const glm::vec2& rangeMin, const glm::vec2& rangeMax,
+	std::vector<glm::vec4>& albedoData,
+	std::vector<glm::vec3>& normalData,
+	std::vector<float>& roughnessData,
+	std::vector<float>& metallicData,
+	glm::ivec2& outputResolution) const
+{
+	const int stride = 1 << slice.m_level;
+	const auto clampedMin = glm::clamp(rangeMin, glm::vec2(0.0f), glm::vec2(0.99f));
+	const auto clampedMax = glm::clamp(rangeMax, glm::vec2(0.0f), glm::vec2(0.99f));
+	const ivec2 fullResolution((clampedMax - clampedMin) * glm::vec2(m_materialTextureResolution));
+	outputResolution = fullResolution / stride;
+	// a coarser level must not drop a range that is visible at full resolution
+	if (fullResolution.x > 0) outputResolution.x = glm::max(outputResolution.x, 1);
+	if (fullResolution.y > 0) outputResolution.y = glm::max(outputResolution.y, 1);
+	outputResolution = glm::max(outputResolution, ivec2(0));
+	const ivec2 start = glm::max(glm::min(ivec2(clampedMin * glm::vec2(m_materialTextureResolution)) / stride, slice.m_resolution - outputResolution), ivec2(0));
 
 	albedoData.resize(outputResolution.x * outputResolution.y);
 	normalData.resize(outputResolution.x * outputResolution.y);
 	roughnessData.resize(outputResolution.x * outputResolution.y);
 	metallicData.resize(outputResolution.x * outputResolution.y);
-
-	for (auto texCoordX = 0; texCoordX < outputResolution.x; ++texCoordX)
+	for (auto texCoordY = 0; texCoordY < outputResolution.y; ++texCoordY)
 	{
-		for (auto texCoordY = 0; texCoordY < outputResolution.y; ++texCoordY)
+		for (auto texCoordX = 0; texCoordX < outputResolution.x; ++texCoordX)
 		{
-			auto outputTex_idx = (backFacing ? outputResolution.x - texCoordX - 1 : texCoordX) + texCoordY * outputResolution.x;
-			auto texture_idx = texCoordXStart + texCoordX + (texCoordYStart + texCoordY) * m_materialTextureResolution.x;
-			int gridCoordZ = texCoordXStart + texCoordX;
-			int gridCoordY = texCoordYStart + texCoordY;
-			glm::vec3 texel_position = GetPositionFromCoordinate(ivec3(0, gridCoordY, gridCoordZ), m_dx, tex_dy, tex_dz);
-			texel_position.x = slize_x_position;
-			if (!PositionInsideVolume(texel_position)) {
-				albedoData[outputTex_idx] = glm::vec4(0.f);
-				normalData[outputTex_idx] = glm::vec3(0, 0, 1);
-				roughnessData[outputTex_idx] = 0.8f;
-				metallicData[outputTex_idx] = 0.2f;
-			}
-			else
-			{
-				GetSoilTextureColorForPosition(texel_position, texture_idx, blur_width,
-					albedoData[outputTex_idx],
-					normalData[outputTex_idx],
-					roughnessData[outputTex_idx],
-					metallicData[outputTex_idx], waterFactor, nutrientFactor
-					);
-				albedoData[outputTex_idx] = glm::vec4(1.0f);
-				if (texel_position.y > m_soilSurface.m_height({ texel_position.x, texel_position.z }) + 0.01f)
-				{
-					albedoData[outputTex_idx].w = 0.0f;
-				}
-			}
+			const auto outputTex_idx = (backFacing ? outputResolution.x - texCoordX - 1 : texCoordX) + texCoordY * outputResolution.x;
+			const auto slice_idx = start.x + texCoordX + (start.y + texCoordY) * slice.m_resolution.x;
+			albedoData[outputTex_idx] = slice.m_albedo[slice_idx];
+			normalData[outputTex_idx] = slice.m_normal[slice_idx];
+			roughnessData[outputTex_idx] = slice.m_roughness[slice_idx];
+			metallicData[outputTex_idx] = slice.m_metallic[slice_idx];
 		}
 	}
 }
@@ -1292,13 +1404,19 @@ void VoxelSoilModel::GetSoilTextureSlideX(bool backFacing, float x, const glm::v
 void EcoSysLab::VoxelSoilModel::GetSoilTextureColorForPosition(const glm::vec3& position, int texture_idx, float blur_width, glm::vec4& albedo,
 	glm::vec3& normal,
 	float& roughness,
-	float& metallic, float waterFactor, float nutrientFactor)
+	float& metallic, float waterFactor, float nutrientFactor) const
 {
 	const float blur_kernel_width = m_dx*m_dx * blur_width * blur_width;
 	auto soil_voxel_base = GetCoordinateFromPosition(position);
-	std::map<int, float> contributing_materials; // we need to store the total some for each material:
-
-												 // do some gaussian blending
+	// we need to store the total sum for each material. The kernel covers at most 27 voxels and thus 27 materials,
+	// so the sums live in a fixed array on the stack instead of a map per texel
+	constexpr int max_contributing_materials = 27;
+	assert(m_blur_3x3_idx.size() <= max_contributing_materials);
+	int contributing_material_ids[max_contributing_materials];
+	float contributing_material_weights[max_contributing_materials];
+	int contributing_material_count = 0;
+
+	// do some gaussian blending
 	float waterLevel = 0.0f;
 	float nutrientLevel = 0.0f;
 	for(auto i=0; i<m_blur_3x3_idx.size(); ++i) // iterate over blur kernel
@@ -1331,11 +1449,17 @@ void EcoSysLab::VoxelSoilModel::GetSoilTextureColorForPosition(const glm::vec3&
 			// compute weight:
 			const float weight = glm::exp(- dist*dist / blur_kernel_width);
 
-			if( contributing_materials.find(material_id) == contributing_materials.end())
-				contributing_materials[material_id] = 0;
+			int slot = 0;
+			while (slot < contributing_material_count && contributing_material_ids[slot] != material_id) ++slot;
+			if (slot == contributing_material_count)
+			{
+				contributing_material_ids[slot] = material_id;
+				contributing_material_weights[slot] = 0;
+				++contributing_material_count;
+			}
 
 			auto heightmap_height = texPtr->m_height_map[texture_idx];
-			contributing_materials[material_id] += weight * heightmap_height * heightmap_height;
+			contributing_material_weights[slot] += weight * heightmap_height * heightmap_height;
 			//total_weight +=  weight * tex.m_height_map[texture_idx];
 
 			//output_color += tex.m_color_map[texture_idx] * weight;
@@ -1363,10 +1487,10 @@ void EcoSysLab::VoxelSoilModel::GetSoilTextureColorForPosition(const glm::vec3&
 	normal = glm::vec3(0.f);
 	metallic = 0.0f;
 	roughness = 0.0f;
-	for(auto& p : contributing_materials)
+	for(auto slot = 0; slot < contributing_material_count; ++slot)
 	{
-		auto weight = p.second * p.second;
-		auto& textures = m_soilLayers[p.first].m_mat.m_soilMaterialTexture;
+		auto weight = contributing_material_weights[slot] * contributing_material_weights[slot];
+		auto& textures = m_soilLayers[contributing_material_ids[slot]].m_mat.m_soilMaterialTexture;
 		albedo += textures->m_color_map[texture_idx] * weight;
 		normal += textures->m_normal_map[texture_idx] * weight;
 		metallic += textures->m_metallic_map[texture_idx] * weight;
@@ -1,4 +1,5 @@
 #include "pybind11/pybind11.h"
+#include "pybind11/numpy.h"
 #include "pybind11/stl/filesystem.h"
 #include "AnimationPlayer.hpp"
 #include "Application.hpp"
@@ -454,6 +455,180 @@ void RBVSpaceColonizationTreeData(
 	scene->DeleteEntity(tempEntity);
 }
 
+#pragma region NumPy
+/**
+ * Hand the storage of the vector over to a NumPy array without copying. The vector is moved into a heap holder whose lifetime is tied to the array through a capsule.
+ */
+template <typename Scalar, typename Element>
+py::array_t<Scalar> ToNumPy(std::vector<Element>&& data, const std::vector<py::ssize_t>& shape)
+{
+	static_assert(sizeof(Element) % sizeof(Scalar) == 0, "Element must be made of scalars!");
+	auto* holder = new std::vector<Element>(std::move(data));
+	py::capsule owner(holder, [](void* p) { delete static_cast<std::vector<Element>*>(p); });
+	return py::array_t<Scalar>(shape, reinterpret_cast<const Scalar*>(holder->data()), owner);
+}
+
+/**
+ * Expose a field of an array of structures as a strided NumPy view. The array keeps the owner of the storage alive, nothing is copied.
+ * @param owner The object that owns the storage.
+ * @param data The first scalar of the field in the first element.
+ * @param count The number of elements.
+ * @param stride The size of one element in bytes.
+ * @param components The number of scalars of the field, 1 for a flat array.
+ */
+template <typename Scalar, typename Owner>
+py::array_t<Scalar> ViewNumPy(const std::shared_ptr<Owner>& owner, const Scalar* data, const size_t count, const size_t stride, const size_t components)
+{
+	auto* holder = new std::shared_ptr<Owner>(owner);
+	py::capsule base(holder, [](void* p) { delete static_cast<std::shared_ptr<Owner>*>(p); });
+	const auto n = static_cast<py::ssize_t>(count);
+	if (components == 1) return py::array_t<Scalar>({ n }, { static_cast<py::ssize_t>(stride) }, data, base);
+	return py::array_t<Scalar>({ n, static_cast<py::ssize_t>(components) },
+		{ static_cast<py::ssize_t>(stride), static_cast<py::ssize_t>(sizeof(Scalar)) }, data, base);
+}
+
+/**
+ * The node arrays are views into the nodes of the skeleton and are indexed by node handle, recycled handles included.
+ * "handles" lists the live nodes from root to ends and "parents" holds the parent handle of every node (-1 for the root and recycled nodes).
+ */
+py::dict SkeletonToNumPy(const std::shared_ptr<ShootSkeleton>& skeleton)
+{
+	const auto& nodes = skeleton->RefRawNodes();
+	const auto& sortedNodeList = skeleton->RefSortedNodeList();
+	const auto nodeSize = nodes.size();
+	constexpr auto stride = sizeof(Node<InternodeGrowthData>);
+	//The parent handle is not a public field of the node, it is the only array that is gathered.
+	std::vector<int> parents(nodeSize, -1);
+	for (const auto& nodeHandle : sortedNodeList) parents[nodeHandle] = skeleton->PeekNode(nodeHandle).GetParentHandle();
+	const auto& firstInfo = nodes.front().m_info;
+	py::dict retVal;
+	retVal["positions"] = ViewNumPy(skeleton, &firstInfo.m_globalPosition.x, nodeSize, stride, 3);
+	//glm stores the quaternion as x, y, z, w.
+	retVal["rotations"] = ViewNumPy(skeleton, &firstInfo.m_globalRotation.x, nodeSize, stride, 4);
+	retVal["thickness"] = ViewNumPy(skeleton, &firstInfo.m_thickness, nodeSize, stride, 1);
+	retVal["length"] = ViewNumPy(skeleton, &firstInfo.m_length, nodeSize, stride, 1);
+	retVal["handles"] = ViewNumPy(skeleton, sortedNodeList.data(), sortedNodeList.size(), sizeof(NodeHandle), 1);
+	retVal["parents"] = ToNumPy<int>(std::move(parents), { static_cast<py::ssize_t>(nodeSize) });
+	return retVal;
+}
+
+/**
+ * The arrays are views into the vertices and triangles of the mesh.
+ */
+py::dict MeshToNumPy(const std::shared_ptr<Mesh>& mesh)
+{
+	const auto& vertices = mesh->UnsafeGetVertices();
+	const auto& triangles = mesh->UnsafeGetTriangles();
+	py::dict retVal;
+	if (vertices.empty() || triangles.empty())
+	{
+		retVal["vertices"] = py::array_t<float>(std::vector<py::ssize_t>{ 0, 3 });
+		retVal["normals"] = py::array_t<float>(std::vector<py::ssize_t>{ 0, 3 });
+		retVal["uvs"] = py::array_t<float>(std::vector<py::ssize_t>{ 0, 2 });
+		retVal["indices"] = py::array_t<unsigned>(std::vector<py::ssize_t>{ 0, 3 });
+		return retVal;
+	}
+	constexpr auto stride = sizeof(Vertex);
+	retVal["vertices"] = ViewNumPy(mesh, &vertices.front().m_position.x, vertices.size(), stride, 3);
+	retVal["normals"] = ViewNumPy(mesh, &vertices.front().m_normal.x, vertices.size(), stride, 3);
+	retVal["uvs"] = ViewNumPy(mesh, &vertices.front().m_texCoord.x, vertices.size(), stride, 2);
+	retVal["indices"] = ViewNumPy(mesh, &triangles.front().x, triangles.size(), sizeof(glm::uvec3), 3);
+	return retVal;
+}
+
+py::dict PointCloudToNumPy(ScannedPointCloud&& pointCloud)
+{
+	const auto pointSize = static_cast<py::ssize_t>(pointCloud.m_points.size());
+	py::dict retVal;
+	retVal["points"] = ToNumPy<float>(std::move(pointCloud.m_points), { pointSize, 3 });
+	const auto addLabels = [&](const char* name, std::vector<int>& labels)
+		{
+			if (static_cast<py::ssize_t>(labels.size()) == pointSize) retVal[name] = ToNumPy<int>(std::move(labels), { pointSize });
+		};
+	addLabels("internode_index", pointCloud.m_internodeIndex);
+	addLabels("branch_index", pointCloud.m_branchIndex);
+	addLabels("tree_part_index", pointCloud.m_treePartIndex);
+	addLabels("line_index", pointCloud.m_lineIndex);
+	addLabels("instance_index", pointCloud.m_instanceIndex);
+	addLabels("type_index", pointCloud.m_typeIndex);
+	return retVal;
+}
+
+/**
+ * Grow a single tree in the active scene and return its skeleton and meshes as NumPy arrays, without touching the disk.
+ * Only the new tree grows, the other trees of the scene are left as they are. Errors are raised as Python exceptions.
+ */
+py::dict Grow(
+	const std::string& treeParametersPath,
+	const int iterations,
+	const int seed,
+	const float deltaTime,
+	const TreeMeshGeneratorSettings& meshGeneratorSettings)
+{
+	const auto applicationStatus = Application::GetApplicationStatus();
+	if (applicationStatus == ApplicationStatus::NoProject) throw std::runtime_error("No project!");
+	if (applicationStatus == ApplicationStatus::OnDestroy) throw std::runtime_error("Application is destroyed!");
+	if (applicationStatus == ApplicationStatus::Uninitialized) throw std::runtime_error("Application not initialized!");
+	const auto scene = Application::GetActiveScene();
+	const auto ecoSysLabLayer = Application::GetLayer<EcoSysLabLayer>();
+	if (!ecoSysLabLayer) throw std::runtime_error("Application doesn't contain EcoSysLab layer!");
+	const auto soil = EcoSysLabLayer::FindSoil().lock();
+	if (!soil) throw std::runtime_error("No soil in scene!");
+	const auto climate = EcoSysLabLayer::FindClimate().lock();
+	if (!climate) throw std::runtime_error("No climate in scene!");
+	if (!ProjectManager::IsInProjectFolder(treeParametersPath))
+	{
+		throw py::value_error("Tree parameters " + treeParametersPath + " are not in the project folder!");
+	}
+	const auto treeDescriptor = std::dynamic_pointer_cast<TreeDescriptor>(ProjectManager::GetOrCreateAsset(ProjectManager::GetPathRelativeToProject(treeParametersPath)));
+	if (!treeDescriptor) throw py::value_error(treeParametersPath + " is not a tree descriptor!");
+
+	const auto tempEntity = scene->CreateEntity("Temp");
+	const auto tree = scene->GetOrSetPrivateComponent<Tree>(tempEntity).lock();
+	tree->m_soil = soil;
+	tree->m_climate = climate;
+	tree->m_treeDescriptor = treeDescriptor;
+	tree->m_treeModel.m_seed = seed;
+	Application::Loop();
+	for (int i = 0; i < iterations; i++)
+	{
+		climate->PrepareForGrowth();
+		tree->TryGrow(deltaTime, 0, true, -1);
+	}
+
+	py::dict retVal;
+	if (meshGeneratorSettings.m_enableBranch) retVal["branch_mesh"] = MeshToNumPy(tree->GenerateBranchMesh(meshGeneratorSettings));
+	if (meshGeneratorSettings.m_enableFoliage) retVal["foliage_mesh"] = MeshToNumPy(tree->GenerateFoliageMesh(meshGeneratorSettings));
+	//The meshes are built, the skeleton moves to the arrays instead of being copied.
+	retVal["skeleton"] = SkeletonToNumPy(std::make_shared<ShootSkeleton>(std::move(tree->m_treeModel.RefShootSkeleton())));
+	scene->DeleteEntity(tempEntity);
+	return retVal;
+}
+
+/**
+ * Scan the trees in the active scene and return the points and their labels as NumPy arrays, without writing a PLY file.
+ * Raises if the scan fails, for example when the ray tracer is not available.
+ */
+py::dict ScanPointCloud(
+	const PointCloudPointSettings& pointSettings,
+	const PointCloudCircularCaptureSettings& captureSettings)
+{
+#ifndef BUILD_WITH_RAYTRACER
+	throw std::runtime_error("Point cloud scanning requires the ray tracer!");
+#else
+	const auto scene = Application::GetActiveScene();
+	const auto tempEntity = scene->CreateEntity("Temp");
+	const auto scanner = scene->GetOrSetPrivateComponent<TreePointCloudScanner>(tempEntity).lock();
+	scanner->m_pointSettings = pointSettings;
+	ScannedPointCloud pointCloud;
+	const bool scanned = scanner->Scan(std::make_shared<PointCloudCircularCaptureSettings>(captureSettings), pointCloud);
+	scene->DeleteEntity(tempEntity);
+	if (!scanned) throw std::runtime_error("Point cloud scanning failed!");
+	return PointCloudToNumPy(std::move(pointCloud));
+#endif
+}
+#pragma endregion
+
 PYBIND11_MODULE(pyecosyslab, m) {
 	py::class_<Entity>(m, "Entity")
 		.def("GetIndex", &Entity::GetIndex)
@@ -584,6 +759,10 @@ PYBIND11_MODULE(pyecosyslab, m) {
 	m.def("voxel_space_colonization_tree_data", &VoxelSpaceColonizationTreeData, "VoxelSpaceColonizationTreeData");
 	m.def("rbv_space_colonization_tree_data", &RBVSpaceColonizationTreeData, "RBVSpaceColonizationTreeData");
 	m.def("rbv_to_obj", &RBVToObj, "RBVToObj");
+	m.def("grow", &Grow, "Grow",
+		py::arg("tree_parameters_path"), py::arg("iterations"), py::arg("seed") = 0,
+		py::arg("delta_time") = 0.0822f, py::arg("mesh_generator_settings") = TreeMeshGeneratorSettings());
+	m.def("scan_point_cloud", &ScanPointCloud, "ScanPointCloud");
 	
 
 	py::class_<DatasetGenerator>(m, "DatasetGenerator")